@@ -13,8 +13,144 @@
 #include "x360mu/types.h"
 #include <cstring>
 
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define X360MU_BYTE_SWAP_NEON 1
+#elif defined(__x86_64__)
+// Built for SSSE3 per function (target attribute) and picked at runtime, so
+// the x86 build needs no -mssse3 and still runs on CPUs without it
+#include <tmmintrin.h>
+#define X360MU_BYTE_SWAP_SSSE3 1
+#endif
+
 namespace x360mu {
 
+// ============================================================================
+// Vector kernels
+// ============================================================================
+
+namespace detail {
+
+#if defined(X360MU_BYTE_SWAP_SSSE3)
+// pshufb masks reversing bytes within each 2/4/8-byte lane, and swapping
+// 16-bit halves within 32-bit lanes
+inline __m128i byte_swap_mask(size_t lane, bool half_swap) {
+    if (half_swap) return _mm_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    switch (lane) {
+        case 2:  return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+        case 4:  return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        default: return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    }
+}
+
+inline bool cpu_has_ssse3() {
+    static const bool has = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3") != 0;
+    }();
+    return has;
+}
+
+// Only called once cpu_has_ssse3() says pshufb exists
+__attribute__((target("ssse3")))
+inline size_t swap_blocks_ssse3(u8* d, const u8* s, size_t bytes, __m128i mask) {
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_shuffle_epi8(a, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i + 16), _mm_shuffle_epi8(b, mask));
+    }
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+#endif
+
+/**
+ * Reverse bytes within each Lane-byte element of 16-byte blocks
+ * (HalfSwap: swap 16-bit halves of 32-bit elements instead).
+ * Returns the number of bytes processed; the caller finishes the tail.
+ */
+template <size_t Lane, bool HalfSwap = false>
+inline size_t swap_blocks(u8* d, const u8* s, size_t bytes) {
+    size_t i = 0;
+#if defined(X360MU_BYTE_SWAP_NEON)
+    auto swap = [](uint8x16_t v) -> uint8x16_t {
+        if constexpr (HalfSwap) return vreinterpretq_u8_u16(vrev32q_u16(vreinterpretq_u16_u8(v)));
+        else if constexpr (Lane == 2) return vrev16q_u8(v);
+        else if constexpr (Lane == 4) return vrev32q_u8(v);
+        else return vrev64q_u8(v);
+    };
+    // Both loads before the stores so dst == src works
+    for (; i + 32 <= bytes; i += 32) {
+        uint8x16_t a = vld1q_u8(s + i);
+        uint8x16_t b = vld1q_u8(s + i + 16);
+        vst1q_u8(d + i, swap(a));
+        vst1q_u8(d + i + 16, swap(b));
+    }
+    for (; i + 16 <= bytes; i += 16) {
+        vst1q_u8(d + i, swap(vld1q_u8(s + i)));
+    }
+#elif defined(X360MU_BYTE_SWAP_SSSE3)
+    if (cpu_has_ssse3()) {
+        i = swap_blocks_ssse3(d, s, bytes, byte_swap_mask(Lane, HalfSwap));
+    }
+#else
+    (void)d; (void)s; (void)bytes;
+#endif
+    return i;
+}
+
+template <typename T>
+inline void byte_swap_copy(void* dst, const void* src, size_t count) {
+    u8* d = static_cast<u8*>(dst);
+    const u8* s = static_cast<const u8*>(src);
+    size_t bytes = count * sizeof(T);
+    for (size_t i = swap_blocks<sizeof(T)>(d, s, bytes); i < bytes; i += sizeof(T)) {
+        T v;
+        memcpy(&v, s + i, sizeof(T));
+        v = byte_swap(v);
+        memcpy(d + i, &v, sizeof(T));
+    }
+}
+
+} // namespace detail
+
+// ============================================================================
+// Bulk byte-swap with no alignment requirement (src -> dst)
+// dst may equal src (in-place); other overlaps are not supported.
+// ============================================================================
+
+inline void byte_swap_copy_16(void* dst, const void* src, size_t count) {
+    detail::byte_swap_copy<u16>(dst, src, count);
+}
+
+inline void byte_swap_copy_32(void* dst, const void* src, size_t count) {
+    detail::byte_swap_copy<u32>(dst, src, count);
+}
+
+inline void byte_swap_copy_64(void* dst, const void* src, size_t count) {
+    detail::byte_swap_copy<u64>(dst, src, count);
+}
+
+/**
+ * Swap the 16-bit halves of each u32 (Xbox 360 16-in-32 endian mode)
+ */
+inline void half_swap_copy_32(void* dst, const void* src, size_t count) {
+    u8* d = static_cast<u8*>(dst);
+    const u8* s = static_cast<const u8*>(src);
+    size_t bytes = count * 4;
+    for (size_t i = detail::swap_blocks<4, true>(d, s, bytes); i < bytes; i += 4) {
+        u32 v;
+        memcpy(&v, s + i, 4);
+        v = (v >> 16) | (v << 16);
+        memcpy(d + i, &v, 4);
+    }
+}
+
 // ============================================================================
 // Bulk array byte-swap (src -> dst)
 // ============================================================================
@@ -26,9 +162,7 @@ namespace x360mu {
  * @param count Number of u16 elements
  */
 inline void byte_swap_array_16(u16* dst, const u16* src, size_t count) {
-    for (size_t i = 0; i < count; i++) {
-        dst[i] = byte_swap(src[i]);
-    }
+    byte_swap_copy_16(dst, src, count);
 }
 
 /**
@@ -38,9 +172,7 @@ inline void byte_swap_array_16(u16* dst, const u16* src, size_t count) {
  * @param count Number of u32 elements
  */
 inline void byte_swap_array_32(u32* dst, const u32* src, size_t count) {
-    for (size_t i = 0; i < count; i++) {
-        dst[i] = byte_swap(src[i]);
-    }
+    byte_swap_copy_32(dst, src, count);
 }
 
 /**
@@ -50,9 +182,7 @@ inline void byte_swap_array_32(u32* dst, const u32* src, size_t count) {
  * @param count Number of u64 elements
  */
 inline void byte_swap_array_64(u64* dst, const u64* src, size_t count) {
-    for (size_t i = 0; i < count; i++) {
-        dst[i] = byte_swap(src[i]);
-    }
+    byte_swap_copy_64(dst, src, count);
 }
 
 // ============================================================================
@@ -60,21 +190,15 @@ inline void byte_swap_array_64(u64* dst, const u64* src, size_t count) {
 // ============================================================================
 
 inline void byte_swap_in_place_16(u16* data, size_t count) {
-    for (size_t i = 0; i < count; i++) {
-        data[i] = byte_swap(data[i]);
-    }
+    byte_swap_copy_16(data, data, count);
 }
 
 inline void byte_swap_in_place_32(u32* data, size_t count) {
-    for (size_t i = 0; i < count; i++) {
-        data[i] = byte_swap(data[i]);
-    }
+    byte_swap_copy_32(data, data, count);
 }
 
 inline void byte_swap_in_place_64(u64* data, size_t count) {
-    for (size_t i = 0; i < count; i++) {
-        data[i] = byte_swap(data[i]);
-    }
+    byte_swap_copy_64(data, data, count);
 }
 
 // ============================================================================
@@ -99,10 +223,8 @@ inline void endian_copy(void* dst, const void* src, size_t size, u32 endian_swap
             break;
 
         case 1: {
-            const u16* s = static_cast<const u16*>(src);
-            u16* d = static_cast<u16*>(dst);
             size_t count = size / 2;
-            byte_swap_array_16(d, s, count);
+            byte_swap_copy_16(dst, src, count);
             if (size & 1) {
                 static_cast<u8*>(dst)[size - 1] = static_cast<const u8*>(src)[size - 1];
             }
@@ -110,10 +232,8 @@ inline void endian_copy(void* dst, const void* src, size_t size, u32 endian_swap
         }
 
         case 2: {
-            const u32* s = static_cast<const u32*>(src);
-            u32* d = static_cast<u32*>(dst);
             size_t count = size / 4;
-            byte_swap_array_32(d, s, count);
+            byte_swap_copy_32(dst, src, count);
             size_t remainder = size & 3;
             if (remainder) {
                 memcpy(static_cast<u8*>(dst) + size - remainder,
@@ -124,13 +244,8 @@ inline void endian_copy(void* dst, const void* src, size_t size, u32 endian_swap
         }
 
         case 3: {
-            const u32* s = static_cast<const u32*>(src);
-            u32* d = static_cast<u32*>(dst);
             size_t count = size / 4;
-            for (size_t i = 0; i < count; i++) {
-                u32 v = s[i];
-                d[i] = (v >> 16) | (v << 16);
-            }
+            half_swap_copy_32(dst, src, count);
             size_t remainder = size & 3;
             if (remainder) {
                 memcpy(static_cast<u8*>(dst) + size - remainder,
@@ -29,12 +29,19 @@ struct EmulatorConfig {
     // CPU settings
     bool enable_jit = true;  // Re-enabled for debugging
     u32 jit_cache_size_mb = 128;
+    bool fiber_scheduler = false;  // Run guest threads as fibers on 6 host workers (M:N)
+    bool pin_host_threads = true;  // Pin hardware/service threads to ranked host cores
+    bool deterministic = false;    // Round-robin guest threads on a virtual clock (reproducible runs)
+    
+    // Memory settings
+    bool use_huge_pages = false;  // Back guest RAM with huge pages when available
     
     // GPU settings
     bool use_vulkan = true;
     u32 internal_resolution_scale = 1; // 1 = native, 2 = 2x, etc.
     bool enable_vsync = true;
     bool enable_async_shaders = true;
+    bool async_gpu_commands = true;  // Process the command ring on its own thread
     
     // Audio settings
     u32 audio_buffer_size_ms = 20;
@@ -174,6 +181,7 @@ public:
         f64 cpu_usage_percent;
         f64 gpu_usage_percent;
         u64 memory_used_bytes;
+        u64 frame_hash;          // GPU command stream hash (deterministic mode)
     };
     Stats get_stats() const;
     
@@ -194,6 +202,9 @@ private:
     // Main emulation loop (runs on dedicated thread)
     void emulation_thread_main();
     
+    // Emulation loop for deterministic mode: virtual time, no pacing
+    void run_deterministic(bool single_step);
+    
     // Frame timing
     void synchronize_frame();
     
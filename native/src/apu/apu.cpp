@@ -547,14 +547,15 @@ void Apu::register_mmio(Memory* memory) {
     memory->register_mmio(
         apu_reg::APU_BASE,
         apu_reg::APU_SIZE,
-        [this](GuestAddr addr) -> u32 {
+        [](void* ctx, GuestAddr addr) -> u32 {
             u32 offset = addr - apu_reg::APU_BASE;
-            return read_register(offset);
+            return static_cast<Apu*>(ctx)->read_register(offset);
         },
-        [this](GuestAddr addr, u32 value) {
+        [](void* ctx, GuestAddr addr, u32 value) {
             u32 offset = addr - apu_reg::APU_BASE;
-            write_register(offset, value);
-        }
+            static_cast<Apu*>(ctx)->write_register(offset, value);
+        },
+        this
     );
 
     LOGI("APU MMIO registered at 0x%08X-0x%08X",
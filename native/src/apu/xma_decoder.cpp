@@ -1342,11 +1342,9 @@ void XmaProcessor::write_pcm_output(HardwareContext& hw_ctx, const s16* pcm_data
         sample_count = bytes_to_write / sizeof(s16);
     }
     
-    // Write PCM data to output buffer
-    for (u32 i = 0; i < sample_count; i++) {
-        memory_->write_u16(ctx.output_buffer + ctx.output_buffer_write_offset + i * 2,
-                          static_cast<u16>(pcm_data[i]));
-    }
+    // Write PCM data to output buffer (big-endian)
+    memory_->write_swapped16(ctx.output_buffer + ctx.output_buffer_write_offset,
+                             reinterpret_cast<const u16*>(pcm_data), sample_count);
     
     ctx.output_buffer_write_offset += bytes_to_write;
 }
@@ -7,6 +7,8 @@
 #include "x360mu/emulator.h"
 #include "kernel/game_info.h"
 #include "save_state.h"
+#include "timeline.h"
+#include "guest_clock.h"
 #include "cpu/xenon/cpu.h"
 #include "cpu/xenon/threading.h"
 #include "gpu/xenos/gpu.h"
@@ -14,6 +16,7 @@
 #include "memory/memory.h"
 #include "kernel/kernel.h"
 #include "kernel/xkernel.h"
+#include "kernel/xthread.h"
 #include "kernel/filesystem/vfs.h"
 #include "input/input_manager.h"
 
@@ -40,6 +43,13 @@ namespace x360mu {
 constexpr auto FRAME_TIME_60FPS = std::chrono::microseconds(16667);  // ~60fps
 constexpr auto FRAME_TIME_30FPS = std::chrono::microseconds(33333);  // ~30fps
 
+// Emulation timeline periods
+constexpr auto VBLANK_PERIOD = FRAME_TIME_60FPS;                     // Display refresh
+constexpr auto AUDIO_MIX_PERIOD = FRAME_TIME_60FPS;                  // Apu mixes 1/60s per call
+constexpr auto KERNEL_SLICE_PERIOD = std::chrono::microseconds(1000); // While XScheduler has threads
+constexpr u64 KERNEL_SLICE_CYCLES = cpu::CLOCK_SPEED / 60 / 100;      // ~1/100th of a frame
+constexpr u32 VIRTUAL_VBLANK_SLICES = 100;                            // Deterministic: slices per vblank
+
 /**
  * Internal emulation thread state
  */
@@ -69,14 +79,19 @@ Status Emulator::initialize(const EmulatorConfig& config) {
     LOGI("Initializing 360μ emulator");
     config_ = config;
     
+    // Kernel time starts counting at initialization, so pick the clock first
+    GuestClock::instance().set_virtual(config_.deterministic);
+    
     // Initialize memory subsystem first (others depend on it)
     LOGI("Initializing memory subsystem");
     memory_ = std::make_unique<Memory>();
+    memory_->set_huge_pages(config_.use_huge_pages);
     Status status = memory_->initialize();
     if (status != Status::Ok) {
         LOGE("Failed to initialize memory: %s", status_to_string(status));
         return status;
     }
+    LOGI("Guest RAM backed by %s", memory_backing_name(memory_->backing()));
     
     // Initialize CPU
     LOGI("Initializing CPU (JIT: %s)", config_.enable_jit ? "enabled" : "disabled");
@@ -98,6 +113,8 @@ Status Emulator::initialize(const EmulatorConfig& config) {
     gpu_config.resolution_scale = config_.internal_resolution_scale;
     gpu_config.enable_vsync = config_.enable_vsync;
     gpu_config.cache_path = config_.cache_path;
+    // Deterministic runs keep command processing inline on the emulation thread
+    gpu_config.async_commands = config_.async_gpu_commands && !config_.deterministic;
     status = gpu_->initialize(memory_.get(), gpu_config);
     if (status != Status::Ok) {
         LOGE("Failed to initialize GPU: %s", status_to_string(status));
@@ -110,14 +127,15 @@ Status Emulator::initialize(const EmulatorConfig& config) {
     memory_->register_mmio(
         memory::GPU_REGS_BASE,
         memory::GPU_REGS_END - memory::GPU_REGS_BASE + 1,
-        [this](GuestAddr addr) -> u32 {
+        [](void* ctx, GuestAddr addr) -> u32 {
             u32 offset = (addr - memory::GPU_REGS_BASE) / 4;
-            return gpu_->read_register(offset);
+            return static_cast<Gpu*>(ctx)->read_register(offset);
         },
-        [this](GuestAddr addr, u32 value) {
+        [](void* ctx, GuestAddr addr, u32 value) {
             u32 offset = (addr - memory::GPU_REGS_BASE) / 4;
-            gpu_->write_register(offset, value);
-        }
+            static_cast<Gpu*>(ctx)->write_register(offset, value);
+        },
+        gpu_.get()
     );
     
     // Initialize audio
@@ -159,13 +177,28 @@ Status Emulator::initialize(const EmulatorConfig& config) {
     // Initialize thread scheduler for multi-threaded guest execution
     LOGI("Initializing thread scheduler");
     scheduler_ = std::make_unique<ThreadScheduler>();
+    HostAffinityConfig affinity_config;
+    affinity_config.enabled = config_.pin_host_threads;
+    scheduler_->set_host_affinity(affinity_config);
     // Use 4 host threads on Android (good balance for big.LITTLE)
     u32 num_threads = std::min(4u, std::thread::hardware_concurrency());
-    status = scheduler_->initialize(memory_.get(), kernel_.get(), cpu_.get(), num_threads);
+    SchedulingMode mode = SchedulingMode::OneToOne;
+    if (config_.deterministic) {
+        mode = SchedulingMode::Deterministic;
+    } else if (config_.fiber_scheduler) {
+        mode = SchedulingMode::Fibers;
+    }
+    status = scheduler_->initialize(memory_.get(), kernel_.get(), cpu_.get(), num_threads, mode);
     if (status != Status::Ok) {
         LOGE("Failed to initialize thread scheduler: %s", status_to_string(status));
         return status;
     }
+    if (config_.deterministic && scheduler_->scheduling_mode() != SchedulingMode::Deterministic) {
+        LOGE("Deterministic mode needs fiber support, running in real time");
+        config_.deterministic = false;
+        GuestClock::instance().set_virtual(false);
+    }
+    gpu_->set_command_hashing(config_.deterministic);
     
     // Connect scheduler to kernel for thread management
     kernel_->set_scheduler(scheduler_.get());
@@ -194,6 +227,7 @@ void Emulator::shutdown() {
     if (emu_thread_ && emu_thread_->thread.joinable()) {
         emu_thread_->should_stop = true;
         emu_thread_->cv.notify_all();
+        Timeline::instance().wake();
         emu_thread_->thread.join();
     }
     
@@ -207,6 +241,7 @@ void Emulator::shutdown() {
     cpu_.reset();
     memory_.reset();
     emu_thread_.reset();
+    GuestClock::instance().set_virtual(false);
     
     state_ = EmulatorState::Uninitialized;
     LOGI("Emulator shutdown complete");
@@ -372,6 +407,7 @@ void Emulator::pause() {
         std::lock_guard<std::mutex> lock(emu_thread_->mutex);
         emu_thread_->paused = true;
     }
+    Timeline::instance().wake();
     
     state_ = EmulatorState::Paused;
 }
@@ -389,6 +425,7 @@ void Emulator::stop() {
         emu_thread_->paused = false;
     }
     emu_thread_->cv.notify_all();
+    Timeline::instance().wake();
     
     state_ = EmulatorState::Stopped;
 }
@@ -427,11 +464,17 @@ void Emulator::emulation_thread_main() {
     LOGI("=== EMULATION THREAD STARTED ===");
     LOGI("========================================");
 
-    using Clock = std::chrono::high_resolution_clock;
-    auto last_frame_time = Clock::now();
+    // Emulation loop drives the GPU and kernel services; keep it off the
+    // cores running guest hardware threads
+    HostAffinity::instance().pin_service_thread("emulation");
+
+    using Clock = Timeline::Clock;
+    auto& timeline = Timeline::instance();
     auto last_log_time = Clock::now();
 
     u64 loop_iterations = 0;
+    u64 passes_since_log = 0;
+    u64 sleeps_since_log = 0;
     u64 frames_since_log = 0;
     u64 frames_skipped = 0;
 
@@ -466,125 +509,139 @@ void Emulator::emulation_thread_main() {
         bool single_step = emu_thread_->step_frame.exchange(false);
         loop_iterations++;
 
-        // Detailed logging for first few frames
-        bool verbose_log = (loop_iterations <= 5);
-
-        if (verbose_log) {
-            LOGI("========================================");
-            LOGI("Frame %llu starting...", loop_iterations);
-            LOGI("========================================");
+        if (config_.deterministic) {
+            run_deterministic(single_step);
+            if (single_step) {
+                emu_thread_->paused = true;
+            }
+            continue;
         }
 
-        // Log periodically
+        // (Re)start the clocks; nothing ran while we were paused
         auto now = Clock::now();
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - last_log_time).count() >= 2) {
-            LOGI("Emulation loop: %llu iterations, %llu frames, %.1f FPS",
-                 loop_iterations, frames_since_log, stats_.fps);
-            last_log_time = now;
-            frames_since_log = 0;
-        }
-
-        // Execute one frame
-        auto frame_start = Clock::now();
-
-        // Start new frame - reset frame_complete flag
-        if (verbose_log) LOGI("  [Frame %llu] Beginning new frame on GPU...", loop_iterations);
+        auto last_pass = now;
+        auto frame_start = now;
+        auto last_present = now;
+        bool frame_ready = false;
+        bool presented = false;
+        timeline.reset();
+        timeline.schedule(TimelineEvent::VBlank, now + VBLANK_PERIOD);
+        if (apu_) timeline.schedule(TimelineEvent::Audio, now + AUDIO_MIX_PERIOD);
         gpu_->begin_new_frame();
-        if (verbose_log) LOGI("  [Frame %llu] GPU frame begun", loop_iterations);
 
-        // Run CPU via the scheduler for multi-threaded execution
-        bool frame_complete = false;
-        u32 cpu_batches = 0;
-
-        if (verbose_log) LOGI("  [Frame %llu] Starting CPU execution loop...", loop_iterations);
-
-        while (!frame_complete && !emu_thread_->paused && !emu_thread_->should_stop) {
-            // Execute via scheduler - this wakes host threads that run guest threads
-            if (verbose_log && cpu_batches < 3) LOGI("    [Batch %u] Running scheduler...", cpu_batches);
-            scheduler_->run(cpu::CLOCK_SPEED / 60 / 100); // ~1/100th of a frame
-            cpu_batches++;
-
-            // Process kernel work items (DPCs, timers, APCs)
-            // This is critical for game initialization - DPCs signal completion events
-            // that the main thread waits for before proceeding to GPU init
-            if (verbose_log && cpu_batches <= 3) LOGI("    [Batch %u] Processing kernel work items...", cpu_batches - 1);
-            XKernel::instance().run_for(cpu::CLOCK_SPEED / 60 / 100);
-
-            // Process GPU command buffer
-            if (verbose_log && cpu_batches <= 3) LOGI("    [Batch %u] Processing GPU commands...", cpu_batches - 1);
-            gpu_->process_commands();
-
-            // Check if GPU finished a frame
-            frame_complete = gpu_->frame_complete();
+        while (!emu_thread_->should_stop && !(single_step && presented) &&
+               (single_step || (emu_thread_->running && !emu_thread_->paused))) {
+            now = Clock::now();
+            u32 due = timeline.take_due(now);
+            passes_since_log++;
+
+            // Guest time advances with the host clock; the 1:1 host threads
+            // run guest code on their own
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - last_pass);
+            scheduler_->run(static_cast<u64>(elapsed.count()) * (cpu::CLOCK_SPEED / 1000000));
+            last_pass = now;
+
+            // Kernel work items (DPCs queued by timers and guest threads, APCs),
+            // plus a slice for any cooperative XScheduler threads
+            XKernel::instance().run_for(KERNEL_SLICE_CYCLES);
+            if (XScheduler::instance().has_threads()) {
+                if (!timeline.scheduled(TimelineEvent::KernelSlice)) {
+                    timeline.schedule(TimelineEvent::KernelSlice, now + KERNEL_SLICE_PERIOD);
+                }
+            } else {
+                timeline.cancel(TimelineEvent::KernelSlice);
+            }
 
-            // Process audio
-            if (apu_) {
-                apu_->process();
+            // Drain the ring buffer up to the end of a frame; a finished frame
+            // holds the rest until it has been presented
+            if (!frame_ready) {
+                gpu_->process_commands();
+                if (gpu_->frame_complete()) {
+                    frame_ready = true;
+                    stats_.frame_time_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - frame_start).count() / 1000.0;
+                }
             }
 
-            // Safety: if we've run too many batches without a frame, break
-            if (cpu_batches >= 1000) {
-                LOGI("Frame taking too long, CPU executed %u batches", cpu_batches);
-                break;
+            if (due & Timeline::bit(TimelineEvent::VBlank)) {
+                // Sync input state to XAM, then raise the vsync interrupt and
+                // VBlank event games use for frame synchronization
+                get_input_manager().sync_to_xam();
+                gpu_->signal_vsync();
+                XKernel::instance().signal_vblank();
+                timeline.schedule(TimelineEvent::VBlank, now + VBLANK_PERIOD);
             }
-        }
 
-        if (verbose_log) {
-            LOGI("  [Frame %llu] CPU execution complete: %u batches, frame_complete=%d",
-                 loop_iterations, cpu_batches, frame_complete);
-        }
-        
-        // Sync input state to XAM before presenting
-        get_input_manager().sync_to_xam();
+            if (apu_ && (due & Timeline::bit(TimelineEvent::Audio))) {
+                apu_->process();
+                timeline.schedule(TimelineEvent::Audio, now + AUDIO_MIX_PERIOD);
+            }
 
-        // Present frame (with frame skip support)
-        if (frame_complete || cpu_batches >= 100) {
-            u32 skip = gpu_ ? gpu_->frame_skip() : 0;
-            bool should_present = (skip == 0) || (frames_skipped >= skip);
+            // Present a finished frame once pacing allows it. With nothing
+            // finished, present anyway when the pacing deadline passes so the
+            // display and frame callback keep running while the title is busy.
+            u32 tfps = gpu_ ? gpu_->target_fps() : 30;
+            Clock::duration frame_period = tfps > 0 ? std::chrono::microseconds(1000000 / tfps)
+                                                    : std::chrono::microseconds(0);
+            auto present_at = last_present +
+                (frame_ready ? frame_period : std::max<Clock::duration>(frame_period, VBLANK_PERIOD));
+            if (now >= present_at || (frame_ready && single_step)) {
+                u32 skip = gpu_ ? gpu_->frame_skip() : 0;
+                bool should_present = (skip == 0) || (frames_skipped >= skip);
+
+                if (should_present) {
+                    gpu_->present();
+                    stats_.frames_rendered++;
+                    frames_since_log++;
+                    frames_skipped = 0;
+                } else {
+                    frames_skipped++;
+                }
+                if (!frame_ready) {
+                    stats_.frame_time_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - frame_start).count() / 1000.0;
+                }
+
+                auto since_last = std::chrono::duration_cast<std::chrono::microseconds>(now - last_present);
+                if (since_last.count() > 0) {
+                    stats_.fps = 1000000.0 / since_last.count();
+                }
+                last_present = now;
+
+                if (frame_callback_) {
+                    frame_callback_();
+                }
 
-            if (should_present) {
-                gpu_->present();
-                stats_.frames_rendered++;
-                frames_since_log++;
-                frames_skipped = 0;
-            } else {
-                // Skip present but still advance frame state
                 gpu_->begin_new_frame();
-                frames_skipped++;
-            }
-
-            // Signal VBlank - this processes timer DPCs and signals VBlank events
-            // Games rely on VBlank for frame synchronization
-            XKernel::instance().signal_vblank();
+                frame_start = now;
+                frame_ready = false;
+                presented = true;
 
-            if (frame_callback_) {
-                frame_callback_();
+                // Commands past the end of the frame may already be queued
+                continue;
+            }
+            timeline.schedule(TimelineEvent::Present, present_at);
+
+            // Log periodically
+            if (now - last_log_time >= std::chrono::seconds(2)) {
+                LOGI("Emulation loop: %llu passes (%llu slept), %llu frames, %.1f FPS",
+                     (unsigned long long)passes_since_log,
+                     (unsigned long long)sleeps_since_log,
+                     (unsigned long long)frames_since_log, stats_.fps);
+                last_log_time = now;
+                passes_since_log = 0;
+                sleeps_since_log = 0;
+                frames_since_log = 0;
             }
-        }
-
-        // Frame timing
-        auto frame_end = Clock::now();
-        auto frame_duration = std::chrono::duration_cast<std::chrono::microseconds>(frame_end - frame_start);
-        stats_.frame_time_ms = frame_duration.count() / 1000.0;
 
-        // Calculate FPS
-        auto since_last = std::chrono::duration_cast<std::chrono::microseconds>(frame_end - last_frame_time);
-        if (since_last.count() > 0) {
-            stats_.fps = 1000000.0 / since_last.count();
+            // Nothing left to do until the next deadline, a ring buffer
+            // write, a queued DPC, or a pause/stop request
+            timeline.wait();
+            sleeps_since_log++;
         }
-        last_frame_time = frame_end;
 
-        // Compute target frame time from GPU's target FPS setting
-        u32 tfps = gpu_ ? gpu_->target_fps() : 30;
-        auto target_frame_time = (tfps > 0)
-            ? std::chrono::microseconds(1000000 / tfps)
-            : std::chrono::microseconds(0);
+        timeline.reset();
 
-        // Sync to target frame rate (if we're ahead)
-        if (!single_step && tfps > 0 && frame_duration < target_frame_time) {
-            std::this_thread::sleep_for(target_frame_time - frame_duration);
-        }
-        
         // Stop after single frame if stepping
         if (single_step) {
             emu_thread_->paused = true;
@@ -594,6 +651,49 @@ void Emulator::emulation_thread_main() {
     LOGI("=== Emulation thread stopped ===");
 }
 
+void Emulator::run_deterministic(bool single_step) {
+    // Every pass runs the guest for a fixed slice of virtual time and a
+    // vblank falls every VIRTUAL_VBLANK_SLICES slices, so the same title and
+    // input replay the same instructions and command stream. Nothing waits
+    // on the host clock; the loop runs as fast as the host allows.
+    auto& clock = GuestClock::instance();
+    u32 slices = 0;
+    gpu_->begin_new_frame();
+
+    while (!emu_thread_->should_stop &&
+           (single_step || (emu_thread_->running && !emu_thread_->paused))) {
+        scheduler_->run(KERNEL_SLICE_CYCLES);
+        XKernel::instance().run_for(KERNEL_SLICE_CYCLES);
+        gpu_->process_commands();
+        stats_.cpu_cycles = clock.cycles();
+
+        if (++slices < VIRTUAL_VBLANK_SLICES) {
+            continue;
+        }
+        slices = 0;
+
+        // Input is sampled only here, at virtual vblanks
+        get_input_manager().sync_to_xam();
+        gpu_->signal_vsync();
+        XKernel::instance().signal_vblank();
+        if (apu_) {
+            apu_->process();
+        }
+
+        gpu_->present();
+        stats_.frames_rendered++;
+        stats_.frame_hash = gpu_->command_hash();
+        if (frame_callback_) {
+            frame_callback_();
+        }
+        gpu_->begin_new_frame();
+
+        if (single_step) {
+            break;
+        }
+    }
+}
+
 // Input methods
 void Emulator::set_button(u32 player, u32 button, bool pressed) {
     if (kernel_) {
@@ -0,0 +1,80 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Guest clock implementation
+ */
+
+#include "guest_clock.h"
+#include <chrono>
+
+namespace x360mu {
+
+namespace {
+
+constexpr u64 NS_PER_SECOND = 1000000000ULL;
+
+// FILETIME of 1970-01-01 and of the virtual boot date, 2010-01-01 00:00 UTC
+constexpr u64 UNIX_EPOCH_FILETIME = 116444736000000000ULL;
+constexpr u64 VIRTUAL_BOOT_FILETIME = 129067776000000000ULL;
+
+// value * num / den without overflowing for any realistic run length
+u64 scale(u64 value, u64 num, u64 den, bool round_up) {
+    u64 whole = value / den;
+    u64 rest = value % den;
+    u64 frac = rest * num;
+    return whole * num + frac / den + (round_up && frac % den ? 1 : 0);
+}
+
+} // namespace
+
+GuestClock& GuestClock::instance() {
+    static GuestClock clock;
+    return clock;
+}
+
+void GuestClock::set_virtual(bool enabled) {
+    if (enabled && !virtual_.load(std::memory_order_relaxed)) {
+        cycles_.store(0, std::memory_order_relaxed);
+    }
+    virtual_.store(enabled, std::memory_order_relaxed);
+}
+
+void GuestClock::advance(u64 cycles) {
+    if (is_virtual()) {
+        cycles_.fetch_add(cycles, std::memory_order_relaxed);
+    }
+}
+
+u64 GuestClock::cycles_to_ns(u64 cycles) {
+    return scale(cycles, NS_PER_SECOND, cpu::CLOCK_SPEED, false);
+}
+
+u64 GuestClock::ns_to_cycles(u64 ns) {
+    return scale(ns, cpu::CLOCK_SPEED, NS_PER_SECOND, true);
+}
+
+u64 GuestClock::now_ns() const {
+    if (is_virtual()) {
+        return cycles_to_ns(cycles());
+    }
+    auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count();
+}
+
+u64 GuestClock::time_base() const {
+    if (is_virtual()) {
+        return scale(cycles(), TIME_BASE_HZ, cpu::CLOCK_SPEED, false);
+    }
+    return scale(now_ns(), TIME_BASE_HZ, NS_PER_SECOND, false);
+}
+
+u64 GuestClock::system_time() const {
+    if (is_virtual()) {
+        return VIRTUAL_BOOT_FILETIME + now_100ns();
+    }
+    auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+    return UNIX_EPOCH_FILETIME +
+           std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count() / 100;
+}
+
+} // namespace x360mu
@@ -0,0 +1,69 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Guest clock
+ *
+ * The one time source behind everything the guest can observe: kernel
+ * interrupt/system time, the performance counter, timer expiries and timed
+ * waits. Normally it follows the host steady clock. In virtual mode
+ * (deterministic execution) it only moves when the scheduler charges guest
+ * cycles, so a run's timeline depends on nothing but the code it executes.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include <atomic>
+
+namespace x360mu {
+
+class GuestClock {
+public:
+    static constexpr u64 TIME_BASE_HZ = 50000000;  // Xenon time base / performance counter
+
+    static GuestClock& instance();
+
+    /**
+     * Switch between host and virtual time. Entering virtual mode restarts
+     * the cycle count at zero.
+     */
+    void set_virtual(bool enabled);
+    bool is_virtual() const { return virtual_.load(std::memory_order_relaxed); }
+
+    /**
+     * Charge executed guest cycles (virtual mode only)
+     */
+    void advance(u64 cycles);
+
+    /**
+     * Guest cycles charged since virtual mode was entered
+     */
+    u64 cycles() const { return cycles_.load(std::memory_order_relaxed); }
+
+    /**
+     * Monotonic time. Host mode: steady clock since its epoch; virtual
+     * mode: charged cycles at the Xenon clock rate, starting from zero.
+     */
+    u64 now_ns() const;
+    u64 now_100ns() const { return now_ns() / 100; }
+
+    /**
+     * Time base ticks (50 MHz) for the current time
+     */
+    u64 time_base() const;
+
+    /**
+     * Wall-clock time as a FILETIME (100ns units since 1601). Virtual mode
+     * counts from a fixed date so guest timestamps repeat too.
+     */
+    u64 system_time() const;
+
+    static u64 cycles_to_ns(u64 cycles);
+    static u64 ns_to_cycles(u64 ns);    // Rounds up
+
+private:
+    std::atomic<bool> virtual_{false};
+    std::atomic<u64> cycles_{0};
+};
+
+} // namespace x360mu
@@ -0,0 +1,90 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Intrusive multi-producer queue
+ *
+ * Producers push with a single CAS on the head pointer; the consumer takes
+ * the whole list with one exchange and reverses it into FIFO order. Neither
+ * side takes a lock, and since nodes are only ever removed all at once there
+ * is no ABA hazard. Several consumers may call pop_all() concurrently; each
+ * gets a disjoint batch.
+ *
+ * Items derive from MpscNode. A node belongs to the queue from push() until
+ * pop_all() hands it back; nodes still queued when the queue is destroyed
+ * are deleted.
+ */
+
+#pragma once
+
+#include <atomic>
+
+namespace x360mu {
+
+struct MpscNode {
+    MpscNode* mpsc_next = nullptr;
+};
+
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() = default;
+    ~MpscQueue() { clear(); }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /**
+     * Publish a node
+     * @return true if the queue was empty, i.e. an idle consumer may need waking
+     */
+    bool push(T* item) {
+        MpscNode* node = item;
+        MpscNode* head = head_.load(std::memory_order_relaxed);
+        do {
+            node->mpsc_next = head;
+        } while (!head_.compare_exchange_weak(head, node, std::memory_order_release,
+                                              std::memory_order_relaxed));
+        return head == nullptr;
+    }
+
+    /**
+     * Detach everything queued so far
+     * @return First node in push order (chained through mpsc_next), or nullptr
+     */
+    T* pop_all() {
+        MpscNode* node = head_.exchange(nullptr, std::memory_order_acquire);
+        MpscNode* fifo = nullptr;
+        while (node) {
+            MpscNode* next = node->mpsc_next;
+            node->mpsc_next = fifo;
+            fifo = node;
+            node = next;
+        }
+        return static_cast<T*>(fifo);
+    }
+
+    static T* next(T* item) {
+        return static_cast<T*>(item->mpsc_next);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == nullptr;
+    }
+
+    /**
+     * Delete all queued nodes
+     */
+    void clear() {
+        T* item = pop_all();
+        while (item) {
+            T* following = next(item);
+            delete item;
+            item = following;
+        }
+    }
+
+private:
+    std::atomic<MpscNode*> head_{nullptr};
+};
+
+} // namespace x360mu
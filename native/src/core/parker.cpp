@@ -0,0 +1,107 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Per-thread parking word implementation
+ */
+
+#include "parker.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#define X360MU_HAVE_FUTEX 1
+#endif
+
+namespace x360mu {
+
+#ifdef X360MU_HAVE_FUTEX
+static void futex_wait(std::atomic<u32>* word, u32 expected, u64 timeout_ns) {
+    timespec ts;
+    timespec* tsp = nullptr;
+    if (timeout_ns != Parker::INFINITE) {
+        ts.tv_sec = static_cast<time_t>(timeout_ns / 1000000000ULL);
+        ts.tv_nsec = static_cast<long>(timeout_ns % 1000000000ULL);
+        tsp = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<u32*>(word), FUTEX_WAIT_PRIVATE, expected, tsp,
+            nullptr, 0);
+}
+
+static void futex_wake(std::atomic<u32>* word) {
+    syscall(SYS_futex, reinterpret_cast<u32*>(word), FUTEX_WAKE_PRIVATE, 1, nullptr,
+            nullptr, 0);
+}
+#endif
+
+bool Parker::park(u64 timeout_ns) {
+    // Consume a pending unpark
+    u32 expected = NOTIFIED;
+    if (state_.compare_exchange_strong(expected, EMPTY, std::memory_order_acquire)) {
+        return true;
+    }
+
+    // EMPTY -> PARKED; only unpark() can have moved it to NOTIFIED meanwhile
+    expected = EMPTY;
+    if (!state_.compare_exchange_strong(expected, PARKED, std::memory_order_acquire)) {
+        state_.store(EMPTY, std::memory_order_relaxed);
+        return true;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    bool timed = timeout_ns != INFINITE;
+    Clock::time_point deadline{};
+    if (timed) {
+        deadline = Clock::now() + std::chrono::nanoseconds(
+            std::min<u64>(timeout_ns, 365ULL * 24 * 3600 * 1000000000ULL));
+    }
+
+    while (true) {
+        u64 remaining_ns = INFINITE;
+        if (timed) {
+            auto now = Clock::now();
+            if (now >= deadline) {
+                // Timed out: leave PARKED, reporting an unpark that raced in
+                return state_.exchange(EMPTY, std::memory_order_acquire) == NOTIFIED;
+            }
+            remaining_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                deadline - now).count();
+        }
+
+#ifdef X360MU_HAVE_FUTEX
+        futex_wait(&state_, PARKED, remaining_ns);
+#else
+        if (timed) {
+            // std::atomic::wait has no timeout; poll in short sleeps
+            if (state_.load(std::memory_order_acquire) == PARKED) {
+                std::this_thread::sleep_for(std::chrono::nanoseconds(
+                    std::min<u64>(remaining_ns, 100000)));
+            }
+        } else {
+            state_.wait(PARKED, std::memory_order_acquire);
+        }
+#endif
+
+        expected = NOTIFIED;
+        if (state_.compare_exchange_strong(expected, EMPTY, std::memory_order_acquire)) {
+            return true;
+        }
+        // Spurious wakeup, keep waiting
+    }
+}
+
+void Parker::unpark() {
+    if (state_.exchange(NOTIFIED, std::memory_order_release) == PARKED) {
+#ifdef X360MU_HAVE_FUTEX
+        futex_wake(&state_);
+#else
+        state_.notify_one();
+#endif
+    }
+}
+
+} // namespace x360mu
@@ -0,0 +1,45 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Per-thread parking word
+ *
+ * One 32-bit futex word per thread: park() blocks the owning thread until
+ * another thread calls unpark(), which is a single atomic exchange plus a
+ * FUTEX_WAKE only if the owner is actually asleep. An unpark() that arrives
+ * first is remembered, so callers can publish their wake condition, then
+ * unpark, without holding a lock. Falls back to std::atomic::wait on hosts
+ * without futex.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include <atomic>
+
+namespace x360mu {
+
+class Parker {
+public:
+    static constexpr u64 INFINITE = ~0ULL;
+
+    /**
+     * Block until unpark() or the timeout. Only the owning thread may park.
+     * May return early spuriously; callers recheck their condition.
+     * @return true if woken by unpark()
+     */
+    bool park(u64 timeout_ns = INFINITE);
+
+    /**
+     * Wake the owner, or make its next park() return immediately
+     */
+    void unpark();
+
+private:
+    static constexpr u32 EMPTY = 0;
+    static constexpr u32 NOTIFIED = 1;
+    static constexpr u32 PARKED = 2;
+
+    std::atomic<u32> state_{EMPTY};
+};
+
+} // namespace x360mu
@@ -0,0 +1,83 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Emulation timeline implementation
+ */
+
+#include "timeline.h"
+#include <algorithm>
+
+namespace x360mu {
+
+Timeline& Timeline::instance() {
+    static Timeline timeline;
+    return timeline;
+}
+
+Timeline::Timeline() {
+    due_.fill(Clock::time_point::max());
+}
+
+Timeline::Clock::time_point Timeline::earliest_locked() const {
+    return *std::min_element(due_.begin(), due_.end());
+}
+
+void Timeline::schedule(TimelineEvent event, Clock::time_point due) {
+    bool new_earliest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        new_earliest = due < earliest_locked();
+        due_[static_cast<size_t>(event)] = due;
+    }
+    // Only an earlier deadline changes how long the waiter should sleep
+    if (new_earliest) {
+        wake();
+    }
+}
+
+void Timeline::cancel(TimelineEvent event) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    due_[static_cast<size_t>(event)] = Clock::time_point::max();
+}
+
+bool Timeline::scheduled(TimelineEvent event) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return due_[static_cast<size_t>(event)] != Clock::time_point::max();
+}
+
+Timeline::Clock::time_point Timeline::next_due() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return earliest_locked();
+}
+
+u32 Timeline::take_due(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    u32 mask = 0;
+    for (size_t i = 0; i < due_.size(); i++) {
+        if (due_[i] <= now) {
+            due_[i] = Clock::time_point::max();
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+bool Timeline::wait() {
+    auto due = next_due();
+    if (due == Clock::time_point::max()) {
+        return parker_.park();
+    }
+    auto now = Clock::now();
+    if (due <= now) {
+        return false;
+    }
+    auto timeout = std::chrono::duration_cast<std::chrono::nanoseconds>(due - now).count();
+    return parker_.park(static_cast<u64>(timeout));
+}
+
+void Timeline::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    due_.fill(Clock::time_point::max());
+}
+
+} // namespace x360mu
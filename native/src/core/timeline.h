@@ -0,0 +1,88 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Emulation timeline
+ *
+ * The deadlines the emulation thread has to meet (vblank, audio buffer
+ * refills, frame presentation, cooperative thread slices) live here, and
+ * the thread sleeps until the earliest of them instead of polling. Work that
+ * arrives asynchronously wakes it early: a ring buffer write-pointer update
+ * from the guest, or a DPC queued by a timer expiry or a guest thread. Each
+ * event kind has at most one pending deadline; scheduling it again moves it.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include "parker.h"
+#include <array>
+#include <chrono>
+#include <mutex>
+
+namespace x360mu {
+
+enum class TimelineEvent : u32 {
+    VBlank,         // Display refresh: vsync interrupt, VBlank event, input sync
+    Audio,          // Mix and submit before the host output buffer drains
+    Present,        // Frame pacing: earliest moment the next frame may be shown
+    KernelSlice,    // Cooperative XScheduler threads are due another slice
+    Count
+};
+
+class Timeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static Timeline& instance();
+
+    Timeline();
+
+    static constexpr u32 bit(TimelineEvent event) {
+        return 1u << static_cast<u32>(event);
+    }
+
+    /**
+     * Set (or move) the deadline of an event. Wakes the sleeping thread if
+     * this is now the earliest deadline.
+     */
+    void schedule(TimelineEvent event, Clock::time_point due);
+    void cancel(TimelineEvent event);
+    bool scheduled(TimelineEvent event) const;
+
+    /**
+     * Earliest pending deadline, or Clock::time_point::max() if none
+     */
+    Clock::time_point next_due() const;
+
+    /**
+     * Remove every event due at or before `now`
+     * @return Mask of bit(event) for the events taken
+     */
+    u32 take_due(Clock::time_point now);
+
+    /**
+     * Sleep until the earliest deadline or wake(). Only one thread (the
+     * emulation thread) may wait. May return early; callers recheck.
+     * @return true if woken by wake()
+     */
+    bool wait();
+
+    /**
+     * Make the waiting thread run a pass now. Lock-free; safe from any thread.
+     */
+    void wake() { parker_.unpark(); }
+
+    /**
+     * Cancel every deadline
+     */
+    void reset();
+
+private:
+    Clock::time_point earliest_locked() const;
+
+    mutable std::mutex mutex_;
+    std::array<Clock::time_point, static_cast<size_t>(TimelineEvent::Count)> due_;
+    Parker parker_;
+};
+
+} // namespace x360mu
@@ -266,61 +266,47 @@ static bool encode_logical_imm_impl(u64 imm, bool is_64bit, u32& n, u32& immr, u
         imm |= (imm << 32);
     }
     
-    // Count trailing zeros and ones
-    int tz = __builtin_ctzll(imm);
-    int to = __builtin_ctzll(~(imm >> tz));
-    int size = tz + to;
+    // Find the smallest power-of-2 element size the value repeats with
+    int size = 64;
+    while (size > 2) {
+        int half = size / 2;
+        u64 half_mask = (1ULL << half) - 1;
+        if ((imm & half_mask) != ((imm >> half) & half_mask)) break;
+        size = half;
+    }
     
-    // Check if pattern repeats
-    // Note: (1ULL << 64) is undefined behavior, so handle size=64 specially
     u64 mask = (size == 64) ? ~0ULL : (1ULL << size) - 1;
     u64 pattern = imm & mask;
-    
-    // Verify pattern repeats across the entire value
-    for (int i = size; i < 64; i += size) {
-        if (((imm >> i) & mask) != pattern) {
-            // Try next power of 2 element size
-            size *= 2;
-            if (size > 64) return false;
-            mask = (size == 64) ? ~0ULL : (1ULL << size) - 1;
-            pattern = imm & mask;
-            i = 0;
-        }
-    }
-    
-    // Find the rotation and element size
     int ones = __builtin_popcountll(pattern);
-    int rotation = 0;
     
-    // Find where the ones start
-    if (pattern & 1) {
-        // Pattern starts with 1, find where 0s start
-        rotation = __builtin_ctzll(~pattern);
-        // Note: shifting by 64 is undefined behavior, so handle specially
-        if (rotation > 0 && rotation < size) {
-            pattern = (pattern >> rotation) | (pattern << (size - rotation));
-            pattern &= mask;
+    // The element must be a single run of ones, possibly wrapping around.
+    // 'start' is the bit index where the run begins.
+    int start;
+    if ((pattern & 1) && ((pattern >> (size - 1)) & 1)) {
+        // Run wraps: the zeros form the contiguous run instead
+        u64 zeros = ~pattern & mask;
+        int zero_start = __builtin_ctzll(zeros);
+        int zero_count = __builtin_popcountll(zeros);
+        if ((zeros >> zero_start) != ((1ULL << zero_count) - 1)) {
+            return false; // Not a valid bitmask
+        }
+        start = zero_start + zero_count;
+    } else {
+        start = __builtin_ctzll(pattern);
+        if ((pattern >> start) != ((1ULL << ones) - 1)) {
+            return false; // Not a valid bitmask
         }
-    }
-    
-    // Verify we have a contiguous sequence of ones
-    int trailing_zeros = __builtin_ctzll(pattern);
-    int leading_zeros = 64 - size + trailing_zeros;
-    u64 check = (pattern >> trailing_zeros);
-    if (check != ((1ULL << ones) - 1)) {
-        return false; // Not a valid bitmask
     }
     
     // Encode N, immr, imms
     // N is 1 for 64-bit element size, 0 otherwise
     n = (size == 64) ? 1 : 0;
     
-    // immr is the rotation amount
-    immr = (size - rotation) & (size - 1);
+    // immr rotates the run of ones (which starts at bit 0) right into place
+    immr = (size - start) & (size - 1);
     
     // imms encodes both element size and number of ones
     // High bits encode element size (inverted), low bits encode ones-1
-    int len = 31 - __builtin_clz(size);
     imms = ((~(size - 1) << 1) & 0x3F) | (ones - 1);
     
     return true;
@@ -635,6 +621,12 @@ void ARM64Emitter::LDP(int rt1, int rt2, int rn, s32 offset) {
     emit32(0xA9400000 | ((imm7 & 0x7F) << 15) | (rt2 << 10) | (rn << 5) | rt1);
 }
 
+void ARM64Emitter::LDP_u32(int rt1, int rt2, int rn, s32 offset) {
+    // LDP Wt1, Wt2, [Xn, #offset] - offset scaled by 4, range -256..252
+    s32 imm7 = offset >> 2;
+    emit32(0x29400000 | ((imm7 & 0x7F) << 15) | (rt2 << 10) | (rn << 5) | rt1);
+}
+
 void ARM64Emitter::STR(int rt, int rn, s32 offset) {
     if (offset >= 0 && offset < 32760 && (offset & 7) == 0) {
         emit32(0xF9000000 | ((offset >> 3) << 10) | (rn << 5) | rt);
@@ -662,6 +654,16 @@ void ARM64Emitter::STR_u32(int rt, int rn, s32 offset) {
     }
 }
 
+void ARM64Emitter::LDXR_32(int rt, int rn) {
+    // LDXR Wt, [Xn]
+    emit32(0x885F7C00 | (rn << 5) | rt);
+}
+
+void ARM64Emitter::STXR_32(int rs, int rt, int rn) {
+    // STXR Ws, Wt, [Xn] - Ws = 0 if the store succeeded
+    emit32(0x88007C00 | (rs << 16) | (rn << 5) | rt);
+}
+
 void ARM64Emitter::STRB(int rt, int rn, s32 offset) {
     if (offset >= 0 && offset < 4096) {
         emit32(0x39000000 | (offset << 10) | (rn << 5) | rt);
@@ -691,6 +693,12 @@ void ARM64Emitter::STP(int rt1, int rt2, int rn, s32 offset) {
     emit32(0xA9000000 | ((imm7 & 0x7F) << 15) | (rt2 << 10) | (rn << 5) | rt1);
 }
 
+void ARM64Emitter::STP_u32(int rt1, int rt2, int rn, s32 offset) {
+    // STP Wt1, Wt2, [Xn, #offset] - offset scaled by 4, range -256..252
+    s32 imm7 = offset >> 2;
+    emit32(0x29000000 | ((imm7 & 0x7F) << 15) | (rt2 << 10) | (rn << 5) | rt1);
+}
+
 void ARM64Emitter::LDR_pre(int rt, int rn, s32 offset) {
     emit32(0xF8400C00 | ((offset & 0x1FF) << 12) | (rn << 5) | rt);
 }
@@ -1194,5 +1202,10 @@ void ARM64Emitter::ROR_32(int rd, int rn, int rm) {
     emit32(0x1AC02C00 | (rm << 16) | (rn << 5) | rd);
 }
 
+void ARM64Emitter::REV_32(int rd, int rn) {
+    // REV Wd, Wn - byte-reverse the low word, upper 32 bits cleared
+    emit32(0x5AC00800 | (rn << 5) | rd);
+}
+
 } // namespace x360mu
 
@@ -15,8 +15,10 @@
 #include <unordered_map>
 #include <vector>
 #include <mutex>
+#include <shared_mutex>
 #include <bitset>
 #include <array>
+#include <atomic>
 
 #ifdef __aarch64__
 #include <sys/mman.h>
@@ -143,7 +145,7 @@ struct CompiledBlock {
     void* code;                     // Pointer to compiled ARM64 code
     u32 code_size;                  // Size of ARM64 code in bytes
     u64 hash;                       // Hash of original PPC code for SMC detection
-    u32 execution_count;            // For hot block tracking
+    std::atomic<u32> execution_count{0};  // For hot block tracking (relaxed, any thread)
     u32 linked_entry_offset;        // Offset past prologue for linked block entry
     bool is_idle_loop;              // Block detected as an idle/spin loop
     std::vector<GuestAddr> exits;   // Block exit addresses
@@ -157,6 +159,14 @@ struct CompiledBlock {
     };
     std::vector<Link> links;
     
+    // Per-instruction profile data (only filled while a profiler is attached)
+    struct ProfiledInst {
+        u32 key;                    // OpcodeProfiler::opcode_key()
+        u32 raw;                    // PPC instruction word
+        bool fallback;              // Hit the default: fallback in compile_instruction
+    };
+    std::vector<ProfiledInst> profile;
+    
     // Block cache management (used by BlockCache)
     CompiledBlock* hash_next = nullptr;  // Hash chain
     CompiledBlock* hash_prev = nullptr;
@@ -169,6 +179,23 @@ struct CompiledBlock {
     }
 };
 
+/**
+ * Dispatch table entry
+ *
+ * The dispatch table is a direct-mapped cache (guest PC -> host code) that the
+ * generated dispatcher probes inline, so the common case never takes
+ * block_map_mutex_. Entries are written under the block map lock and read
+ * lock-free: the writer clears pc, fills block/cycles, then publishes pc.
+ * The dispatcher reads the host entry point through the block, so it can
+ * count the execution on the way in.
+ */
+struct DispatchEntry {
+    std::atomic<u32> pc{0};         // Guest PC (0 = empty slot)
+    std::atomic<u32> cycles{0};     // Block size in PPC instructions
+    std::atomic<CompiledBlock*> block{nullptr};
+};
+static_assert(sizeof(DispatchEntry) == 16, "dispatcher indexes entries with LSL #4");
+
 /**
  * ARM64 code emitter
  */
@@ -277,6 +304,7 @@ public:
     void LDRSW(int rt, int rn, s32 offset = 0);
     void LDR_reg(int rt, int rn, int rm, int extend = 0, bool shift = false);
     void LDP(int rt1, int rt2, int rn, s32 offset = 0);
+    void LDP_u32(int rt1, int rt2, int rn, s32 offset = 0);  // 32-bit pair load (zero-extends)
     
     void STR(int rt, int rn, s32 offset = 0);
     void STR_u32(int rt, int rn, s32 offset = 0);  // 32-bit store
@@ -284,6 +312,11 @@ public:
     void STRH(int rt, int rn, s32 offset = 0);
     void STR_reg(int rt, int rn, int rm, int extend = 0, bool shift = false);
     void STP(int rt1, int rt2, int rn, s32 offset = 0);
+    void STP_u32(int rt1, int rt2, int rn, s32 offset = 0);  // 32-bit pair store
+    
+    // Load/Store exclusive (32-bit, no offset)
+    void LDXR_32(int rt, int rn);
+    void STXR_32(int rs, int rt, int rn);      // rs = 0 on success
     
     // Load/Store pre/post-index
     void LDR_pre(int rt, int rn, s32 offset);
@@ -390,6 +423,7 @@ public:
     void LSR_32(int rd, int rn, int rm);
     void ASR_32(int rd, int rn, int rm);
     void ROR_32(int rd, int rn, int rm);
+    void REV_32(int rd, int rn);  // REV Wd, Wn (zero-extends to 64-bit)
     
     // Address manipulation
     void ADR(int rd, s32 offset);
@@ -455,7 +489,7 @@ public:
      */
     struct Stats {
         u64 blocks_compiled;
-        u64 code_bytes_used;
+        u64 code_bytes_used;        // Code of live blocks (arena space is reclaimed only on reset)
         u64 cache_hits;
         u64 cache_misses;
         u64 instructions_executed;
@@ -463,8 +497,15 @@ public:
         u64 blocks_linked;
         u64 idle_loops_detected;
         u64 idle_loops_skipped;
+        u64 dispatch_hits;          // Blocks entered via the inline table probe
+        u64 dispatch_misses;        // Probes that fell back to lookup_block_for_dispatch
     };
-    Stats get_stats() const { return stats_; }
+    Stats get_stats() const {
+        Stats s = stats_;
+        s.dispatch_hits = dispatch_hits_.load(std::memory_order_relaxed);
+        s.dispatch_misses = dispatch_misses_.load(std::memory_order_relaxed);
+        return s;
+    }
     
     /**
      * Flush entire cache
@@ -472,7 +513,7 @@ public:
     void flush_cache();
     
     /**
-     * Look up block for dispatch (called from JIT code)
+     * Look up block for dispatch (dispatch table miss path)
      */
     void* lookup_block_for_dispatch(GuestAddr pc);
     
@@ -481,16 +522,50 @@ public:
      */
     u8* get_memory_base() const;
     
+    /**
+     * Attach an opcode profiler (nullptr to detach). While attached, blocks
+     * run through execute()'s C++ loop unlinked so every execution is
+     * counted; only blocks compiled after attaching carry per-instruction data.
+     */
+    void set_profiler(OpcodeProfiler* profiler) {
+        profiler_.store(profiler, std::memory_order_release);
+    }
+    
 private:
-    // Compile without locking (lock must be held)
+    // Compile without holding block_map_mutex_ (code_arena_mutex_ must be held
+    // shared). Returns nullptr if the code arena is exhausted.
     CompiledBlock* compile_block_unlocked(GuestAddr addr);
+    
+    // Insert a freshly compiled block, or return the block another thread
+    // published for the same address first (lock must be held)
+    CompiledBlock* publish_block(CompiledBlock* block);
     Memory* memory_ = nullptr;
     
     // Code cache - executable memory region
     u8* code_cache_ = nullptr;
-    u8* code_write_ptr_ = nullptr;
+    u8* code_write_ptr_ = nullptr;  // End of dispatcher/exit stub (start of arena)
     size_t cache_size_ = 0;
     
+    // Code arena for compiled blocks. Each compiling thread carves fixed-size
+    // chunks off the arena with an atomic bump and emits into its own chunk,
+    // so compilation runs in parallel. Resetting the arena takes
+    // code_arena_mutex_ exclusively; compilation holds it shared.
+    static constexpr size_t CODE_CHUNK_SIZE = 64 * 1024;
+    struct CodeChunk {
+        u32 generation = 0;                      // Arena generation (globally unique)
+        u8* cur = nullptr;
+        u8* end = nullptr;
+    };
+    static thread_local CodeChunk tls_code_chunk_;
+    size_t code_chunk_size_ = CODE_CHUNK_SIZE;
+    std::atomic<size_t> code_arena_next_{0};     // Offset of next free chunk
+    std::atomic<u32> code_arena_generation_{0};  // Renewed on every reset
+    std::shared_mutex code_arena_mutex_;
+    std::vector<CompiledBlock*> retired_blocks_;  // Freed on the following reset
+    std::vector<CompiledBlock*> invalidated_blocks_;  // Retired at the next reset (block map lock)
+    u8* alloc_code(size_t size);
+    void reset_code_arena();                     // Both locks must be held
+    
     // Block lookup (PPC address -> compiled block)
     std::unordered_map<GuestAddr, CompiledBlock*> block_map_;
     std::mutex block_map_mutex_;
@@ -501,12 +576,17 @@ private:
     
     // Statistics
     Stats stats_ = {};
+    std::atomic<OpcodeProfiler*> profiler_{nullptr};
     
-    // Register allocator
-    RegisterAllocator reg_alloc_;
+    // Counters gathered while compiling on this thread; folded into stats_
+    // when the block is published
+    static thread_local Stats tls_compile_stats_;
+    
+    // Register allocator (per compiling thread)
+    static thread_local RegisterAllocator reg_alloc_;
     
     // Current instruction count during block compilation (for time_base tracking)
-    u32 current_block_inst_count_ = 0;
+    static thread_local u32 current_block_inst_count_;
     
     // Compile a single block
     CompiledBlock* compile_block(GuestAddr addr);
@@ -608,6 +688,14 @@ private:
     // Helper: Translate virtual address to physical and add fastmem base
     void emit_translate_address(ARM64Emitter& emit, int addr_reg);
     
+    // Helper: Report the masked address in X0 to the memory heatmap. Emits
+    // nothing unless a heatmap was recording when the block was compiled.
+    void emit_heatmap_sample(ARM64Emitter& emit, bool is_store);
+
+    // Helper: After a fastmem store to host_addr, break any reservations on
+    // the granules it touched. Costs a barrier and a load while none are held.
+    void emit_reservation_invalidate(ARM64Emitter& emit, int host_addr, u32 size);
+
     // Helper: Memory byte swap (big-endian to little-endian)
     void byteswap32(ARM64Emitter& emit, int reg);
     void byteswap16(ARM64Emitter& emit, int reg);
@@ -625,10 +713,27 @@ private:
     // Idle loop detection
     bool detect_idle_loop(GuestAddr addr, u32 inst_count);
     
-    // Dispatcher
-    using DispatcherFunc = void(*)(ThreadContext* ctx, void* jit);
+    // Dispatcher: runs blocks found in the dispatch table until the cycle
+    // budget is spent, the thread stops, or a probe misses. Returns cycles run.
+    using DispatcherFunc = u64(*)(ThreadContext* ctx, u64 cycle_budget);
     DispatcherFunc dispatcher_ = nullptr;
     void generate_dispatcher();
+
+    // Direct-mapped dispatch table (probed from generated code)
+    static constexpr u32 DISPATCH_TABLE_BITS = 16;
+    static constexpr u32 DISPATCH_TABLE_SIZE = 1u << DISPATCH_TABLE_BITS;
+    static constexpr u32 DISPATCH_TABLE_MASK = DISPATCH_TABLE_SIZE - 1;
+    static constexpr u32 dispatch_index(GuestAddr pc) {
+        return (pc >> 2) & DISPATCH_TABLE_MASK;
+    }
+    std::unique_ptr<DispatchEntry[]> dispatch_table_;
+    // Totals over all threads. The dispatcher counts into the calling
+    // thread's ThreadContext; execute() folds those in after it returns.
+    std::atomic<u64> dispatch_hits_{0};
+    std::atomic<u64> dispatch_misses_{0};
+    void publish_dispatch_entry(CompiledBlock* block);  // Lock must be held
+    void remove_dispatch_entry(CompiledBlock* block);   // Lock must be held
+    void clear_dispatch_table();                        // Lock must be held
     
     // Exit stub (return to dispatcher)
     void* exit_stub_ = nullptr;
@@ -676,6 +781,18 @@ private:
     static constexpr size_t ctx_offset_fpscr() {
         return offsetof(ThreadContext, fpscr);
     }
+    static constexpr size_t ctx_offset_running() {
+        return offsetof(ThreadContext, running);
+    }
+    static constexpr size_t ctx_offset_interrupted() {
+        return offsetof(ThreadContext, interrupted);
+    }
+    static constexpr size_t ctx_offset_dispatch_hits() {
+        return offsetof(ThreadContext, dispatch_hits);
+    }
+    static constexpr size_t ctx_offset_dispatch_misses() {
+        return offsetof(ThreadContext, dispatch_misses);
+    }
 };
 
 // ARM64 condition codes
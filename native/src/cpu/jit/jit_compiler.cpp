@@ -9,7 +9,9 @@
 
 #include "jit.h"
 #include "../../memory/memory.h"
+#include "../../memory/heatmap.h"
 #include "../xenon/cpu.h"
+#include "../xenon/profiler.h"
 #include "x360mu/feature_flags.h"
 #include <thread>
 #include <unordered_map>
@@ -141,8 +143,8 @@ extern "C" void jit_trace_original_addr(GuestAddr original_addr, GuestAddr maske
     }
 }
 
-extern "C" void jit_trace_all_access(GuestAddr addr, u32 is_store) {
-    // Kept for compatibility but not used
+extern "C" void jit_heatmap_sample(void* heatmap, GuestAddr addr, u32 is_store) {
+    static_cast<MemoryHeatmap*>(heatmap)->record(addr, is_store != 0, false);
 }
 
 extern "C" void jit_mmio_write_u32(void* mem, GuestAddr addr, u32 value) {
@@ -160,6 +162,25 @@ extern "C" void jit_mmio_write_u64(void* mem, GuestAddr addr, u64 value) {
     static_cast<Memory*>(mem)->write_u64(addr, value);
 }
 
+// lwarx/stwcx. go through the shared granule reservation table so JIT and
+// interpreter threads see each other's reservations and stores
+extern "C" u32 jit_lwarx(void* mem, u32 thread_id, GuestAddr addr) {
+    auto* memory = static_cast<Memory*>(mem);
+    memory->set_reservation(thread_id, addr, 4);
+    return memory->read_u32(addr);
+}
+
+extern "C" u32 jit_stwcx(void* mem, u32 thread_id, GuestAddr addr, u32 value) {
+    auto* memory = static_cast<Memory*>(mem);
+    bool success = memory->store_conditional(thread_id, addr, 4, value);
+    memory->clear_reservation(thread_id);
+    return success ? 1 : 0;
+}
+
+extern "C" void jit_invalidate_reservations(void* mem, GuestAddr addr, u32 size) {
+    static_cast<Memory*>(mem)->invalidate_reservations(addr, size);
+}
+
 extern "C" u8 jit_mmio_read_u8(void* mem, GuestAddr addr) {
     return static_cast<Memory*>(mem)->read_u8(addr);
 }
@@ -301,6 +322,16 @@ int RegisterAllocator::cached_ppc_reg(int slot) const {
 // JIT Compiler Core
 //=============================================================================
 
+// Per-thread compilation state
+thread_local JitCompiler::CodeChunk JitCompiler::tls_code_chunk_;
+thread_local JitCompiler::Stats JitCompiler::tls_compile_stats_ = {};
+thread_local RegisterAllocator JitCompiler::reg_alloc_;
+thread_local u32 JitCompiler::current_block_inst_count_ = 0;
+
+// Arena generations are unique across all JitCompiler instances, so a
+// thread's cached chunk can never be mistaken for one in a new arena
+static std::atomic<u32> g_code_arena_generations{0};
+
 JitCompiler::JitCompiler() = default;
 
 JitCompiler::~JitCompiler() {
@@ -343,10 +374,22 @@ Status JitCompiler::initialize(Memory* memory, u64 cache_size) {
     
     code_write_ptr_ = code_cache_;
     
+    // Dispatch table must exist before the dispatcher bakes in its address
+    dispatch_table_ = std::make_unique<DispatchEntry[]>(DISPATCH_TABLE_SIZE);
+    
     // Generate dispatcher and exit stub
     generate_dispatcher();
     generate_exit_stub();
     
+    // Compiled blocks are carved from the rest of the cache
+    code_arena_next_.store(code_write_ptr_ - code_cache_, std::memory_order_relaxed);
+    code_arena_generation_.store(g_code_arena_generations.fetch_add(1) + 1,
+                                 std::memory_order_release);
+    
+    // Small caches still get enough chunks to go around several threads
+    size_t arena_size = cache_size_ - (code_write_ptr_ - code_cache_);
+    code_chunk_size_ = std::min(CODE_CHUNK_SIZE, (arena_size / 16) & ~static_cast<size_t>(15));
+    
     LOGI("JIT initialized with %lluMB cache", (unsigned long long)(cache_size / (1024 * 1024)));
     return Status::Ok;
 }
@@ -359,6 +402,15 @@ void JitCompiler::shutdown() {
             delete block;
         }
         block_map_.clear();
+        for (CompiledBlock* block : retired_blocks_) {
+            delete block;
+        }
+        retired_blocks_.clear();
+        for (CompiledBlock* block : invalidated_blocks_) {
+            delete block;
+        }
+        invalidated_blocks_.clear();
+        dispatch_table_.reset();
     }
     
     // Free code cache
@@ -401,6 +453,21 @@ u64 JitCompiler::execute(ThreadContext& ctx, u64 cycles) {
                 break;
             }
             
+            // Fast path: the generated dispatcher chains through blocks that
+            // hit in the dispatch table and only returns here on a miss.
+            // Block tracing and profiling need the per-block hooks below.
+            OpcodeProfiler* profiler = profiler_.load(std::memory_order_acquire);
+            if (!profiler && !FeatureFlags::jit_trace_blocks.load(std::memory_order_relaxed)) {
+                cycles_executed += dispatcher_(&ctx, cycles - cycles_executed);
+                dispatch_hits_.fetch_add(ctx.dispatch_hits, std::memory_order_relaxed);
+                dispatch_misses_.fetch_add(ctx.dispatch_misses, std::memory_order_relaxed);
+                ctx.dispatch_hits = 0;
+                ctx.dispatch_misses = 0;
+                if (!ctx.running || ctx.interrupted || cycles_executed >= cycles || ctx.pc == 0) {
+                    continue;
+                }
+            }
+            
             // Look up or compile block
             CompiledBlock* block = compile_block(ctx.pc);
             if (!block) {
@@ -426,7 +493,8 @@ u64 JitCompiler::execute(ThreadContext& ctx, u64 cycles) {
             
             // Idle loop optimization: if this block is an idle loop that has
             // been executed many times, advance time base and yield CPU
-            if (block->is_idle_loop && block->execution_count > 10) {
+            if (block->is_idle_loop &&
+                block->execution_count.load(std::memory_order_relaxed) > 10) {
                 ctx.time_base += 4000;  // Skip ~1000 instructions worth of time
                 cycles_executed += 1000;
                 stats_.idle_loops_skipped++;
@@ -438,7 +506,19 @@ u64 JitCompiler::execute(ThreadContext& ctx, u64 cycles) {
             fn(&ctx, nullptr);
 
             cycles_executed += block->size;
-            block->execution_count++;
+            block->execution_count.fetch_add(1, std::memory_order_relaxed);
+            
+            if (profiler) {
+                profiler->record_block(block->start_addr, block->size, block->size);
+                GuestAddr inst_pc = block->start_addr;
+                for (const auto& inst : block->profile) {
+                    profiler->record_instruction(inst.key, inst.raw);
+                    if (inst.fallback) {
+                        profiler->record_fallback(inst_pc, inst.raw);
+                    }
+                    inst_pc += 4;
+                }
+            }
         }
     }
 #else
@@ -461,8 +541,12 @@ void JitCompiler::invalidate(GuestAddr addr, u32 size) {
         
         if (block->start_addr < end_addr && block->end_addr > addr) {
             // Block overlaps with invalidated region
+            // A dispatcher or execute() may already be running it; free the
+            // struct after the next arena reset, like reset_code_arena() does
+            remove_dispatch_entry(block);
             unlink_block(block);
-            delete block;
+            stats_.code_bytes_used -= block->code_size;
+            invalidated_blocks_.push_back(block);
             it = block_map_.erase(it);
         } else {
             ++it;
@@ -471,40 +555,133 @@ void JitCompiler::invalidate(GuestAddr addr, u32 size) {
 }
 
 void JitCompiler::flush_cache() {
+    std::unique_lock<std::shared_mutex> arena_lock(code_arena_mutex_);
     std::lock_guard<std::mutex> lock(block_map_mutex_);
     
-    for (auto& [addr, block] : block_map_) {
-        delete block;
-    }
-    block_map_.clear();
-    
-    // Reset code write pointer (leave room for dispatcher)
-    code_write_ptr_ = code_cache_ + 4096;
+    reset_code_arena();
     stats_ = {};
+    dispatch_hits_.store(0, std::memory_order_relaxed);
+    dispatch_misses_.store(0, std::memory_order_relaxed);
 }
 
 CompiledBlock* JitCompiler::compile_block(GuestAddr addr) {
-    std::lock_guard<std::mutex> lock(block_map_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(block_map_mutex_);
+        
+        // Check cache first
+        auto it = block_map_.find(addr);
+        if (it != block_map_.end()) {
+            stats_.cache_hits++;
+            // The slot may have been taken by a colliding PC since publication
+            publish_dispatch_entry(it->second);
+            return it->second;
+        }
+        
+        stats_.cache_misses++;
+    }
+    
+    // Compile outside block_map_mutex_ so threads hitting new code at the
+    // same time only serialize on publication
+    for (int attempt = 0; attempt < 2; attempt++) {
+        u32 generation;
+        {
+            std::shared_lock<std::shared_mutex> arena_lock(code_arena_mutex_);
+            generation = code_arena_generation_.load(std::memory_order_acquire);
+            
+            CompiledBlock* block = compile_block_unlocked(addr);
+            if (block) {
+                std::lock_guard<std::mutex> lock(block_map_mutex_);
+                return publish_block(block);
+            }
+        }
+        
+        // Arena exhausted: flush unless another thread already did
+        std::unique_lock<std::shared_mutex> arena_lock(code_arena_mutex_);
+        std::lock_guard<std::mutex> lock(block_map_mutex_);
+        if (code_arena_generation_.load(std::memory_order_relaxed) == generation) {
+            LOGE("JIT code cache overflow! Flushing cache.");
+            reset_code_arena();
+        }
+    }
     
-    // Check cache first
-    auto it = block_map_.find(addr);
+    return nullptr;
+}
+
+CompiledBlock* JitCompiler::publish_block(CompiledBlock* block) {
+    auto it = block_map_.find(block->start_addr);
     if (it != block_map_.end()) {
-        stats_.cache_hits++;
+        // Another thread published this address first; our arena space is
+        // simply abandoned until the next reset
+        delete block;
+        tls_compile_stats_ = {};
         return it->second;
     }
     
-    stats_.cache_misses++;
-    
-    CompiledBlock* block = compile_block_unlocked(addr);
+    // Add to cache
+    block_map_[block->start_addr] = block;
     
-    // Try to link this block to others
-    if (block) {
+    stats_.blocks_compiled++;
+    stats_.code_bytes_used += block->code_size;
+    stats_.instructions_executed += tls_compile_stats_.instructions_executed;
+    stats_.interpreter_fallbacks += tls_compile_stats_.interpreter_fallbacks;
+    stats_.idle_loops_detected += tls_compile_stats_.idle_loops_detected;
+    tls_compile_stats_ = {};
+    
+    // Try to link this block to others. Linked exits bypass execute(), so
+    // leave blocks unlinked while profiling.
+    if (!profiler_.load(std::memory_order_relaxed)) {
         try_link_block(block);
     }
+    publish_dispatch_entry(block);
     
     return block;
 }
 
+u8* JitCompiler::alloc_code(size_t size) {
+    size = (size + 15) & ~static_cast<size_t>(15);
+    
+    CodeChunk& chunk = tls_code_chunk_;
+    u32 generation = code_arena_generation_.load(std::memory_order_acquire);
+    if (chunk.generation != generation ||
+        static_cast<size_t>(chunk.end - chunk.cur) < size) {
+        // Grab a fresh chunk; oversized blocks get a chunk of their own
+        size_t chunk_size = std::max(code_chunk_size_, size);
+        size_t offset = code_arena_next_.fetch_add(chunk_size, std::memory_order_relaxed);
+        if (offset + chunk_size > cache_size_) {
+            return nullptr;
+        }
+        chunk.generation = generation;
+        chunk.cur = code_cache_ + offset;
+        chunk.end = chunk.cur + chunk_size;
+    }
+    
+    u8* code = chunk.cur;
+    chunk.cur += size;
+    return code;
+}
+
+void JitCompiler::reset_code_arena() {
+    // Other threads may still hold a block returned by compile_block() from
+    // before this reset, so keep the structs alive until the next one
+    for (CompiledBlock* block : retired_blocks_) {
+        delete block;
+    }
+    retired_blocks_.clear();
+    retired_blocks_.swap(invalidated_blocks_);
+    for (auto& [addr, block] : block_map_) {
+        retired_blocks_.push_back(block);
+    }
+    block_map_.clear();
+    clear_dispatch_table();
+    stats_.code_bytes_used = 0;
+    
+    // Reset the arena to just past the dispatcher; every thread's cached
+    // chunk goes stale with the new generation
+    code_arena_next_.store(code_write_ptr_ - code_cache_, std::memory_order_relaxed);
+    code_arena_generation_.store(g_code_arena_generations.fetch_add(1) + 1,
+                                 std::memory_order_release);
+}
+
 bool JitCompiler::is_block_ending(const DecodedInst& inst) const {
     switch (inst.type) {
         case DecodedInst::Type::Branch:
@@ -700,7 +877,7 @@ void JitCompiler::compile_instruction(ARM64Emitter& emit, ThreadContext& ctx_tem
             break;
             
         case DecodedInst::Type::DCBZ:
-            // Data Cache Block Zero - zeros 32 bytes aligned to 32-byte boundary
+            // Data Cache Block Zero - 32-byte block, or 128-byte line for dcbz128
             compile_dcbz(emit, inst);
             break;
 
@@ -718,11 +895,11 @@ void JitCompiler::compile_instruction(ARM64Emitter& emit, ThreadContext& ctx_tem
         default:
             // Fallback: NOP for unknown instructions
             emit.NOP();
-            stats_.interpreter_fallbacks++;
+            tls_compile_stats_.interpreter_fallbacks++;
             break;
     }
     
-    stats_.instructions_executed++;
+    tls_compile_stats_.instructions_executed++;
 }
 
 //=============================================================================
@@ -1498,25 +1675,7 @@ void JitCompiler::compile_load(ARM64Emitter& emit, const DecodedInst& inst) {
     emit.MOV_imm(arm64::X16, 0x1FFFFFFFULL);
     emit.AND(arm64::X0, arm64::X0, arm64::X16);
     
-    // DEBUG: Trace the masked address before fastmem access
-    // If we still crash, this will show what addresses reach fastmem
-    {
-        emit.SUB_imm(arm64::SP, arm64::SP, 48);
-        emit.STP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.STP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.STP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        
-        // X0 = masked addr, X1 = is_store (0 for load)
-        emit.MOV_imm(arm64::X1, 0);
-        u64 trace_func = reinterpret_cast<u64>(&jit_trace_all_access);
-        emit.MOV_imm(arm64::X16, trace_func);
-        emit.BLR(arm64::X16);
-        
-        emit.LDP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.LDP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.LDP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.ADD_imm(arm64::SP, arm64::SP, 48);
-    }
+    emit_heatmap_sample(emit, false);
     
     // === FASTMEM PATH for loads ===
     // X0 now contains physical address in range 0x00000000-0x1FFFFFFF
@@ -1622,10 +1781,47 @@ void JitCompiler::compile_load(ARM64Emitter& emit, const DecodedInst& inst) {
     u8* skip_mmio_load = emit.current();
     emit.B(0);
     
+    // === SHADOW REGISTER PATH for 32-bit GPU register loads ===
+    // Status registers the GPU publishes to Memory's shadow page are read
+    // straight from it; unpublished registers fall through to the helper
+    bool is_word_load = inst.opcode == 32 || inst.opcode == 33 ||
+                        (inst.opcode == 31 && (inst.xo == 23 || inst.xo == 55));
+    u8* shadow_hit = nullptr;
+    if (is_word_load && memory_) {
+        emit.patch_branch(reinterpret_cast<u32*>(is_gpu_mmio), emit.current());
+        
+        // X16 = register index = (EA - 0x7FC00000) >> 2
+        emit.MOV_imm(arm64::X16, memory::GPU_REGS_BASE);
+        emit.SUB(arm64::X16, arm64::X2, arm64::X16);
+        emit.LSR_imm(arm64::X16, arm64::X16, 2);
+        emit.MOV_imm(arm64::X17, Memory::SHADOW_REGISTER_COUNT);
+        emit.CMP(arm64::X16, arm64::X17);
+        u8* beyond_shadow = emit.current();
+        emit.B_cond(arm64_cond::CS, 0);
+        
+        // X16 = shadow[index]; published entries have bit 32 set
+        emit.MOV_imm(arm64::X17, reinterpret_cast<u64>(memory_->register_shadow()));
+        emit.LDR_reg(arm64::X16, arm64::X17, arm64::X16, 0, true);
+        emit.LSR_imm(arm64::X17, arm64::X16, 32);
+        emit.CMP(arm64::X17, arm64::XZR);
+        u8* not_published = emit.current();
+        emit.B_cond(arm64_cond::EQ, 0);
+        
+        emit.UXTW(arm64::X1, arm64::X16);
+        shadow_hit = emit.current();
+        emit.B(0);
+        
+        is_gpu_mmio = emit.current();  // Misses continue on the MMIO path below
+        emit.patch_branch(reinterpret_cast<u32*>(beyond_shadow), is_gpu_mmio);
+        emit.patch_branch(reinterpret_cast<u32*>(not_published), is_gpu_mmio);
+    }
+    
     // === MMIO PATH for loads ===
     // Kernel addresses (>= 0xA0000000) and GPU MMIO (0x7FC00000-0x7FFFFFFF) land here
     emit.patch_branch(reinterpret_cast<u32*>(kernel_space_load), emit.current());
-    emit.patch_branch(reinterpret_cast<u32*>(is_gpu_mmio), emit.current());
+    if (!shadow_hit) {
+        emit.patch_branch(reinterpret_cast<u32*>(is_gpu_mmio), emit.current());
+    }
     
     // Call helper function with original virtual address (X2)
     // jit_mmio_read_XX(memory, addr) returns value - Memory class handles routing
@@ -1678,6 +1874,9 @@ void JitCompiler::compile_load(ARM64Emitter& emit, const DecodedInst& inst) {
     
     // === DONE ===
     emit.patch_branch(reinterpret_cast<u32*>(skip_mmio_load), emit.current());
+    if (shadow_hit) {
+        emit.patch_branch(reinterpret_cast<u32*>(shadow_hit), emit.current());
+    }
     
     store_gpr(emit, inst.rd, arm64::X1);
     
@@ -1922,6 +2121,7 @@ void JitCompiler::compile_store(ARM64Emitter& emit, const DecodedInst& inst) {
         emit.LDP(arm64::X0, arm64::X1, arm64::SP, 0);
         emit.ADD_imm(arm64::SP, arm64::SP, 64);
     }
+    emit_heatmap_sample(emit, true);
     
     // Reload value since we may have clobbered X1 in MMIO path setup
     load_gpr(emit, arm64::X1, inst.rs);
@@ -1931,6 +2131,7 @@ void JitCompiler::compile_store(ARM64Emitter& emit, const DecodedInst& inst) {
     emit.ADD(arm64::X0, arm64::X0, arm64::X16);
     
     // Store based on opcode
+    u32 store_size = 8;  // bytes actually written by the host store
     switch (inst.opcode) {
         case 36: // stw
         case 37: // stwu
@@ -1940,11 +2141,13 @@ void JitCompiler::compile_store(ARM64Emitter& emit, const DecodedInst& inst) {
         case 38: // stb
         case 39: // stbu
             emit.STRB(arm64::X1, arm64::X0);
+            store_size = 1;
             break;
         case 44: // sth
         case 45: // sthu
             byteswap16(emit, arm64::X1);
             emit.STRH(arm64::X1, arm64::X0);
+            store_size = 2;
             break;
         case 52: // stfs
         case 53: // stfsu
@@ -1965,10 +2168,12 @@ void JitCompiler::compile_store(ARM64Emitter& emit, const DecodedInst& inst) {
                     break;
                 case 215: // stbx
                     emit.STRB(arm64::X1, arm64::X0);
+                    store_size = 1;
                     break;
                 case 407: // sthx
                     byteswap16(emit, arm64::X1);
                     emit.STRH(arm64::X1, arm64::X0);
+                    store_size = 2;
                     break;
                 case 149: // stdx
                     byteswap64(emit, arm64::X1);
@@ -1985,6 +2190,7 @@ void JitCompiler::compile_store(ARM64Emitter& emit, const DecodedInst& inst) {
                     break;
                 case 918: // sthbrx (store halfword byte-reverse indexed)
                     emit.STRH(arm64::X1, arm64::X0);
+                    store_size = 2;
                     break;
                 case 660: // stdbrx (store doubleword byte-reverse indexed)
                     emit.STR(arm64::X1, arm64::X0);
@@ -1992,6 +2198,7 @@ void JitCompiler::compile_store(ARM64Emitter& emit, const DecodedInst& inst) {
             }
             break;
     }
+    emit_reservation_invalidate(emit, arm64::X0, store_size);
     
     // === DONE ===
     // Patch skip_fastmem branch to here
@@ -2004,6 +2211,10 @@ void JitCompiler::compile_store(ARM64Emitter& emit, const DecodedInst& inst) {
 }
 
 void JitCompiler::compile_load_multiple(ARM64Emitter& emit, const DecodedInst& inst) {
+    // lmw rD, d(rA) - loads rD..r31 from consecutive big-endian words.
+    // Fastmem path moves two words per LDP and byte-swaps each with a 32-bit REV.
+    const u32 run_bytes = (32 - inst.rd) * 4;
+    
     calc_ea(emit, arm64::X0, inst.ra, inst.simm);
     
     // Save original EA for slow path
@@ -2033,49 +2244,46 @@ void JitCompiler::compile_load_multiple(ARM64Emitter& emit, const DecodedInst& i
     emit.MOV_imm(arm64::X16, 0x1FFFFFFFULL);
     emit.AND(arm64::X0, arm64::X0, arm64::X16);
     
-    // DEBUG: Trace the masked address before fastmem access (lmw)
-    {
-        emit.SUB_imm(arm64::SP, arm64::SP, 48);
-        emit.STP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.STP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.STP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.MOV_imm(arm64::X1, 0);  // is_store = false (lmw is load)
-        u64 trace_func = reinterpret_cast<u64>(&jit_trace_all_access);
-        emit.MOV_imm(arm64::X16, trace_func);
-        emit.BLR(arm64::X16);
-        emit.LDP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.LDP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.LDP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.ADD_imm(arm64::SP, arm64::SP, 48);
-    }
+    // A run that would cross the end of the 512MB window has to wrap per word
+    // (0x1FFFFFC0 + 64 -> 0x00000000), so leave it to the slow path
+    emit.ADD_imm(arm64::X3, arm64::X0, run_bytes);
+    emit.MOV_imm(arm64::X16, 0x20000000ULL);
+    emit.CMP(arm64::X3, arm64::X16);
+    u8* wraps = emit.current();
+    emit.B_cond(arm64_cond::HI, 0);
     
-    // Fastmem path - address is in main RAM (< 0x20000000 after masking)
-    // CRITICAL FIX: Must mask EACH address including offset to avoid overflow past 512MB
-    // Xbox 360 memory wraps, so 0x1FFFFFC0 + 64 should wrap to 0x00000000 not crash at 0x20000000
-    for (u32 r = inst.rd; r < 32; r++) {
-        // Calculate full address = base + offset
-        emit.ADD_imm(arm64::X3, arm64::X0, (r - inst.rd) * 4);
-        // Mask to 512MB to handle wrap-around
-        emit.MOV_imm(arm64::X16, 0x1FFFFFFFULL);
-        emit.AND(arm64::X3, arm64::X3, arm64::X16);
-        // Add fastmem base
-        emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(fastmem_base_));
-        emit.ADD(arm64::X3, arm64::X3, arm64::X16);
-        // Load from masked address
-        emit.LDR(arm64::X1, arm64::X3);
-        byteswap32(emit, arm64::X1);
+    emit_heatmap_sample(emit, false);
+    
+    // Fastmem path - whole run is inside main RAM
+    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(fastmem_base_));
+    emit.ADD(arm64::X3, arm64::X0, arm64::X16);
+    
+    u32 r = inst.rd;
+    for (; r + 1 < 32; r += 2) {
+        s32 offset = static_cast<s32>((r - inst.rd) * 4);
+        emit.LDP_u32(arm64::X1, arm64::X4, arm64::X3, offset);
+        emit.REV_32(arm64::X1, arm64::X1);
+        emit.REV_32(arm64::X4, arm64::X4);
+        store_gpr(emit, r, arm64::X1);
+        store_gpr(emit, r + 1, arm64::X4);
+    }
+    if (r < 32) {
+        // Odd register count - r31 comes in on its own
+        emit.LDR_u32(arm64::X1, arm64::X3, static_cast<s32>((r - inst.rd) * 4));
+        emit.REV_32(arm64::X1, arm64::X1);
         store_gpr(emit, r, arm64::X1);
     }
     
     u8* done = emit.current();
     emit.B(0);  // Jump to end
     
-    // Slow path - kernel addresses and GPU MMIO
+    // Slow path - kernel addresses, GPU MMIO and wrapping runs
     emit.patch_branch(reinterpret_cast<u32*>(kernel_addr), emit.current());
     emit.patch_branch(reinterpret_cast<u32*>(is_gpu), emit.current());
+    emit.patch_branch(reinterpret_cast<u32*>(wraps), emit.current());
     
     // X2 has the original EA
-    for (u32 r = inst.rd; r < 32; r++) {
+    for (r = inst.rd; r < 32; r++) {
         // Calculate address for this register
         emit.ADD_imm(arm64::X1, arm64::X2, (r - inst.rd) * 4);
         
@@ -2095,6 +2303,10 @@ void JitCompiler::compile_load_multiple(ARM64Emitter& emit, const DecodedInst& i
 }
 
 void JitCompiler::compile_store_multiple(ARM64Emitter& emit, const DecodedInst& inst) {
+    // stmw rS, d(rA) - stores rS..r31 as consecutive big-endian words.
+    // Fastmem path byte-swaps two registers with 32-bit REV and writes them with one STP.
+    const u32 run_bytes = (32 - inst.rs) * 4;
+    
     calc_ea(emit, arm64::X0, inst.ra, inst.simm);
     
     // Save original EA for slow path
@@ -2124,48 +2336,47 @@ void JitCompiler::compile_store_multiple(ARM64Emitter& emit, const DecodedInst&
     emit.MOV_imm(arm64::X16, 0x1FFFFFFFULL);
     emit.AND(arm64::X0, arm64::X0, arm64::X16);
     
-    // DEBUG: Trace the masked address before fastmem access (stmw)
-    {
-        emit.SUB_imm(arm64::SP, arm64::SP, 48);
-        emit.STP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.STP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.STP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.MOV_imm(arm64::X1, 1);  // is_store = true (stmw is store)
-        u64 trace_func = reinterpret_cast<u64>(&jit_trace_all_access);
-        emit.MOV_imm(arm64::X16, trace_func);
-        emit.BLR(arm64::X16);
-        emit.LDP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.LDP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.LDP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.ADD_imm(arm64::SP, arm64::SP, 48);
-    }
+    // A run that would cross the end of the 512MB window has to wrap per word,
+    // so leave it to the slow path
+    emit.ADD_imm(arm64::X4, arm64::X0, run_bytes);
+    emit.MOV_imm(arm64::X16, 0x20000000ULL);
+    emit.CMP(arm64::X4, arm64::X16);
+    u8* wraps = emit.current();
+    emit.B_cond(arm64_cond::HI, 0);
     
-    // Fastmem path - address is now in valid range
-    // CRITICAL FIX: Must mask EACH address including offset to avoid overflow past 512MB
-    for (u32 r = inst.rs; r < 32; r++) {
+    emit_heatmap_sample(emit, true);
+    
+    // Fastmem path - whole run is inside main RAM
+    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(fastmem_base_));
+    emit.ADD(arm64::X4, arm64::X0, arm64::X16);
+    
+    u32 r = inst.rs;
+    for (; r + 1 < 32; r += 2) {
+        s32 offset = static_cast<s32>((r - inst.rs) * 4);
         load_gpr(emit, arm64::X1, r);
-        byteswap32(emit, arm64::X1);
-        // Calculate full address = base + offset
-        emit.ADD_imm(arm64::X4, arm64::X0, (r - inst.rs) * 4);
-        // Mask to 512MB to handle wrap-around
-        emit.MOV_imm(arm64::X16, 0x1FFFFFFFULL);
-        emit.AND(arm64::X4, arm64::X4, arm64::X16);
-        // Add fastmem base
-        emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(fastmem_base_));
-        emit.ADD(arm64::X4, arm64::X4, arm64::X16);
-        // Store to masked address
-        emit.STR(arm64::X1, arm64::X4);
+        load_gpr(emit, arm64::X5, r + 1);
+        emit.REV_32(arm64::X1, arm64::X1);
+        emit.REV_32(arm64::X5, arm64::X5);
+        emit.STP_u32(arm64::X1, arm64::X5, arm64::X4, offset);
     }
+    if (r < 32) {
+        // Odd register count - r31 goes out on its own
+        load_gpr(emit, arm64::X1, r);
+        emit.REV_32(arm64::X1, arm64::X1);
+        emit.STR_u32(arm64::X1, arm64::X4, static_cast<s32>((r - inst.rs) * 4));
+    }
+    emit_reservation_invalidate(emit, arm64::X4, run_bytes);
     
     u8* done = emit.current();
     emit.B(0);  // Jump to end
     
-    // Slow path - kernel addresses and GPU MMIO
+    // Slow path - kernel addresses, GPU MMIO and wrapping runs
     emit.patch_branch(reinterpret_cast<u32*>(kernel_addr), emit.current());
     emit.patch_branch(reinterpret_cast<u32*>(is_gpu), emit.current());
+    emit.patch_branch(reinterpret_cast<u32*>(wraps), emit.current());
     
     // X3 has the original EA
-    for (u32 r = inst.rs; r < 32; r++) {
+    for (r = inst.rs; r < 32; r++) {
         // Load value to store
         load_gpr(emit, arm64::X2, r);
         
@@ -2191,183 +2402,35 @@ void JitCompiler::compile_store_multiple(ARM64Emitter& emit, const DecodedInst&
 void JitCompiler::compile_atomic_load(ARM64Emitter& emit, const DecodedInst& inst) {
     // lwarx rD, rA, rB - Load Word And Reserve Indexed
     calc_ea_indexed(emit, arm64::X0, inst.ra, inst.rb);
-    
-    // Save untranslated address for reservation
     emit.ORR(arm64::X2, arm64::XZR, arm64::X0);
     
-    // === Address routing (v4 - correct mirror handling) ===
-    // Check for kernel addresses (>= 0xA0000000)
-    emit.MOV_imm(arm64::X16, 0xA0000000ULL);
-    emit.CMP(arm64::X0, arm64::X16);
-    u8* kernel_addr = emit.current();
-    emit.B_cond(arm64_cond::CS, 0);  // Branch to NOP path if kernel
-    
-    // Check for GPU MMIO physical range (0x7FC00000-0x7FFFFFFF)
-    emit.MOV_imm(arm64::X16, 0x7FC00000ULL);
-    emit.CMP(arm64::X0, arm64::X16);
-    u8* below_gpu = emit.current();
-    emit.B_cond(arm64_cond::CC, 0);  // Branch if addr < 0x7FC00000
-    
-    emit.MOV_imm(arm64::X16, 0x80000000ULL);
-    emit.CMP(arm64::X0, arm64::X16);
-    u8* is_gpu = emit.current();
-    emit.B_cond(arm64_cond::CC, 0);  // Branch to NOP if < 0x80000000 (in GPU MMIO)
-    
-    emit.patch_branch(reinterpret_cast<u32*>(below_gpu), emit.current());
-    
-    // For all other addresses, apply mask to get physical address in 512MB range
-    emit.MOV_imm(arm64::X16, 0x1FFFFFFFULL);
-    emit.AND(arm64::X0, arm64::X0, arm64::X16);
-    
-    // DEBUG: Trace the masked address before fastmem access (lwarx)
-    {
-        emit.SUB_imm(arm64::SP, arm64::SP, 48);
-        emit.STP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.STP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.STP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.MOV_imm(arm64::X1, 0);  // is_store = false (lwarx is load)
-        u64 trace_func = reinterpret_cast<u64>(&jit_trace_all_access);
-        emit.MOV_imm(arm64::X16, trace_func);
-        emit.BLR(arm64::X16);
-        emit.LDP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.LDP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.LDP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.ADD_imm(arm64::SP, arm64::SP, 48);
-    }
-    
-    // Fastmem path - address is in main RAM
-    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(fastmem_base_));
-    emit.ADD(arm64::X0, arm64::X0, arm64::X16);
-    
-    // Load the value with exclusive access
-    emit.LDR(arm64::X1, arm64::X0, 0);
-    byteswap32(emit, arm64::X1);
-    
-    store_gpr(emit, inst.rd, arm64::X1);
-    
-    // Store per-thread reservation in ThreadContext
-    emit.STR(arm64::X2, arm64::CTX_REG, offsetof(ThreadContext, reservation_addr));
-    emit.MOV_imm(arm64::X3, 4);  // reservation size = 4 bytes
-    emit.STR(arm64::X3, arm64::CTX_REG, offsetof(ThreadContext, reservation_size));
-    emit.MOV_imm(arm64::X3, 1);  // has_reservation = true
-    emit.STRB(arm64::X3, arm64::CTX_REG, offsetof(ThreadContext, has_reservation));
-    
-    u8* done = emit.current();
-    emit.B(0);  // Jump to end
-    
-    // NOP path for unsupported addresses (kernel/GPU MMIO)
-    // Return 0 and don't set reservation
-    emit.patch_branch(reinterpret_cast<u32*>(kernel_addr), emit.current());
-    emit.patch_branch(reinterpret_cast<u32*>(is_gpu), emit.current());
-    emit.MOV_imm(arm64::X1, 0);
-    store_gpr(emit, inst.rd, arm64::X1);
+    // Call jit_lwarx(memory, thread_id, addr): reserves the granule in the
+    // Memory table before loading, same as the interpreter
+    emit.LDR(arm64::X0, arm64::CTX_REG, offsetof(ThreadContext, memory));
+    emit.LDR_u32(arm64::X1, arm64::CTX_REG, offsetof(ThreadContext, thread_id));
+    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(&jit_lwarx));
+    emit.BLR(arm64::X16);
     
-    emit.patch_branch(reinterpret_cast<u32*>(done), emit.current());
+    store_gpr(emit, inst.rd, arm64::X0);
 }
 
 void JitCompiler::compile_atomic_store(ARM64Emitter& emit, const DecodedInst& inst) {
     // stwcx. rS, rA, rB - Store Word Conditional Indexed
     calc_ea_indexed(emit, arm64::X0, inst.ra, inst.rb);
+    emit.ORR(arm64::X2, arm64::XZR, arm64::X0);
+    load_gpr(emit, arm64::X3, inst.rs);
     
-    // Check if reservation is valid
-    emit.LDRB(arm64::X3, arm64::CTX_REG, offsetof(ThreadContext, has_reservation));
-    emit.CBZ(arm64::X3, 0);  // Branch if no reservation
-    u8* no_reservation = emit.current() - 4;
-    
-    // Load reservation address (untranslated) from context
-    emit.LDR(arm64::X2, arm64::CTX_REG, offsetof(ThreadContext, reservation_addr));
-    
-    // Compare addresses (both untranslated)
-    emit.CMP(arm64::X0, arm64::X2);
-    
-    // If not equal, set CR0.EQ=0 and skip store
-    u8* skip = emit.current();
-    emit.B_cond(arm64_cond::NE, 0);
-    
-    // Addresses match - need proper address routing before store
-    // Save original address for potential failure path
-    emit.ORR(arm64::X4, arm64::XZR, arm64::X0);
-    
-    // === Address routing (v4 - correct mirror handling) ===
-    // Check for kernel addresses (>= 0xA0000000)
-    emit.MOV_imm(arm64::X16, 0xA0000000ULL);
-    emit.CMP(arm64::X0, arm64::X16);
-    u8* kernel_addr = emit.current();
-    emit.B_cond(arm64_cond::CS, 0);  // Branch to failure if kernel
-    
-    // Check for GPU MMIO physical range (0x7FC00000-0x7FFFFFFF)
-    emit.MOV_imm(arm64::X16, 0x7FC00000ULL);
-    emit.CMP(arm64::X0, arm64::X16);
-    u8* below_gpu = emit.current();
-    emit.B_cond(arm64_cond::CC, 0);  // Branch if addr < 0x7FC00000
-    
-    emit.MOV_imm(arm64::X16, 0x80000000ULL);
-    emit.CMP(arm64::X0, arm64::X16);
-    u8* is_gpu = emit.current();
-    emit.B_cond(arm64_cond::CC, 0);  // Branch to failure if < 0x80000000 (in GPU MMIO)
-    
-    emit.patch_branch(reinterpret_cast<u32*>(below_gpu), emit.current());
-    
-    // For all other addresses, apply mask to get physical address in 512MB range
-    emit.MOV_imm(arm64::X16, 0x1FFFFFFFULL);
-    emit.AND(arm64::X0, arm64::X0, arm64::X16);
-    
-    // DEBUG: Trace the masked address before fastmem access (stwcx.)
-    {
-        emit.SUB_imm(arm64::SP, arm64::SP, 48);
-        emit.STP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.STP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.STP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.MOV_imm(arm64::X1, 1);  // is_store = true (stwcx. is store)
-        u64 trace_func = reinterpret_cast<u64>(&jit_trace_all_access);
-        emit.MOV_imm(arm64::X16, trace_func);
-        emit.BLR(arm64::X16);
-        emit.LDP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.LDP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.LDP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.ADD_imm(arm64::SP, arm64::SP, 48);
-    }
-    
-    // Fastmem path - address is in main RAM
-    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(fastmem_base_));
-    emit.ADD(arm64::X0, arm64::X0, arm64::X16);
-    
-    load_gpr(emit, arm64::X1, inst.rs);
-    byteswap32(emit, arm64::X1);
-    emit.STR(arm64::X1, arm64::X0, 0);
+    // Call jit_stwcx(memory, thread_id, addr, value) -> 1 if stored; the
+    // reservation is cleared either way
+    emit.LDR(arm64::X0, arm64::CTX_REG, offsetof(ThreadContext, memory));
+    emit.LDR_u32(arm64::X1, arm64::CTX_REG, offsetof(ThreadContext, thread_id));
+    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(&jit_stwcx));
+    emit.BLR(arm64::X16);
     
-    // Set CR0.EQ=1 (success)
-    emit.MOV_imm(arm64::X2, 1);
-    emit.STRB(arm64::X2, arm64::CTX_REG, ctx_offset_cr(0) + 2); // EQ
+    // CR0: EQ = success, LT = GT = 0
+    emit.STRB(arm64::X0, arm64::CTX_REG, ctx_offset_cr(0) + 2); // EQ
     emit.STRB(arm64::XZR, arm64::CTX_REG, ctx_offset_cr(0) + 0); // LT
     emit.STRB(arm64::XZR, arm64::CTX_REG, ctx_offset_cr(0) + 1); // GT
-    
-    u8* done = emit.current();
-    emit.B(0);
-    
-    // Patch no_reservation branch (CBZ)
-    s64 no_res_offset = emit.current() - no_reservation;
-    *reinterpret_cast<u32*>(no_reservation) = 0xB4000000 | ((no_res_offset >> 2) << 5) | arm64::X3;
-    
-    // Patch skip branch
-    s64 skip_offset = emit.current() - skip;
-    *reinterpret_cast<u32*>(skip) = 0x54000000 | ((skip_offset >> 2) << 5) | arm64_cond::NE;
-    
-    // Failure path for kernel/GPU MMIO addresses
-    emit.patch_branch(reinterpret_cast<u32*>(kernel_addr), emit.current());
-    emit.patch_branch(reinterpret_cast<u32*>(is_gpu), emit.current());
-    
-    // Set CR0.EQ=0 (failure)
-    emit.STRB(arm64::XZR, arm64::CTX_REG, ctx_offset_cr(0) + 2); // EQ = 0
-    emit.STRB(arm64::XZR, arm64::CTX_REG, ctx_offset_cr(0) + 0); // LT = 0
-    emit.STRB(arm64::XZR, arm64::CTX_REG, ctx_offset_cr(0) + 1); // GT = 0
-    
-    // Patch done branch
-    s64 done_offset = emit.current() - done;
-    *reinterpret_cast<u32*>(done) = 0x14000000 | ((done_offset >> 2) & 0x03FFFFFF);
-    
-    // Clear reservation (has_reservation = false)
-    emit.STRB(arm64::XZR, arm64::CTX_REG, offsetof(ThreadContext, has_reservation));
 }
 
 //=============================================================================
@@ -2375,13 +2438,16 @@ void JitCompiler::compile_atomic_store(ARM64Emitter& emit, const DecodedInst& in
 //=============================================================================
 
 void JitCompiler::compile_dcbz(ARM64Emitter& emit, const DecodedInst& inst) {
-    // dcbz - Data Cache Block Zero: zeros 32 bytes aligned to 32-byte boundary
-    // Address = (rA|0) + rB, aligned to 32 bytes
+    // dcbz - Data Cache Block Zero: zeros 32 bytes aligned to 32-byte boundary.
+    // dcbz128 (same XO with the L bit, rD field = 1) clears a full 128-byte
+    // Xenon cache line instead.
+    // Address = (rA|0) + rB, aligned to the block size
+    const u32 block_size = (inst.rd == 1) ? 128 : 32;
     
     calc_ea_indexed(emit, arm64::X0, inst.ra, inst.rb);
     
-    // Align to 32 bytes (clear lower 5 bits)
-    emit.MOV_imm(arm64::X16, ~31ULL);
+    // Align to the block size (aligned blocks never straddle the 512MB wrap)
+    emit.MOV_imm(arm64::X16, ~static_cast<u64>(block_size - 1));
     emit.AND(arm64::X0, arm64::X0, arm64::X16);
     
     // === Address routing (v4 - correct mirror handling) ===
@@ -2408,31 +2474,17 @@ void JitCompiler::compile_dcbz(ARM64Emitter& emit, const DecodedInst& inst) {
     emit.MOV_imm(arm64::X16, 0x1FFFFFFFULL);
     emit.AND(arm64::X0, arm64::X0, arm64::X16);
     
-    // DEBUG: Trace the masked address before fastmem access (dcbz)
-    {
-        emit.SUB_imm(arm64::SP, arm64::SP, 48);
-        emit.STP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.STP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.STP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.MOV_imm(arm64::X1, 1);  // is_store = true (dcbz writes zeros)
-        u64 trace_func = reinterpret_cast<u64>(&jit_trace_all_access);
-        emit.MOV_imm(arm64::X16, trace_func);
-        emit.BLR(arm64::X16);
-        emit.LDP(arm64::X30, arm64::XZR, arm64::SP, 32);
-        emit.LDP(arm64::X2, arm64::X3, arm64::SP, 16);
-        emit.LDP(arm64::X0, arm64::X1, arm64::SP, 0);
-        emit.ADD_imm(arm64::SP, arm64::SP, 48);
-    }
+    emit_heatmap_sample(emit, true);
     
     // Fastmem path - address is in main RAM
     emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(fastmem_base_));
     emit.ADD(arm64::X0, arm64::X0, arm64::X16);
     
-    // Zero 32 bytes using 4 STR of 64-bit zeros = 4 * 8 = 32 bytes
-    emit.STR(arm64::XZR, arm64::X0, 0);
-    emit.STR(arm64::XZR, arm64::X0, 8);
-    emit.STR(arm64::XZR, arm64::X0, 16);
-    emit.STR(arm64::XZR, arm64::X0, 24);
+    // Zero 16 bytes per STP XZR, XZR (2 for dcbz, 8 for dcbz128)
+    for (u32 offset = 0; offset < block_size; offset += 16) {
+        emit.STP(arm64::XZR, arm64::XZR, arm64::X0, static_cast<s32>(offset));
+    }
+    emit_reservation_invalidate(emit, arm64::X0, block_size);
     
     // Done - skip NOP path
     u8* done = emit.current();
@@ -2804,6 +2856,7 @@ void JitCompiler::compile_vector(ARM64Emitter& emit, const DecodedInst& inst) {
                 emit.ADD(arm64::X0, arm64::X0, arm64::X16);
                 // Store 16 bytes from NEON register
                 emit.STR_vec(0, arm64::X0);
+                emit_reservation_invalidate(emit, arm64::X0, 16);
                 return;
             }
             case 6:  // lvsl - Load Vector for Shift Left
@@ -3765,6 +3818,69 @@ void JitCompiler::emit_translate_address(ARM64Emitter& emit, int addr_reg) {
     emit.ADD(addr_reg, addr_reg, arm64::X16);
 }
 
+void JitCompiler::emit_heatmap_sample(ARM64Emitter& emit, bool is_store) {
+    MemoryHeatmap* heatmap = memory_ ? memory_->active_heatmap() : nullptr;
+    if (!heatmap) return;
+    
+    // Full caller-saved GPR spill: the sampler is ordinary C++ and the
+    // surrounding load/store sequences keep temporaries in X0-X15
+    emit.SUB_imm(arm64::SP, arm64::SP, 144);
+    for (int reg = 0; reg < 16; reg += 2) {
+        emit.STP(reg, reg + 1, arm64::SP, reg * 8);
+    }
+    emit.STP(arm64::X30, arm64::XZR, arm64::SP, 128);
+    
+    // X0 = heatmap, X1 = masked addr, X2 = is_store
+    emit.ORR(arm64::X1, arm64::XZR, arm64::X0);
+    emit.MOV_imm(arm64::X0, reinterpret_cast<u64>(heatmap));
+    emit.MOV_imm(arm64::X2, is_store ? 1 : 0);
+    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(&jit_heatmap_sample));
+    emit.BLR(arm64::X16);
+    
+    emit.LDP(arm64::X30, arm64::XZR, arm64::SP, 128);
+    for (int reg = 14; reg >= 0; reg -= 2) {
+        emit.LDP(reg, reg + 1, arm64::SP, reg * 8);
+    }
+    emit.ADD_imm(arm64::SP, arm64::SP, 144);
+}
+
+void JitCompiler::emit_reservation_invalidate(ARM64Emitter& emit, int host_addr, u32 size) {
+    if (!memory_) return;
+
+    // Order the store before the count check (pairs with set_reservation),
+    // then stay on the fast path while no thread holds a reservation
+    emit.DMB(11);  // ISH
+    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(memory_->active_reservation_count()));
+    emit.LDR_u32(arm64::X16, arm64::X16);
+    u8* none = emit.current();
+    emit.CBZ_32(arm64::X16, 0);
+
+    emit.SUB_imm(arm64::SP, arm64::SP, 144);
+    for (int reg = 0; reg < 16; reg += 2) {
+        emit.STP(reg, reg + 1, arm64::SP, reg * 8);
+    }
+    emit.STP(arm64::X30, arm64::XZR, arm64::SP, 128);
+
+    // X0 = memory, X1 = physical addr, X2 = size
+    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(fastmem_base_));
+    emit.SUB(arm64::X1, host_addr, arm64::X16);
+    emit.MOV_imm(arm64::X0, reinterpret_cast<u64>(memory_));
+    emit.MOV_imm(arm64::X2, size);
+    emit.MOV_imm(arm64::X16, reinterpret_cast<u64>(&jit_invalidate_reservations));
+    emit.BLR(arm64::X16);
+
+    emit.LDP(arm64::X30, arm64::XZR, arm64::SP, 128);
+    for (int reg = 14; reg >= 0; reg -= 2) {
+        emit.LDP(reg, reg + 1, arm64::SP, reg * 8);
+    }
+    emit.ADD_imm(arm64::SP, arm64::SP, 144);
+
+    // patch_branch doesn't know CBZ; fill in its imm19 directly
+    s32 imm19 = static_cast<s32>(emit.current() - none) >> 2;
+    u32* patch_addr = reinterpret_cast<u32*>(none);
+    *patch_addr = (*patch_addr & 0xFF00001F) | ((imm19 & 0x7FFFF) << 5);
+}
+
 void JitCompiler::byteswap32(ARM64Emitter& emit, int reg) {
     emit.REV32(reg, reg);
 }
@@ -3980,30 +4096,52 @@ extern "C" void* jit_lookup_block(JitCompiler* jit, GuestAddr pc) {
 }
 
 void* JitCompiler::lookup_block_for_dispatch(GuestAddr pc) {
-    std::lock_guard<std::mutex> lock(block_map_mutex_);
+    CompiledBlock* block = compile_block(pc);
+    return block ? block->code : nullptr;
+}
+
+void JitCompiler::publish_dispatch_entry(CompiledBlock* block) {
+    // Idle loops stay out of the table so execute() can apply its skip logic
+    if (!dispatch_table_ || block->is_idle_loop) return;
     
-    auto it = block_map_.find(pc);
-    if (it != block_map_.end()) {
-        stats_.cache_hits++;
-        return it->second->code;
+    DispatchEntry& entry = dispatch_table_[dispatch_index(block->start_addr)];
+    if (entry.pc.load(std::memory_order_relaxed) == block->start_addr &&
+        entry.block.load(std::memory_order_relaxed) == block) {
+        return;
     }
     
-    stats_.cache_misses++;
+    // Invalidate the slot before changing its payload; the dispatcher
+    // re-checks pc after reading code, so it never pairs a pc with stale code
+    entry.pc.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.block.store(block, std::memory_order_relaxed);
+    entry.cycles.store(block->size, std::memory_order_relaxed);
+    entry.pc.store(block->start_addr, std::memory_order_release);
+}
+
+void JitCompiler::remove_dispatch_entry(CompiledBlock* block) {
+    if (!dispatch_table_) return;
     
-    CompiledBlock* block = compile_block_unlocked(pc);
-    if (block) {
-        return block->code;
+    DispatchEntry& entry = dispatch_table_[dispatch_index(block->start_addr)];
+    if (entry.block.load(std::memory_order_relaxed) == block) {
+        entry.pc.store(0, std::memory_order_release);
     }
+}
+
+void JitCompiler::clear_dispatch_table() {
+    if (!dispatch_table_) return;
     
-    return nullptr;
+    for (u32 i = 0; i < DISPATCH_TABLE_SIZE; i++) {
+        dispatch_table_[i].pc.store(0, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
 }
 
 CompiledBlock* JitCompiler::compile_block_unlocked(GuestAddr addr) {
     // Allocate new block
     CompiledBlock* block = new CompiledBlock();
     block->start_addr = addr;
-    block->code = code_write_ptr_;
-    block->execution_count = 0;
+    block->code = nullptr;
     block->linked_entry_offset = 0;
     block->is_idle_loop = false;
 
@@ -4033,7 +4171,7 @@ CompiledBlock* JitCompiler::compile_block_unlocked(GuestAddr addr) {
         // Detect idle loops (small loops that just spin on a condition)
         block->is_idle_loop = detect_idle_loop(addr, pre_scan_count);
         if (block->is_idle_loop) {
-            stats_.idle_loops_detected++;
+            tls_compile_stats_.idle_loops_detected++;
             LOGI("Idle loop detected at %08llX (%u instructions)", (unsigned long long)addr, pre_scan_count);
         }
     }
@@ -4041,6 +4179,7 @@ CompiledBlock* JitCompiler::compile_block_unlocked(GuestAddr addr) {
     GuestAddr pc = addr;
     u32 inst_count = 0;
     bool block_ended = false;
+    OpcodeProfiler* profiler = profiler_.load(std::memory_order_acquire);
 
     // Reset instruction count for time_base tracking
     current_block_inst_count_ = 0;
@@ -4067,8 +4206,14 @@ CompiledBlock* JitCompiler::compile_block_unlocked(GuestAddr addr) {
         current_block_inst_count_ = inst_count + 1;
         
         // Compile instruction
+        u64 fallbacks_before = tls_compile_stats_.interpreter_fallbacks;
         compile_instruction(emit, ctx_template, decoded, pc);
         
+        if (profiler) {
+            block->profile.push_back({OpcodeProfiler::opcode_key(decoded), ppc_inst,
+                                      tls_compile_stats_.interpreter_fallbacks != fallbacks_before});
+        }
+        
         inst_count++;
         pc += 4;
         
@@ -4089,26 +4234,16 @@ CompiledBlock* JitCompiler::compile_block_unlocked(GuestAddr addr) {
     block->end_addr = pc;
     block->code_size = emit.size();
     
-    // Check for code cache overflow
-    if (code_write_ptr_ + emit.size() > code_cache_ + cache_size_) {
-        LOGE("JIT code cache overflow! Flushing cache.");
-        // Clear all blocks except this one
-        for (auto& [a, b] : block_map_) {
-            if (b != block) delete b;
-        }
-        block_map_.clear();
-        code_write_ptr_ = code_cache_ + 4096;  // Leave room for dispatcher
-        block->code = code_write_ptr_;
+    // Reserve space in this thread's arena chunk (caller flushes on overflow)
+    block->code = alloc_code(emit.size());
+    if (!block->code) {
+        delete block;
+        tls_compile_stats_ = {};
+        return nullptr;
     }
     
     // Copy code to executable cache
-    memcpy(code_write_ptr_, temp_buffer, emit.size());
-    code_write_ptr_ += emit.size();
-    
-    // Align to 16 bytes
-    code_write_ptr_ = reinterpret_cast<u8*>(
-        (reinterpret_cast<uintptr_t>(code_write_ptr_) + 15) & ~15
-    );
+    memcpy(block->code, temp_buffer, emit.size());
     
 #ifdef __aarch64__
     // Clear instruction cache
@@ -4125,12 +4260,6 @@ CompiledBlock* JitCompiler::compile_block_unlocked(GuestAddr addr) {
         block->hash = (block->hash << 5) | (block->hash >> 59);
     }
     
-    // Add to cache
-    block_map_[addr] = block;
-    
-    stats_.blocks_compiled++;
-    stats_.code_bytes_used = code_write_ptr_ - code_cache_;
-    
     LOGD("Compiled block at %08llX (%u instructions, %u bytes)", 
          (unsigned long long)addr, inst_count, (unsigned)block->code_size);
     
@@ -4164,7 +4293,12 @@ void JitCompiler::generate_dispatcher() {
     ARM64Emitter emit(code_cache_, 4096);
     
     // Dispatcher entry point
-    // Arguments: X0 = ThreadContext*, X1 = JitCompiler*
+    // Arguments: X0 = ThreadContext*, X1 = cycle budget
+    // Returns:   X0 = cycles executed
+    //
+    // Register usage (all callee-saved, untouched by compiled blocks):
+    //   X19 = ThreadContext*, X20 = dispatch table base,
+    //   X25 = table hits this call, X26 = cycles executed, X28 = cycle budget
     
     // Save callee-saved registers
     emit.STP(arm64::X29, arm64::X30, arm64::SP, -16);
@@ -4177,15 +4311,84 @@ void JitCompiler::generate_dispatcher() {
     
     // Set up context register
     emit.ORR(arm64::CTX_REG, arm64::XZR, arm64::X0);
+    emit.ORR(arm64::CYCLES_REG, arm64::XZR, arm64::X1);
+    emit.MOV_imm(arm64::X20, reinterpret_cast<u64>(dispatch_table_.get()));
+    emit.MOVZ(arm64::X25, 0);
+    emit.MOVZ(arm64::X26, 0);
+    
+    // Forward branches to the miss/exit paths, patched below
+    std::vector<u8*> exit_branches;
+    std::vector<u8*> miss_branches;
+    
+    u8* loop = emit.current();
+    
+    // Stop when the budget is spent or the thread is stopped/interrupted
+    emit.CMP(arm64::X26, arm64::CYCLES_REG);
+    exit_branches.push_back(emit.current());
+    emit.B_cond(arm64_cond::CS, 0);
+    emit.LDRB(arm64::X0, arm64::CTX_REG, ctx_offset_running());
+    exit_branches.push_back(emit.current());
+    emit.CBZ(arm64::X0, 0);
+    emit.LDRB(arm64::X0, arm64::CTX_REG, ctx_offset_interrupted());
+    exit_branches.push_back(emit.current());
+    emit.CBNZ(arm64::X0, 0);
+    
+    // PC=0 terminates the thread (DPC return); execute() handles it
+    emit.LDR(arm64::X0, arm64::CTX_REG, ctx_offset_pc());
+    exit_branches.push_back(emit.current());
+    emit.CBZ(arm64::X0, 0);
+    
+    // X2 = &dispatch_table_[(pc >> 2) & mask]
+    emit.LSR_imm(arm64::X1, arm64::X0, 2);
+    emit.AND_imm(arm64::X1, arm64::X1, DISPATCH_TABLE_MASK);
+    emit.ADD(arm64::X2, arm64::X20, arm64::X1, 0, 4);
+    
+    emit.LDR_u32(arm64::X3, arm64::X2, offsetof(DispatchEntry, pc));
+    emit.CMP(arm64::X3, arm64::X0);
+    miss_branches.push_back(emit.current());
+    emit.B_cond(arm64_cond::NE, 0);
     
-    // Save JIT pointer
-    emit.ORR(arm64::JIT_REG, arm64::XZR, arm64::X1);
-    
-    // Note: MEM_BASE (X20) is no longer used - fastmem_base is loaded
-    // directly into X16 in emit_translate_address for each memory access.
+    // Entries are updated while other threads probe them. Make each load
+    // address-dependent on the previous one (EOR of equal values is zero) so
+    // block is read after pc, and pc is re-checked after block.
+    emit.EOR(arm64::X5, arm64::X3, arm64::X0);
+    emit.ADD(arm64::X2, arm64::X2, arm64::X5);
+    emit.LDR(arm64::X8, arm64::X2, offsetof(DispatchEntry, block));
+    emit.LDR_u32(arm64::X6, arm64::X2, offsetof(DispatchEntry, cycles));
+    emit.EOR(arm64::X5, arm64::X8, arm64::X8);
+    emit.ADD(arm64::X7, arm64::X2, arm64::X5);
+    emit.LDR_u32(arm64::X3, arm64::X7, offsetof(DispatchEntry, pc));
+    emit.CMP(arm64::X3, arm64::X0);
+    miss_branches.push_back(emit.current());
+    emit.B_cond(arm64_cond::NE, 0);
     
-    // Main loop would go here, but we use execute() loop instead
-    // Just restore and return for now
+    // Hit: account cycles up front and count the execution (as execute()
+    // does, a relaxed atomic increment), then run the block
+    emit.LDR(arm64::X4, arm64::X8, offsetof(CompiledBlock, code));
+    emit.ADD_imm(arm64::X10, arm64::X8, offsetof(CompiledBlock, execution_count));
+    u8* count_retry = emit.current();
+    emit.LDXR_32(arm64::X9, arm64::X10);
+    emit.ADD_imm(arm64::X9, arm64::X9, 1);
+    emit.STXR_32(arm64::X11, arm64::X9, arm64::X10);
+    emit.CBNZ_32(arm64::X11, static_cast<s32>(count_retry - emit.current()));
+    emit.ADD(arm64::X26, arm64::X26, arm64::X6);
+    emit.ADD_imm(arm64::X25, arm64::X25, 1);
+    emit.ORR(arm64::X0, arm64::XZR, arm64::CTX_REG);
+    emit.BLR(arm64::X4);
+    emit.B(static_cast<s32>(loop - emit.current()));
+    
+    // Miss: count it and return to execute() for the C++ lookup. Counters
+    // live in the ThreadContext so concurrent dispatchers never share them.
+    u8* miss_path = emit.current();
+    emit.LDR(arm64::X1, arm64::CTX_REG, ctx_offset_dispatch_misses());
+    emit.ADD_imm(arm64::X1, arm64::X1, 1);
+    emit.STR(arm64::X1, arm64::CTX_REG, ctx_offset_dispatch_misses());
+    
+    u8* exit_path = emit.current();
+    emit.LDR(arm64::X1, arm64::CTX_REG, ctx_offset_dispatch_hits());
+    emit.ADD(arm64::X1, arm64::X1, arm64::X25);
+    emit.STR(arm64::X1, arm64::CTX_REG, ctx_offset_dispatch_hits());
+    emit.ORR(arm64::X0, arm64::XZR, arm64::X26);
     
     emit.ADD_imm(arm64::SP, arm64::SP, 112);
     emit.LDP(arm64::X27, arm64::X28, arm64::SP, -96);
@@ -4196,6 +4399,15 @@ void JitCompiler::generate_dispatcher() {
     emit.LDP(arm64::X29, arm64::X30, arm64::SP, -16);
     emit.RET();
     
+    // Patch forward branches (B.cond/CBZ/CBNZ all carry imm19 in bits 5-23)
+    auto patch_imm19 = [](u8* site, u8* target) {
+        u32* patch_addr = reinterpret_cast<u32*>(site);
+        s32 imm19 = static_cast<s32>(target - site) >> 2;
+        *patch_addr = (*patch_addr & 0xFF00001F) | ((imm19 & 0x7FFFF) << 5);
+    };
+    for (u8* site : exit_branches) patch_imm19(site, exit_path);
+    for (u8* site : miss_branches) patch_imm19(site, miss_path);
+    
     dispatcher_ = reinterpret_cast<DispatcherFunc>(code_cache_);
     
     __builtin___clear_cache(
@@ -5,6 +5,7 @@
  */
 
 #include "cpu.h"
+#include "profiler.h"
 #include "memory/memory.h"
 #include "kernel/kernel.h"
 
@@ -149,7 +150,13 @@ void Cpu::execute_thread(u32 thread_id, u64 cycles) {
 }
 
 void Cpu::dispatch_syscall(ThreadContext& ctx) {
-    // r0 contains: (module_id << 16) | ordinal
+    // Resolved import thunks load r0 with IMPORT_SLOT_FLAG | slot
+    if (kernel_ && (ctx.gpr[0] & IMPORT_SLOT_FLAG)) {
+        kernel_->dispatch_import(static_cast<u32>(ctx.gpr[0] & (IMPORT_SLOT_FLAG - 1)));
+        return;
+    }
+    
+    // Otherwise r0 contains: (module_id << 16) | ordinal
     // This encoding is set up by the import thunks (Task A.4)
     u32 ordinal = ctx.gpr[0] & 0xFFFF;
     u32 module = (ctx.gpr[0] >> 16) & 0xFF;
@@ -234,9 +241,9 @@ bool Cpu::any_running() const {
     return false;
 }
 
-void Cpu::execute_with_context(u32 thread_id, ThreadContext& external_ctx, u64 cycles) {
+u64 Cpu::execute_with_context(u32 thread_id, ThreadContext& external_ctx, u64 cycles) {
     if (thread_id >= cpu::NUM_THREADS) {
-        return;
+        return 0;
     }
     
     // === DEBUG: Log PC periodically to see where the game is spinning ===
@@ -366,13 +373,13 @@ void Cpu::execute_with_context(u32 thread_id, ThreadContext& external_ctx, u64 c
         if (executed > 0) {
             // Copy CPU context back to external context
             external_ctx = cpu_ctx;
-            return;
+            return executed;
         }
     }
 #endif
     
     // Interpreter fallback
-    interpreter_->execute(cpu_ctx, cycles);
+    u64 executed = interpreter_->execute(cpu_ctx, cycles);
     
     if (cpu_ctx.interrupted) {
         cpu_ctx.interrupted = false;
@@ -384,11 +391,58 @@ void Cpu::execute_with_context(u32 thread_id, ThreadContext& external_ctx, u64 c
     
     // Copy CPU context back to external context (restore state)
     external_ctx = cpu_ctx;
+    return executed;
 }
 
 std::mutex& Cpu::get_context_mutex(u32 thread_id) {
     return context_mutexes_[thread_id % cpu::NUM_THREADS];
 }
 
+void Cpu::set_profiling_enabled(bool enabled) {
+    if (!profiler_) {
+        if (!enabled) return;
+        profiler_ = std::make_unique<OpcodeProfiler>();
+    }
+    
+    profiler_->set_enabled(enabled);
+    OpcodeProfiler* attached = enabled ? profiler_.get() : nullptr;
+    
+    if (interpreter_) {
+        interpreter_->set_profiler(attached);
+    }
+    
+#ifdef X360MU_JIT_ENABLED
+    if (jit_) {
+        jit_->set_profiler(attached);
+        if (enabled) {
+            // Blocks compiled earlier carry no per-instruction profile data
+            jit_->flush_cache();
+        }
+    }
+#endif
+    
+    LOGI("Opcode profiling %s", enabled ? "enabled" : "disabled");
+}
+
+void Cpu::set_memory_heatmap_enabled(bool enabled) {
+    if (!memory_) return;
+    
+    memory_->set_heatmap_enabled(enabled);
+    
+#ifdef X360MU_JIT_ENABLED
+    if (jit_) {
+        // Sampling is compiled into blocks, so drop it along with them
+        jit_->flush_cache();
+    }
+#endif
+}
+
+std::string Cpu::get_profile_report(size_t max_rows) const {
+    if (!profiler_) {
+        return "Opcode profiling has not been enabled\n";
+    }
+    return profiler_->report(max_rows);
+}
+
 } // namespace x360mu
 
@@ -11,6 +11,7 @@
 #include <array>
 #include <string>
 #include <mutex>
+#include <atomic>
 
 #ifdef __aarch64__
 #include <arm_neon.h>
@@ -21,6 +22,7 @@ namespace x360mu {
 class Memory;
 class JitCompiler;
 class Kernel;
+class OpcodeProfiler;
 
 /**
  * CPU configuration
@@ -143,6 +145,11 @@ struct ThreadContext {
     u32 reservation_size;
     bool has_reservation;
     
+    // JIT dispatcher counters, written only by this thread's generated code
+    // and drained by JitCompiler::execute()
+    u64 dispatch_hits;
+    u64 dispatch_misses;
+    
     void reset() {
         gpr.fill(0);
         fpr.fill(0.0);
@@ -165,6 +172,8 @@ struct ThreadContext {
         reservation_addr = 0;
         reservation_size = 0;
         has_reservation = false;
+        dispatch_hits = 0;
+        dispatch_misses = 0;
     }
 };
 
@@ -256,11 +265,23 @@ public:
     
     /**
      * Execute until cycle count reached
+     * Returns cycles consumed (less if the thread stopped or trapped)
      */
-    void execute(ThreadContext& ctx, u64 cycles);
+    u64 execute(ThreadContext& ctx, u64 cycles);
+    
+    /**
+     * Attach an opcode profiler (nullptr to detach)
+     */
+    void set_profiler(OpcodeProfiler* profiler) {
+        profiler_.store(profiler, std::memory_order_release);
+    }
     
 private:
     Memory* memory_;
+    std::atomic<OpcodeProfiler*> profiler_{nullptr};
+    
+    // execute() with per-block profiling
+    u64 execute_profiled(ThreadContext& ctx, u64 cycles, OpcodeProfiler* profiler);
     
     // Instruction handlers
     void exec_integer(ThreadContext& ctx, const DecodedInst& inst);
@@ -285,6 +306,12 @@ private:
     void write_u32(ThreadContext& ctx, GuestAddr addr, u32 value);
     void write_u64(ThreadContext& ctx, GuestAddr addr, u64 value);
     
+    // Bulk access helpers (lmw/stmw/dcbz) - go through the host pointer when
+    // the whole range is plain RAM, per-word through Memory otherwise
+    void load_multiple(ThreadContext& ctx, GuestAddr addr, u32 first_reg);
+    void store_multiple(ThreadContext& ctx, GuestAddr addr, u32 first_reg);
+    void zero_cache_block(GuestAddr addr, u32 block_size);
+    
     // CR update helpers
     void update_cr0(ThreadContext& ctx, s64 result);
     void update_cr1(ThreadContext& ctx);
@@ -360,14 +387,30 @@ public:
     /**
      * Execute with external context (for scheduler integration)
      * Copies context in, executes, copies back - thread-safe
+     * Returns cycles executed
      */
-    void execute_with_context(u32 thread_id, ThreadContext& external_ctx, u64 cycles);
+    u64 execute_with_context(u32 thread_id, ThreadContext& external_ctx, u64 cycles);
     
     /**
      * Lock/unlock context for external access
      */
     std::mutex& get_context_mutex(u32 thread_id);
     
+    /**
+     * Opcode profiling (interpreter and JIT). Enabling flushes the JIT cache
+     * so every block is recompiled with profiling information.
+     */
+    void set_profiling_enabled(bool enabled);
+    std::string get_profile_report(size_t max_rows = 32) const;
+    OpcodeProfiler* get_profiler() const { return profiler_.get(); }
+    
+    /**
+     * Memory access heatmap (see Memory::set_heatmap_enabled). Toggling
+     * flushes the JIT cache so blocks are recompiled with or without
+     * fastmem sampling.
+     */
+    void set_memory_heatmap_enabled(bool enabled);
+    
 private:
     Memory* memory_ = nullptr;
     Kernel* kernel_ = nullptr;
@@ -381,6 +424,7 @@ private:
     
     // Execution engines
     std::unique_ptr<Interpreter> interpreter_;
+    std::unique_ptr<OpcodeProfiler> profiler_;
     
 #ifdef X360MU_JIT_ENABLED
     std::unique_ptr<JitCompiler> jit_;
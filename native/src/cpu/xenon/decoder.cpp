@@ -511,11 +511,14 @@ DecodedInst Decoder::decode(u32 inst) {
                 case XO31_DCBST:
                 case XO31_DCBT:
                 case XO31_DCBTST:
-                case XO31_DCBZ:
                 case XO31_DCBI:
                     d.type = DecodedInst::Type::DCBF;
                     break;
                     
+                case XO31_DCBZ:
+                    d.type = DecodedInst::Type::DCBZ;
+                    break;
+                    
                 case XO31_ICBI:
                     d.type = DecodedInst::Type::ICBI;
                     break;
@@ -0,0 +1,199 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * User-space fibers
+ */
+
+#include "fiber.h"
+#include <cstdlib>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace x360mu {
+
+// Context switch: push the callee-saved registers on the current stack,
+// store the stack pointer to *save_sp, load new_sp and pop the registers
+// saved there. A new fiber's stack is seeded so the first switch "returns"
+// into the trampoline, which calls entry(fiber) from two saved registers.
+extern "C" void x360mu_fiber_switch(void** save_sp, void* new_sp);
+extern "C" void x360mu_fiber_trampoline();
+
+#if defined(__aarch64__)
+#define X360MU_FIBERS_SUPPORTED 1
+
+asm(R"(
+    .text
+    .p2align 4
+    .globl x360mu_fiber_switch
+    .hidden x360mu_fiber_switch
+    .type x360mu_fiber_switch, %function
+x360mu_fiber_switch:
+    sub sp, sp, #160
+    stp x19, x20, [sp, #0]
+    stp x21, x22, [sp, #16]
+    stp x23, x24, [sp, #32]
+    stp x25, x26, [sp, #48]
+    stp x27, x28, [sp, #64]
+    stp x29, x30, [sp, #80]
+    stp d8, d9, [sp, #96]
+    stp d10, d11, [sp, #112]
+    stp d12, d13, [sp, #128]
+    stp d14, d15, [sp, #144]
+    mov x9, sp
+    str x9, [x0]
+    mov sp, x1
+    ldp x19, x20, [sp, #0]
+    ldp x21, x22, [sp, #16]
+    ldp x23, x24, [sp, #32]
+    ldp x25, x26, [sp, #48]
+    ldp x27, x28, [sp, #64]
+    ldp x29, x30, [sp, #80]
+    ldp d8, d9, [sp, #96]
+    ldp d10, d11, [sp, #112]
+    ldp d12, d13, [sp, #128]
+    ldp d14, d15, [sp, #144]
+    add sp, sp, #160
+    ret
+    .size x360mu_fiber_switch, .-x360mu_fiber_switch
+
+    .p2align 4
+    .globl x360mu_fiber_trampoline
+    .hidden x360mu_fiber_trampoline
+    .type x360mu_fiber_trampoline, %function
+x360mu_fiber_trampoline:
+    mov x0, x19
+    blr x20
+    brk #0
+    .size x360mu_fiber_trampoline, .-x360mu_fiber_trampoline
+)");
+
+// Frame popped by the first switch: x19 = fiber, x20 = entry, x30 = trampoline
+static void* seed_stack(u8* top, void* fiber, void* entry) {
+    u64* frame = reinterpret_cast<u64*>(top - 160);
+    for (int i = 0; i < 20; i++) frame[i] = 0;
+    frame[0] = reinterpret_cast<u64>(fiber);
+    frame[1] = reinterpret_cast<u64>(entry);
+    frame[11] = reinterpret_cast<u64>(&x360mu_fiber_trampoline);
+    return frame;
+}
+
+#elif defined(__x86_64__)
+#define X360MU_FIBERS_SUPPORTED 1
+
+asm(R"(
+    .text
+    .p2align 4
+    .globl x360mu_fiber_switch
+    .hidden x360mu_fiber_switch
+    .type x360mu_fiber_switch, %function
+x360mu_fiber_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size x360mu_fiber_switch, .-x360mu_fiber_switch
+
+    .p2align 4
+    .globl x360mu_fiber_trampoline
+    .hidden x360mu_fiber_trampoline
+    .type x360mu_fiber_trampoline, %function
+x360mu_fiber_trampoline:
+    movq %rbx, %rdi
+    callq *%r12
+    ud2
+    .size x360mu_fiber_trampoline, .-x360mu_fiber_trampoline
+)");
+
+// Frame popped by the first switch: r12 = entry, rbx = fiber, then the
+// return address. Placed so the stack is 16-byte aligned at the call.
+static void* seed_stack(u8* top, void* fiber, void* entry) {
+    u64* frame = reinterpret_cast<u64*>(top - 72);
+    for (int i = 0; i < 7; i++) frame[i] = 0;
+    frame[3] = reinterpret_cast<u64>(entry);
+    frame[4] = reinterpret_cast<u64>(fiber);
+    frame[6] = reinterpret_cast<u64>(&x360mu_fiber_trampoline);
+    return frame;
+}
+
+#endif
+
+namespace {
+thread_local Fiber* tls_current_fiber = nullptr;
+}
+
+bool Fiber::supported() {
+#ifdef X360MU_FIBERS_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+Fiber* Fiber::current() {
+    return tls_current_fiber;
+}
+
+Fiber::Fiber(std::function<void()> entry, size_t stack_size)
+    : entry_(std::move(entry)) {
+#ifdef X360MU_FIBERS_SUPPORTED
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    stack_size_ = align_up<size_t>(stack_size, page) + page;
+
+    void* base = mmap(nullptr, stack_size_, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        stack_size_ = 0;
+        return;
+    }
+    mprotect(base, page, PROT_NONE);  // Guard page below the stack
+    stack_ = base;
+
+    u8* top = static_cast<u8*>(base) + stack_size_;
+    sp_ = seed_stack(top, this, reinterpret_cast<void*>(&Fiber::entry_point));
+#endif
+}
+
+Fiber::~Fiber() {
+    if (stack_) {
+        munmap(stack_, stack_size_);
+    }
+}
+
+void Fiber::resume() {
+#ifdef X360MU_FIBERS_SUPPORTED
+    if (!stack_ || finished_) return;
+
+    caller_fiber_ = tls_current_fiber;
+    tls_current_fiber = this;
+    x360mu_fiber_switch(&caller_sp_, sp_);
+    tls_current_fiber = caller_fiber_;
+#endif
+}
+
+void Fiber::suspend() {
+#ifdef X360MU_FIBERS_SUPPORTED
+    x360mu_fiber_switch(&sp_, caller_sp_);
+#endif
+}
+
+void Fiber::entry_point(Fiber* fiber) {
+    fiber->entry_();
+    fiber->finished_ = true;
+    fiber->suspend();
+
+    // A finished fiber is never resumed
+    std::abort();
+}
+
+} // namespace x360mu
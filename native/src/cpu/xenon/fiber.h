@@ -0,0 +1,79 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * User-space fibers
+ *
+ * Minimal stackful coroutines used by the M:N guest thread scheduler.
+ * A fiber runs on its own mmap'd stack and switches with a handful of
+ * register saves instead of a kernel context switch. Bionic has no
+ * makecontext/swapcontext, so the switch is hand-written for arm64 and
+ * x86_64; other hosts report !supported() and keep the 1:1 model.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include <functional>
+
+namespace x360mu {
+
+class Fiber {
+public:
+    static constexpr size_t DEFAULT_STACK_SIZE = 512 * KB;
+
+    /**
+     * Whether fibers can be created on this host
+     */
+    static bool supported();
+
+    /**
+     * Create a fiber that runs `entry` on first resume(). The stack is
+     * reserved lazily and ends in a guard page.
+     */
+    explicit Fiber(std::function<void()> entry, size_t stack_size = DEFAULT_STACK_SIZE);
+    ~Fiber();
+
+    Fiber(const Fiber&) = delete;
+    Fiber& operator=(const Fiber&) = delete;
+
+    /**
+     * False if the stack could not be allocated
+     */
+    bool valid() const { return stack_ != nullptr; }
+
+    /**
+     * Switch into the fiber. Returns when it calls suspend() or its entry
+     * function returns.
+     */
+    void resume();
+
+    /**
+     * Switch back to whoever last resumed this fiber. Must be called from
+     * inside the fiber.
+     */
+    void suspend();
+
+    /**
+     * True once the entry function has returned
+     */
+    bool finished() const { return finished_; }
+
+    /**
+     * The fiber running on this host thread, or nullptr outside fibers
+     */
+    static Fiber* current();
+
+private:
+    static void entry_point(Fiber* fiber);
+
+    std::function<void()> entry_;
+    void* stack_ = nullptr;
+    size_t stack_size_ = 0;
+
+    void* sp_ = nullptr;          // Saved stack pointer while switched out
+    void* caller_sp_ = nullptr;   // Saved stack pointer of the resumer
+    Fiber* caller_fiber_ = nullptr;
+    bool finished_ = false;
+};
+
+} // namespace x360mu
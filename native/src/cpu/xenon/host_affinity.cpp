@@ -0,0 +1,205 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Host core placement implementation
+ */
+
+#include "host_affinity.h"
+#include <algorithm>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define X360MU_HAVE_AFFINITY 1
+#endif
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "360mu-affinity"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) printf("[AFFINITY] " __VA_ARGS__); printf("\n")
+#define LOGW(...) printf("[AFFINITY WARN] " __VA_ARGS__); printf("\n")
+#endif
+
+namespace x360mu {
+
+HostAffinity& HostAffinity::instance() {
+    static HostAffinity affinity;
+    return affinity;
+}
+
+void HostAffinity::configure(const HostAffinityConfig& config) {
+    configure(config, detect_cpus());
+}
+
+void HostAffinity::configure(const HostAffinityConfig& config, std::vector<HostCpu> cpus) {
+    enabled_ = false;
+    boost_priority_ = config.boost_priority;
+    hw_thread_cpus_.fill(0);
+    service_cpus_ = 0;
+
+    if (!config.enabled) {
+        LOGI("Host CPU pinning disabled");
+        return;
+    }
+    if (cpus.size() < 2) {
+        LOGI("Host CPU pinning off: %zu usable CPU(s)", cpus.size());
+        return;
+    }
+
+    // Fastest first; equal capacities keep CPU id order
+    std::stable_sort(cpus.begin(), cpus.end(), [](const HostCpu& a, const HostCpu& b) {
+        return a.capacity > b.capacity;
+    });
+
+    u64 all = 0;
+    for (const auto& cpu : cpus) {
+        all |= 1ULL << cpu.id;
+    }
+
+    // Hardware thread 0 gets the fastest core to itself. With three or more
+    // CPUs the next one is kept for service threads, and hardware threads
+    // 1-5 round-robin over the rest.
+    size_t service_count = cpus.size() >= 3 ? 1 : 0;
+    hw_thread_cpus_[0] = 1ULL << cpus[0].id;
+    service_cpus_ = service_count ? 1ULL << cpus[1].id : all;
+
+    size_t first_shared = 1 + service_count;
+    size_t shared = cpus.size() - first_shared;
+    for (u32 i = 1; i < hw_thread_cpus_.size(); i++) {
+        hw_thread_cpus_[i] = 1ULL << cpus[first_shared + (i - 1) % shared].id;
+    }
+
+    // Explicit masks win, restricted to CPUs we may actually use
+    for (u32 i = 0; i < hw_thread_cpus_.size(); i++) {
+        if (config.hw_thread_cpus[i] & all) {
+            hw_thread_cpus_[i] = config.hw_thread_cpus[i] & all;
+        }
+    }
+    if (config.service_cpus & all) {
+        service_cpus_ = config.service_cpus & all;
+    }
+
+    enabled_ = true;
+    LOGI("Host CPU layout (%zu CPUs, fastest capacity %llu): %s", cpus.size(),
+         (unsigned long long)cpus[0].capacity, describe().c_str());
+}
+
+u64 HostAffinity::hw_thread_cpus(u32 hw_thread) const {
+    return hw_thread < hw_thread_cpus_.size() ? hw_thread_cpus_[hw_thread] : 0;
+}
+
+u64 HostAffinity::guest_cpus(u32 affinity_mask) const {
+    u64 cpus = 0;
+    for (u32 i = 0; i < hw_thread_cpus_.size(); i++) {
+        if (affinity_mask & (1u << i)) {
+            cpus |= hw_thread_cpus_[i];
+        }
+    }
+    return cpus;
+}
+
+static std::string format_cpus(u64 mask) {
+    std::string out;
+    for (u32 cpu = 0; cpu < 64; cpu++) {
+        if (mask & (1ULL << cpu)) {
+            if (!out.empty()) out += ',';
+            out += std::to_string(cpu);
+        }
+    }
+    return out.empty() ? "-" : out;
+}
+
+std::string HostAffinity::describe() const {
+    if (!enabled_) {
+        return "unpinned";
+    }
+    std::string out;
+    for (u32 i = 0; i < hw_thread_cpus_.size(); i++) {
+        out += "hw" + std::to_string(i) + "=" + format_cpus(hw_thread_cpus_[i]) + " ";
+    }
+    out += "service=" + format_cpus(service_cpus_);
+    return out;
+}
+
+void HostAffinity::pin_service_thread(const char* name) const {
+    if (!enabled_) return;
+    if (!pin_thread(current_thread_id(), service_cpus_)) {
+        LOGW("Could not pin %s thread to CPUs %s", name, format_cpus(service_cpus_).c_str());
+    }
+}
+
+s32 HostAffinity::current_thread_id() {
+#ifdef X360MU_HAVE_AFFINITY
+    return static_cast<s32>(syscall(SYS_gettid));
+#else
+    return 0;
+#endif
+}
+
+bool HostAffinity::pin_thread(s32 tid, u64 cpus) {
+#ifdef X360MU_HAVE_AFFINITY
+    if (!tid || !cpus) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (u32 cpu = 0; cpu < 64; cpu++) {
+        if (cpus & (1ULL << cpu)) CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(tid, sizeof(set), &set) == 0;
+#else
+    (void)tid;
+    (void)cpus;
+    return false;
+#endif
+}
+
+bool HostAffinity::set_thread_nice(s32 tid, int nice) {
+#ifdef X360MU_HAVE_AFFINITY
+    // Linux applies PRIO_PROCESS with a thread id to that thread only
+    return tid && setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice) == 0;
+#else
+    (void)tid;
+    (void)nice;
+    return false;
+#endif
+}
+
+#ifdef X360MU_HAVE_AFFINITY
+static u64 read_sysfs_u64(u32 cpu, const char* leaf) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/%s", cpu, leaf);
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+    unsigned long long value = 0;
+    if (fscanf(file, "%llu", &value) != 1) value = 0;
+    fclose(file);
+    return value;
+}
+#endif
+
+std::vector<HostCpu> HostAffinity::detect_cpus() {
+    std::vector<HostCpu> cpus;
+#ifdef X360MU_HAVE_AFFINITY
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return cpus;
+    }
+    for (u32 cpu = 0; cpu < 64; cpu++) {
+        if (!CPU_ISSET(cpu, &set)) continue;
+        // ARM kernels publish a normalized capacity; otherwise rank by
+        // maximum frequency, and treat unknown CPUs as equal
+        u64 capacity = read_sysfs_u64(cpu, "cpu_capacity");
+        if (!capacity) capacity = read_sysfs_u64(cpu, "cpufreq/cpuinfo_max_freq");
+        cpus.push_back({cpu, capacity ? capacity : 1});
+    }
+#endif
+    return cpus;
+}
+
+} // namespace x360mu
@@ -0,0 +1,92 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Host core placement
+ *
+ * Maps the six Xenon hardware threads and the emulator's own service
+ * threads (emulation loop, GPU, timers) onto host CPUs. Cores are ranked by
+ * capacity read from sysfs, so on big.LITTLE phones hardware thread 0,
+ * which usually runs the game's main thread, gets the fastest core, the
+ * service threads get the next one, and the remaining hardware threads
+ * share what is left. Pinning uses sched_setaffinity and only happens on
+ * Linux/Android hosts with at least two usable CPUs.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include <array>
+#include <string>
+#include <vector>
+
+namespace x360mu {
+
+struct HostAffinityConfig {
+    bool enabled = true;                    // Pin threads to host CPUs at all
+    bool boost_priority = true;             // Raise host priority of high-priority guest threads
+    std::array<u64, 6> hw_thread_cpus{};    // Host CPU mask per hardware thread (0 = auto)
+    u64 service_cpus = 0;                   // Host CPU mask for service threads (0 = auto)
+};
+
+struct HostCpu {
+    u32 id;
+    u64 capacity;   // cpu_capacity, or max frequency in kHz; higher is faster
+};
+
+class HostAffinity {
+public:
+    static HostAffinity& instance();
+
+    HostAffinity() = default;
+
+    /**
+     * Build the layout from the CPUs this process may run on.
+     * Call before starting the threads it places.
+     */
+    void configure(const HostAffinityConfig& config);
+
+    /**
+     * Build the layout from an explicit CPU list (tests, overrides)
+     */
+    void configure(const HostAffinityConfig& config, std::vector<HostCpu> cpus);
+
+    bool enabled() const { return enabled_; }
+    bool boost_priority() const { return boost_priority_; }
+
+    /**
+     * Host CPU mask for one hardware thread, or for every hardware thread
+     * set in a CpuAffinity mask. 0 when pinning is disabled.
+     */
+    u64 hw_thread_cpus(u32 hw_thread) const;
+    u64 guest_cpus(u32 affinity_mask) const;
+
+    u64 service_cpus() const { return service_cpus_; }
+
+    /**
+     * Human-readable layout, e.g. "hw0=7 hw1=5 ... service=4"
+     */
+    std::string describe() const;
+
+    /**
+     * Pin the calling thread to the service CPUs
+     */
+    void pin_service_thread(const char* name) const;
+
+    // Host thread helpers (no-ops returning false where unsupported)
+    static s32 current_thread_id();
+    static bool pin_thread(s32 tid, u64 cpus);
+    static bool set_thread_nice(s32 tid, int nice);
+
+    /**
+     * CPUs this process may run on, with their capacities
+     */
+    static std::vector<HostCpu> detect_cpus();
+
+private:
+    bool enabled_ = false;
+    bool boost_priority_ = false;
+    std::array<u64, 6> hw_thread_cpus_{};
+    u64 service_cpus_ = 0;
+};
+
+} // namespace x360mu
@@ -5,7 +5,9 @@
  */
 
 #include "cpu.h"
+#include "profiler.h"
 #include "memory/memory.h"
+#include <cstring>
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -31,6 +33,10 @@ u32 Interpreter::execute_one(ThreadContext& ctx) {
     // Decode
     DecodedInst d = Decoder::decode(inst);
     
+    if (OpcodeProfiler* profiler = profiler_.load(std::memory_order_relaxed)) {
+        profiler->record_instruction(d);
+    }
+    
     // Execute based on type
     switch (d.type) {
         case DecodedInst::Type::Add:
@@ -138,9 +144,14 @@ u32 Interpreter::execute_one(ThreadContext& ctx) {
     return 1; // Cycles consumed
 }
 
-void Interpreter::execute(ThreadContext& ctx, u64 cycles) {
+u64 Interpreter::execute(ThreadContext& ctx, u64 cycles) {
     u64 executed = 0;
     
+    OpcodeProfiler* profiler = profiler_.load(std::memory_order_acquire);
+    if (profiler) {
+        return execute_profiled(ctx, cycles, profiler);
+    }
+    
     while (executed < cycles && ctx.running && !ctx.interrupted) {
         // Check for PC=0 termination (used for DPC return)
         // When a DPC routine executes 'blr' with LR=0, PC becomes 0
@@ -151,6 +162,41 @@ void Interpreter::execute(ThreadContext& ctx, u64 cycles) {
         
         executed += execute_one(ctx);
     }
+    return executed;
+}
+
+u64 Interpreter::execute_profiled(ThreadContext& ctx, u64 cycles, OpcodeProfiler* profiler) {
+    u64 executed = 0;
+    
+    // A block runs until control flow leaves the straight-line path
+    GuestAddr block_start = static_cast<GuestAddr>(ctx.pc);
+    u32 block_insts = 0;
+    u64 block_cycles = 0;
+    
+    while (executed < cycles && ctx.running && !ctx.interrupted) {
+        if (ctx.pc == 0) {
+            ctx.running = false;
+            break;
+        }
+        
+        u64 pc = ctx.pc;
+        u32 consumed = execute_one(ctx);
+        executed += consumed;
+        block_insts++;
+        block_cycles += consumed;
+        
+        if (ctx.pc != pc + 4) {
+            profiler->record_block(block_start, block_insts, block_cycles);
+            block_start = static_cast<GuestAddr>(ctx.pc);
+            block_insts = 0;
+            block_cycles = 0;
+        }
+    }
+    
+    if (block_insts > 0) {
+        profiler->record_block(block_start, block_insts, block_cycles);
+    }
+    return executed;
 }
 
 void Interpreter::exec_integer(ThreadContext& ctx, const DecodedInst& d) {
@@ -606,16 +652,10 @@ void Interpreter::exec_load_store(ThreadContext& ctx, const DecodedInst& d) {
             ctx.gpr[d.ra] = addr;
             break;
         case 46: // lmw
-            for (u32 r = d.rd; r < 32; r++) {
-                ctx.gpr[r] = read_u32(ctx, addr);
-                addr += 4;
-            }
+            load_multiple(ctx, addr, d.rd);
             break;
         case 47: // stmw
-            for (u32 r = d.rs; r < 32; r++) {
-                write_u32(ctx, addr, static_cast<u32>(ctx.gpr[r]));
-                addr += 4;
-            }
+            store_multiple(ctx, addr, d.rs);
             break;
         case 48: // lfs - Load Floating-Point Single
             {
@@ -937,12 +977,11 @@ void Interpreter::exec_system(ThreadContext& ctx, const DecodedInst& d) {
         case DecodedInst::Type::ICBI:
             // Cache operations - mostly no-op
             if (d.type == DecodedInst::Type::DCBZ) {
-                // Zero a cache line
+                // Zero a cache block (dcbz128 when the L bit in rD is set)
                 GuestAddr addr = static_cast<GuestAddr>(
                     (d.ra == 0 ? 0 : ctx.gpr[d.ra]) + ctx.gpr[d.rb]
                 );
-                addr &= ~31; // Align to 32 bytes
-                memory_->zero_bytes(addr, 32);
+                zero_cache_block(addr, d.rd == 1 ? 128 : 32);
             }
             break;
             
@@ -1073,6 +1112,62 @@ void Interpreter::write_u64(ThreadContext& ctx, GuestAddr addr, u64 value) {
     memory_->write_u64(addr, value);
 }
 
+// Bulk access helpers
+// lmw/stmw move up to 32 words and dcbz up to a 128-byte line; when the
+// translated range sits entirely in main RAM this is one host memcpy/memset
+// plus a single write notification instead of a Memory call per word.
+void Interpreter::load_multiple(ThreadContext& ctx, GuestAddr addr, u32 first_reg) {
+    u32 count = 32 - first_reg;
+    GuestAddr phys = memory_->translate_address(addr);
+    const u8* host = static_cast<const u8*>(memory_->get_host_ptr(phys));
+    
+    if (!host || !memory_->get_host_ptr(phys + count * 4 - 1)) {
+        // MMIO or a run that wraps the 512MB window
+        for (u32 r = first_reg; r < 32; r++) {
+            ctx.gpr[r] = read_u32(ctx, addr);
+            addr += 4;
+        }
+        return;
+    }
+    
+    for (u32 i = 0; i < count; i++) {
+        u32 value;
+        memcpy(&value, host + i * 4, sizeof(u32));
+        ctx.gpr[first_reg + i] = byte_swap(value);
+    }
+}
+
+void Interpreter::store_multiple(ThreadContext& ctx, GuestAddr addr, u32 first_reg) {
+    u32 count = 32 - first_reg;
+    GuestAddr phys = memory_->translate_address(addr);
+    
+    if (!memory_->get_host_ptr(phys) || !memory_->get_host_ptr(phys + count * 4 - 1)) {
+        for (u32 r = first_reg; r < 32; r++) {
+            write_u32(ctx, addr, static_cast<u32>(ctx.gpr[r]));
+            addr += 4;
+        }
+        return;
+    }
+    
+    u32 words[32];
+    for (u32 i = 0; i < count; i++) {
+        words[i] = byte_swap(static_cast<u32>(ctx.gpr[first_reg + i]));
+    }
+    memory_->write_bytes(phys, words, count * 4);
+}
+
+void Interpreter::zero_cache_block(GuestAddr addr, u32 block_size) {
+    addr &= ~(block_size - 1);
+    GuestAddr phys = memory_->translate_address(addr);
+    
+    if (!memory_->get_host_ptr(phys)) {
+        // Nothing to clear behind MMIO, the real cache would fault here
+        return;
+    }
+    
+    memory_->zero_bytes(phys, block_size);
+}
+
 // CR update helpers
 void Interpreter::update_cr0(ThreadContext& ctx, s64 result) {
     ctx.cr[0].lt = result < 0;
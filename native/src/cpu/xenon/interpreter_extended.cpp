@@ -728,29 +728,27 @@ void Interpreter::exec_integer_ext31(ThreadContext& ctx, const DecodedInst& d) {
         case 20: // lwarx (load word and reserve)
             {
                 GuestAddr addr = (d.ra ? ctx.gpr[d.ra] : 0) + ctx.gpr[d.rb];
-                ctx.gpr[d.rd] = read_u32(ctx, addr);
-                // Set per-thread reservation
+                // Reserve before loading so a racing store invalidates us
                 memory_->set_reservation(ctx.thread_id, addr, 4);
+                ctx.gpr[d.rd] = read_u32(ctx, addr);
             }
             break;
             
         case 84: // ldarx (load doubleword and reserve)
             {
                 GuestAddr addr = (d.ra ? ctx.gpr[d.ra] : 0) + ctx.gpr[d.rb];
-                ctx.gpr[d.rd] = read_u64(ctx, addr);
-                // Set per-thread reservation
+                // Reserve before loading so a racing store invalidates us
                 memory_->set_reservation(ctx.thread_id, addr, 8);
+                ctx.gpr[d.rd] = read_u64(ctx, addr);
             }
             break;
             
         case 150: // stwcx. (store word conditional)
             {
                 GuestAddr addr = (d.ra ? ctx.gpr[d.ra] : 0) + ctx.gpr[d.rb];
-                // Check per-thread reservation
-                bool success = memory_->check_reservation(ctx.thread_id, addr, 4);
-                if (success) {
-                    write_u32(ctx, addr, static_cast<u32>(ctx.gpr[d.rs]));
-                }
+                // Store only if this thread's reservation still holds
+                bool success = memory_->store_conditional(ctx.thread_id, addr, 4,
+                                                          static_cast<u32>(ctx.gpr[d.rs]));
                 // Set CR0: [lt, gt, eq, so] = [0, 0, success, xer.so]
                 u8 cr0_byte = (success ? 0x2 : 0) | (ctx.xer.so ? 0x1 : 0);
                 ctx.cr[0].from_byte(cr0_byte);
@@ -762,9 +760,8 @@ void Interpreter::exec_integer_ext31(ThreadContext& ctx, const DecodedInst& d) {
         case 214: // stdcx. (store doubleword conditional)
             {
                 GuestAddr addr = (d.ra ? ctx.gpr[d.ra] : 0) + ctx.gpr[d.rb];
-                // Check per-thread reservation
-                if (memory_->check_reservation(ctx.thread_id, addr, 8)) {
-                    write_u64(ctx, addr, ctx.gpr[d.rs]);
+                // Store only if this thread's reservation still holds
+                if (memory_->store_conditional(ctx.thread_id, addr, 8, ctx.gpr[d.rs])) {
                     ctx.cr[0].eq = true;
                 } else {
                     ctx.cr[0].eq = false;
@@ -970,11 +967,10 @@ void Interpreter::exec_integer_ext31(ThreadContext& ctx, const DecodedInst& d) {
             // Cache hints - no-op
             break;
             
-        case 1014: // dcbz
+        case 1014: // dcbz / dcbz128
             {
                 GuestAddr addr = (d.ra ? ctx.gpr[d.ra] : 0) + ctx.gpr[d.rb];
-                addr &= ~31; // Align to 32 bytes
-                memory_->zero_bytes(addr, 32);
+                zero_cache_block(addr, d.rd == 1 ? 128 : 32);
             }
             break;
             
@@ -0,0 +1,170 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Opcode execution profiler
+ */
+
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace x360mu {
+
+OpcodeProfiler::OpcodeProfiler() = default;
+
+void OpcodeProfiler::set_enabled(bool enabled) {
+    if (enabled) {
+        std::call_once(alloc_once_, [this] {
+            counts_ = std::make_unique<std::atomic<u64>[]>(NUM_KEYS);
+            samples_ = std::make_unique<std::atomic<u32>[]>(NUM_KEYS);
+        });
+    }
+    enabled_.store(enabled, std::memory_order_release);
+}
+
+u32 OpcodeProfiler::opcode_key(const DecodedInst& inst) {
+    u32 key = static_cast<u32>(inst.opcode & 0x3F) << 10;
+    switch (inst.opcode) {
+        case 4: case 19: case 30: case 31: case 59: case 63:
+            key |= inst.xo & 0x3FF;
+            break;
+        default:
+            break;
+    }
+    return key;
+}
+
+void OpcodeProfiler::record_instruction(u32 key, u32 raw) {
+    if (!enabled()) return;
+
+    key &= NUM_KEYS - 1;
+    if (counts_[key].fetch_add(1, std::memory_order_relaxed) == 0) {
+        samples_[key].store(raw, std::memory_order_relaxed);
+    }
+}
+
+void OpcodeProfiler::record_block(GuestAddr start, u32 instructions, u64 cycles) {
+    if (!enabled()) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    BlockStats& stats = blocks_[start];
+    stats.instructions = instructions;
+    stats.executions++;
+    stats.cycles += cycles;
+}
+
+void OpcodeProfiler::record_fallback(GuestAddr pc, u32 raw) {
+    if (!enabled()) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    FallbackStats& stats = fallbacks_[pc];
+    stats.raw = raw;
+    stats.count++;
+}
+
+std::vector<OpcodeProfiler::OpcodeEntry> OpcodeProfiler::opcode_counts() const {
+    std::vector<OpcodeEntry> entries;
+    if (!counts_) return entries;
+
+    for (u32 key = 0; key < NUM_KEYS; key++) {
+        u64 count = counts_[key].load(std::memory_order_relaxed);
+        if (count == 0) continue;
+
+        u32 raw = samples_[key].load(std::memory_order_relaxed);
+        entries.push_back({key, raw, Decoder::get_mnemonic(Decoder::decode(raw)), count});
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const OpcodeEntry& a, const OpcodeEntry& b) { return a.count > b.count; });
+    return entries;
+}
+
+std::vector<OpcodeProfiler::BlockEntry> OpcodeProfiler::hot_blocks() const {
+    std::vector<BlockEntry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries.reserve(blocks_.size());
+        for (const auto& [start, stats] : blocks_) {
+            entries.push_back({start, stats.instructions, stats.executions, stats.cycles});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const BlockEntry& a, const BlockEntry& b) { return a.cycles > b.cycles; });
+    return entries;
+}
+
+std::vector<OpcodeProfiler::FallbackEntry> OpcodeProfiler::fallbacks() const {
+    std::vector<FallbackEntry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries.reserve(fallbacks_.size());
+        for (const auto& [pc, stats] : fallbacks_) {
+            entries.push_back({pc, stats.raw, nullptr, stats.count});
+        }
+    }
+
+    for (auto& entry : entries) {
+        entry.mnemonic = Decoder::get_mnemonic(Decoder::decode(entry.raw));
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const FallbackEntry& a, const FallbackEntry& b) { return a.count > b.count; });
+    return entries;
+}
+
+std::string OpcodeProfiler::report(size_t max_rows) const {
+    std::string out;
+    char line[160];
+
+    auto opcodes = opcode_counts();
+    u64 total = 0;
+    for (const auto& entry : opcodes) total += entry.count;
+
+    snprintf(line, sizeof(line), "Opcode counts (%llu instructions, %zu distinct)\n",
+             (unsigned long long)total, opcodes.size());
+    out += line;
+    for (size_t i = 0; i < opcodes.size() && i < max_rows; i++) {
+        const auto& e = opcodes[i];
+        snprintf(line, sizeof(line), "  %-10s op=%-2u xo=%-4u %14llu  %5.1f%%\n",
+                 e.mnemonic, e.key >> 10, e.key & 0x3FF, (unsigned long long)e.count,
+                 total ? 100.0 * e.count / total : 0.0);
+        out += line;
+    }
+
+    auto blocks = hot_blocks();
+    snprintf(line, sizeof(line), "Hot blocks (%zu)\n", blocks.size());
+    out += line;
+    for (size_t i = 0; i < blocks.size() && i < max_rows; i++) {
+        const auto& e = blocks[i];
+        snprintf(line, sizeof(line), "  %08X  %3u insts  %12llu execs  %14llu cycles\n",
+                 e.start, e.instructions, (unsigned long long)e.executions,
+                 (unsigned long long)e.cycles);
+        out += line;
+    }
+
+    auto misses = fallbacks();
+    snprintf(line, sizeof(line), "JIT interpreter fallbacks (%zu)\n", misses.size());
+    out += line;
+    for (size_t i = 0; i < misses.size() && i < max_rows; i++) {
+        const auto& e = misses[i];
+        snprintf(line, sizeof(line), "  %08X  %08X  %-10s op=%-2u %12llu\n",
+                 e.pc, e.raw, e.mnemonic, e.raw >> 26, (unsigned long long)e.count);
+        out += line;
+    }
+
+    return out;
+}
+
+void OpcodeProfiler::reset() {
+    if (counts_) {
+        for (u32 key = 0; key < NUM_KEYS; key++) {
+            counts_[key].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks_.clear();
+    fallbacks_.clear();
+}
+
+} // namespace x360mu
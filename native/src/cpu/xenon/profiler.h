@@ -0,0 +1,119 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Opcode execution profiler
+ *
+ * Optional instrumentation shared by the interpreter and the JIT. Records
+ * how often each opcode executes, how many cycles each guest block costs,
+ * and which instructions the JIT could not compile. Used to decide where
+ * JIT effort pays off for a given title.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include "cpu.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace x360mu {
+
+class OpcodeProfiler {
+public:
+    OpcodeProfiler();
+
+    /**
+     * Enable/disable recording. Counters are allocated on first enable.
+     */
+    void set_enabled(bool enabled);
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    /**
+     * Profile key for an instruction: primary opcode, plus the extended
+     * opcode for the opcode groups that have one (4, 19, 30, 31, 59, 63)
+     */
+    static u32 opcode_key(const DecodedInst& inst);
+
+    /**
+     * Count one execution of an instruction (inst.raw must be set)
+     */
+    void record_instruction(const DecodedInst& inst) {
+        record_instruction(opcode_key(inst), inst.raw);
+    }
+    void record_instruction(u32 key, u32 raw);
+
+    /**
+     * Count one execution of a guest block
+     */
+    void record_block(GuestAddr start, u32 instructions, u64 cycles);
+
+    /**
+     * Count one execution of an instruction the JIT compiled as a fallback
+     */
+    void record_fallback(GuestAddr pc, u32 raw);
+
+    struct OpcodeEntry {
+        u32 key;
+        u32 sample_raw;         // First instruction word seen with this key
+        const char* mnemonic;
+        u64 count;
+    };
+
+    struct BlockEntry {
+        GuestAddr start;
+        u32 instructions;       // Instructions per execution (last seen)
+        u64 executions;
+        u64 cycles;             // Total estimated cycles
+    };
+
+    struct FallbackEntry {
+        GuestAddr pc;
+        u32 raw;
+        const char* mnemonic;
+        u64 count;
+    };
+
+    // Snapshots, sorted hottest first
+    std::vector<OpcodeEntry> opcode_counts() const;
+    std::vector<BlockEntry> hot_blocks() const;
+    std::vector<FallbackEntry> fallbacks() const;
+
+    /**
+     * Human-readable report of the top entries in each table
+     */
+    std::string report(size_t max_rows = 32) const;
+
+    /**
+     * Clear all counters
+     */
+    void reset();
+
+private:
+    static constexpr u32 NUM_KEYS = 64 << 10;   // 6-bit opcode x 10-bit xo
+
+    std::atomic<bool> enabled_{false};
+
+    // Indexed by opcode_key(); allocated on first enable
+    std::unique_ptr<std::atomic<u64>[]> counts_;
+    std::unique_ptr<std::atomic<u32>[]> samples_;
+    std::once_flag alloc_once_;
+
+    struct BlockStats {
+        u32 instructions = 0;
+        u64 executions = 0;
+        u64 cycles = 0;
+    };
+    struct FallbackStats {
+        u32 raw = 0;
+        u64 count = 0;
+    };
+    mutable std::mutex mutex_;
+    std::unordered_map<GuestAddr, BlockStats> blocks_;
+    std::unordered_map<GuestAddr, FallbackStats> fallbacks_;
+};
+
+} // namespace x360mu
@@ -8,6 +8,8 @@
 #include "cpu.h"
 #include "../../memory/memory.h"
 #include "../../kernel/kernel.h"
+#include "../../kernel/timer_queue.h"
+#include "../../core/guest_clock.h"
 #include <algorithm>
 #include <chrono>
 #include <unordered_map>
@@ -55,6 +57,14 @@ void SetCurrentGuestThread(GuestThread* thread) {
     g_current_guest_thread = thread;
 }
 
+GuestThread* GetCurrentFiberThread() {
+    GuestThread* thread = g_current_guest_thread;
+    if (thread && thread->fiber && Fiber::current() == thread->fiber.get()) {
+        return thread;
+    }
+    return nullptr;
+}
+
 void SetTlsTemplateInfo(GuestAddr raw_data_address, u32 data_size, u32 slot_count) {
     g_tls_template.raw_data_address = raw_data_address;
     g_tls_template.data_size = data_size;
@@ -73,11 +83,18 @@ ThreadScheduler::~ThreadScheduler() {
     shutdown();
 }
 
-Status ThreadScheduler::initialize(Memory* memory, Kernel* kernel, Cpu* cpu, u32 num_host_threads) {
+Status ThreadScheduler::initialize(Memory* memory, Kernel* kernel, Cpu* cpu, u32 num_host_threads,
+                                   SchedulingMode mode) {
     memory_ = memory;
     kernel_ = kernel;
     cpu_ = cpu;
     current_time_ = 0;
+    mode_ = mode;
+    
+    if (uses_fibers() && !Fiber::supported()) {
+        LOGW("Fibers are not supported on this host, using 1:1 threading");
+        mode_ = SchedulingMode::OneToOne;
+    }
     
     // Determine number of host threads to use
     if (num_host_threads == 0) {
@@ -89,6 +106,9 @@ Status ThreadScheduler::initialize(Memory* memory, Kernel* kernel, Cpu* cpu, u32
     LOGI("ThreadScheduler: using %u host threads for %u guest hardware threads", 
          num_host_threads_, 6u);
     
+    // Decide which host cores each hardware thread and service thread use
+    HostAffinity::instance().configure(host_affinity_config_);
+    
     // Initialize hardware thread state (legacy, kept for compatibility)
     for (u32 i = 0; i < 6; i++) {
         hw_threads_[i].current_thread = nullptr;
@@ -108,6 +128,38 @@ Status ThreadScheduler::initialize(Memory* memory, Kernel* kernel, Cpu* cpu, u32
     running_ = true;
     num_host_threads_ = 0;  // Disable legacy scheduler threads
     
+    // === M:N FIBER MODEL ===
+    // One worker per hardware thread; guest threads become fibers on them
+    if (mode_ == SchedulingMode::Fibers) {
+        for (u32 i = 0; i < fiber_workers_.size(); i++) {
+            auto& worker = fiber_workers_[i];
+            worker.stop = false;
+            worker.fibers = 0;
+            worker.run_queue.clear();
+            worker.sleepers.clear();
+            worker.switches = 0;
+            worker.host_thread = std::thread(&ThreadScheduler::fiber_worker_main, this, i);
+        }
+        LOGI("ThreadScheduler initialized with M:N fibers on %zu workers", fiber_workers_.size());
+        return Status::Ok;
+    }
+    
+    // === DETERMINISTIC MODEL ===
+    // Every fiber goes to worker 0, whose queues run() drains itself
+    if (mode_ == SchedulingMode::Deterministic) {
+        for (auto& worker : fiber_workers_) {
+            worker.stop = false;
+            worker.fibers = 0;
+            worker.run_queue.clear();
+            worker.sleepers.clear();
+            worker.switches = 0;
+        }
+        GuestClock::instance().set_virtual(true);
+        synced_time_base_ = GuestClock::instance().time_base();
+        LOGI("ThreadScheduler initialized with deterministic fibers on a virtual clock");
+        return Status::Ok;
+    }
+    
     LOGI("ThreadScheduler initialized with 1:1 threading model (no legacy hw_threads)");
     return Status::Ok;
 }
@@ -147,6 +199,48 @@ void ThreadScheduler::shutdown() {
     }
     LOGI("All 1:1 host threads joined");
     
+    // === M:N FIBER MODEL: Stop the workers ===
+    // Woken fibers get a moment to run to completion. Fibers still blocked
+    // after that (e.g. in an infinite guest wait) are abandoned mid-call;
+    // their stacks are released with the threads below.
+    if (mode_ == SchedulingMode::Fibers) {
+        auto grace_end = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+        while (std::chrono::steady_clock::now() < grace_end) {
+            bool any_running = false;
+            {
+                std::lock_guard<std::mutex> lock(threads_mutex_);
+                for (auto& thread : threads_) {
+                    if (thread->fiber && thread->is_running.load()) {
+                        any_running = true;
+                        break;
+                    }
+                }
+            }
+            if (!any_running) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        
+        for (auto& worker : fiber_workers_) {
+            {
+                std::lock_guard<std::mutex> lock(worker.mutex);
+                worker.stop = true;
+            }
+            worker.cv.notify_all();
+        }
+        for (auto& worker : fiber_workers_) {
+            if (worker.host_thread.joinable()) {
+                worker.host_thread.join();
+            }
+        }
+        LOGI("Fiber workers stopped");
+    }
+    
+    // Deterministic fibers have no workers; those not finished are abandoned
+    if (mode_ == SchedulingMode::Deterministic) {
+        GuestClock::instance().set_virtual(false);
+        TimerQueue::instance().clock_changed();
+    }
+    
     // Stop legacy hardware threads (scheduler infrastructure)
     for (auto& hw : hw_threads_) {
         hw.stop_flag = true;
@@ -330,15 +424,7 @@ GuestThread* ThreadScheduler::create_thread(GuestAddr entry_point, GuestAddr par
     memory_->write_u32(kthread_addr + 0xD0, thread->stack_base);   // stack_alloc_base
     
     // 0x130: create_time (Windows FILETIME: 100ns intervals since Jan 1, 1601)
-    {
-        auto now = std::chrono::system_clock::now();
-        auto unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
-            now.time_since_epoch()).count();
-        // Windows epoch offset: 11644473600 seconds between 1601 and 1970
-        constexpr u64 WINDOWS_EPOCH_OFFSET = 116444736000000000ULL;
-        u64 filetime = static_cast<u64>(unix_ns / 100) + WINDOWS_EPOCH_OFFSET;
-        memory_->write_u64(kthread_addr + 0x130, filetime);
-    }
+    memory_->write_u64(kthread_addr + 0x130, GuestClock::instance().system_time());
     
     // 0x144-0x148: More list entries
     memory_->write_u32(kthread_addr + 0x144, kthread_addr + 0x144);
@@ -402,182 +488,13 @@ GuestThread* ThreadScheduler::create_thread(GuestAddr entry_point, GuestAddr par
         // Only spawn host thread if there's actual code to run
         thread->should_run.store(!start_suspended);
         
-        // Capture needed pointers for the lambda
-        Cpu* cpu = cpu_;
-        Memory* memory = memory_;
-        
-        thread->host_thread = std::make_unique<std::thread>([ptr, cpu, memory, this]() {
-            // === SET THREAD-LOCAL STORAGE ===
-            // This allows syscall handlers to find this thread's context
-            SetCurrentGuestThread(ptr);
-            
-            LOGI("1:1 Host thread started for guest thread %u (entry=0x%08X)", 
-                 ptr->thread_id, (u32)ptr->context.pc);
-            
-            ptr->is_running.store(true);
-            
-            // Update KPCR's current thread pointer to this thread's KTHREAD
-            // This is crucial for game code that reads current thread directly from KPCR
-            {
-                u32 cpu_id = ptr->thread_id % 6;  // Assign to a processor
-                GuestAddr kpcr = 0x00010000 + (cpu_id * 0x1000);  // KPCR base from xkernel
-                GuestAddr kthread = 0x80070000 + (ptr->handle & 0xFFFF) * 0x200;  // This thread's KTHREAD
-                GuestAddr tls = ptr->tls_address;  // TLS data address (NOT r13, which is PCR!)
-                
-                // KPCR fields based on Xenia's X_KPCR
-                memory->write_u32(kpcr + 0x00, tls);      // KPCR + 0x0 = tls_ptr
-                memory->write_u32(kpcr + 0x30, kpcr);     // KPCR + 0x30 = pcr_ptr (self)
-                memory->write_u32(kpcr + 0x70, ptr->stack_base);   // stack_base_ptr
-                memory->write_u32(kpcr + 0x74, ptr->stack_limit);  // stack_end_ptr
-                memory->write_u32(kpcr + 0x100, kthread); // KPCR + 0x100 = current_thread
-                memory->write_u8(kpcr + 0x10C, cpu_id);   // KPCR + 0x10C = current_cpu
-                
-                LOGI("Updated KPCR[%u]: tls=0x%08X, kthread=0x%08X, stack=0x%08X-0x%08X, pcr=0x%08X",
-                     cpu_id, tls, kthread, ptr->stack_base, ptr->stack_limit, ptr->pcr_address);
-            }
-            
-            // Wait until we should run (handles CREATE_SUSPENDED)
-            {
-                std::unique_lock<std::mutex> lock(ptr->wait_mutex);
-                ptr->wait_cv.wait(lock, [ptr]{ return ptr->should_run.load(); });
-            }
-            
-            // Main execution loop - run until thread terminates
-            static int loop_log_counter = 0;
-            static u64 last_pc = 0;
-            static int same_pc_count = 0;
-            while (ptr->should_run.load() && ptr->state != ThreadState::Terminated) {
-                loop_log_counter++;
-                
-                // Track if PC is changing - detect infinite loops
-                if (ptr->context.pc == last_pc) {
-                    same_pc_count++;
-                    if (same_pc_count == 100 || same_pc_count == 1000 || same_pc_count == 10000) {
-                        LOGI("1:1 thread %u: STUCK at PC=0x%08llX for %d iterations",
-                             ptr->thread_id, ptr->context.pc, same_pc_count);
-                    }
-                } else {
-                    if (same_pc_count > 100) {
-                        LOGI("1:1 thread %u: moved from PC=0x%08llX (was stuck %d iters) to PC=0x%08llX",
-                             ptr->thread_id, last_pc, same_pc_count, ptr->context.pc);
-                    }
-                    same_pc_count = 0;
-                    last_pc = ptr->context.pc;
-                }
-                
-                if (loop_log_counter <= 10 || (loop_log_counter % 50000 == 0)) {
-                    LOGI("1:1 thread %u loop #%d: state=%d, PC=0x%08llX",
-                         ptr->thread_id, loop_log_counter, (int)ptr->state, ptr->context.pc);
-                }
-                
-                if (ptr->state == ThreadState::Waiting) {
-                    // Thread is in a blocking wait - actually block here
-                    LOGI("1:1 thread %u entering wait (loop #%d)", ptr->thread_id, loop_log_counter);
-                    std::unique_lock<std::mutex> lock(ptr->wait_mutex);
-                    ptr->wait_cv.wait(lock, [ptr]{ 
-                        return ptr->wait_signaled || !ptr->should_run.load() ||
-                               ptr->state != ThreadState::Waiting;
-                    });
-                    LOGI("1:1 thread %u woke from wait: signaled=%d, should_run=%d, state=%d",
-                         ptr->thread_id, ptr->wait_signaled, ptr->should_run.load(), (int)ptr->state);
-                    
-                    if (ptr->wait_signaled) {
-                        ptr->state = ThreadState::Running;
-                        ptr->wait_signaled = false;
-                    }
-                    continue;
-                }
-                
-                if (ptr->state == ThreadState::Suspended) {
-                    // Thread is suspended - wait for resume
-                    std::unique_lock<std::mutex> lock(ptr->wait_mutex);
-                    ptr->wait_cv.wait(lock, [ptr]{ 
-                        return ptr->suspend_count == 0 || !ptr->should_run.load();
-                    });
-                    if (ptr->suspend_count == 0) {
-                        ptr->state = ThreadState::Ready;
-                    }
-                    continue;
-                }
-                
-                // Execute guest code
-                ptr->state = ThreadState::Running;
-                ptr->context.running = true;
-                
-                // Execute a batch of cycles
-                constexpr u64 CYCLES_PER_BATCH = 10000;
-                cpu->execute_with_context(ptr->thread_id, ptr->context, CYCLES_PER_BATCH);
-                
-                // Check if thread exited (LR=0 and PC=0 means returned from entry)
-                if (ptr->context.pc == 0) {
-                    LOGI("Guest thread %u returned (exit)", ptr->thread_id);
-                    ptr->state = ThreadState::Terminated;
-                    break;
-                }
-                
-                ptr->execution_time += CYCLES_PER_BATCH;
-                
-                // Yield occasionally to other threads
-                std::this_thread::yield();
-            }
-            
-            ptr->is_running.store(false);
-            ptr->context.running = false;
-            LOGI("1:1 Host thread ended for guest thread %u", ptr->thread_id);
-        });
+        start_thread(ptr, [this, ptr]() { guest_thread_main(ptr); });
     } else if (thread->is_worker_thread) {
         // Worker thread (entry=0): Spawn host thread that processes work queue items
         LOGI("Spawning 1:1 host thread for worker thread %u (queue_type=%d)",
              thread->thread_id, static_cast<int>(thread->worker_queue_type));
         
-        ptr->host_thread = std::make_unique<std::thread>([ptr, scheduler = this]() {
-            LOGI("1:1 Worker host thread started for guest worker thread %u", ptr->thread_id);
-            ptr->is_running.store(true);
-            
-            int loop_count = 0;
-            int work_processed = 0;
-            
-            while (ptr->should_run.load()) {
-                loop_count++;
-                
-                // Log periodically
-                if (loop_count == 1 || loop_count == 100 || loop_count % 10000 == 0) {
-                    LOGI("Worker thread %u loop #%d: processed %d items so far",
-                         ptr->thread_id, loop_count, work_processed);
-                }
-                
-                // Handle waiting state
-                if (ptr->state == ThreadState::Waiting) {
-                    std::unique_lock<std::mutex> lock(ptr->wait_mutex);
-                    ptr->wait_cv.wait(lock, [ptr]{ 
-                        return ptr->wait_signaled || !ptr->should_run.load() ||
-                               ptr->state != ThreadState::Waiting;
-                    });
-                    if (ptr->wait_signaled) {
-                        ptr->state = ThreadState::Ready;
-                        ptr->wait_signaled = false;
-                    }
-                    continue;
-                }
-                
-                // Process work queue items
-                ptr->state = ThreadState::Running;
-                bool did_work = scheduler->process_worker_thread(ptr);
-                
-                if (did_work) {
-                    work_processed++;
-                } else {
-                    // No work available - yield and sleep briefly to avoid busy spinning
-                    ptr->state = ThreadState::Ready;
-                    std::this_thread::yield();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-                }
-            }
-            
-            ptr->is_running.store(false);
-            LOGI("1:1 Worker host thread ended for guest worker thread %u (processed %d items)",
-                 ptr->thread_id, work_processed);
-        });
+        start_thread(ptr, [this, ptr]() { worker_thread_main(ptr); });
     } else {
         // entry_point == 0 but not a worker thread - this shouldn't happen
         LOGW("Thread %u has entry=0 but is_worker_thread=false, skipping host thread", 
@@ -590,6 +507,261 @@ GuestThread* ThreadScheduler::create_thread(GuestAddr entry_point, GuestAddr par
     return ptr;
 }
 
+void ThreadScheduler::start_thread(GuestThread* thread, std::function<void()> body) {
+    thread->scheduler = this;
+    if (uses_fibers()) {
+        thread->fiber = std::make_unique<Fiber>(body);
+        if (thread->fiber->valid()) {
+            thread->fiber_worker = pick_fiber_worker(thread->affinity_mask);
+            LOGI("Guest thread %u runs as a fiber on worker %u",
+                 thread->thread_id, thread->fiber_worker);
+            // A thread created suspended stays parked until resume_thread()
+            if (thread->should_run.load()) {
+                make_runnable(thread);
+            } else {
+                thread->parked = true;
+            }
+            return;
+        }
+        LOGW("Fiber stack allocation failed for thread %u, using a host thread",
+             thread->thread_id);
+        thread->fiber.reset();
+    }
+    
+    thread->host_thread = std::make_unique<std::thread>([this, thread, body = std::move(body)]() {
+        place_host_thread(thread);
+        body();
+        thread->host_tid.store(0);
+    });
+}
+
+int ThreadScheduler::host_nice(ThreadPriority priority) {
+    // Android's URGENT_DISPLAY and DISPLAY levels; everything else stays normal
+    switch (priority) {
+        case ThreadPriority::TimeCritical: return -8;
+        case ThreadPriority::Highest:      return -4;
+        default:                           return 0;
+    }
+}
+
+void ThreadScheduler::place_host_thread(GuestThread* thread) {
+    auto& affinity = HostAffinity::instance();
+    s32 tid = HostAffinity::current_thread_id();
+    thread->host_tid.store(tid);
+    
+    if (affinity.enabled()) {
+        HostAffinity::pin_thread(tid, affinity.guest_cpus(thread->affinity_mask));
+    }
+    if (affinity.boost_priority()) {
+        int nice = host_nice(thread->priority);
+        if (nice != 0 && !HostAffinity::set_thread_nice(tid, nice)) {
+            LOGD("Could not raise host priority of thread %u", thread->thread_id);
+        }
+    }
+}
+
+void ThreadScheduler::guest_thread_main(GuestThread* thread) {
+    // === SET THREAD-LOCAL STORAGE ===
+    // This allows syscall handlers to find this thread's context
+    SetCurrentGuestThread(thread);
+    
+    LOGI("1:1 Host thread started for guest thread %u (entry=0x%08X)", 
+         thread->thread_id, (u32)thread->context.pc);
+    
+    thread->is_running.store(true);
+    
+    // Update KPCR's current thread pointer to this thread's KTHREAD
+    // This is crucial for game code that reads current thread directly from KPCR
+    {
+        u32 cpu_id = thread->thread_id % 6;  // Assign to a processor
+        GuestAddr kpcr = 0x00010000 + (cpu_id * 0x1000);  // KPCR base from xkernel
+        GuestAddr kthread = 0x80070000 + (thread->handle & 0xFFFF) * 0x200;  // This thread's KTHREAD
+        GuestAddr tls = thread->tls_address;  // TLS data address (NOT r13, which is PCR!)
+        
+        // KPCR fields based on Xenia's X_KPCR
+        memory_->write_u32(kpcr + 0x00, tls);      // KPCR + 0x0 = tls_ptr
+        memory_->write_u32(kpcr + 0x30, kpcr);     // KPCR + 0x30 = pcr_ptr (self)
+        memory_->write_u32(kpcr + 0x70, thread->stack_base);   // stack_base_ptr
+        memory_->write_u32(kpcr + 0x74, thread->stack_limit);  // stack_end_ptr
+        memory_->write_u32(kpcr + 0x100, kthread); // KPCR + 0x100 = current_thread
+        memory_->write_u8(kpcr + 0x10C, cpu_id);   // KPCR + 0x10C = current_cpu
+        
+        LOGI("Updated KPCR[%u]: tls=0x%08X, kthread=0x%08X, stack=0x%08X-0x%08X, pcr=0x%08X",
+             cpu_id, tls, kthread, thread->stack_base, thread->stack_limit, thread->pcr_address);
+    }
+    
+    // Wait until we should run (handles CREATE_SUSPENDED)
+    wait_until_woken(thread, [this, thread]{ return thread->should_run.load() || !running_; });
+    
+    // Main execution loop - run until thread terminates
+    static int loop_log_counter = 0;
+    static u64 last_pc = 0;
+    static int same_pc_count = 0;
+    while (thread->should_run.load() && thread->state != ThreadState::Terminated) {
+        loop_log_counter++;
+        
+        // Track if PC is changing - detect infinite loops
+        if (thread->context.pc == last_pc) {
+            same_pc_count++;
+            if (same_pc_count == 100 || same_pc_count == 1000 || same_pc_count == 10000) {
+                LOGI("1:1 thread %u: STUCK at PC=0x%08llX for %d iterations",
+                     thread->thread_id, thread->context.pc, same_pc_count);
+            }
+        } else {
+            if (same_pc_count > 100) {
+                LOGI("1:1 thread %u: moved from PC=0x%08llX (was stuck %d iters) to PC=0x%08llX",
+                     thread->thread_id, last_pc, same_pc_count, thread->context.pc);
+            }
+            same_pc_count = 0;
+            last_pc = thread->context.pc;
+        }
+        
+        if (loop_log_counter <= 10 || (loop_log_counter % 50000 == 0)) {
+            LOGI("1:1 thread %u loop #%d: state=%d, PC=0x%08llX",
+                 thread->thread_id, loop_log_counter, (int)thread->state, thread->context.pc);
+        }
+        
+        if (thread->state == ThreadState::Waiting) {
+            // Thread is in a blocking wait - actually block here
+            LOGI("1:1 thread %u entering wait (loop #%d)", thread->thread_id, loop_log_counter);
+            wait_until_woken(thread, [thread]{ 
+                return thread->wait_signaled || !thread->should_run.load() ||
+                       thread->state != ThreadState::Waiting;
+            });
+            std::lock_guard<std::mutex> lock(thread->wait_mutex);
+            LOGI("1:1 thread %u woke from wait: signaled=%d, should_run=%d, state=%d",
+                 thread->thread_id, thread->wait_signaled, thread->should_run.load(), (int)thread->state);
+            
+            if (thread->wait_signaled) {
+                thread->state = ThreadState::Running;
+                thread->wait_signaled = false;
+            }
+            continue;
+        }
+        
+        if (thread->state == ThreadState::Suspended) {
+            // Thread is suspended - wait for resume
+            wait_until_woken(thread, [thread]{ 
+                return thread->suspend_count == 0 || !thread->should_run.load();
+            });
+            if (thread->suspend_count == 0) {
+                thread->state = ThreadState::Ready;
+            }
+            continue;
+        }
+        
+        // Execute guest code
+        thread->state = ThreadState::Running;
+        thread->context.running = true;
+        
+        // Execute a batch of cycles
+        constexpr u64 CYCLES_PER_BATCH = 10000;
+        u64 executed = cpu_->execute_with_context(thread->thread_id, thread->context,
+                                                  CYCLES_PER_BATCH);
+        
+        // Check if thread exited (LR=0 and PC=0 means returned from entry)
+        if (thread->context.pc == 0) {
+            LOGI("Guest thread %u returned (exit)", thread->thread_id);
+            thread->state = ThreadState::Terminated;
+            break;
+        }
+        
+        thread->execution_time += executed;
+        
+        // Yield occasionally to other threads. In fiber mode this ends the
+        // time slice so the next ready fiber on this worker gets to run.
+        if (thread->fiber) {
+            yield(thread);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    
+    thread->is_running.store(false);
+    thread->context.running = false;
+    LOGI("1:1 Host thread ended for guest thread %u", thread->thread_id);
+}
+
+void ThreadScheduler::worker_thread_main(GuestThread* thread) {
+    LOGI("1:1 Worker host thread started for guest worker thread %u", thread->thread_id);
+    thread->is_running.store(true);
+    
+    int loop_count = 0;
+    int work_processed = 0;
+    
+    while (thread->should_run.load()) {
+        loop_count++;
+        
+        // Log periodically
+        if (loop_count == 1 || loop_count == 100 || loop_count % 10000 == 0) {
+            LOGI("Worker thread %u loop #%d: processed %d items so far",
+                 thread->thread_id, loop_count, work_processed);
+        }
+        
+        // Handle waiting state
+        if (thread->state == ThreadState::Waiting) {
+            wait_until_woken(thread, [thread]{ 
+                return thread->wait_signaled || !thread->should_run.load() ||
+                       thread->state != ThreadState::Waiting;
+            });
+            std::lock_guard<std::mutex> lock(thread->wait_mutex);
+            if (thread->wait_signaled) {
+                thread->state = ThreadState::Ready;
+                thread->wait_signaled = false;
+            }
+            continue;
+        }
+        
+        // Process work queue items
+        thread->state = ThreadState::Running;
+        bool did_work = process_worker_thread(thread);
+        
+        if (did_work) {
+            work_processed++;
+        } else {
+            // No work available. Host threads already parked in dequeue()
+            // until an enqueue woke them or it timed out; fibers poll.
+            thread->state = ThreadState::Ready;
+            if (thread->fiber) {
+                park(thread, 1000000);
+            }
+        }
+    }
+    
+    thread->is_running.store(false);
+    LOGI("1:1 Worker host thread ended for guest worker thread %u (processed %d items)",
+         thread->thread_id, work_processed);
+}
+
+GuestThread* ThreadScheduler::create_system_thread(std::function<void(GuestThread*)> routine,
+                                                   u32 affinity_mask) {
+    std::lock_guard<std::mutex> lock(threads_mutex_);
+    
+    auto thread = std::make_unique<GuestThread>();
+    thread->reset();
+    thread->thread_id = next_thread_id_++;
+    thread->handle = next_handle_++;
+    thread->affinity_mask = (affinity_mask & kAllThreads) ? (affinity_mask & kAllThreads)
+                                                          : kAllThreads;
+    thread->is_system_thread = true;
+    thread->state = ThreadState::Ready;
+    thread->should_run.store(true);
+    thread->system_routine = std::move(routine);
+    
+    GuestThread* ptr = thread.get();
+    start_thread(ptr, [ptr]() {
+        SetCurrentGuestThread(ptr);
+        ptr->is_running.store(true);
+        ptr->system_routine(ptr);
+        ptr->state = ThreadState::Terminated;
+        ptr->is_running.store(false);
+    });
+    
+    stats_.total_threads_created++;
+    threads_.push_back(std::move(thread));
+    return ptr;
+}
+
 void ThreadScheduler::terminate_thread(GuestThread* thread, u32 exit_code) {
     if (!thread) return;
     
@@ -615,6 +787,16 @@ void ThreadScheduler::terminate_thread(GuestThread* thread, u32 exit_code) {
         }
         ht->join();
         LOGI("Host thread for guest %u joined", thread->thread_id);
+    } else if (thread->fiber && thread != GetCurrentFiberThread()) {
+        // Fiber mode: let the fiber leave its run loop before its stack goes
+        GuestThread* current = GetCurrentFiberThread();
+        while (thread->is_running.load()) {
+            if (current) {
+                yield(current);
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
     }
     
     std::lock_guard<std::mutex> lock(threads_mutex_);
@@ -662,9 +844,9 @@ u32 ThreadScheduler::resume_thread(GuestThread* thread) {
     if (thread->suspend_count == 0 && thread->state == ThreadState::Suspended) {
         thread->state = ThreadState::Ready;
         
-        // === 1:1 THREADING MODEL: Wake the host thread ===
+        // === Wake the host thread (or fiber) ===
         thread->should_run.store(true);
-        thread->wait_cv.notify_one();
+        unpark(thread);
         
         LOGI("Resumed thread %u", thread->thread_id);
     }
@@ -690,6 +872,14 @@ void ThreadScheduler::set_priority(GuestThread* thread, ThreadPriority priority)
     if (was_ready) {
         enqueue_thread(thread);
     }
+    
+    // 1:1 threads carry the priority over to their host thread
+    s32 tid = thread->host_tid.load();
+    if (tid && HostAffinity::instance().boost_priority()) {
+        if (!HostAffinity::set_thread_nice(tid, host_nice(priority))) {
+            LOGD("Could not set host priority of thread %u", thread->thread_id);
+        }
+    }
 }
 
 void ThreadScheduler::set_affinity(GuestThread* thread, u32 affinity_mask) {
@@ -698,6 +888,24 @@ void ThreadScheduler::set_affinity(GuestThread* thread, u32 affinity_mask) {
         if (thread->affinity_mask == 0) {
             thread->affinity_mask = kAllThreads;  // Default to all
         }
+        
+        // 1:1 threads move their host thread to the matching cores
+        auto& affinity = HostAffinity::instance();
+        if (s32 tid = thread->host_tid.load(); tid && affinity.enabled()) {
+            HostAffinity::pin_thread(tid, affinity.guest_cpus(thread->affinity_mask));
+        }
+        
+        // Fibers are pinned once started (they may be blocked inside a
+        // syscall holding host state); one created suspended that has not
+        // run yet moves to a worker its new mask allows
+        if (thread->fiber && !(thread->affinity_mask & (1u << thread->fiber_worker))) {
+            std::lock_guard<std::mutex> threads_lock(threads_mutex_);
+            std::lock_guard<std::mutex> lock(thread->wait_mutex);
+            if (thread->parked && !thread->is_running.load()) {
+                fiber_workers_[thread->fiber_worker].fibers--;
+                thread->fiber_worker = pick_fiber_worker(thread->affinity_mask);
+            }
+        }
     }
 }
 
@@ -792,6 +1000,10 @@ int ThreadScheduler::priority_to_queue_index(ThreadPriority priority) const {
 }
 
 u64 ThreadScheduler::run(u64 cycles) {
+    if (mode_ == SchedulingMode::Deterministic) {
+        return run_deterministic(cycles);
+    }
+    
     u64 total_executed = 0;
     
     // === 1:1 THREADING MODEL ===
@@ -817,6 +1029,12 @@ u64 ThreadScheduler::run(u64 cycles) {
 void ThreadScheduler::yield(GuestThread* thread) {
     if (!thread) return;
     
+    // Fiber mode: go to the back of this worker's run queue
+    if (thread->fiber && Fiber::current() == thread->fiber.get()) {
+        switch_out(thread, FiberWorker::Action::Yield);
+        return;
+    }
+    
     // Put back in ready queue
     thread->state = ThreadState::Ready;
     enqueue_thread(thread);
@@ -834,6 +1052,10 @@ void ThreadScheduler::yield(GuestThread* thread) {
 void ThreadScheduler::sleep(GuestThread* thread, u64 nanoseconds) {
     if (!thread) return;
 
+    {
+        std::lock_guard<std::mutex> lock(thread->wait_mutex);
+        thread->wait_signaled = false;
+    }
     thread->state = ThreadState::Waiting;
     thread->wait_timeout = current_time_ + (nanoseconds / 100);  // Convert to ~cycles
 
@@ -880,21 +1102,40 @@ u32 ThreadScheduler::wait_for_object(GuestThread* thread, GuestAddr object, u64
     }
     
     // Mark thread as waiting
+    {
+        std::lock_guard<std::mutex> lock(thread->wait_mutex);
+        thread->wait_signaled = false;
+    }
     thread->state = ThreadState::Waiting;
     thread->wait_object = object;
-    thread->wait_signaled = false;
+    
+    // A signal_object() between the check above and publishing the wait
+    // would not have seen us; recheck now that it will
+    if (memory_->read_u32(object + 4) > 0) {
+        if (header.type == static_cast<u8>(KernelObjectType::SynchronizationEvent)) {
+            memory_->write_u32(object + 4, 0);
+        }
+        thread->state = ThreadState::Running;
+        thread->wait_object = 0;
+        return 0;
+    }
     
     stats_.waiting_thread_count++;
     
-    // Convert timeout
-    u64 timeout_ms = (timeout_ns == ~0ULL) ? 0 : (timeout_ns / 1000000);
+    // Convert timeout (rounded up so short waits don't become infinite)
+    u64 timeout_ms = (timeout_ns == ~0ULL) ? 0 : (timeout_ns + 999999) / 1000000;
     
-    // ACTUALLY BLOCK using the thread's condition variable
+    // ACTUALLY BLOCK on the thread's parking word
     // The thread will be woken when signal_object() is called
     u32 result = thread->block_until_signaled(timeout_ms);
     
     stats_.waiting_thread_count--;
     
+    // Timed out: nobody moved us out of Waiting
+    if (thread->state == ThreadState::Waiting) {
+        thread->state = ThreadState::Running;
+    }
+    
     if (result == 0) {
         // Successfully signaled
         // For auto-reset events, clear the signal
@@ -985,6 +1226,10 @@ GuestThread* ThreadScheduler::get_thread_by_handle(u32 handle) {
 }
 
 ThreadScheduler::Stats ThreadScheduler::get_stats() const {
+    stats_.fiber_switches = 0;
+    for (const auto& worker : fiber_workers_) {
+        stats_.fiber_switches += worker.switches.load(std::memory_order_relaxed);
+    }
     stats_.active_thread_count = 0;
     for (const auto& thread : threads_) {
         if (thread->state != ThreadState::Terminated) {
@@ -1107,6 +1352,349 @@ void ThreadScheduler::execute_thread(u32 hw_thread_id) {
     }
 }
 
+//=============================================================================
+// Blocking (1:1 and M:N fiber modes)
+//=============================================================================
+
+u32 GuestThread::block_until_signaled(u64 timeout_ms) {
+    // Parks the fiber (M:N) or the host thread (1:1) until signal_wake().
+    // Callers clear wait_signaled before publishing the wait, so a wake that
+    // lands before we get here is not lost.
+    // The deadline is on the guest clock so it is virtual in deterministic mode
+    auto& clock = GuestClock::instance();
+    u64 deadline = clock.now_ns() + timeout_ms * 1000000ULL;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            if (wait_signaled || !should_run.load()) break;
+        }
+        u64 park_ns = Parker::INFINITE;
+        if (timeout_ms != 0) {
+            u64 now = clock.now_ns();
+            if (now >= deadline) {
+                return 0x00000102;  // STATUS_TIMEOUT
+            }
+            park_ns = deadline - now;
+        }
+        if (scheduler) {
+            scheduler->park(this, park_ns);
+        } else {
+            parker.park(park_ns);
+        }
+    }
+    
+    if (!should_run.load()) {
+        return 0xC0000001;  // STATUS_UNSUCCESSFUL - thread terminating
+    }
+    
+    return wait_result;
+}
+
+void GuestThread::signal_wake(u32 result) {
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        wait_signaled = true;
+        wait_result = result;
+    }
+    if (scheduler) {
+        scheduler->unpark(this);
+    } else {
+        parker.unpark();
+    }
+}
+
+template <typename Predicate>
+void ThreadScheduler::wait_until_woken(GuestThread* thread, Predicate ready) {
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(thread->wait_mutex);
+            if (ready()) return;
+        }
+        park(thread);
+    }
+}
+
+void ThreadScheduler::park(GuestThread* thread, u64 timeout_ns) {
+    if (!thread) return;
+    
+    // 1:1 (or a fiber thread touched from outside its fiber): the futex word
+    if (!thread->fiber || Fiber::current() != thread->fiber.get()) {
+        if (running_) {
+            thread->parker.park(timeout_ns);
+        }
+        return;
+    }
+    
+    using Clock = std::chrono::steady_clock;
+    bool timed = timeout_ns != Parker::INFINITE;
+    Clock::time_point deadline = Clock::time_point::max();
+    if (timed) {
+        // Deterministic mode keeps sleepers on the virtual clock instead
+        Clock::time_point now = mode_ == SchedulingMode::Deterministic
+            ? Clock::time_point(std::chrono::nanoseconds(GuestClock::instance().now_ns()))
+            : Clock::now();
+        deadline = now + std::chrono::nanoseconds(
+            std::min<u64>(timeout_ns, 365ULL * 24 * 3600 * 1000000000ULL));
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(thread->wait_mutex);
+        if (thread->wake_permit) {
+            thread->wake_permit = false;
+            return;
+        }
+    }
+    if (!running_) {
+        // Shutting down: hand control back so the worker can stop
+        switch_out(thread, FiberWorker::Action::Yield);
+        return;
+    }
+    if (timed && timeout_ns == 0) return;
+    
+    // The worker finishes the park after the switch (see run_fiber)
+    switch_out(thread, FiberWorker::Action::Park, deadline);
+}
+
+void ThreadScheduler::unpark(GuestThread* thread) {
+    if (!thread) return;
+    
+    if (!thread->fiber) {
+        thread->parker.unpark();
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(thread->wait_mutex);
+        if (!thread->parked) {
+            thread->wake_permit = true;
+            return;
+        }
+        thread->parked = false;
+        thread->park_seq++;
+    }
+    make_runnable(thread);
+}
+
+//=============================================================================
+// M:N Fiber Scheduling
+//=============================================================================
+
+u32 ThreadScheduler::pick_fiber_worker(u32 affinity_mask) {
+    // Least loaded worker the mask allows (caller holds threads_mutex_)
+    if (mode_ == SchedulingMode::Deterministic) {
+        fiber_workers_[0].fibers++;
+        return 0;
+    }
+    u32 best = 0;
+    bool found = false;
+    for (u32 i = 0; i < fiber_workers_.size(); i++) {
+        if (!(affinity_mask & (1u << i))) continue;
+        if (!found || fiber_workers_[i].fibers < fiber_workers_[best].fibers) {
+            best = i;
+            found = true;
+        }
+    }
+    fiber_workers_[best].fibers++;
+    return best;
+}
+
+void ThreadScheduler::make_runnable(GuestThread* thread) {
+    auto& worker = fiber_workers_[thread->fiber_worker];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.run_queue.push_back(thread);
+    }
+    worker.cv.notify_one();
+}
+
+void ThreadScheduler::wake_timed_out(GuestThread* thread, u32 park_seq) {
+    {
+        std::lock_guard<std::mutex> lock(thread->wait_mutex);
+        if (!thread->parked || thread->park_seq != park_seq) return;  // Already woken
+        thread->parked = false;
+        thread->park_seq++;
+    }
+    make_runnable(thread);
+}
+
+void ThreadScheduler::switch_out(GuestThread* thread, FiberWorker::Action action,
+                                 std::chrono::steady_clock::time_point deadline) {
+    // Runs on the fiber, i.e. on the worker's host thread
+    auto& worker = fiber_workers_[thread->fiber_worker];
+    worker.action = action;
+    worker.park_deadline = deadline;
+    thread->fiber->suspend();
+}
+
+void ThreadScheduler::run_fiber(FiberWorker& worker, GuestThread* thread) {
+    worker.current = thread;
+    worker.action = FiberWorker::Action::None;
+    SetCurrentGuestThread(thread);
+    
+    thread->fiber->resume();
+    
+    SetCurrentGuestThread(nullptr);
+    worker.current = nullptr;
+    worker.switches.fetch_add(1, std::memory_order_relaxed);
+    
+    if (thread->fiber->finished()) return;
+    if (worker.stop) return;  // Abandoned at shutdown
+    
+    if (worker.action == FiberWorker::Action::Park) {
+        // Park only if no unpark() slipped in since the fiber checked its
+        // permit; unpark() of a parked thread requeues it itself
+        std::unique_lock<std::mutex> lock(thread->wait_mutex);
+        if (!thread->wake_permit) {
+            thread->parked = true;
+            u32 seq = thread->park_seq;
+            lock.unlock();
+            
+            if (worker.park_deadline != std::chrono::steady_clock::time_point::max()) {
+                std::lock_guard<std::mutex> worker_lock(worker.mutex);
+                worker.sleepers.emplace(worker.park_deadline, std::make_pair(thread, seq));
+            }
+            return;
+        }
+        thread->wake_permit = false;
+    }
+    
+    make_runnable(thread);
+}
+
+void ThreadScheduler::fiber_worker_main(u32 index) {
+    auto& worker = fiber_workers_[index];
+    std::vector<std::pair<GuestThread*, u32>> expired;
+    
+    // Worker i is Xenon hardware thread i
+    auto& affinity = HostAffinity::instance();
+    if (affinity.enabled()) {
+        HostAffinity::pin_thread(HostAffinity::current_thread_id(), affinity.hw_thread_cpus(index));
+    }
+    
+    LOGI("Fiber worker %u started", index);
+    
+    while (true) {
+        GuestThread* next = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            while (true) {
+                auto now = std::chrono::steady_clock::now();
+                while (!worker.sleepers.empty() && worker.sleepers.begin()->first <= now) {
+                    expired.push_back(worker.sleepers.begin()->second);
+                    worker.sleepers.erase(worker.sleepers.begin());
+                }
+                if (worker.stop) {
+                    LOGI("Fiber worker %u stopped", index);
+                    return;
+                }
+                if (!expired.empty()) break;
+                
+                if (!worker.run_queue.empty()) {
+                    next = worker.run_queue.front();
+                    worker.run_queue.pop_front();
+                    break;
+                }
+                
+                if (worker.sleepers.empty()) {
+                    worker.cv.wait(lock);
+                } else {
+                    worker.cv.wait_until(lock, worker.sleepers.begin()->first);
+                }
+            }
+        }
+        
+        // Timed-out parks are requeued outside the worker lock (the thread
+        // lock is taken first everywhere else)
+        if (!expired.empty()) {
+            for (auto& [thread, seq] : expired) {
+                wake_timed_out(thread, seq);
+            }
+            expired.clear();
+            continue;
+        }
+        
+        run_fiber(worker, next);
+    }
+}
+
+u64 ThreadScheduler::run_deterministic(u64 cycles) {
+    // Worker 0's loop, run on this thread: expired sleepers and timers are
+    // woken whenever guest time moves, then the queue front runs a slice.
+    // With nothing runnable the clock skips ahead to the next deadline.
+    auto& clock = GuestClock::instance();
+    auto& worker = fiber_workers_[0];
+    using Clock = std::chrono::steady_clock;
+    std::vector<std::pair<GuestThread*, u32>> expired;
+    
+    u64 start = clock.cycles();
+    u64 end = start + cycles;
+    while (running_ && clock.cycles() < end) {
+        Clock::time_point now(std::chrono::nanoseconds(clock.now_ns()));
+        GuestThread* next = nullptr;
+        Clock::time_point next_sleeper = Clock::time_point::max();
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            while (!worker.sleepers.empty() && worker.sleepers.begin()->first <= now) {
+                expired.push_back(worker.sleepers.begin()->second);
+                worker.sleepers.erase(worker.sleepers.begin());
+            }
+            if (expired.empty() && !worker.run_queue.empty()) {
+                next = worker.run_queue.front();
+                worker.run_queue.pop_front();
+            }
+            if (!worker.sleepers.empty()) {
+                next_sleeper = worker.sleepers.begin()->first;
+            }
+        }
+        
+        if (!expired.empty()) {
+            for (auto& [thread, seq] : expired) {
+                wake_timed_out(thread, seq);
+            }
+            expired.clear();
+            continue;
+        }
+        
+        // Timer expiries queue DPCs and unpark sleeping guest threads
+        if (TimerQueue::instance().run_expired() > 0) {
+            continue;
+        }
+        
+        if (next) {
+            u64 before = next->execution_time;
+            run_fiber(worker, next);
+            u64 executed = next->execution_time - before;
+            clock.advance(std::max(executed, DETERMINISTIC_MIN_SLICE));
+            continue;
+        }
+        
+        // Idle: jump to whichever comes first, a sleeper, a timer or the end
+        u64 target = end;
+        if (next_sleeper != Clock::time_point::max()) {
+            u64 ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                next_sleeper.time_since_epoch()).count();
+            target = std::min(target, GuestClock::ns_to_cycles(ns));
+        }
+        u64 timer_due = TimerQueue::instance().next_due();
+        if (timer_due != ~0ULL) {
+            target = std::min(target, GuestClock::ns_to_cycles(timer_due * 100));
+        }
+        clock.advance(std::max<u64>(target, clock.cycles() + 1) - clock.cycles());
+    }
+    
+    // mftb reads the time base from Memory
+    u64 time_base = clock.time_base();
+    if (memory_ && time_base > synced_time_base_) {
+        memory_->advance_time_base(time_base - synced_time_base_);
+    }
+    synced_time_base_ = time_base;
+    
+    u64 advanced = clock.cycles() - start;
+    current_time_ += advanced;
+    stats_.total_cycles_executed += advanced;
+    return advanced;
+}
+
 //=============================================================================
 // APC (Asynchronous Procedure Call) Support
 //=============================================================================
@@ -1123,6 +1711,9 @@ void ThreadScheduler::queue_apc(GuestThread* thread, GuestAddr routine, GuestAdd
     // If kernel-mode APC, alert the thread
     if (kernel_mode) {
         alert_thread(thread);
+    } else if (thread->in_alertable_wait) {
+        // Alertable waits park without polling; let it see the APC
+        unpark(thread);
     }
 }
 
@@ -1134,19 +1725,24 @@ u32 ThreadScheduler::process_pending_apcs(GuestThread* thread) {
     
     u32 count = 0;
     
+    ApcEntry* batch = nullptr;
+    
     while (true) {
-        ApcEntry apc;
-        
-        // Get next APC from queue
-        {
-            std::lock_guard<std::mutex> lock(thread->apc_mutex);
-            if (thread->apc_queue.empty()) {
+        // Refill from the queues, kernel APCs first
+        if (!batch) {
+            batch = thread->kernel_apcs.pop_all();
+            if (!batch) {
+                batch = thread->user_apcs.pop_all();
+            }
+            if (!batch) {
                 break;
             }
-            apc = thread->apc_queue.front();
-            thread->apc_queue.pop_front();
         }
         
+        std::unique_ptr<ApcEntry> node(batch);
+        batch = MpscQueue<ApcEntry>::next(batch);
+        const ApcEntry& apc = *node;
+        
         LOGI("Executing APC for thread %u: routine=0x%08X, context=0x%08X",
              thread->thread_id, apc.routine, apc.context);
         
@@ -1184,6 +1780,7 @@ u32 ThreadScheduler::process_pending_apcs(GuestThread* thread) {
             thread->context.gpr[5] = saved_r5;
         }
         
+        thread->pending_apcs.fetch_sub(1, std::memory_order_acq_rel);
         count++;
     }
     
@@ -1200,6 +1797,9 @@ void ThreadScheduler::alert_thread(GuestThread* thread) {
     thread->alert();
     
     // If thread is in an alertable wait, wake it up
+    if (thread->in_alertable_wait) {
+        unpark(thread);
+    }
     if (thread->in_alertable_wait && thread->state == ThreadState::Waiting) {
         thread->state = ThreadState::Ready;
         thread->wait_object = 0;
@@ -1215,9 +1815,11 @@ bool ThreadScheduler::process_worker_thread(GuestThread* thread) {
         return false;
     }
     
-    // Try to dequeue a work item (non-blocking, short timeout)
+    // Try to dequeue a work item (non-blocking, short timeout). A fiber must
+    // not block its worker, so it polls and parks in worker_thread_main().
     WorkQueueItem item;
-    if (!WorkQueueManager::instance().dequeue(thread->worker_queue_type, item, 10)) {
+    u32 timeout_ms = thread->fiber ? 0 : 10;
+    if (!WorkQueueManager::instance().dequeue(thread->worker_queue_type, item, timeout_ms)) {
         // No work available
         return false;
     }
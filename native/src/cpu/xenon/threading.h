@@ -12,6 +12,10 @@
 
 #include "x360mu/types.h"
 #include "cpu.h"
+#include "fiber.h"
+#include "host_affinity.h"
+#include "../../core/parker.h"
+#include "../../core/mpsc_queue.h"
 #include "../../kernel/work_queue.h"
 #include <vector>
 #include <deque>
@@ -20,12 +24,15 @@
 #include <condition_variable>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <functional>
+#include <map>
 
 namespace x360mu {
 
 class Memory;
 class Kernel;
+class ThreadScheduler;
 struct GuestThread;
 
 // === THREAD-LOCAL STORAGE FOR 1:1 THREADING ===
@@ -34,6 +41,10 @@ struct GuestThread;
 GuestThread* GetCurrentGuestThread();
 void SetCurrentGuestThread(GuestThread* thread);
 
+// The current guest thread if it runs as a fiber (SchedulingMode::Fibers),
+// else nullptr. Blocking HLE paths use this to park instead of sleeping.
+GuestThread* GetCurrentFiberThread();
+
 // === TLS TEMPLATE CONFIGURATION ===
 // Called by the kernel after loading an XEX to configure the TLS template.
 // This template data is copied to each new thread's TLS area.
@@ -51,6 +62,15 @@ enum class ThreadState {
     Terminated,     // Thread has exited
 };
 
+/**
+ * How guest threads map onto host threads
+ */
+enum class SchedulingMode {
+    OneToOne,   // Each guest thread owns a host thread (default)
+    Fibers,     // Guest threads are fibers multiplexed onto six workers (M:N)
+    Deterministic,  // Fibers round-robin on the caller of run() with a virtual clock
+};
+
 /**
  * Thread priority levels
  */
@@ -83,7 +103,7 @@ enum CpuAffinity : u32 {
  * APCs are callbacks queued to a specific thread. User-mode APCs
  * are only delivered when the thread enters an alertable wait state.
  */
-struct ApcEntry {
+struct ApcEntry : MpscNode {
     GuestAddr routine;       // Function to call
     GuestAddr context;       // First argument (context pointer)
     GuestAddr system_arg1;   // Second argument
@@ -140,10 +160,10 @@ struct GuestThread {
     
     // Synchronization for blocking waits (1:1 model)
     // When a guest thread calls KeWaitForSingleObject, we actually block
-    // the host thread using this condition variable. When KeSetEvent is
-    // called, we signal this CV to wake the thread.
+    // the host thread on its parking word. When KeSetEvent is called, the
+    // flags below are set under wait_mutex and the thread is unparked.
     std::mutex wait_mutex;
-    std::condition_variable wait_cv;
+    Parker parker;
     bool wait_signaled;         // Set to true when wait object is signaled
     u32 wait_result;            // Result code when woken (STATUS_SUCCESS, etc.)
     
@@ -166,12 +186,32 @@ struct GuestThread {
     bool is_worker_thread;
     WorkQueueType worker_queue_type;
     
-    // APC (Asynchronous Procedure Call) support
-    std::deque<ApcEntry> apc_queue;
-    std::mutex apc_mutex;
+    // APC (Asynchronous Procedure Call) support. Queued lock-free from any
+    // thread; kernel APCs have their own queue so they run first.
+    // pending_apcs counts APCs queued but not yet run.
+    MpscQueue<ApcEntry> kernel_apcs;
+    MpscQueue<ApcEntry> user_apcs;
+    std::atomic<u32> pending_apcs{0};
     bool alerted;               // Thread has been alerted
     bool in_alertable_wait;     // Currently in an alertable wait
     
+    // === M:N FIBER MODEL ===
+    // In SchedulingMode::Fibers the thread runs as a fiber pinned to one
+    // worker, and blocking switches fibers instead of parking the host.
+    // wake_permit/parked are protected by wait_mutex.
+    ThreadScheduler* scheduler = nullptr;   // Owning scheduler (park/unpark)
+    std::unique_ptr<Fiber> fiber;
+    u32 fiber_worker;           // Worker (hardware thread) the fiber runs on
+    bool wake_permit;           // unpark() arrived while the thread was running
+    bool parked;                // Switched out in ThreadScheduler::park()
+    u32 park_seq;               // Invalidates stale timed wakeups
+    
+    // Host-implemented body for system threads (see create_system_thread)
+    std::function<void(GuestThread*)> system_routine;
+    
+    // Host thread id in 1:1 mode, for re-applying affinity/priority (0 = none)
+    std::atomic<s32> host_tid{0};
+    
     void reset() {
         context.reset();
         state = ThreadState::Created;
@@ -185,7 +225,9 @@ struct GuestThread {
         host_thread = nullptr;
         next = prev = nullptr;
         tls_slots.fill(0);
-        apc_queue.clear();
+        kernel_apcs.clear();
+        user_apcs.clear();
+        pending_apcs.store(0);
         alerted = false;
         in_alertable_wait = false;
         is_system_thread = false;
@@ -195,6 +237,13 @@ struct GuestThread {
         wait_result = 0;
         should_run.store(false);
         is_running.store(false);
+        scheduler = nullptr;
+        fiber_worker = 0;
+        wake_permit = false;
+        parked = false;
+        park_seq = 0;
+        system_routine = nullptr;
+        host_tid.store(0);
     }
     
     /**
@@ -207,21 +256,20 @@ struct GuestThread {
      */
     void queue_apc(GuestAddr routine, GuestAddr ctx, GuestAddr arg1, 
                    GuestAddr arg2, bool kernel_mode = false) {
-        std::lock_guard<std::mutex> lock(apc_mutex);
-        
-        ApcEntry apc;
-        apc.routine = routine;
-        apc.context = ctx;
-        apc.system_arg1 = arg1;
-        apc.system_arg2 = arg2;
-        apc.kernel_mode = kernel_mode;
+        auto* apc = new ApcEntry();
+        apc->routine = routine;
+        apc->context = ctx;
+        apc->system_arg1 = arg1;
+        apc->system_arg2 = arg2;
+        apc->kernel_mode = kernel_mode;
         
+        // Count first so has_pending_apcs() never misses a queued APC
+        pending_apcs.fetch_add(1, std::memory_order_release);
         if (kernel_mode) {
-            // Kernel APCs go to front of queue
-            apc_queue.push_front(apc);
+            // Kernel APCs run before user APCs
+            kernel_apcs.push(apc);
         } else {
-            // User APCs go to back
-            apc_queue.push_back(apc);
+            user_apcs.push(apc);
         }
     }
     
@@ -229,8 +277,7 @@ struct GuestThread {
      * Check if there are pending user-mode APCs
      */
     bool has_pending_apcs() const {
-        std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(apc_mutex));
-        return !apc_queue.empty();
+        return pending_apcs.load(std::memory_order_acquire) != 0;
     }
     
     /**
@@ -245,33 +292,13 @@ struct GuestThread {
     /**
      * Block this thread until signaled or timeout.
      * Called when guest code calls KeWaitForSingleObject.
-     * This ACTUALLY blocks the host thread using condition variables.
+     * This ACTUALLY blocks the host thread using condition variables,
+     * or switches to another fiber in fiber mode.
      * 
      * @param timeout_ms Timeout in milliseconds (0 = infinite)
      * @return Wait result (STATUS_SUCCESS, STATUS_TIMEOUT, etc.)
      */
-    u32 block_until_signaled(u64 timeout_ms = 0) {
-        std::unique_lock<std::mutex> lock(wait_mutex);
-        wait_signaled = false;
-        
-        if (timeout_ms == 0) {
-            // Infinite wait
-            wait_cv.wait(lock, [this]{ return wait_signaled || !should_run.load(); });
-        } else {
-            // Timed wait
-            auto result = wait_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
-                                           [this]{ return wait_signaled || !should_run.load(); });
-            if (!result && !wait_signaled) {
-                return 0x00000102;  // STATUS_TIMEOUT
-            }
-        }
-        
-        if (!should_run.load()) {
-            return 0xC0000001;  // STATUS_UNSUCCESSFUL - thread terminating
-        }
-        
-        return wait_result;
-    }
+    u32 block_until_signaled(u64 timeout_ms = 0);
     
     /**
      * Wake this thread from a blocking wait.
@@ -279,14 +306,7 @@ struct GuestThread {
      * 
      * @param result The result code the wait should return
      */
-    void signal_wake(u32 result = 0) {
-        {
-            std::lock_guard<std::mutex> lock(wait_mutex);
-            wait_signaled = true;
-            wait_result = result;
-        }
-        wait_cv.notify_one();
-    }
+    void signal_wake(u32 result = 0);
 };
 
 /**
@@ -332,6 +352,18 @@ struct SyncObject {
  * - create_thread() spawns a real std::thread for each guest thread
  * - wait_for_object() actually blocks the calling host thread
  * - signal_object() wakes blocked threads via condition variables
+ * 
+ * Optional M:N mode (SchedulingMode::Fibers): guest threads are fibers
+ * run by six worker host threads, one per Xenon hardware thread. A fiber
+ * is pinned to a worker allowed by its affinity mask when created, and
+ * waits, sleeps and yields switch to the next ready fiber on that worker
+ * instead of blocking the host thread.
+ * 
+ * Deterministic mode (SchedulingMode::Deterministic) is fiber mode with no
+ * workers: run() resumes ready fibers one at a time, in FIFO order, on the
+ * calling thread, and charges what they execute to the virtual GuestClock.
+ * Timed waits, the timer queue and the time base all follow that clock, so
+ * identical input gives an identical run.
  */
 class ThreadScheduler {
 public:
@@ -340,8 +372,20 @@ public:
     
     /**
      * Initialize the scheduler
+     * @param mode Fibers and Deterministic fall back to OneToOne if the host
+     *             cannot run fibers
      */
-    Status initialize(Memory* memory, Kernel* kernel, class Cpu* cpu, u32 num_host_threads = 0);
+    Status initialize(Memory* memory, Kernel* kernel, class Cpu* cpu, u32 num_host_threads = 0,
+                      SchedulingMode mode = SchedulingMode::OneToOne);
+    
+    SchedulingMode scheduling_mode() const { return mode_; }
+    
+    /**
+     * Host CPU placement used by the next initialize(). Host threads of
+     * hardware threads are pinned to the cores chosen for them, and
+     * TimeCritical/Highest guest threads get a higher host priority.
+     */
+    void set_host_affinity(const HostAffinityConfig& config) { host_affinity_config_ = config; }
     
     /**
      * Shutdown
@@ -354,6 +398,14 @@ public:
     GuestThread* create_thread(GuestAddr entry_point, GuestAddr param,
                                u32 stack_size, u32 creation_flags);
     
+    /**
+     * Create a kernel thread whose body is host code. It is scheduled like
+     * a guest thread (own host thread, or a fiber in fiber mode) and may
+     * use park()/unpark()/yield(), but has no guest stack or context.
+     */
+    GuestThread* create_system_thread(std::function<void(GuestThread*)> routine,
+                                      u32 affinity_mask = kAllThreads);
+    
     /**
      * Terminate a thread
      */
@@ -385,7 +437,8 @@ public:
     GuestThread* get_current_thread(u32 hw_thread);
     
     /**
-     * Run the scheduler for one time slice
+     * Run the scheduler for one time slice. In deterministic mode this runs
+     * the guest threads until the virtual clock has advanced by `cycles`.
      * Returns cycles executed
      */
     u64 run(u64 cycles);
@@ -400,6 +453,19 @@ public:
      */
     void sleep(GuestThread* thread, u64 nanoseconds);
     
+    /**
+     * Block the calling thread until unpark() or the timeout. Returns at
+     * once if an unpark() arrived since the last park. Wakeups may be
+     * spurious, so callers re-check their condition.
+     * @param timeout_ns ~0ULL = no timeout
+     */
+    void park(GuestThread* thread, u64 timeout_ns = ~0ULL);
+    
+    /**
+     * Wake a thread blocked in park(), or make its next park() return
+     */
+    void unpark(GuestThread* thread);
+    
     /**
      * Wait for synchronization object
      */
@@ -469,6 +535,7 @@ public:
         u32 active_thread_count;
         u32 ready_thread_count;
         u32 waiting_thread_count;
+        u64 fiber_switches;      // Fiber mode: fibers resumed by workers
     };
     Stats get_stats() const;
     
@@ -476,6 +543,8 @@ private:
     Memory* memory_;
     Kernel* kernel_;
     class Cpu* cpu_;
+    SchedulingMode mode_ = SchedulingMode::OneToOne;
+    HostAffinityConfig host_affinity_config_;
     
     // Thread storage
     std::vector<std::unique_ptr<GuestThread>> threads_;
@@ -486,6 +555,27 @@ private:
     std::array<GuestThread*, NUM_PRIORITIES> ready_queues_;
     mutable std::mutex ready_queues_mutex_;  // Protects ready_queues_ access
     
+    // Fiber mode workers, one per hardware thread
+    struct FiberWorker {
+        enum class Action { None, Yield, Park };
+        
+        std::thread host_thread;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<GuestThread*> run_queue;
+        // Timed parks: deadline -> (thread, park_seq at park time)
+        std::multimap<std::chrono::steady_clock::time_point, std::pair<GuestThread*, u32>> sleepers;
+        std::atomic<bool> stop{false};
+        u32 fibers = 0;                     // Fibers pinned here (placement)
+        
+        // Owned by the worker's host thread
+        GuestThread* current = nullptr;
+        Action action = Action::None;       // Why the current fiber switched out
+        std::chrono::steady_clock::time_point park_deadline;
+        std::atomic<u64> switches{0};
+    };
+    std::array<FiberWorker, 6> fiber_workers_;
+    
     // Hardware thread state
     struct HardwareThread {
         GuestThread* current_thread;
@@ -521,6 +611,32 @@ private:
     void execute_thread(u32 hw_thread_id);
     void hw_thread_main(u32 hw_thread_id);
     
+    // Thread bodies, run on a dedicated host thread or on a fiber
+    void guest_thread_main(GuestThread* thread);
+    void worker_thread_main(GuestThread* thread);
+    void start_thread(GuestThread* thread, std::function<void()> body);
+    void place_host_thread(GuestThread* thread);
+    static int host_nice(ThreadPriority priority);
+    template <typename Predicate>
+    void wait_until_woken(GuestThread* thread, Predicate ready);
+    
+    // Fiber mode
+    void fiber_worker_main(u32 index);
+    void run_fiber(FiberWorker& worker, GuestThread* thread);
+    void make_runnable(GuestThread* thread);
+    void wake_timed_out(GuestThread* thread, u32 park_seq);
+    void switch_out(GuestThread* thread, FiberWorker::Action action,
+                    std::chrono::steady_clock::time_point deadline = {});
+    u32 pick_fiber_worker(u32 affinity_mask);
+    bool uses_fibers() const {
+        return mode_ == SchedulingMode::Fibers || mode_ == SchedulingMode::Deterministic;
+    }
+    
+    // Deterministic mode: worker 0's queues, driven from run()
+    u64 run_deterministic(u64 cycles);
+    static constexpr u64 DETERMINISTIC_MIN_SLICE = 100;  // Cycles charged per fiber switch
+    u64 synced_time_base_ = 0;  // Time base already passed to Memory
+    
     // Internal unlocked helpers (caller must hold ready_queues_mutex_)
     GuestThread* dequeue_thread_unlocked(u32 affinity_mask);
     bool has_ready_threads_unlocked(u32 affinity_mask) const;
@@ -0,0 +1,57 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * GPU command thread implementation
+ */
+
+#include "command_thread.h"
+#include "cpu/xenon/host_affinity.h"
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "360mu-gpu"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) printf("[GPU] " __VA_ARGS__); printf("\n")
+#endif
+
+namespace x360mu {
+
+CommandThread::~CommandThread() {
+    stop();
+}
+
+void CommandThread::start(DrainFn drain) {
+    if (running()) return;
+    drain_ = std::move(drain);
+    stop_.store(false, std::memory_order_relaxed);
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread(&CommandThread::thread_main, this);
+    LOGI("GPU command thread started");
+}
+
+void CommandThread::stop() {
+    if (!thread_.joinable()) return;
+    stop_.store(true, std::memory_order_release);
+    parker_.unpark();
+    thread_.join();
+    running_.store(false, std::memory_order_release);
+    drain_ = nullptr;
+    LOGI("GPU command thread stopped");
+}
+
+void CommandThread::thread_main() {
+    // Command processing feeds the renderer, not guest code; keep it off
+    // the cores running Xenon hardware threads
+    HostAffinity::instance().pin_service_thread("gpu");
+
+    while (!stop_.load(std::memory_order_acquire)) {
+        bool poll = drain_();
+        passes_.fetch_add(1, std::memory_order_relaxed);
+        if (stop_.load(std::memory_order_acquire)) break;
+        parker_.park(poll ? POLL_INTERVAL_NS : Parker::INFINITE);
+    }
+}
+
+} // namespace x360mu
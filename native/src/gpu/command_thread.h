@@ -0,0 +1,64 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * GPU command thread
+ *
+ * Runs the PM4 command processor off the emulation thread. The thread sleeps
+ * until the guest moves the ring write pointer (CP_RB_WPTR) or the emulation
+ * thread hands it a new frame, then drains the ring. While a WAIT_REG_MEM
+ * holds the ring it re-polls at a short interval instead, since the memory it
+ * waits on is written by guest code that does not notify anyone.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include "core/parker.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+
+namespace x360mu {
+
+class CommandThread {
+public:
+    /**
+     * One drain pass. Returns true to be called again after POLL_INTERVAL_NS
+     * even without a kick (a stalled wait), false to sleep until kicked.
+     */
+    using DrainFn = std::function<bool()>;
+
+    static constexpr u64 POLL_INTERVAL_NS = 100000;  // 100us
+
+    CommandThread() = default;
+    ~CommandThread();
+
+    CommandThread(const CommandThread&) = delete;
+    CommandThread& operator=(const CommandThread&) = delete;
+
+    void start(DrainFn drain);
+    void stop();
+    bool running() const { return running_.load(std::memory_order_acquire); }
+
+    /**
+     * Make the thread run a pass. Lock-free; safe from any thread.
+     */
+    void kick() { parker_.unpark(); }
+
+    /**
+     * Drain passes run so far
+     */
+    u64 passes() const { return passes_.load(std::memory_order_relaxed); }
+
+private:
+    void thread_main();
+
+    std::thread thread_;
+    Parker parker_;
+    DrainFn drain_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stop_{false};
+    std::atomic<u64> passes_{0};
+};
+
+} // namespace x360mu
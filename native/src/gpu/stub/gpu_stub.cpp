@@ -24,6 +24,9 @@ namespace x360mu {
 
 #include "gpu/xenos/gpu.h"
 #include "memory/memory.h"
+#include "core/timeline.h"
+#include <cstring>
+#include <thread>
 
 // ===========================================================================
 // Inline PM4 parsing helpers (matching command_processor.cpp)
@@ -55,32 +58,125 @@ void VulkanBackend::shutdown() {}
 // Gpu implementation
 // ===========================================================================
 Gpu::Gpu() = default;
-Gpu::~Gpu() = default;
+Gpu::~Gpu() {
+    command_thread_.stop();
+}
 
 Status Gpu::initialize(Memory* memory, const GpuConfig& config) {
     memory_ = memory;
     config_ = config;
     registers_.fill(0);
-    registers_[0x0010] = 0x80000000; // GRBM_STATUS: idle
+    registers_[xenos_reg::GRBM_STATUS] = 0x80000000; // idle
+    publish_status_registers();
+    
+    // Headless command processor: parses the ring, no rendering
+    command_processor_ = std::make_unique<CommandProcessor>();
+    command_processor_->initialize(memory_, nullptr, nullptr, nullptr);
+    if (config.async_commands) {
+        start_command_thread();
+    }
     return Status::Ok;
 }
 
-void Gpu::shutdown() {}
+void Gpu::shutdown() {
+    command_thread_.stop();
+    command_processor_.reset();
+    unpublish_status_registers();
+    memory_ = nullptr;
+}
 
 void Gpu::reset() {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    ring_buffer_base_.store(0, std::memory_order_relaxed);
+    ring_buffer_size_.store(0, std::memory_order_relaxed);
+    read_ptr_.store(0, std::memory_order_relaxed);
+    write_ptr_.store(0, std::memory_order_relaxed);
+    if (command_processor_) {
+        command_processor_->reset();
+    }
     registers_.fill(0);
-    registers_[0x0010] = 0x80000000; // GRBM_STATUS: idle
+    registers_[xenos_reg::GRBM_STATUS] = 0x80000000; // idle
+    publish_status_registers();
     render_state_ = {};
     frame_complete_ = false;
     in_frame_ = false;
     stats_ = {};
+    command_hash_ = COMMAND_HASH_SEED;
 }
 
 void Gpu::set_surface(void*) {}
 void Gpu::resize(u32, u32) {}
-void Gpu::process_commands() {}
+
+void Gpu::process_commands() {
+    if (command_thread_.running()) {
+        command_thread_.kick();
+        return;
+    }
+    drain_ring();
+}
+
+void Gpu::start_command_thread() {
+    command_processor_->set_stall_on_wait(true);
+    command_thread_.start([this]() {
+        if (frame_complete_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        return drain_ring();
+    });
+}
+
+// Same ring/fence handling as gpu.cpp, minus rendering
+bool Gpu::drain_ring() {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    if (!command_processor_ || !memory_) return false;
+
+    GuestAddr rb_base = ring_buffer_base_.load(std::memory_order_acquire);
+    u32 rb_size = ring_buffer_size_.load(std::memory_order_acquire);
+    if (rb_base == 0 || rb_size == 0) {
+        return false;
+    }
+
+    u64 current_cpu_fence = cpu_fence_.load(std::memory_order_acquire);
+    u32 rp = read_ptr_.load(std::memory_order_acquire);
+    u32 wp = write_ptr_.load(std::memory_order_acquire);
+
+    u32 start_rp = rp;
+    bool frame_done = command_processor_->process(rb_base, rb_size, rp, wp);
+
+    if (hash_commands_) {
+        u32 ring_dwords = rb_size / sizeof(u32);
+        for (u32 p = start_rp % ring_dwords; p != rp; p = (p + 1) % ring_dwords) {
+            u32 dword = memory_->read_u32(rb_base + p * sizeof(u32));
+            for (u32 i = 0; i < 4; i++) {
+                command_hash_ = (command_hash_ ^ ((dword >> (i * 8)) & 0xFF)) * 0x100000001b3ULL;
+            }
+        }
+    }
+
+    read_ptr_.store(rp, std::memory_order_release);
+    publish_status_register(xenos_reg::CP_RB_RPTR, rp);
+    u32 rptr_addr = registers_[xenos_reg::CP_RB_RPTR_ADDR];
+    if (rptr_addr != 0) {
+        memory_->write_u32(rptr_addr, rp);
+    }
+
+    bool drained = rp == wp % (rb_size / sizeof(u32));
+    if (drained && current_cpu_fence > gpu_fence_.load(std::memory_order_relaxed)) {
+        gpu_signal_fence(current_cpu_fence);
+    }
+
+    if (frame_done) {
+        frame_complete_ = true;
+        stats_.frames++;
+        if (command_thread_.running()) {
+            Timeline::instance().wake();
+        }
+    }
+    return command_processor_->wait_stalled();
+}
 
 void Gpu::present() {
+    std::lock_guard<std::mutex> lock(command_mutex_);
     frame_complete_ = true;
     stats_.frames++;
 }
@@ -95,6 +191,53 @@ u32 Gpu::read_register(u32 offset) {
 void Gpu::write_register(u32 offset, u32 value) {
     if (offset < registers_.size()) {
         registers_[offset] = value;
+        switch (offset) {
+            case xenos_reg::CP_RB_BASE:
+                ring_buffer_base_.store(value, std::memory_order_release);
+                break;
+            case xenos_reg::CP_RB_CNTL:
+                ring_buffer_size_.store(1u << ((value & 0x3F) + 1), std::memory_order_release);
+                break;
+            case xenos_reg::CP_RB_RPTR:
+                read_ptr_.store(value, std::memory_order_release);
+                publish_status_register(offset, value);
+                break;
+            case xenos_reg::GRBM_STATUS:
+            case xenos_reg::GRBM_STATUS2:
+            case xenos_reg::VSYNC_COUNTER:
+                publish_status_register(offset, value);
+                break;
+            case xenos_reg::CP_RB_WPTR:
+                write_ptr_.store(value, std::memory_order_release);
+                if (command_thread_.running()) {
+                    command_thread_.kick();
+                } else {
+                    Timeline::instance().wake();
+                }
+                break;
+        }
+    }
+}
+
+void Gpu::publish_status_register(u32 offset, u32 value) {
+    registers_[offset] = value;
+    if (memory_) {
+        memory_->shadow_register(offset, value);
+    }
+}
+
+void Gpu::publish_status_registers() {
+    for (u32 offset : {xenos_reg::GRBM_STATUS, xenos_reg::GRBM_STATUS2,
+                       xenos_reg::CP_RB_RPTR, xenos_reg::VSYNC_COUNTER}) {
+        publish_status_register(offset, registers_[offset]);
+    }
+}
+
+void Gpu::unpublish_status_registers() {
+    if (!memory_) return;
+    for (u32 offset : {xenos_reg::GRBM_STATUS, xenos_reg::GRBM_STATUS2,
+                       xenos_reg::CP_RB_RPTR, xenos_reg::VSYNC_COUNTER}) {
+        memory_->unshadow_register(offset);
     }
 }
 
@@ -115,12 +258,30 @@ void Gpu::set_vsync(bool enabled) { config_.enable_vsync = enabled; }
 void Gpu::set_frame_skip(u32 count) { frame_skip_ = count; }
 void Gpu::set_target_fps(u32 fps) { target_fps_ = fps; }
 
-void Gpu::cpu_signal_fence(u64 value) { cpu_fence_.store(value, std::memory_order_release); }
+void Gpu::cpu_signal_fence(u64 value) {
+    cpu_fence_.store(value, std::memory_order_release);
+    command_thread_.kick();
+}
 void Gpu::gpu_signal_fence(u64 value) {
-    gpu_fence_.store(value, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(fence_mutex_);
+        gpu_fence_.store(value, std::memory_order_release);
+    }
     fence_cv_.notify_all();
 }
-bool Gpu::wait_for_gpu_fence(u64, u64) { return true; }
+bool Gpu::wait_for_gpu_fence(u64 fence_value, u64 timeout_ns) {
+    auto reached = [this, fence_value]() {
+        return gpu_fence_.load(std::memory_order_acquire) >= fence_value;
+    };
+    if (reached()) return true;
+    if (timeout_ns == 0) return false;
+    std::unique_lock<std::mutex> lock(fence_mutex_);
+    if (timeout_ns == UINT64_MAX) {
+        fence_cv_.wait(lock, reached);
+        return true;
+    }
+    return fence_cv_.wait_for(lock, std::chrono::nanoseconds(timeout_ns), reached);
+}
 
 // ===========================================================================
 // ShaderTranslator stub
@@ -262,11 +423,15 @@ void CommandProcessor::reset() {
     render_state_ = {};
     frame_complete_ = false;
     in_frame_ = false;
+    wait_stalled_ = false;
+    wait_stall_polls_ = 0;
     packets_processed_ = 0;
     draws_this_frame_ = 0;
     direct_buffer_ = nullptr;
     direct_buffer_size_ = 0;
     direct_buffer_pos_ = 0;
+    stream_base_ = 0;
+    stream_size_bytes_ = 0;
     ib_depth_ = 0;
     scratch_ram_.fill(0);
     bin_mask_lo_ = 0xFFFFFFFF;
@@ -288,24 +453,39 @@ void CommandProcessor::write_register(u32 index, u32 value) {
 }
 
 u32 CommandProcessor::read_cmd(GuestAddr addr) {
-    if (memory_) return memory_->read_u32(addr);
-    return 0;
+    if (!memory_) return 0;
+    // Wrap payload reads that cross the end of the ring
+    if (stream_size_bytes_ != 0 && addr >= stream_base_) {
+        u64 byte_offset = static_cast<u64>(addr - stream_base_);
+        if (byte_offset >= stream_size_bytes_) {
+            addr = stream_base_ + static_cast<GuestAddr>(byte_offset % stream_size_bytes_);
+        }
+    }
+    return memory_->read_u32(addr);
 }
 
 // --- Packet processing (memory-based, used by process()) ---
 
 bool CommandProcessor::process(GuestAddr ring_base, u32 ring_size, u32& read_ptr, u32 write_ptr) {
     frame_complete_ = false;
+    wait_stalled_ = false;
     u32 safety = 0;
     constexpr u32 kMaxPackets = 100000;
 
+    // Ring size is in bytes, pointers in dwords
+    const u32 ring_size_dwords = ring_size / sizeof(u32);
+    if (ring_size_dwords == 0) return false;
+    read_ptr %= ring_size_dwords;
+    write_ptr %= ring_size_dwords;
+
     while (read_ptr != write_ptr && safety++ < kMaxPackets) {
         GuestAddr packet_addr = ring_base + (read_ptr * 4);
         u32 packets_consumed = 0;
-        execute_packet(packet_addr, packets_consumed);
+        execute_packet(packet_addr, packets_consumed, ring_base, ring_size);
+        if (wait_stalled_) break;
 
         if (packets_consumed == 0) packets_consumed = 1;
-        read_ptr = (read_ptr + packets_consumed) % ring_size;
+        read_ptr = (read_ptr + packets_consumed) % ring_size_dwords;
         packets_processed_++;
 
         if (frame_complete_) break;
@@ -313,7 +493,10 @@ bool CommandProcessor::process(GuestAddr ring_base, u32 ring_size, u32& read_ptr
     return frame_complete_;
 }
 
-u32 CommandProcessor::execute_packet(GuestAddr addr, u32& packets_consumed) {
+u32 CommandProcessor::execute_packet(GuestAddr addr, u32& packets_consumed,
+                                     GuestAddr stream_base, u32 stream_size_bytes) {
+    stream_base_ = stream_base;
+    stream_size_bytes_ = stream_size_bytes;
     u32 header = read_cmd(addr);
     PacketType type = get_packet_type(header);
 
@@ -381,6 +564,9 @@ void CommandProcessor::execute_type3(u32 header, GuestAddr data_addr) {
         case PM4Opcode::MEM_WRITE:
             handle_mem_write(data_addr, count);
             break;
+        case PM4Opcode::WAIT_REG_MEM:
+            handle_wait_reg_mem(data_addr, count);
+            break;
         case PM4Opcode::SURFACE_SYNC:
             handle_surface_sync(data_addr, count);
             break;
@@ -548,6 +734,36 @@ void CommandProcessor::handle_mem_write(GuestAddr data_addr, u32 count) {
     }
 }
 
+void CommandProcessor::handle_wait_reg_mem(GuestAddr data_addr, u32 count) {
+    if (count < 5) return;
+    u32 wait_info = read_cmd(data_addr);
+    u32 poll_addr = read_cmd(data_addr + 4);
+    u32 reference = read_cmd(data_addr + 12);
+    u32 mask = read_cmd(data_addr + 16);
+
+    bool mem_space = (wait_info >> 4) & 1;
+    u32 value = (mem_space && memory_ ? memory_->read_u32(poll_addr) : get_register(poll_addr)) & mask;
+    bool condition_met;
+    switch (wait_info & 0x7) {
+        case 1: condition_met = value < reference; break;
+        case 2: condition_met = value <= reference; break;
+        case 3: condition_met = value == reference; break;
+        case 4: condition_met = value != reference; break;
+        case 5: condition_met = value >= reference; break;
+        case 6: condition_met = value > reference; break;
+        default: condition_met = true; break;
+    }
+
+    // Same stall rules as command_processor.cpp (no spin: the caller re-polls)
+    if (!condition_met && stall_on_wait_ && stream_base_ != 0 && ib_depth_ == 0 &&
+        wait_stall_polls_ < kMaxWaitStallPolls) {
+        wait_stall_polls_++;
+        wait_stalled_ = true;
+        return;
+    }
+    wait_stall_polls_ = 0;
+}
+
 // --- Type 3 handlers (direct-buffer) ---
 
 void CommandProcessor::handle_set_constant_direct(const u32* data, u32 count) {
@@ -605,7 +821,6 @@ void CommandProcessor::handle_draw_indx_immd(GuestAddr, u32) {}
 void CommandProcessor::handle_load_alu_constant(GuestAddr, u32) {}
 void CommandProcessor::handle_load_bool_constant(GuestAddr, u32) {}
 void CommandProcessor::handle_load_loop_constant(GuestAddr, u32) {}
-void CommandProcessor::handle_wait_reg_mem(GuestAddr, u32) {}
 void CommandProcessor::handle_indirect_buffer(GuestAddr, u32) {}
 void CommandProcessor::handle_cond_write(GuestAddr, u32) {}
 void CommandProcessor::handle_surface_sync(GuestAddr, u32) {}
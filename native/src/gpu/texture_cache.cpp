@@ -11,6 +11,7 @@
 #include "texture_cache.h"
 #include "vulkan/vulkan_backend.h"
 #include "memory/memory.h"
+#include "x360mu/byte_swap.h"
 #include <cstring>
 #include <algorithm>
 
@@ -620,11 +621,7 @@ void TextureCacheImpl::byte_swap_texture_data(void* data, u64 size, TextureForma
         case TextureFormat::k_8_8:
         case TextureFormat::k_16:
         case TextureFormat::k_16_FLOAT: {
-            u16* d16 = reinterpret_cast<u16*>(bytes);
-            u64 count = size / 2;
-            for (u64 i = 0; i < count; i++) {
-                d16[i] = __builtin_bswap16(d16[i]);
-            }
+            byte_swap_in_place_16(reinterpret_cast<u16*>(bytes), size / 2);
             break;
         }
 
@@ -640,11 +637,7 @@ void TextureCacheImpl::byte_swap_texture_data(void* data, u64 size, TextureForma
         case TextureFormat::k_16_16_EXPAND:
         case TextureFormat::k_16_16_FLOAT:
         case TextureFormat::k_32_FLOAT: {
-            u32* d32 = reinterpret_cast<u32*>(bytes);
-            u64 count = size / 4;
-            for (u64 i = 0; i < count; i++) {
-                d32[i] = __builtin_bswap32(d32[i]);
-            }
+            byte_swap_in_place_32(reinterpret_cast<u32*>(bytes), size / 4);
             break;
         }
 
@@ -653,22 +646,14 @@ void TextureCacheImpl::byte_swap_texture_data(void* data, u64 size, TextureForma
         case TextureFormat::k_16_16_16_16_EXPAND:
         case TextureFormat::k_16_16_16_16_FLOAT:
         case TextureFormat::k_32_32_FLOAT: {
-            u32* d32 = reinterpret_cast<u32*>(bytes);
-            u64 count = size / 4;
-            for (u64 i = 0; i < count; i++) {
-                d32[i] = __builtin_bswap32(d32[i]);
-            }
+            byte_swap_in_place_32(reinterpret_cast<u32*>(bytes), size / 4);
             break;
         }
 
         // 128-bit float
         case TextureFormat::k_32_32_32_32_FLOAT:
         case TextureFormat::k_32_32_32_FLOAT: {
-            u32* d32 = reinterpret_cast<u32*>(bytes);
-            u64 count = size / 4;
-            for (u64 i = 0; i < count; i++) {
-                d32[i] = __builtin_bswap32(d32[i]);
-            }
+            byte_swap_in_place_32(reinterpret_cast<u32*>(bytes), size / 4);
             break;
         }
 
@@ -679,11 +664,7 @@ void TextureCacheImpl::byte_swap_texture_data(void* data, u64 size, TextureForma
         case TextureFormat::k_DXT3A:
         case TextureFormat::k_DXT5A: {
             // DXT1/CTX1: 8 bytes per block, swap as 16-bit words
-            u16* d16 = reinterpret_cast<u16*>(bytes);
-            u64 count = size / 2;
-            for (u64 i = 0; i < count; i++) {
-                d16[i] = __builtin_bswap16(d16[i]);
-            }
+            byte_swap_in_place_16(reinterpret_cast<u16*>(bytes), size / 2);
             break;
         }
 
@@ -693,11 +674,7 @@ void TextureCacheImpl::byte_swap_texture_data(void* data, u64 size, TextureForma
         case TextureFormat::k_DXT4_5_AS_16_16_16_16:
         case TextureFormat::k_DXN: {
             // 16 bytes per block, swap as 16-bit words
-            u16* d16 = reinterpret_cast<u16*>(bytes);
-            u64 count = size / 2;
-            for (u64 i = 0; i < count; i++) {
-                d16[i] = __builtin_bswap16(d16[i]);
-            }
+            byte_swap_in_place_16(reinterpret_cast<u16*>(bytes), size / 2);
             break;
         }
 
@@ -265,6 +265,8 @@ void CommandProcessor::reset() {
     render_state_ = {};
     frame_complete_ = false;
     in_frame_ = false;
+    wait_stalled_ = false;
+    wait_stall_polls_ = 0;
     packets_processed_ = 0;
     draws_this_frame_ = 0;
     
@@ -296,6 +298,7 @@ void CommandProcessor::write_register(u32 index, u32 value) {
 
 bool CommandProcessor::process(GuestAddr ring_base, u32 ring_size, u32& read_ptr, u32 write_ptr) {
     frame_complete_ = false;
+    wait_stalled_ = false;
 
     // Ring size from CP_RB_CNTL is in bytes, while read/write pointers are in dwords.
     // Convert once so pointer wrap math stays in pointer units.
@@ -318,6 +321,11 @@ bool CommandProcessor::process(GuestAddr ring_base, u32 ring_size, u32& read_ptr
         u32 packets_consumed = 0;
         execute_packet(packet_addr, packets_consumed, ring_base, ring_size);
 
+        // An unmet WAIT_REG_MEM holds everything behind it; retry it next time
+        if (wait_stalled_) {
+            break;
+        }
+
         if (packets_consumed == 0) {
             LOGE("Packet processing stalled at %08X", packet_addr);
             packets_consumed = 1;  // Skip to prevent infinite loop
@@ -1313,6 +1321,25 @@ void CommandProcessor::handle_wait_reg_mem(GuestAddr data_addr, u32 count) {
         }
     }
 
+    // Stall the ring at this packet so later packets (MEM_WRITEs, fences)
+    // cannot overtake the wait. Only for packets read straight from the ring:
+    // inside an indirect buffer the wait could not be resumed on its own.
+    if (!condition_met && stall_on_wait_ && stream_base_ != 0 && ib_depth_ == 0 &&
+        wait_stall_polls_ < kMaxWaitStallPolls) {
+        wait_stall_polls_++;
+        wait_stalled_ = true;
+        return;
+    }
+    if (!condition_met && wait_stall_polls_ >= kMaxWaitStallPolls) {
+        // Giving up lets later packets overtake the wait; make that visible
+        LOGE("WAIT_REG_MEM: still unmet after %u stalled polls (%s addr=%08x mask=%08x ref=%08x fn=%u), "
+             "proceeding out of order", kMaxWaitStallPolls, mem_space ? "mem" : "reg",
+             poll_addr, mask, reference, function);
+        wait_stall_polls_ = 0;
+        return;
+    }
+    wait_stall_polls_ = 0;
+
     if (!condition_met) {
         LOGW("WAIT_REG_MEM: condition not met after %u retries (%s addr=%08x mask=%08x ref=%08x fn=%u), proceeding",
              kMaxRetries, mem_space ? "mem" : "reg", poll_addr, mask, reference, function);
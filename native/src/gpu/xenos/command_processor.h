@@ -250,6 +250,15 @@ public:
     bool frame_complete() const { return frame_complete_; }
     void clear_frame_complete() { frame_complete_ = false; }
     
+    /**
+     * Stall on an unmet WAIT_REG_MEM instead of proceeding. process() then
+     * stops with read_ptr on the wait packet and wait_stalled() set, and the
+     * caller polls again later. Used by the GPU command thread, which can
+     * afford to wait; inline processing keeps the bounded spin.
+     */
+    void set_stall_on_wait(bool enabled) { stall_on_wait_ = enabled; }
+    bool wait_stalled() const { return wait_stalled_; }
+    
     /**
      * Statistics
      */
@@ -353,6 +362,12 @@ private:
     bool frame_complete_ = false;
     bool in_frame_ = false;
     
+    // WAIT_REG_MEM stalling (GPU command thread)
+    bool stall_on_wait_ = false;
+    bool wait_stalled_ = false;
+    u32 wait_stall_polls_ = 0;            // Consecutive stalls on the same wait
+    static constexpr u32 kMaxWaitStallPolls = 1000;
+    
     // Stats
     u64 packets_processed_ = 0;
     u64 draws_this_frame_ = 0;
@@ -23,6 +23,7 @@
 #include "gpu/render_target.h"
 #include "memory/memory.h"
 #include "kernel/xobject.h"
+#include "core/timeline.h"
 #include <cstring>
 #include <cstdio>
 #include <chrono>
@@ -104,14 +105,20 @@ Status Gpu::initialize(Memory* memory, const GpuConfig& config) {
     
     // Set GPU status registers to indicate GPU is ready/idle
     // This helps games that poll GPU status before initializing
-    registers_[0x0010] = 0x80000000;  // GRBM_STATUS - GUI_ACTIVE=0, indicates idle
-    registers_[0x0014] = 0;           // GRBM_STATUS2
+    registers_[xenos_reg::GRBM_STATUS] = 0x80000000;  // GUI_ACTIVE=0, indicates idle
+    registers_[xenos_reg::GRBM_STATUS2] = 0;
+    publish_status_registers();
+    
+    if (config.async_commands) {
+        start_command_thread();
+    }
     
     LOGI("GPU initialized (waiting for game to configure ring buffer)");
     return Status::Ok;
 }
 
 void Gpu::shutdown() {
+    command_thread_.stop();
     surface_active_ = false;
 
     if (command_processor_) {
@@ -159,11 +166,14 @@ void Gpu::shutdown() {
         vulkan_.reset();
     }
 
+    unpublish_status_registers();
     memory_ = nullptr;
     LOGI("GPU shutdown complete");
 }
 
 void Gpu::reset() {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    
     // Reset registers
     registers_.fill(0);
     
@@ -174,8 +184,9 @@ void Gpu::reset() {
     write_ptr_.store(0, std::memory_order_relaxed);
     
     // Set GPU status to idle/ready
-    registers_[0x0010] = 0x80000000;  // GRBM_STATUS - idle
-    registers_[0x0014] = 0;           // GRBM_STATUS2
+    registers_[xenos_reg::GRBM_STATUS] = 0x80000000;  // idle
+    registers_[xenos_reg::GRBM_STATUS2] = 0;
+    publish_status_registers();
     
     // Reset render state
     render_state_ = {};
@@ -183,6 +194,7 @@ void Gpu::reset() {
     // Reset frame state
     frame_complete_ = false;
     in_frame_ = false;
+    command_hash_ = COMMAND_HASH_SEED;
     
     // Reset command processor
     if (command_processor_) {
@@ -199,6 +211,7 @@ void Gpu::reset() {
 
 void Gpu::set_surface(void* native_window) {
     LOGI("GPU::set_surface called with window=%p", native_window);
+    std::lock_guard<std::mutex> lock(command_mutex_);
     
     if (!vulkan_) {
         LOGE("set_surface: Vulkan backend not created!");
@@ -329,6 +342,7 @@ void Gpu::set_surface(void* native_window) {
 }
 
 void Gpu::resize(u32 width, u32 height) {
+    std::lock_guard<std::mutex> lock(command_mutex_);
     if (vulkan_ && surface_active_) {
         // width=0, height=0 means recreate at current dimensions
         // (used for swapchain error recovery)
@@ -337,7 +351,29 @@ void Gpu::resize(u32 width, u32 height) {
 }
 
 void Gpu::process_commands() {
-    if (!command_processor_ || !memory_) return;
+    if (command_thread_.running()) {
+        command_thread_.kick();
+        return;
+    }
+    drain_ring();
+}
+
+void Gpu::start_command_thread() {
+    // The thread can afford to wait out a WAIT_REG_MEM, so later packets
+    // never overtake it
+    command_processor_->set_stall_on_wait(true);
+    command_thread_.start([this]() {
+        // A finished frame holds the rest of the ring until begin_new_frame()
+        if (frame_complete_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        return drain_ring();
+    });
+}
+
+bool Gpu::drain_ring() {
+    std::lock_guard<std::mutex> lock(command_mutex_);
+    if (!command_processor_ || !memory_) return false;
     
     // Load ring buffer state atomically (acquire to see CPU's writes)
     GuestAddr rb_base = ring_buffer_base_.load(std::memory_order_acquire);
@@ -345,18 +381,35 @@ void Gpu::process_commands() {
     
     // Check if we have commands to process
     if (rb_base == 0 || rb_size == 0) {
-        return;
+        return false;
     }
     
+    // The CPU fence is read before the write pointer: the CPU signals a
+    // fence after moving the write pointer past its commands, so seeing the
+    // fence guarantees this pass also sees (and drains) those commands
+    u64 current_cpu_fence = cpu_fence_.load(std::memory_order_acquire);
+    
     // Load pointers with acquire semantics to see CPU's command writes
     u32 rp = read_ptr_.load(std::memory_order_acquire);
     u32 wp = write_ptr_.load(std::memory_order_acquire);
     
     // Let the command processor handle the ring buffer
+    u32 start_rp = rp;
     bool frame_done = command_processor_->process(rb_base, rb_size, rp, wp);
     
+    if (hash_commands_) {
+        u32 ring_dwords = rb_size / sizeof(u32);
+        for (u32 p = start_rp % ring_dwords; p != rp; p = (p + 1) % ring_dwords) {
+            u32 dword = memory_->read_u32(rb_base + p * sizeof(u32));
+            for (u32 i = 0; i < 4; i++) {
+                command_hash_ = (command_hash_ ^ ((dword >> (i * 8)) & 0xFF)) * 0x100000001b3ULL;
+            }
+        }
+    }
+    
     // Store updated read pointer with release semantics
     read_ptr_.store(rp, std::memory_order_release);
+    publish_status_register(xenos_reg::CP_RB_RPTR, rp);
 
     // CP_RB_RPTR writeback: write read pointer to guest memory so CPU can track GPU progress
     // Games configure CP_RB_RPTR_ADDR to specify where the GPU writes back the read pointer
@@ -366,80 +419,91 @@ void Gpu::process_commands() {
     }
 
     // Signal GPU fence: we've processed up to the current CPU fence
-    // This tells waiting CPU threads that GPU has caught up
-    u64 current_cpu_fence = cpu_fence_.load(std::memory_order_acquire);
-    if (current_cpu_fence > gpu_fence_.load(std::memory_order_relaxed)) {
+    // This tells waiting CPU threads that GPU has caught up. Not if the pass
+    // stopped early (end of frame, stalled wait): commands remain.
+    bool drained = rp == wp % (rb_size / sizeof(u32));
+    if (drained && current_cpu_fence > gpu_fence_.load(std::memory_order_relaxed)) {
         gpu_signal_fence(current_cpu_fence);
     }
     
     if (frame_done) {
         frame_complete_ = true;
         stats_.frames++;
+        // The emulation thread may be asleep waiting for a frame to present
+        if (command_thread_.running()) {
+            Timeline::instance().wake();
+        }
     }
+    return command_processor_->wait_stalled();
 }
 
 void Gpu::present() {
-    frame_count_++;
-
-    // Log every 60 frames
-    if (frame_count_ % 60 == 1) {
-        LOGI("GPU::present() called (frame %llu)", (unsigned long long)frame_count_);
-    }
+    // Only the Vulkan work runs under command_mutex_; the pacing sleep
+    // below must not hold up the command thread
+    {
+        std::lock_guard<std::mutex> lock(command_mutex_);
+        frame_count_++;
 
-    if (!vulkan_ || !surface_active_) {
+        // Log every 60 frames
         if (frame_count_ % 60 == 1) {
-            LOGE("GPU::present() - vulkan not ready (vulkan_=%p, surface_active_=%d)",
-                 (void*)vulkan_.get(), surface_active_);
+            LOGI("GPU::present() called (frame %llu)", (unsigned long long)frame_count_);
         }
-        frame_complete_ = true;
-        in_frame_ = false;
-        return;
-    }
 
-    // Frame skip: only present every (frame_skip_ + 1) frames
-    if (frame_skip_ > 0 && (frame_count_ % (frame_skip_ + 1)) != 0) {
-        frame_complete_ = true;
-        in_frame_ = false;
-        return;
-    }
-
-    // Begin frame if not already in one
-    if (!in_frame_) {
-        Status status = vulkan_->begin_frame();
-        if (status == Status::ErrorSwapchain) {
-            // Swapchain out of date - recreate and retry once
-            LOGI("Swapchain out of date on begin_frame, recreating...");
-            Status resize_status = vulkan_->resize(0, 0);
-            if (resize_status == Status::Ok) {
-                status = vulkan_->begin_frame();
-            }
-        }
-        if (status != Status::Ok) {
+        if (!vulkan_ || !surface_active_) {
             if (frame_count_ % 60 == 1) {
-                LOGE("Failed to begin frame for present");
+                LOGE("GPU::present() - vulkan not ready (vulkan_=%p, surface_active_=%d)",
+                     (void*)vulkan_.get(), surface_active_);
             }
             frame_complete_ = true;
             in_frame_ = false;
             return;
         }
-    }
 
-    // End frame and present
-    Status status = vulkan_->end_frame();
-    if (status == Status::ErrorSwapchain) {
-        // Swapchain suboptimal or out of date during present
-        // Recreate for the next frame
-        LOGI("Swapchain error on end_frame, will recreate next frame");
-        vulkan_->resize(0, 0);
-    } else if (status != Status::Ok) {
-        if (frame_count_ % 60 == 1) {
-            LOGE("end_frame() failed with status %d", static_cast<int>(status));
+        // Frame skip: only present every (frame_skip_ + 1) frames
+        if (frame_skip_ > 0 && (frame_count_ % (frame_skip_ + 1)) != 0) {
+            frame_complete_ = true;
+            in_frame_ = false;
+            return;
         }
-    }
 
-    stats_.frames++;
-    frame_complete_ = true;
-    in_frame_ = false;
+        // Begin frame if not already in one
+        if (!in_frame_) {
+            Status status = vulkan_->begin_frame();
+            if (status == Status::ErrorSwapchain) {
+                // Swapchain out of date - recreate and retry once
+                LOGI("Swapchain out of date on begin_frame, recreating...");
+                Status resize_status = vulkan_->resize(0, 0);
+                if (resize_status == Status::Ok) {
+                    status = vulkan_->begin_frame();
+                }
+            }
+            if (status != Status::Ok) {
+                if (frame_count_ % 60 == 1) {
+                    LOGE("Failed to begin frame for present");
+                }
+                frame_complete_ = true;
+                in_frame_ = false;
+                return;
+            }
+        }
+
+        // End frame and present
+        Status status = vulkan_->end_frame();
+        if (status == Status::ErrorSwapchain) {
+            // Swapchain suboptimal or out of date during present
+            // Recreate for the next frame
+            LOGI("Swapchain error on end_frame, will recreate next frame");
+            vulkan_->resize(0, 0);
+        } else if (status != Status::Ok) {
+            if (frame_count_ % 60 == 1) {
+                LOGE("end_frame() failed with status %d", static_cast<int>(status));
+            }
+        }
+
+        stats_.frames++;
+        frame_complete_ = true;
+        in_frame_ = false;
+    }
 
     // Frame pacing: sleep to hit target FPS
     if (target_fps_ > 0) {
@@ -538,12 +602,24 @@ void Gpu::write_register(u32 offset, u32 value) {
                 
             case xenos_reg::CP_RB_RPTR:
                 read_ptr_.store(value, std::memory_order_release);
+                publish_status_register(offset, value);
+                break;
+                
+            case xenos_reg::GRBM_STATUS:
+            case xenos_reg::GRBM_STATUS2:
+            case xenos_reg::VSYNC_COUNTER:
+                publish_status_register(offset, value);
                 break;
                 
             case xenos_reg::CP_RB_WPTR:
                 // CRITICAL: Use release ordering so GPU sees all command buffer writes
                 // that the CPU made before updating the write pointer
                 write_ptr_.store(value, std::memory_order_release);
+                if (command_thread_.running()) {
+                    command_thread_.kick();
+                } else {
+                    Timeline::instance().wake();
+                }
                 LOGD("Ring buffer write pointer updated: %u", value);
                 break;
 
@@ -560,6 +636,28 @@ void Gpu::write_register(u32 offset, u32 value) {
     }
 }
 
+void Gpu::publish_status_register(u32 offset, u32 value) {
+    registers_[offset] = value;
+    if (memory_) {
+        memory_->shadow_register(offset, value);
+    }
+}
+
+void Gpu::publish_status_registers() {
+    for (u32 offset : {xenos_reg::GRBM_STATUS, xenos_reg::GRBM_STATUS2,
+                       xenos_reg::CP_RB_RPTR, xenos_reg::VSYNC_COUNTER}) {
+        publish_status_register(offset, registers_[offset]);
+    }
+}
+
+void Gpu::unpublish_status_registers() {
+    if (!memory_) return;
+    for (u32 offset : {xenos_reg::GRBM_STATUS, xenos_reg::GRBM_STATUS2,
+                       xenos_reg::CP_RB_RPTR, xenos_reg::VSYNC_COUNTER}) {
+        memory_->unshadow_register(offset);
+    }
+}
+
 void Gpu::execute_packet(u32 packet) {
     u32 type = (packet >> 30) & 0x3;
     
@@ -766,7 +864,7 @@ void Gpu::signal_vsync() {
     // at COHER_STATUS_HOST (used by D3D for VBlank queries)
     static u32 vsync_count = 0;
     vsync_count++;
-    registers_[0x0E40] = vsync_count;  // VSync counter register
+    publish_status_register(xenos_reg::VSYNC_COUNTER, vsync_count);
 
     // Signal GPU interrupt so kernel event waiters (VBlank wait) get woken
     KernelState::instance().queue_gpu_interrupt();
@@ -788,6 +886,9 @@ void Gpu::cpu_signal_fence(u64 fence_value) {
             break;
         }
     }
+    // The fence is reached by the next drain pass; don't leave it waiting
+    // for the next write pointer update
+    command_thread_.kick();
     LOGD("CPU signaled fence: %llu", fence_value);
 }
 
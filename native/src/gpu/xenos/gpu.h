@@ -8,6 +8,7 @@
 
 #include "x360mu/types.h"
 #include "texture.h"  // For TextureFormat, TextureDimension
+#include "gpu/command_thread.h"
 #include <array>
 #include <memory>
 #include <string>
@@ -39,6 +40,7 @@ struct GpuConfig {
     u32 resolution_scale = 1;
     bool enable_vsync = true;
     bool enable_async_shaders = true;
+    bool async_commands = false;  // Drain the ring buffer on a dedicated command thread
     std::string cache_path;
 };
 
@@ -54,6 +56,11 @@ namespace xenos_reg {
     constexpr u32 CP_RB_WPTR = 0x070E;
     constexpr u32 CP_RB_WPTR_DELAY = 0x070F;
     
+    // Status (polled by guests; published to Memory's register shadow)
+    constexpr u32 GRBM_STATUS = 0x0010;
+    constexpr u32 GRBM_STATUS2 = 0x0014;
+    constexpr u32 VSYNC_COUNTER = 0x0E40;
+    
     // Command processor
     constexpr u32 CP_ME_CNTL = 0x0000;
     constexpr u32 CP_ME_STATUS = 0x0001;
@@ -480,19 +487,29 @@ public:
     
     /**
      * Process command buffer
-     * Called from CPU emulation loop
+     * Called from CPU emulation loop. With the command thread running this
+     * only wakes it; the thread drains the ring on its own.
      */
     void process_commands();
     
+    /**
+     * True while a dedicated thread processes commands (GpuConfig::async_commands)
+     */
+    bool async_commands() const { return command_thread_.running(); }
+    
     /**
      * Check if a frame is ready
      */
-    bool frame_complete() const { return frame_complete_; }
+    bool frame_complete() const { return frame_complete_.load(std::memory_order_acquire); }
     
     /**
-     * Start a new frame (clears frame_complete flag)
+     * Start a new frame (clears frame_complete flag). The command thread
+     * holds the commands after a finished frame until this is called.
      */
-    void begin_new_frame() { frame_complete_ = false; }
+    void begin_new_frame() {
+        frame_complete_.store(false, std::memory_order_release);
+        command_thread_.kick();
+    }
     
     /**
      * Present the frame
@@ -520,6 +537,13 @@ public:
      */
     void set_target_fps(u32 fps);
 
+    /**
+     * Fold every command dword the GPU consumes into a running FNV-1a hash.
+     * Deterministic runs compare it to check two runs drew the same frames.
+     */
+    void set_command_hashing(bool enabled) { hash_commands_ = enabled; }
+    u64 command_hash() const { return command_hash_; }
+
     bool vsync_enabled() const { return config_.enable_vsync; }
     u32 frame_skip() const { return frame_skip_; }
     u32 target_fps() const { return target_fps_; }
@@ -555,7 +579,8 @@ public:
     
     /**
      * Signal that CPU has written commands up to this fence value
-     * Call this after writing to the command buffer
+     * Call this after writing to the command buffer and moving CP_RB_WPTR
+     * past it; the GPU reaches the fence once it has drained that far
      */
     void cpu_signal_fence(u64 fence_value);
     
@@ -590,6 +615,14 @@ public:
     u64 allocate_fence() { return next_fence_.fetch_add(1, std::memory_order_relaxed); }
     
 private:
+    /**
+     * Update a status register and publish it to the memory shadow page so
+     * guest polling reads skip the MMIO handler
+     */
+    void publish_status_register(u32 offset, u32 value);
+    void publish_status_registers();
+    void unpublish_status_registers();
+    
     Memory* memory_ = nullptr;
     GpuConfig config_;
     
@@ -606,7 +639,7 @@ private:
     RenderState render_state_;
     
     // Frame state
-    bool frame_complete_ = false;
+    std::atomic<bool> frame_complete_{false};
     bool in_frame_ = false;
     
     // Subsystems
@@ -629,6 +662,11 @@ private:
     u64 frame_count_ = 0;
     std::chrono::steady_clock::time_point last_present_time_{};
 
+    // Command stream hash (deterministic mode)
+    static constexpr u64 COMMAND_HASH_SEED = 0xcbf29ce484222325ULL;
+    bool hash_commands_ = false;
+    u64 command_hash_ = COMMAND_HASH_SEED;
+
     // Statistics
     Stats stats_{};
     
@@ -642,6 +680,14 @@ private:
     // Internal: GPU signals completion
     void gpu_signal_fence(u64 fence_value);
     
+    // Command thread (GpuConfig::async_commands). command_mutex_ serializes
+    // ring draining with the emulation/UI thread entry points that touch the
+    // command processor or the Vulkan backend (present, surface changes, reset).
+    CommandThread command_thread_;
+    std::mutex command_mutex_;
+    bool drain_ring();
+    void start_command_thread();
+    
     // Command processing
     void execute_packet(u32 packet);
     void execute_type0(u32 packet);  // Register write
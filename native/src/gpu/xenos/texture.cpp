@@ -15,6 +15,7 @@
 #include "texture.h"
 #include "edram.h"
 #include "memory/memory.h"
+#include "x360mu/byte_swap.h"
 #include <cstring>
 #include <algorithm>
 #include <cmath>
@@ -723,19 +724,11 @@ void TextureFormatConverter::convert_to_rgba8(const u8* src, u8* dst,
 }
 
 void TextureFormatConverter::byte_swap_16(u8* data, u32 size) {
-    u16* data16 = reinterpret_cast<u16*>(data);
-    u32 count = size / 2;
-    for (u32 i = 0; i < count; i++) {
-        data16[i] = __builtin_bswap16(data16[i]);
-    }
+    byte_swap_in_place_16(reinterpret_cast<u16*>(data), size / 2);
 }
 
 void TextureFormatConverter::byte_swap_32(u8* data, u32 size) {
-    u32* data32 = reinterpret_cast<u32*>(data);
-    u32 count = size / 4;
-    for (u32 i = 0; i < count; i++) {
-        data32[i] = __builtin_bswap32(data32[i]);
-    }
+    byte_swap_in_place_32(reinterpret_cast<u32*>(data), size / 4);
 }
 
 void TextureFormatConverter::apply_swizzle(u8* data, u32 pixel_count,
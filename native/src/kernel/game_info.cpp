@@ -61,7 +61,7 @@ std::string region_to_string(u32 region) {
 
 GameInfo extract_game_info(
     const XexModule& module,
-    const std::unordered_map<u64, std::function<void(class Cpu*, class Memory*, u64*, u64*)>>& hle_functions,
+    const std::unordered_map<u64, void (*)(class Cpu*, class Memory*, u64*, u64*)>& hle_functions,
     std::function<u64(u32, u32)> make_import_key)
 {
     GameInfo info{};
@@ -83,7 +83,7 @@ struct GameInfo {
  */
 GameInfo extract_game_info(
     const XexModule& module,
-    const std::unordered_map<u64, std::function<void(class Cpu*, class Memory*, u64*, u64*)>>& hle_functions,
+    const std::unordered_map<u64, void (*)(class Cpu*, class Memory*, u64*, u64*)>& hle_functions,
     std::function<u64(u32, u32)> make_import_key);
 
 /**
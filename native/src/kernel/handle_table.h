@@ -0,0 +1,275 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Lock-free handle table
+ *
+ * Maps handles to shared_ptr<T>. A handle encodes a slot index and that
+ * slot's generation, so a closed handle stays invalid after its slot is
+ * reused. Lookups take no lock: they pin the slot with an atomic reader
+ * count, copy the shared_ptr and unpin. Free slots sit on a lock-free
+ * (tagged) stack.
+ *
+ * handle = tag | generation << 18 | slot << 2. Slot 0 is never used, so a
+ * fresh table hands out tag|4, tag|8, ... The tag is a run of high bits that
+ * keeps one table's handles apart from another's; the generation gets the
+ * bits below it.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <memory>
+#include <thread>
+
+namespace x360mu {
+
+template <typename T>
+class HandleTable {
+public:
+    explicit HandleTable(u32 tag = 0)
+        : tag_(tag),
+          generation_mask_((1u << ((tag ? std::countr_zero(tag) : 31) - GENERATION_SHIFT)) - 1) {}
+
+    ~HandleTable() {
+        for (auto& chunk : chunks_) {
+            delete chunk.exchange(nullptr);
+        }
+    }
+
+    HandleTable(const HandleTable&) = delete;
+    HandleTable& operator=(const HandleTable&) = delete;
+
+    /**
+     * Add an object under a fresh handle
+     * @return The handle, or 0 if every slot is in use
+     */
+    u32 insert(std::shared_ptr<T> object) {
+        u32 index = allocate_slot();
+        if (index == 0) return 0;
+
+        // Stale handles may briefly pin a dead slot, so the reader count isn't
+        // necessarily zero here; they back off without touching the object
+        Slot* slot = slot_at(index);
+        slot->object = std::move(object);
+        u64 state = slot->state.fetch_or(STATE_LIVE, std::memory_order_release);
+        u32 generation = static_cast<u32>(state >> 32) & generation_mask_;
+        live_count_.fetch_add(1, std::memory_order_relaxed);
+
+        return make_handle(index, generation);
+    }
+
+    /**
+     * Remove a handle. Only one of several racing removals succeeds.
+     * @return The object it referred to, or nullptr if the handle was invalid
+     */
+    std::shared_ptr<T> remove(u32 handle) {
+        // Pinning first validates the handle; clearing LIVE while pinned makes
+        // this the only closer and stops new readers
+        Slot* slot = pin(handle);
+        if (!slot) return nullptr;
+
+        u64 state = slot->state.load(std::memory_order_relaxed);
+        do {
+            if (!(state & STATE_LIVE)) {
+                unpin(slot);
+                return nullptr;  // Lost a race with another close
+            }
+        } while (!slot->state.compare_exchange_weak(state, (state & ~STATE_LIVE) - 1,
+                                                    std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed));
+
+        // Readers only hold a slot for a shared_ptr copy
+        while ((slot->state.load(std::memory_order_acquire) & STATE_READERS) != 0) {
+            std::this_thread::yield();
+        }
+
+        std::shared_ptr<T> object = std::move(slot->object);
+        slot->state.fetch_add(1ull << 32, std::memory_order_release);  // Next generation
+        live_count_.fetch_sub(1, std::memory_order_relaxed);
+        free_slot((handle >> SLOT_SHIFT) & (MAX_SLOTS - 1));
+        return object;
+    }
+
+    std::shared_ptr<T> lookup(u32 handle) const {
+        Slot* slot = pin(handle);
+        if (!slot) return nullptr;
+        std::shared_ptr<T> object = slot->object;
+        unpin(slot);
+        return object;
+    }
+
+    /**
+     * Run fn(const shared_ptr<T>&) while the handle is pinned, so a racing
+     * remove() waits for it to return. Keep fn short: it holds up the closer.
+     * @return false if the handle was invalid (fn not called)
+     */
+    template <typename Fn>
+    bool with_pinned(u32 handle, Fn&& fn) const {
+        Slot* slot = pin(handle);
+        if (!slot) return false;
+        fn(slot->object);
+        unpin(slot);
+        return true;
+    }
+
+    /**
+     * Call fn(handle, shared_ptr<T>) for every live handle. Walks every slot
+     * handed out so far, so keep it off hot paths.
+     */
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        u32 end = std::min(next_unused_slot_.load(std::memory_order_acquire), MAX_SLOTS);
+        for (u32 index = 1; index < end; index++) {
+            Slot* slot = slot_at(index);
+            if (!slot) continue;
+            u64 state = slot->state.load(std::memory_order_acquire);
+            if (!(state & STATE_LIVE)) continue;
+            u32 handle = make_handle(index, static_cast<u32>(state >> 32) & generation_mask_);
+            if (auto object = lookup(handle)) {
+                fn(handle, object);
+            }
+        }
+    }
+
+    size_t size() const { return live_count_.load(std::memory_order_relaxed); }
+
+    /**
+     * Drop every handle, calling on_live(T&) for each live one first.
+     * Shutdown only: no other thread may use the table meanwhile.
+     */
+    template <typename Fn>
+    void clear(Fn&& on_live) {
+        u32 end = std::min(next_unused_slot_.load(std::memory_order_acquire), MAX_SLOTS);
+        for (u32 index = 1; index < end; index++) {
+            Slot* slot = slot_at(index);
+            if (!slot) continue;
+            if (slot->state.load(std::memory_order_acquire) & STATE_LIVE) {
+                on_live(*slot->object);
+            }
+            slot->object.reset();
+            slot->state.store(0, std::memory_order_relaxed);
+            slot->next_free.store(0, std::memory_order_relaxed);
+        }
+
+        // Start over at slot 1, like a fresh table
+        free_head_.store(0, std::memory_order_relaxed);
+        next_unused_slot_.store(1, std::memory_order_relaxed);
+        live_count_.store(0, std::memory_order_release);
+    }
+
+    void clear() {
+        clear([](T&) {});
+    }
+
+    static constexpr u32 MAX_SLOTS = 1u << 16;
+
+private:
+    static constexpr u32 SLOT_SHIFT = 2;
+    static constexpr u32 SLOT_BITS = 16;
+    static constexpr u32 GENERATION_SHIFT = SLOT_SHIFT + SLOT_BITS;
+    static constexpr u32 CHUNK_SLOTS = 256;
+    static constexpr u32 CHUNK_COUNT = MAX_SLOTS / CHUNK_SLOTS;
+
+    // Slot state: generation (high 32 bits) | LIVE | reader count
+    static constexpr u64 STATE_LIVE = 1ull << 31;
+    static constexpr u64 STATE_READERS = STATE_LIVE - 1;
+
+    // One cache line per slot so lookups of different handles don't
+    // contend on each other's reader counts
+    struct alignas(64) Slot {
+        std::atomic<u64> state{0};
+        std::shared_ptr<T> object;   // Written only while not LIVE and unpinned
+        std::atomic<u32> next_free{0};
+    };
+    struct Chunk {
+        Slot slots[CHUNK_SLOTS];
+    };
+
+    const u32 tag_;
+    const u32 generation_mask_;
+    std::array<std::atomic<Chunk*>, CHUNK_COUNT> chunks_{};
+    std::atomic<u64> free_head_{0};        // ABA tag (high 32) | slot index (0 = empty)
+    std::atomic<u32> next_unused_slot_{1};
+    std::atomic<u32> live_count_{0};
+
+    u32 make_handle(u32 index, u32 generation) const {
+        return tag_ | (generation << GENERATION_SHIFT) | (index << SLOT_SHIFT);
+    }
+
+    Slot* slot_at(u32 index) const {
+        Chunk* chunk = chunks_[index / CHUNK_SLOTS].load(std::memory_order_acquire);
+        return chunk ? &chunk->slots[index % CHUNK_SLOTS] : nullptr;
+    }
+
+    Slot* pin(u32 handle) const {
+        if ((handle & tag_) != tag_) return nullptr;
+        u32 bits = handle & ~tag_;
+        u32 index = (bits >> SLOT_SHIFT) & (MAX_SLOTS - 1);
+        u32 generation = bits >> GENERATION_SHIFT;
+        if ((bits & ((1u << SLOT_SHIFT) - 1)) != 0 || generation > generation_mask_ || index == 0) {
+            return nullptr;
+        }
+        Slot* slot = slot_at(index);
+        if (!slot) return nullptr;
+
+        // Count ourselves in as a reader, then check the slot is live and
+        // current; remove() waits for readers before it touches the shared_ptr
+        u64 state = slot->state.fetch_add(1, std::memory_order_acquire);
+        if (!(state & STATE_LIVE) || ((state >> 32) & generation_mask_) != generation) {
+            unpin(slot);
+            return nullptr;
+        }
+        return slot;
+    }
+
+    static void unpin(Slot* slot) {
+        slot->state.fetch_sub(1, std::memory_order_release);
+    }
+
+    u32 allocate_slot() {
+        // Pop the free stack; the tag in the high half defeats ABA
+        u64 head = free_head_.load(std::memory_order_acquire);
+        while (static_cast<u32>(head) != 0) {
+            u32 index = static_cast<u32>(head);
+            u32 next = slot_at(index)->next_free.load(std::memory_order_relaxed);
+            u64 new_head = (((head >> 32) + 1) << 32) | next;
+            if (free_head_.compare_exchange_weak(head, new_head, std::memory_order_acq_rel,
+                                                 std::memory_order_acquire)) {
+                return index;
+            }
+        }
+
+        // Nothing free: take a fresh slot, creating its chunk on first use
+        u32 index = next_unused_slot_.fetch_add(1, std::memory_order_relaxed);
+        if (index >= MAX_SLOTS) {
+            next_unused_slot_.store(MAX_SLOTS, std::memory_order_relaxed);
+            return 0;
+        }
+        auto& chunk = chunks_[index / CHUNK_SLOTS];
+        if (!chunk.load(std::memory_order_acquire)) {
+            Chunk* fresh = new Chunk();
+            Chunk* expected = nullptr;
+            if (!chunk.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+                delete fresh;
+            }
+        }
+        return index;
+    }
+
+    void free_slot(u32 index) {
+        Slot* slot = slot_at(index);
+        u64 head = free_head_.load(std::memory_order_relaxed);
+        u64 new_head;
+        do {
+            slot->next_free.store(static_cast<u32>(head), std::memory_order_relaxed);
+            new_head = (((head >> 32) + 1) << 32) | index;
+        } while (!free_head_.compare_exchange_weak(head, new_head, std::memory_order_release,
+                                                   std::memory_order_relaxed));
+    }
+};
+
+} // namespace x360mu
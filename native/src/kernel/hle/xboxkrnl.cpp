@@ -19,6 +19,8 @@
 #include "../../cpu/xenon/cpu.h"
 #include "../../cpu/xenon/threading.h"
 #include "../../memory/memory.h"
+#include "../../memory/extent_allocator.h"
+#include "../../core/guest_clock.h"
 #include <cstring>
 #include <algorithm>
 #include <unordered_map>
@@ -136,6 +138,10 @@ constexpr u32 MEM_FREE = 0x10000;
 constexpr u32 MEM_IMAGE = 0x1000000;
 constexpr u32 LARGE_PAGE_SIZE = 64 * 1024;  // 64KB large pages on Xbox 360
 
+// Contiguous physical allocations (16MB-256MB), shared with the Mm* physical
+// memory services in xboxkrnl_extended.cpp
+ExtentAllocator g_physical_heap(0x01000000, 0x0F000000);
+
 static struct HleState {
     // Virtual memory allocator state
     struct VirtualAllocation {
@@ -149,8 +155,10 @@ static struct HleState {
         bool dirty;          // Page dirty tracking for save state
     };
     std::unordered_map<GuestAddr, VirtualAllocation> virtual_allocations;
-    GuestAddr next_virtual_addr = 0x10000000;
-    GuestAddr next_physical_addr = 0x01000000;  // Physical allocations start at 16MB
+    ExtentAllocator virtual_heap{0x10000000, 0x08000000};  // 256MB-384MB, 4KB pages
+    // MEM_LARGE_PAGES allocations get their own 64KB-granular pool so they
+    // never fragment the 4KB heap (384MB-512MB)
+    ExtentAllocator large_page_heap{0x18000000, 0x08000000, LARGE_PAGE_SIZE};
     std::mutex alloc_mutex;
 
     // Section objects for memory-mapped files
@@ -311,6 +319,24 @@ static std::string read_object_attributes_path(Memory* memory, GuestAddr obj_att
 // Memory Management Functions
 //=============================================================================
 
+// Heap that owns an address, or nullptr for unmanaged ranges
+static ExtentAllocator* heap_for_address(GuestAddr addr) {
+    if (g_hle.virtual_heap.contains(addr)) return &g_hle.virtual_heap;
+    if (g_hle.large_page_heap.contains(addr)) return &g_hle.large_page_heap;
+    if (g_physical_heap.contains(addr)) return &g_physical_heap;
+    return nullptr;
+}
+
+// Tracked allocation containing addr, or end()
+static auto find_containing_allocation(GuestAddr addr) {
+    for (auto it = g_hle.virtual_allocations.begin(); it != g_hle.virtual_allocations.end(); ++it) {
+        if (addr >= it->first && addr < it->first + it->second.size) {
+            return it;
+        }
+    }
+    return g_hle.virtual_allocations.end();
+}
+
 static void HLE_NtAllocateVirtualMemory(Cpu* cpu, Memory* memory, u64* args, u64* result) {
     // NTSTATUS NtAllocateVirtualMemory(
     //   HANDLE ProcessHandle,       // arg[0] - ignored, always current process
@@ -346,51 +372,60 @@ static void HLE_NtAllocateVirtualMemory(Cpu* cpu, Memory* memory, u64* args, u64
         // Caller requested specific address
         base_addr = align_down(requested_base, static_cast<GuestAddr>(page_size));
 
-        // Check if already allocated (exact match or containing region)
-        auto it = g_hle.virtual_allocations.find(base_addr);
+        // Check if it falls inside an existing allocation (usually a reservation
+        // being committed piecewise)
+        auto it = find_containing_allocation(base_addr);
         if (it != g_hle.virtual_allocations.end()) {
-            if (alloc_type & MEM_COMMIT) {
-                // Committing previously reserved memory
-                it->second.committed = true;
-                it->second.protect = protect;
-                memory->write_u32(base_addr_ptr, base_addr);
-                memory->write_u32(region_size_ptr, aligned_size);
-                *result = STATUS_SUCCESS;
-                LOGD("NtAllocateVirtualMemory: commit 0x%08X, size=0x%X", base_addr, aligned_size);
-                return;
-            } else if (alloc_type & MEM_RESET) {
-                // MEM_RESET: hint that memory contents are no longer needed
-                it->second.dirty = false;
-                memory->write_u32(base_addr_ptr, base_addr);
-                memory->write_u32(region_size_ptr, aligned_size);
-                *result = STATUS_SUCCESS;
-                return;
-            } else {
-                // Address conflict
+            auto& alloc = it->second;
+            u32 alloc_page = alloc.large_pages ? LARGE_PAGE_SIZE : memory::MEM_PAGE_SIZE;
+            GuestAddr sub_base = align_down(requested_base, static_cast<GuestAddr>(alloc_page));
+            u64 sub_end = align_up(static_cast<u64>(requested_base) + std::max(requested_size, 1u),
+                                   static_cast<u64>(alloc_page));
+            if (sub_end > it->first + alloc.size ||
+                !(alloc_type & (MEM_COMMIT | MEM_RESET))) {
+                // Runs past the reservation, or re-reserves taken space
                 *result = STATUS_CONFLICTING_ADDRESSES;
                 return;
             }
+            u32 sub_size = static_cast<u32>(sub_end - sub_base);
+
+            if (alloc_type & MEM_COMMIT) {
+                // Committing (part of) previously reserved memory
+                alloc.committed = true;
+                alloc.protect = protect;
+                memory->protect(sub_base, sub_size, protection_to_flags(protect));
+                LOGD("NtAllocateVirtualMemory: commit 0x%08X, size=0x%X in 0x%08X",
+                     sub_base, sub_size, it->first);
+            } else {
+                // MEM_RESET: contents are no longer needed, drop the host pages
+                memory->decommit(sub_base, sub_size);
+                alloc.dirty = false;
+            }
+            memory->write_u32(base_addr_ptr, sub_base);
+            memory->write_u32(region_size_ptr, sub_size);
+            *result = STATUS_SUCCESS;
+            return;
         }
-    } else {
-        if (use_physical) {
-            // MEM_PHYSICAL: contiguous physical allocation from low memory
-            base_addr = align_up(g_hle.next_physical_addr, static_cast<GuestAddr>(page_size));
-            g_hle.next_physical_addr = base_addr + aligned_size;
-        } else if (alloc_type & MEM_TOP_DOWN) {
-            base_addr = 0x7FFF0000 - aligned_size;  // Top-down allocation
-        } else {
-            base_addr = align_up(g_hle.next_virtual_addr, static_cast<GuestAddr>(page_size));
-            g_hle.next_virtual_addr = base_addr + aligned_size + page_size;  // Leave gap
-        }
-    }
 
-    // Ensure address is within valid range
-    if (base_addr + aligned_size > memory::MAIN_MEMORY_SIZE) {
-        // Try a different region
-        base_addr = 0x40000000 + (g_hle.virtual_allocations.size() * page_size);
-        if (base_addr + aligned_size > memory::MAIN_MEMORY_SIZE) {
+        // Claim the range from the heap that manages it, if any
+        ExtentAllocator* heap = heap_for_address(base_addr);
+        if (heap && !heap->allocate_fixed(base_addr, aligned_size)) {
+            *result = STATUS_CONFLICTING_ADDRESSES;
+            return;
+        }
+    } else {
+        // MEM_PHYSICAL: contiguous physical allocation from low memory
+        ExtentAllocator& heap = use_physical ? g_physical_heap
+                              : use_large_pages ? g_hle.large_page_heap
+                              : g_hle.virtual_heap;
+        base_addr = heap.allocate(aligned_size, page_size, (alloc_type & MEM_TOP_DOWN) != 0);
+        if (base_addr == 0) {
+            auto stats = heap.stats();
             *result = STATUS_NO_MEMORY;
-            LOGW("NtAllocateVirtualMemory: FAILED (OOM), size=0x%X", requested_size);
+            LOGW("NtAllocateVirtualMemory: FAILED (OOM), size=0x%X, used=0x%llX, "
+                 "largest free=0x%llX, fragmentation=%.2f", requested_size,
+                 (unsigned long long)stats.used, (unsigned long long)stats.largest_free,
+                 stats.fragmentation);
             return;
         }
     }
@@ -426,6 +461,9 @@ static void HLE_NtAllocateVirtualMemory(Cpu* cpu, Memory* memory, u64* args, u64
              base_addr, aligned_size, alloc_type, protect,
              use_large_pages ? " [LARGE]" : "", use_physical ? " [PHYS]" : "");
     } else {
+        if (ExtentAllocator* heap = heap_for_address(base_addr)) {
+            heap->free(base_addr);
+        }
         *result = STATUS_NO_MEMORY;
         LOGW("NtAllocateVirtualMemory: FAILED, size=0x%X", requested_size);
     }
@@ -452,11 +490,19 @@ static void HLE_NtFreeVirtualMemory(Cpu* cpu, Memory* memory, u64* args, u64* re
         if (free_type & MEM_RELEASE) {
             // Full release
             memory->free(base_addr);
+            if (ExtentAllocator* heap = heap_for_address(base_addr)) {
+                heap->free(base_addr);
+            }
             g_hle.virtual_allocations.erase(it);
             LOGD("NtFreeVirtualMemory: released 0x%08X", base_addr);
         } else if (free_type & MEM_DECOMMIT) {
-            // Just decommit (keep reservation)
-            it->second.committed = false;
+            // Just decommit (keep reservation), returning the host pages
+            u32 region_size = region_size_ptr ? memory->read_u32(region_size_ptr) : 0;
+            u64 size = region_size ? std::min<u64>(region_size, it->second.size) : it->second.size;
+            memory->decommit(base_addr, size);
+            if (size == it->second.size) {
+                it->second.committed = false;
+            }
             LOGD("NtFreeVirtualMemory: decommitted 0x%08X", base_addr);
         }
     }
@@ -598,11 +644,7 @@ static void HLE_KeSetAffinityThread(Cpu* cpu, Memory* memory, u64* args, u64* re
 static void HLE_KeQueryPerformanceCounter(Cpu* cpu, Memory* memory, u64* args, u64* result) {
     // Return high-resolution performance counter
     // Xbox 360 uses a 50 MHz counter
-    static u64 counter = 0;
-    auto now = std::chrono::high_resolution_clock::now();
-    auto duration = now.time_since_epoch();
-    counter = std::chrono::duration_cast<std::chrono::microseconds>(duration).count() * 50;
-    *result = counter;
+    *result = GuestClock::instance().time_base();
 }
 
 static void HLE_KeQueryPerformanceFrequency(Cpu* cpu, Memory* memory, u64* args, u64* result) {
@@ -622,7 +664,10 @@ static void HLE_KeDelayExecutionThread(Cpu* cpu, Memory* memory, u64* args, u64*
         if (interval < 0) {
             // Relative time in 100ns units
             u64 microseconds = static_cast<u64>(-interval) / 10;
-            if (microseconds > 0 && microseconds < 1000000) {
+            auto& clock = GuestClock::instance();
+            if (clock.is_virtual()) {
+                clock.advance(GuestClock::ns_to_cycles(microseconds * 1000));
+            } else if (microseconds > 0 && microseconds < 1000000) {
                 std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
             }
         }
@@ -768,22 +813,17 @@ static void HLE_KeWaitForSingleObject(Cpu* cpu, Memory* memory, u64* args, u64*
     
     // Use scheduler for proper thread blocking
     if (g_scheduler) {
-        // Get current thread from scheduler
-        u32 hw_thread_id = cpu->get_context(0).thread_id % 6;
-        GuestThread* thread = g_scheduler->get_current_thread(hw_thread_id);
+        // The calling guest thread (1:1 host thread or fiber), else the
+        // legacy per-hardware-thread current thread
+        GuestThread* thread = GetCurrentGuestThread();
+        if (!thread) {
+            u32 hw_thread_id = cpu->get_context(0).thread_id % 6;
+            thread = g_scheduler->get_current_thread(hw_thread_id);
+        }
         
         if (thread) {
-            // Block the thread properly
-            u32 wait_result = g_scheduler->wait_for_object(thread, object, timeout_ns);
-            
-            // If we're waiting, yield to other threads
-            if (thread->state == ThreadState::Waiting) {
-                // Thread is now blocked - will be woken when signaled
-                // For now, yield and let scheduler handle it
-                g_scheduler->yield(thread);
-            }
-            
-            *result = wait_result;
+            // Parks the thread until signal_object() or the timeout
+            *result = g_scheduler->wait_for_object(thread, object, timeout_ns);
             return;
         }
     }
@@ -1881,14 +1921,16 @@ static void HLE_NtMapViewOfSection(Cpu* cpu, Memory* memory, u64* args, u64* res
         base_addr = memory->read_u32(base_addr_ptr);
     }
     if (base_addr == 0) {
-        base_addr = g_hle.next_virtual_addr;
-        g_hle.next_virtual_addr += aligned_size + memory::MEM_PAGE_SIZE;
-    }
-
-    // Ensure within bounds
-    if (base_addr + aligned_size > memory::MAIN_MEMORY_SIZE) {
-        *result = STATUS_NO_MEMORY;
-        return;
+        base_addr = g_hle.virtual_heap.allocate(aligned_size, memory::MEM_PAGE_SIZE);
+        if (base_addr == 0) {
+            *result = STATUS_NO_MEMORY;
+            return;
+        }
+    } else if (ExtentAllocator* heap = heap_for_address(base_addr)) {
+        if (!heap->allocate_fixed(base_addr, aligned_size)) {
+            *result = STATUS_CONFLICTING_ADDRESSES;
+            return;
+        }
     }
 
     // Allocate the view
@@ -1929,6 +1971,9 @@ static void HLE_NtMapViewOfSection(Cpu* cpu, Memory* memory, u64* args, u64* res
         LOGD("NtMapViewOfSection: section=0x%X -> base=0x%08X, size=0x%X",
              section_handle, base_addr, aligned_size);
     } else {
+        if (ExtentAllocator* heap = heap_for_address(base_addr)) {
+            heap->free(base_addr);
+        }
         *result = STATUS_NO_MEMORY;
         LOGW("NtMapViewOfSection: FAILED, size=0x%X", aligned_size);
     }
@@ -1943,6 +1988,9 @@ static void HLE_NtUnmapViewOfSection(Cpu* cpu, Memory* memory, u64* args, u64* r
     auto it = g_hle.virtual_allocations.find(base_addr);
     if (it != g_hle.virtual_allocations.end()) {
         memory->free(base_addr);
+        if (ExtentAllocator* heap = heap_for_address(base_addr)) {
+            heap->free(base_addr);
+        }
         g_hle.virtual_allocations.erase(it);
         LOGD("NtUnmapViewOfSection: 0x%08X unmapped", base_addr);
     }
@@ -19,7 +19,9 @@
 #include "../../cpu/xenon/cpu.h"
 #include "../../cpu/xenon/threading.h"
 #include "../../memory/memory.h"
+#include "../../memory/extent_allocator.h"
 #include "../../apu/xma_decoder.h"
+#include "../../core/guest_clock.h"
 #include <cstring>
 #include <ctime>
 #include <chrono>
@@ -65,7 +67,7 @@ constexpr u32 CREATE_SUSPENDED = 0x00000004;
 //=============================================================================
 static struct ExtendedHleState {
     // Time tracking
-    std::chrono::steady_clock::time_point boot_time;
+    u64 boot_100ns;
     u64 performance_counter_offset;
     
     // Thread management
@@ -101,7 +103,6 @@ static struct ExtendedHleState {
         u32 protect;
     };
     std::unordered_map<GuestAddr, PhysAllocation> physical_allocations;
-    GuestAddr next_physical_addr = 0xA0000000;
     std::mutex phys_mutex;
     
     // Module tracking
@@ -126,7 +127,7 @@ static struct ExtendedHleState {
     std::mutex dpc_mutex;
     
     void init() {
-        boot_time = std::chrono::steady_clock::now();
+        boot_100ns = GuestClock::instance().now_100ns();
         performance_counter_offset = 0;
         current_thread_handle.fill(0);
         tls_slots.fill(0);
@@ -137,6 +138,9 @@ static struct ExtendedHleState {
 // Scheduler pointer (set by kernel init, accessible from other HLE modules)
 ThreadScheduler* g_scheduler = nullptr;
 
+// Contiguous physical memory heap (defined in xboxkrnl.cpp)
+extern ExtentAllocator g_physical_heap;
+
 //=============================================================================
 // Extended Memory Functions
 //=============================================================================
@@ -152,8 +156,12 @@ static void HLE_MmAllocatePhysicalMemory(Cpu* cpu, Memory* memory, u64* args, u6
     
     std::lock_guard<std::mutex> lock(g_ext_hle.phys_mutex);
     
-    GuestAddr addr = g_ext_hle.next_physical_addr;
-    g_ext_hle.next_physical_addr += size + memory::MEM_PAGE_SIZE;  // Leave gap
+    GuestAddr addr = g_physical_heap.allocate(size, memory::MEM_PAGE_SIZE);
+    if (addr == 0) {
+        *result = 0;
+        LOGW("MmAllocatePhysicalMemory: FAILED size=0x%X (no contiguous range)", size);
+        return;
+    }
     
     // Perform allocation
     u32 mem_flags = MemoryRegion::Read | MemoryRegion::Write;
@@ -167,6 +175,7 @@ static void HLE_MmAllocatePhysicalMemory(Cpu* cpu, Memory* memory, u64* args, u6
         *result = addr;
         LOGD("MmAllocatePhysicalMemory: size=0x%X -> 0x%08X", size, addr);
     } else {
+        g_physical_heap.free(addr);
         *result = 0;
         LOGW("MmAllocatePhysicalMemory: FAILED size=0x%X", size);
     }
@@ -193,19 +202,15 @@ static void HLE_MmAllocatePhysicalMemoryEx(Cpu* cpu, Memory* memory, u64* args,
     
     std::lock_guard<std::mutex> lock(g_ext_hle.phys_mutex);
     
-    // Try to allocate within range
-    GuestAddr addr = align_up(
-        std::max(g_ext_hle.next_physical_addr, min_addr),
-        static_cast<GuestAddr>(alignment)
-    );
-    
-    if (max_addr != 0 && addr + size > max_addr) {
-        // Try from min_addr
-        addr = align_up(min_addr, static_cast<GuestAddr>(alignment));
+    // Best fit within [min_addr, max_addr]
+    GuestAddr addr = g_physical_heap.allocate(size, alignment, false, min_addr, max_addr);
+    if (addr == 0) {
+        *result = 0;
+        LOGW("MmAllocatePhysicalMemoryEx: FAILED size=0x%X, range=0x%08X-0x%08X",
+             size, min_addr, max_addr);
+        return;
     }
     
-    g_ext_hle.next_physical_addr = addr + size + memory::MEM_PAGE_SIZE;
-    
     u32 mem_flags = MemoryRegion::Read | MemoryRegion::Write;
     if (protect & 0x10) mem_flags |= MemoryRegion::Execute;
     
@@ -217,6 +222,7 @@ static void HLE_MmAllocatePhysicalMemoryEx(Cpu* cpu, Memory* memory, u64* args,
         *result = addr;
         LOGD("MmAllocatePhysicalMemoryEx: size=0x%X, align=0x%X -> 0x%08X", size, alignment, addr);
     } else {
+        g_physical_heap.free(addr);
         *result = 0;
     }
 }
@@ -230,6 +236,7 @@ static void HLE_MmFreePhysicalMemory(Cpu* cpu, Memory* memory, u64* args, u64* r
     auto it = g_ext_hle.physical_allocations.find(addr);
     if (it != g_ext_hle.physical_allocations.end()) {
         memory->free(addr);
+        g_physical_heap.free(addr);
         g_ext_hle.physical_allocations.erase(it);
         LOGD("MmFreePhysicalMemory: freed 0x%08X", addr);
     }
@@ -597,12 +604,7 @@ static void HLE_KeQuerySystemTime(Cpu* cpu, Memory* memory, u64* args, u64* resu
     GuestAddr time_ptr = static_cast<GuestAddr>(args[0]);
     
     // Get current time as 100ns intervals since January 1, 1601
-    auto now = std::chrono::system_clock::now();
-    auto since_epoch = now.time_since_epoch();
-    auto ticks = std::chrono::duration_cast<std::chrono::microseconds>(since_epoch).count() * 10;
-    
-    // Add offset from 1601 to 1970 (Unix epoch)
-    u64 system_time = static_cast<u64>(ticks) + 116444736000000000ULL;
+    u64 system_time = GuestClock::instance().system_time();
     
     memory->write_u64(time_ptr, system_time);
     *result = 0;
@@ -610,11 +612,7 @@ static void HLE_KeQuerySystemTime(Cpu* cpu, Memory* memory, u64* args, u64* resu
 
 static void HLE_KeQueryInterruptTime(Cpu* cpu, Memory* memory, u64* args, u64* result) {
     // Return time since boot in 100ns units
-    auto now = std::chrono::steady_clock::now();
-    auto since_boot = now - g_ext_hle.boot_time;
-    u64 ticks = std::chrono::duration_cast<std::chrono::nanoseconds>(since_boot).count() / 100;
-    
-    *result = ticks;
+    *result = GuestClock::instance().now_100ns() - g_ext_hle.boot_100ns;
 }
 
 static void HLE_NtQuerySystemTime(Cpu* cpu, Memory* memory, u64* args, u64* result) {
@@ -982,9 +980,10 @@ static void HLE_RtlUnicodeStringToAnsiString(Cpu* cpu, Memory* memory, u64* args
         ansi_buf = memory->read_u32(ansi + 4);
     }
     
+    std::vector<u16> wide(ansi_len);
+    memory->read_swapped16(uni_buf, wide.data(), ansi_len);
     for (u16 i = 0; i < ansi_len; i++) {
-        u16 wc = memory->read_u16(uni_buf + i * 2);
-        memory->write_u8(ansi_buf + i, static_cast<u8>(wc & 0xFF));
+        memory->write_u8(ansi_buf + i, static_cast<u8>(wide[i] & 0xFF));
     }
     memory->write_u8(ansi_buf + ansi_len, 0);
     
@@ -1153,9 +1152,10 @@ static void HLE_RtlUnicodeToMultiByteN(Cpu* cpu, Memory* memory, u64* args, u64*
     u32 uni_bytes = static_cast<u32>(args[4]);
 
     u32 chars_to_convert = std::min(uni_bytes / 2, max_bytes);
+    std::vector<u16> wide(chars_to_convert);
+    memory->read_swapped16(uni_buf, wide.data(), chars_to_convert);
     for (u32 i = 0; i < chars_to_convert; i++) {
-        u16 wc = memory->read_u16(uni_buf + i * 2);
-        memory->write_u8(mb_buf + i, static_cast<u8>(wc & 0xFF));
+        memory->write_u8(mb_buf + i, static_cast<u8>(wide[i] & 0xFF));
     }
 
     if (bytes_written_ptr) {
@@ -1272,7 +1272,11 @@ static void HLE_ExGetXConfigSetting(Cpu* cpu, Memory* memory, u64* args, u64* re
 static void HLE_KeStallExecutionProcessor(Cpu* cpu, Memory* memory, u64* args, u64* result) {
     // VOID KeStallExecutionProcessor(ULONG Microseconds);
     u32 microseconds = static_cast<u32>(args[0]);
-    if (microseconds > 0 && microseconds < 100000) {
+    auto& clock = GuestClock::instance();
+    if (clock.is_virtual()) {
+        // A busy-wait costs the caller guest time, not host time
+        clock.advance(GuestClock::ns_to_cycles(u64(microseconds) * 1000));
+    } else if (microseconds > 0 && microseconds < 100000) {
         std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
     }
     *result = 0;
@@ -1861,12 +1865,13 @@ static void HLE_VdGetCurrentDisplayGamma(Cpu* cpu, Memory* memory, u64* args, u6
     // Return a default gamma ramp (linear 1.0)
     if (gamma_ramp) {
         // Gamma ramp is 256 entries per channel (R, G, B), each u16
+        u16 ramp[256];
         for (int i = 0; i < 256; i++) {
-            u16 value = static_cast<u16>((i << 8) | i);  // Linear ramp
-            memory->write_u16(gamma_ramp + i * 2, value);         // R
-            memory->write_u16(gamma_ramp + 512 + i * 2, value);   // G
-            memory->write_u16(gamma_ramp + 1024 + i * 2, value);  // B
+            ramp[i] = static_cast<u16>((i << 8) | i);  // Linear ramp
         }
+        memory->write_swapped16(gamma_ramp, ramp, 256);         // R
+        memory->write_swapped16(gamma_ramp + 512, ramp, 256);   // G
+        memory->write_swapped16(gamma_ramp + 1024, ramp, 256);  // B
     }
     
     *result = 1;  // Success
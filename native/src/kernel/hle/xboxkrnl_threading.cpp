@@ -726,9 +726,7 @@ static void HLE_NtWaitForMultipleObjects(Cpu* cpu, Memory* memory, u64* args, u6
     
     // Read handles
     std::vector<u32> handles(count);
-    for (u32 i = 0; i < count; i++) {
-        handles[i] = memory->read_u32(handles_ptr + i * 4);
-    }
+    memory->read_swapped32(handles_ptr, handles.data(), count);
     
     s64 timeout = 0;
     s64* timeout_p = nullptr;
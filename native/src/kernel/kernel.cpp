@@ -13,7 +13,7 @@
 #include "xex_loader.h"
 #include "filesystem/vfs.h"
 #include "input/input_manager.h"
-#include <unordered_set>
+#include "core/guest_clock.h"
 #include <chrono>
 
 #ifdef __ANDROID__
@@ -57,6 +57,8 @@ Status Kernel::initialize(Memory* memory, Cpu* cpu, VirtualFileSystem* vfs) {
     // Register all HLE functions
     register_hle_functions();
     
+    import_slots_ = std::make_unique<ImportSlot[]>(MAX_IMPORT_SLOTS);
+    
     LOGI("Kernel initialized with HLE functions");
     return Status::Ok;
 }
@@ -72,6 +74,10 @@ void Kernel::shutdown() {
     objects_.clear();
     threads_.clear();
     hle_functions_.clear();
+    
+    import_slot_count_.store(0, std::memory_order_relaxed);
+    import_slot_index_.clear();
+    import_slots_.reset();
 }
 
 void Kernel::stop_system_worker() {
@@ -181,8 +187,10 @@ Status Kernel::load_xex(const std::string& path) {
         );
     }
     
-    // Install import thunks for syscall handling
-    install_import_thunks(*xex_module);
+    // Resolve imports to dispatch slots, then point the thunks at them
+    std::vector<u32> import_slots;
+    resolve_imports(*xex_module, import_slots);
+    install_import_thunks(*xex_module, import_slots);
 
     // Extract game info and analyze import compatibility
     game_info_ = std::make_unique<GameInfo>(
@@ -280,12 +288,21 @@ void Kernel::start_system_worker() {
     LOGI("System worker thread disabled - DPCs now processed via XKernel::run_for()");
 }
 
+// Publish host input to XAM right away, except under the virtual clock:
+// deterministic runs sample input only at their virtual vblanks so a replay
+// sees it at the same guest time
+static void sync_input() {
+    if (!GuestClock::instance().is_virtual()) {
+        get_input_manager().sync_to_xam();
+    }
+}
+
 void Kernel::input_button(u32 player, u32 button, bool pressed) {
     if (player >= 4) return;
 
     // Use InputManager which maps Android button indices to XInput flags
     get_input_manager().set_button(player, button, pressed);
-    get_input_manager().sync_to_xam();
+    sync_input();
 
     // Keep local state in sync
     u16 xinput_flag = android_button_to_xinput(button);
@@ -300,7 +317,7 @@ void Kernel::input_trigger(u32 player, u32 trigger, f32 value) {
     if (player >= 4) return;
 
     get_input_manager().set_trigger(player, trigger, value);
-    get_input_manager().sync_to_xam();
+    sync_input();
 
     if (trigger == 0) {
         input_state_[player].left_trigger = value;
@@ -313,7 +330,7 @@ void Kernel::input_stick(u32 player, u32 stick, f32 x, f32 y) {
     if (player >= 4) return;
 
     get_input_manager().set_stick(player, stick, x, y);
-    get_input_manager().sync_to_xam();
+    sync_input();
 
     if (stick == 0) {
         input_state_[player].left_stick_x = x;
@@ -325,6 +342,19 @@ void Kernel::input_stick(u32 player, u32 stick, f32 x, f32 y) {
 }
 
 void Kernel::handle_syscall(u32 ordinal, u32 module_ordinal) {
+    u32 slot = resolve_import(module_ordinal, ordinal);
+    if (slot == INVALID_IMPORT_SLOT) {
+        LOGE("Import table full, dropping syscall: module=%u, ordinal=%u",
+             module_ordinal, ordinal);
+        if (GuestThread* current_thread = GetCurrentGuestThread()) {
+            current_thread->context.gpr[3] = 0;  // STATUS_SUCCESS
+        }
+        return;
+    }
+    dispatch_import(slot);
+}
+
+void Kernel::dispatch_import(u32 slot) {
     // === 1:1 THREADING MODEL: Use Thread-Local Storage ===
     // Get the current thread's context via TLS, not a global "context 0"
     GuestThread* current_thread = GetCurrentGuestThread();
@@ -338,39 +368,77 @@ void Kernel::handle_syscall(u32 ordinal, u32 module_ordinal) {
     
     ThreadContext& ctx = current_thread->context;
     
-    // Log unique syscalls for debugging
-    static std::unordered_set<u64> logged_syscalls;
-    u64 key = make_import_key(module_ordinal, ordinal);
-    
-    if (logged_syscalls.find(key) == logged_syscalls.end() && logged_syscalls.size() < 100) {
-        LOGI("First call to syscall: module=%u, ordinal=%u (PC=0x%08llX, thread=%u)", 
-             module_ordinal, ordinal, ctx.pc, current_thread->thread_id);
-        logged_syscalls.insert(key);
+    if (slot >= import_slot_count_.load(std::memory_order_acquire)) {
+        LOGE("Invalid import slot %u at PC=0x%08llX, LR=0x%08llX", slot, ctx.pc, ctx.lr);
+        ctx.gpr[3] = 0;  // STATUS_SUCCESS
+        return;
     }
     
-    auto it = hle_functions_.find(key);
-    if (it == hle_functions_.end()) {
-        static std::unordered_set<u64> logged_unimpl;
-        if (logged_unimpl.find(key) == logged_unimpl.end()) {
+    ImportSlot& entry = import_slots_[slot];
+    u64 calls = entry.calls.fetch_add(1, std::memory_order_relaxed);
+    
+    if (!entry.function) {
+        if (calls == 0) {
             LOGE("UNIMPLEMENTED syscall: module=%u, ordinal=%u at PC=0x%08llX, LR=0x%08llX", 
-                 module_ordinal, ordinal, ctx.pc, ctx.lr);
-            logged_unimpl.insert(key);
+                 entry.module, entry.ordinal, ctx.pc, ctx.lr);
         }
         // FIX: Set return value to STATUS_SUCCESS so game doesn't retry in infinite loop
         ctx.gpr[3] = 0;  // STATUS_SUCCESS
         return;
     }
     
+    // Log first call of each syscall for debugging
+    if (calls == 0) {
+        LOGI("First call to syscall: module=%u, ordinal=%u (PC=0x%08llX, thread=%u)", 
+             entry.module, entry.ordinal, ctx.pc, current_thread->thread_id);
+    }
+    
     u64 args[8] = {
         ctx.gpr[3], ctx.gpr[4], ctx.gpr[5], ctx.gpr[6],
         ctx.gpr[7], ctx.gpr[8], ctx.gpr[9], ctx.gpr[10]
     };
     
     u64 result = 0;
-    it->second(cpu_, memory_, args, &result);
+    entry.function(cpu_, memory_, args, &result);
     ctx.gpr[3] = result;
 }
 
+u32 Kernel::resolve_import(u32 module, u32 ordinal) {
+    u64 key = make_import_key(module, ordinal);
+    
+    std::lock_guard<std::mutex> lock(import_mutex_);
+    auto it = import_slot_index_.find(key);
+    if (it != import_slot_index_.end()) {
+        return it->second;
+    }
+    
+    u32 slot = import_slot_count_.load(std::memory_order_relaxed);
+    if (!import_slots_ || slot >= MAX_IMPORT_SLOTS) {
+        return INVALID_IMPORT_SLOT;
+    }
+    
+    // Fill the slot before publishing the new count to dispatchers
+    ImportSlot& entry = import_slots_[slot];
+    auto fn = hle_functions_.find(key);
+    entry.function = fn != hle_functions_.end() ? fn->second : nullptr;
+    entry.module = module;
+    entry.ordinal = ordinal;
+    entry.calls.store(0, std::memory_order_relaxed);
+    
+    import_slot_index_.emplace(key, slot);
+    import_slot_count_.store(slot + 1, std::memory_order_release);
+    return slot;
+}
+
+u64 Kernel::get_import_call_count(u32 module, u32 ordinal) {
+    std::lock_guard<std::mutex> lock(import_mutex_);
+    auto it = import_slot_index_.find(make_import_key(module, ordinal));
+    if (it == import_slot_index_.end()) {
+        return 0;
+    }
+    return import_slots_[it->second].calls.load(std::memory_order_relaxed);
+}
+
 const LoadedModule* Kernel::get_module(const std::string& name) const {
     for (const auto& module : modules_) {
         if (module.name == name) {
@@ -500,11 +568,40 @@ Status Kernel::load_xex_image(const std::vector<u8>& /*data*/, LoadedModule& /*m
     return Status::NotImplemented;
 }
 
-Status Kernel::resolve_imports(LoadedModule& /*module*/) {
-    return Status::NotImplemented;
+// Module id used in import keys for a library name
+static u32 import_module_id(const std::string& lib_name) {
+    if (lib_name == "xboxkrnl.exe" || lib_name.find("xboxkrnl") != std::string::npos) {
+        return 0;
+    } else if (lib_name == "xam.xex" || lib_name.find("xam") != std::string::npos) {
+        return 1;
+    }
+    return 2; // Unknown/other
 }
 
-void Kernel::install_import_thunks(const XexModule& module) {
+Status Kernel::resolve_imports(const XexModule& xex, std::vector<u32>& slots) {
+    slots.clear();
+    u32 unresolved = 0;
+    
+    for (const auto& lib : xex.imports) {
+        u32 module_id = import_module_id(lib.name);
+        for (const auto& imp : lib.imports) {
+            u32 slot = resolve_import(module_id, imp.ordinal);
+            if (slot == INVALID_IMPORT_SLOT) {
+                unresolved++;
+            }
+            slots.push_back(slot);
+        }
+    }
+    
+    LOGI("Resolved %zu imports to %u dispatch slots", slots.size(),
+         import_slot_count_.load(std::memory_order_relaxed));
+    if (unresolved) {
+        LOGE("Import table full: %u imports use legacy ordinal dispatch", unresolved);
+    }
+    return Status::Ok;
+}
+
+void Kernel::install_import_thunks(const XexModule& module, const std::vector<u32>& slots) {
     LOGI("Installing import thunks for %zu libraries", module.imports.size());
     
     // Debug: Check what's at a specific problematic address BEFORE patching
@@ -524,14 +621,7 @@ void Kernel::install_import_thunks(const XexModule& module) {
     
     for (const auto& lib : module.imports) {
         // Determine module ID based on library name
-        u32 module_id = 0;
-        if (lib.name == "xboxkrnl.exe" || lib.name.find("xboxkrnl") != std::string::npos) {
-            module_id = 0;
-        } else if (lib.name == "xam.xex" || lib.name.find("xam") != std::string::npos) {
-            module_id = 1;
-        } else {
-            module_id = 2; // Unknown/other
-        }
+        u32 module_id = import_module_id(lib.name);
         
         LOGI("  Library: %s (module_id=%u, %zu imports)", 
              lib.name.c_str(), module_id, lib.imports.size());
@@ -546,8 +636,12 @@ void Kernel::install_import_thunks(const XexModule& module) {
                 thunk_ptr += 16;  // Each thunk needs up to 16 bytes
             }
 
-            // Encode: (module_id << 16) | ordinal
-            u32 encoded = (module_id << 16) | (ordinal & 0xFFFF);
+            // Encode: IMPORT_SLOT_FLAG | slot, or (module_id << 16) | ordinal
+            // when the import could not be given a slot
+            u32 slot = total_thunks < slots.size() ? slots[total_thunks] : INVALID_IMPORT_SLOT;
+            u32 encoded = slot != INVALID_IMPORT_SLOT
+                ? IMPORT_SLOT_FLAG | slot
+                : (module_id << 16) | (ordinal & 0xFFFF);
 
             // Write thunk code:
             // For values <= 0x7FFF: li r0, encoded (single instruction)
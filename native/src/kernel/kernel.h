@@ -16,6 +16,7 @@
 #include <array>
 #include <thread>
 #include <atomic>
+#include <mutex>
 
 namespace x360mu {
 
@@ -131,9 +132,20 @@ struct ThreadInfo {
 };
 
 /**
- * HLE function signature
+ * HLE function signature. A plain function pointer so syscall dispatch is a
+ * single indirect call; every HLE export is a free function or a
+ * captureless lambda.
  */
-using HleFunction = std::function<void(Cpu*, Memory*, u64* args, u64* result)>;
+using HleFunction = void (*)(Cpu*, Memory*, u64* args, u64* result);
+
+/**
+ * Import thunks load r0 with IMPORT_SLOT_FLAG | slot, where slot indexes
+ * the kernel's flat import table. Thunks without the flag carry the legacy
+ * (module << 16) | ordinal encoding.
+ */
+constexpr u32 IMPORT_SLOT_FLAG = 0x01000000;
+constexpr u32 MAX_IMPORT_SLOTS = 0x4000;
+constexpr u32 INVALID_IMPORT_SLOT = ~0u;
 
 /**
  * Kernel HLE implementation
@@ -179,10 +191,26 @@ public:
     void input_stick(u32 player, u32 stick, f32 x, f32 y);
     
     /**
-     * Handle syscall from CPU
+     * Handle syscall from CPU (legacy module/ordinal encoding)
      */
     void handle_syscall(u32 ordinal, u32 module_ordinal);
     
+    /**
+     * Handle syscall from an import thunk carrying a resolved slot
+     */
+    void dispatch_import(u32 slot);
+    
+    /**
+     * Get (or assign) the dense import slot for module/ordinal
+     * @return Slot index, or INVALID_IMPORT_SLOT if the table is full
+     */
+    u32 resolve_import(u32 module, u32 ordinal);
+    
+    /**
+     * Number of times an import has been called (0 if never resolved)
+     */
+    u64 get_import_call_count(u32 module, u32 ordinal);
+    
     /**
      * Get loaded module info
      */
@@ -255,16 +283,30 @@ private:
     void stop_system_worker();
     void create_system_guest_threads();
     
-    // HLE function table
+    // HLE function table (registration; keyed by make_import_key)
     std::unordered_map<u64, HleFunction> hle_functions_;
     
+    // Flat import table used for dispatch. Slots are append-only and never
+    // move, so dispatch reads them without locking; import_mutex_ only
+    // serializes slot assignment.
+    struct ImportSlot {
+        HleFunction function = nullptr;
+        u32 module = 0;
+        u32 ordinal = 0;
+        std::atomic<u64> calls{0};
+    };
+    std::unique_ptr<ImportSlot[]> import_slots_;
+    std::atomic<u32> import_slot_count_{0};
+    std::unordered_map<u64, u32> import_slot_index_;
+    std::mutex import_mutex_;
+    
     // XEX loading
     Status parse_xex_header(const std::vector<u8>& data, LoadedModule& module);
     Status load_xex_image(const std::vector<u8>& data, LoadedModule& module);
-    Status resolve_imports(LoadedModule& module);
+    Status resolve_imports(const class XexModule& xex, std::vector<u32>& slots);
     
     // Import thunk installation
-    void install_import_thunks(const class XexModule& module);
+    void install_import_thunks(const class XexModule& module, const std::vector<u32>& slots);
     
     // HLE registration
     void register_hle_functions();
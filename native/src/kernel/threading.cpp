@@ -6,10 +6,12 @@
 
 #include "threading.h"
 #include "kernel.h"
+#include "timer_queue.h"
 #include "xobject.h"
 #include "../memory/memory.h"
 #include "../cpu/xenon/cpu.h"
 #include "../cpu/xenon/threading.h"
+#include "../core/parker.h"
 #include <algorithm>
 #include <chrono>
 #include <thread>
@@ -80,6 +82,23 @@ Status KernelThreadManager::initialize(Memory* memory, Cpu* cpu, ThreadScheduler
 }
 
 void KernelThreadManager::shutdown() {
+    // Disarm timers first; their callbacks look objects up under objects_mutex_
+    std::vector<u64> timer_ids;
+    {
+        std::lock_guard<std::mutex> lock(objects_mutex_);
+        objects_.for_each([&](u32, const std::shared_ptr<KernelWaitable>& obj) {
+            if (obj->type != KernelWaitableType::Timer) return;
+            auto* timer = static_cast<KernelTimer*>(obj.get());
+            if (timer->timer_id) timer_ids.push_back(timer->timer_id);
+            timer->timer_id = 0;
+        });
+    }
+    auto& timer_queue = TimerQueue::instance();
+    for (u64 id : timer_ids) {
+        timer_queue.cancel(id);
+    }
+    timer_queue.synchronize();
+
     std::lock_guard<std::mutex> lock(objects_mutex_);
     objects_.clear();
     thread_handles_.clear();
@@ -88,7 +107,6 @@ void KernelThreadManager::shutdown() {
 
 void KernelThreadManager::reset() {
     shutdown();
-    next_handle_ = 0x80001000;
     stats_ = {};
 }
 
@@ -149,7 +167,7 @@ u32 KernelThreadManager::terminate_thread(u32 handle, u32 exit_code) {
     // Release any mutants owned by this thread
     {
         std::lock_guard<std::mutex> lock(objects_mutex_);
-        for (auto& [h, obj] : objects_) {
+        objects_.for_each([&](u32, const std::shared_ptr<KernelWaitable>& obj) {
             if (obj->type == KernelWaitableType::Mutant) {
                 auto* mutant = static_cast<KernelMutant*>(obj.get());
                 if (mutant->owner == thread) {
@@ -159,7 +177,7 @@ u32 KernelThreadManager::terminate_thread(u32 handle, u32 exit_code) {
                     wake_waiters(mutant);
                 }
             }
-        }
+        });
     }
     
     // Remove from handle tracking
@@ -276,16 +294,13 @@ u32 KernelThreadManager::set_thread_priority(u32 handle, s32 priority) {
 
 u32 KernelThreadManager::create_event(u32* handle_out, u32 access_mask, GuestAddr obj_attr,
                                        EventType event_type, bool initial_state) {
-    auto event = std::make_unique<KernelEvent>();
+    auto event = std::make_shared<KernelEvent>();
     event->event_type = event_type;
     event->signaled = initial_state;
-    event->handle = allocate_handle();
-    
-    u32 handle = event->handle;
     
-    {
-        std::lock_guard<std::mutex> lock(objects_mutex_);
-        objects_[handle] = std::move(event);
+    u32 handle = add_object(event);
+    if (handle == 0) {
+        return nt::STATUS_NO_MEMORY;
     }
     
     if (handle_out) *handle_out = handle;
@@ -298,48 +313,51 @@ u32 KernelThreadManager::create_event(u32* handle_out, u32 access_mask, GuestAdd
 }
 
 u32 KernelThreadManager::set_event(u32 handle, s32* prev_state) {
-    std::lock_guard<std::mutex> lock(objects_mutex_);
-    
-    auto it = objects_.find(handle);
-    if (it == objects_.end() || it->second->type != KernelWaitableType::Event) {
-        return nt::STATUS_INVALID_HANDLE;
-    }
-    
-    auto* event = static_cast<KernelEvent*>(it->second.get());
-    if (prev_state) *prev_state = event->signaled ? 1 : 0;
-    
-    event->signaled = true;
-    wake_waiters(event);
+    // Signal under the pin instead of copying the shared_ptr out; a racing
+    // close just waits for the wake to finish
+    bool is_event = false;
+    bool valid = objects_.with_pinned(handle, [&](const std::shared_ptr<KernelWaitable>& obj) {
+        if (obj->type != KernelWaitableType::Event) return;
+        is_event = true;
+        auto* event = static_cast<KernelEvent*>(obj.get());
+        {
+            std::lock_guard<std::mutex> lock(event->wait_mutex);
+            if (prev_state) *prev_state = event->signaled ? 1 : 0;
+            event->signaled = true;
+        }
+        wake_waiters(event);
+    });
     
-    return nt::STATUS_SUCCESS;
+    return (valid && is_event) ? nt::STATUS_SUCCESS : nt::STATUS_INVALID_HANDLE;
 }
 
 u32 KernelThreadManager::clear_event(u32 handle) {
-    std::lock_guard<std::mutex> lock(objects_mutex_);
-    
-    auto it = objects_.find(handle);
-    if (it == objects_.end() || it->second->type != KernelWaitableType::Event) {
+    auto obj = get_waitable(handle, KernelWaitableType::Event);
+    if (!obj) {
         return nt::STATUS_INVALID_HANDLE;
     }
     
-    static_cast<KernelEvent*>(it->second.get())->signaled = false;
+    std::lock_guard<std::mutex> lock(obj->wait_mutex);
+    static_cast<KernelEvent*>(obj.get())->signaled = false;
     return nt::STATUS_SUCCESS;
 }
 
 u32 KernelThreadManager::pulse_event(u32 handle, s32* prev_state) {
-    std::lock_guard<std::mutex> lock(objects_mutex_);
-    
-    auto it = objects_.find(handle);
-    if (it == objects_.end() || it->second->type != KernelWaitableType::Event) {
+    auto obj = get_waitable(handle, KernelWaitableType::Event);
+    if (!obj) {
         return nt::STATUS_INVALID_HANDLE;
     }
     
-    auto* event = static_cast<KernelEvent*>(it->second.get());
-    if (prev_state) *prev_state = event->signaled ? 1 : 0;
+    auto* event = static_cast<KernelEvent*>(obj.get());
     
     // Set then immediately reset
-    event->signaled = true;
+    {
+        std::lock_guard<std::mutex> lock(event->wait_mutex);
+        if (prev_state) *prev_state = event->signaled ? 1 : 0;
+        event->signaled = true;
+    }
     wake_waiters(event);
+    std::lock_guard<std::mutex> lock(event->wait_mutex);
     event->signaled = false;
     
     return nt::STATUS_SUCCESS;
@@ -355,16 +373,13 @@ u32 KernelThreadManager::create_semaphore(u32* handle_out, u32 access_mask, Gues
         return nt::STATUS_INVALID_PARAMETER;
     }
     
-    auto sem = std::make_unique<KernelSemaphore>();
+    auto sem = std::make_shared<KernelSemaphore>();
     sem->count = initial_count;
     sem->max_count = max_count;
-    sem->handle = allocate_handle();
     
-    u32 handle = sem->handle;
-    
-    {
-        std::lock_guard<std::mutex> lock(objects_mutex_);
-        objects_[handle] = std::move(sem);
+    u32 handle = add_object(sem);
+    if (handle == 0) {
+        return nt::STATUS_NO_MEMORY;
     }
     
     if (handle_out) *handle_out = handle;
@@ -380,14 +395,13 @@ u32 KernelThreadManager::release_semaphore(u32 handle, s32 release_count, s32* p
         return nt::STATUS_INVALID_PARAMETER;
     }
     
-    std::lock_guard<std::mutex> lock(objects_mutex_);
-    
-    auto it = objects_.find(handle);
-    if (it == objects_.end() || it->second->type != KernelWaitableType::Semaphore) {
+    auto obj = get_waitable(handle, KernelWaitableType::Semaphore);
+    if (!obj) {
         return nt::STATUS_INVALID_HANDLE;
     }
     
-    auto* sem = static_cast<KernelSemaphore*>(it->second.get());
+    std::lock_guard<std::mutex> lock(objects_mutex_);
+    auto* sem = static_cast<KernelSemaphore*>(obj.get());
     
     if (prev_count) *prev_count = sem->count;
     
@@ -408,8 +422,7 @@ u32 KernelThreadManager::release_semaphore(u32 handle, s32 release_count, s32* p
 
 u32 KernelThreadManager::create_mutant(u32* handle_out, u32 access_mask, GuestAddr obj_attr,
                                         bool initial_owner) {
-    auto mutant = std::make_unique<KernelMutant>();
-    mutant->handle = allocate_handle();
+    auto mutant = std::make_shared<KernelMutant>();
     
     if (initial_owner && scheduler_) {
         GuestThread* current = scheduler_->get_current_thread(0);
@@ -420,11 +433,9 @@ u32 KernelThreadManager::create_mutant(u32* handle_out, u32 access_mask, GuestAd
         }
     }
     
-    u32 handle = mutant->handle;
-    
-    {
-        std::lock_guard<std::mutex> lock(objects_mutex_);
-        objects_[handle] = std::move(mutant);
+    u32 handle = add_object(mutant);
+    if (handle == 0) {
+        return nt::STATUS_NO_MEMORY;
     }
     
     if (handle_out) *handle_out = handle;
@@ -436,14 +447,13 @@ u32 KernelThreadManager::create_mutant(u32* handle_out, u32 access_mask, GuestAd
 }
 
 u32 KernelThreadManager::release_mutant(u32 handle, bool abandoned, s32* prev_count) {
-    std::lock_guard<std::mutex> lock(objects_mutex_);
-    
-    auto it = objects_.find(handle);
-    if (it == objects_.end() || it->second->type != KernelWaitableType::Mutant) {
+    auto obj = get_waitable(handle, KernelWaitableType::Mutant);
+    if (!obj) {
         return nt::STATUS_INVALID_HANDLE;
     }
     
-    auto* mutant = static_cast<KernelMutant*>(it->second.get());
+    std::lock_guard<std::mutex> lock(objects_mutex_);
+    auto* mutant = static_cast<KernelMutant*>(obj.get());
     
     // Verify ownership
     GuestThread* current = scheduler_ ? scheduler_->get_current_thread(0) : nullptr;
@@ -471,7 +481,15 @@ u32 KernelThreadManager::release_mutant(u32 handle, bool abandoned, s32* prev_co
 //=============================================================================
 
 u32 KernelThreadManager::wait_for_single_object(u32 handle, bool alertable, s64* timeout_100ns) {
-    return wait_for_multiple_objects(1, &handle, WaitType::WaitAny, alertable, timeout_100ns);
+    // The reference keeps the object alive through the wait even if the
+    // handle is closed meanwhile
+    auto obj = get_waitable(handle, KernelWaitableType::None);
+    if (!obj) {
+        return nt::STATUS_INVALID_HANDLE;
+    }
+    
+    stats_.total_waits++;
+    return perform_wait({obj.get()}, WaitType::WaitAny, alertable, timeout_100ns);
 }
 
 u32 KernelThreadManager::wait_for_multiple_objects(u32 count, const u32* handles,
@@ -483,19 +501,20 @@ u32 KernelThreadManager::wait_for_multiple_objects(u32 count, const u32* handles
     
     stats_.total_waits++;
     
-    // Collect waitable objects
+    // Collect waitable objects; the references keep them alive through
+    // the wait even if a handle is closed meanwhile
+    std::vector<std::shared_ptr<KernelWaitable>> refs;
     std::vector<KernelWaitable*> objects;
+    refs.reserve(count);
     objects.reserve(count);
     
-    {
-        std::lock_guard<std::mutex> lock(objects_mutex_);
-        for (u32 i = 0; i < count; i++) {
-            auto* obj = get_waitable(handles[i]);
-            if (!obj) {
-                return nt::STATUS_INVALID_HANDLE;
-            }
-            objects.push_back(obj);
+    for (u32 i = 0; i < count; i++) {
+        auto obj = get_waitable(handles[i], KernelWaitableType::None);
+        if (!obj) {
+            return nt::STATUS_INVALID_HANDLE;
         }
+        objects.push_back(obj.get());
+        refs.push_back(std::move(obj));
     }
     
     return perform_wait(objects, wait_type, alertable, timeout_100ns);
@@ -553,9 +572,46 @@ u32 KernelThreadManager::perform_wait(const std::vector<KernelWaitable*>& object
         current->in_alertable_wait = true;
     }
 
-    // Use condition variable-based waiting to avoid busy-wait.
-    // We pick the first object's CV for blocking (for WaitAny) or iterate for WaitAll.
-    // Each object's CV is notified when it becomes signaled via wake_waiters().
+    // A guest thread registers on every object and parks on its own futex
+    // word (or, as a fiber, lets its worker run other fibers) until
+    // wake_waiters() unparks it, or the timer queue does at the deadline.
+    // Each registration takes one object's lock on its own, so WaitAll never
+    // nests locks. Callers that aren't guest threads (host-side helpers,
+    // tests) block on the first object's CV.
+    GuestThread* parking_thread = GetCurrentGuestThread();
+    if (parking_thread && !parking_thread->scheduler) {
+        parking_thread = nullptr;
+    }
+    auto register_waiter = [&]() {
+        for (auto* obj : objects) {
+            std::lock_guard<std::mutex> lock(obj->wait_mutex);
+            auto& w = obj->waiters;
+            // wake_waiters() takes the whole list, so re-add after each wake
+            if (std::find(w.begin(), w.end(), parking_thread) == w.end()) {
+                w.push_back(parking_thread);
+            }
+        }
+    };
+    if (parking_thread) {
+        register_waiter();
+    }
+    struct WaiterGuard {
+        KernelThreadManager* manager;
+        const std::vector<KernelWaitable*>& objects;
+        GuestThread* thread;
+        u64 wake_id;
+        ~WaiterGuard() {
+            if (!thread) return;
+            for (auto* obj : objects) {
+                std::lock_guard<std::mutex> lock(obj->wait_mutex);
+                auto& w = obj->waiters;
+                w.erase(std::remove(w.begin(), w.end(), thread), w.end());
+            }
+            manager->disarm_wake(wake_id);
+        }
+    } waiter_guard{this, objects, parking_thread,
+                   (parking_thread && !infinite_wait) ? arm_wake(parking_thread, deadline) : 0};
+
     while (true) {
         // Check for pending APCs if alertable
         if (alertable && current) {
@@ -610,7 +666,11 @@ u32 KernelThreadManager::perform_wait(const std::vector<KernelWaitable*>& object
         // Block on the first object's condition variable with a timeout.
         // This avoids busy-waiting: we sleep until signaled or a short interval for
         // APC checking and timeout rechecking.
-        if (!objects.empty()) {
+        if (parking_thread) {
+            // No polling: signals, alerts, APCs and the deadline all unpark
+            parking_thread->scheduler->park(parking_thread);
+            register_waiter();
+        } else if (!objects.empty()) {
             auto* obj = objects[0];
             std::unique_lock<std::mutex> lock(obj->wait_mutex);
 
@@ -677,72 +737,110 @@ u32 KernelThreadManager::init_critical_section_with_spin(GuestAddr cs_ptr, u32 s
     return nt::STATUS_SUCCESS;
 }
 
+// Spin-wait hint for the critical section spin loop
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#endif
+}
+
+// Upper bound on critical section spinning; guest spin counts are tuned for
+// Xenon and can be far longer than a host context switch
+static constexpr u32 MAX_CS_SPIN = 4000;
+
+s32 KernelThreadManager::add_lock_count(GuestAddr cs_ptr, s32 delta) {
+    using CS = RTL_CRITICAL_SECTION_LAYOUT;
+    
+    GuestAddr addr = cs_ptr + CS::OFFSET_LOCK_COUNT;
+    u32 value = memory_->read_u32(addr);
+    if (!memory_->is_atomic_word(addr)) {
+        // The CAS below could never succeed here; the entry points reject
+        // such sections, so this is only a guard against spinning forever
+        memory_->write_u32(addr, value + static_cast<u32>(delta));
+        return static_cast<s32>(value + static_cast<u32>(delta));
+    }
+    while (!memory_->compare_exchange_u32(addr, value, value + static_cast<u32>(delta))) {
+    }
+    return static_cast<s32>(value + static_cast<u32>(delta));
+}
+
+bool KernelThreadManager::valid_critical_section(GuestAddr cs_ptr, const char* caller) {
+    using CS = RTL_CRITICAL_SECTION_LAYOUT;
+    
+    // The lock word must support host CAS (aligned RAM, not MMIO)
+    if (memory_->is_atomic_word(cs_ptr + CS::OFFSET_LOCK_COUNT)) {
+        return true;
+    }
+    LOGE("%s: invalid critical section 0x%08X", caller, cs_ptr);
+    return false;
+}
+
 u32 KernelThreadManager::enter_critical_section(GuestAddr cs_ptr) {
     using CS = RTL_CRITICAL_SECTION_LAYOUT;
     
+    if (!valid_critical_section(cs_ptr, "RtlEnterCriticalSection")) {
+        return nt::STATUS_INVALID_PARAMETER;
+    }
+    
     u32 current_tid = get_current_thread_id();
     if (current_tid == 0) current_tid = 1;  // Default to main thread
     
-    // Try to acquire
-    s32 lock_count = static_cast<s32>(memory_->read_u32(cs_ptr + CS::OFFSET_LOCK_COUNT));
-    u32 owning_thread = memory_->read_u32(cs_ptr + CS::OFFSET_OWNING_THREAD);
-    
-    // Already owned by us? (recursive)
-    if (owning_thread == current_tid) {
+    // Already owned by us? (recursive). Only the owner writes OwningThread,
+    // so seeing our own id can't be a race.
+    if (memory_->read_u32(cs_ptr + CS::OFFSET_OWNING_THREAD) == current_tid) {
+        add_lock_count(cs_ptr, 1);
         s32 recursion = static_cast<s32>(memory_->read_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT));
-        memory_->write_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, static_cast<u32>(lock_count + 1));
         memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, static_cast<u32>(recursion + 1));
         return nt::STATUS_SUCCESS;
     }
     
-    // Spin first (if spin count > 0)
-    u32 spin_count = memory_->read_u32(cs_ptr + CS::OFFSET_SPIN_COUNT);
-    for (u32 i = 0; i < spin_count; i++) {
-        lock_count = static_cast<s32>(memory_->read_u32(cs_ptr + CS::OFFSET_LOCK_COUNT));
-        if (lock_count == -1) {
-            // Unlocked - try to acquire
-            memory_->write_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, 0);
-            memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, 1);
-            memory_->write_u32(cs_ptr + CS::OFFSET_OWNING_THREAD, current_tid);
-            return nt::STATUS_SUCCESS;
+    // Uncontended: -1 -> 0 in one CAS. Spin while the section is held by a
+    // lone owner; once others are queued (LockCount > 0) spinning won't win.
+    u32 spin_count = std::min(memory_->read_u32(cs_ptr + CS::OFFSET_SPIN_COUNT), MAX_CS_SPIN);
+    for (u32 i = 0; ; i++) {
+        u32 expected = static_cast<u32>(-1);
+        if (memory_->compare_exchange_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, expected, 0)) {
+            break;
         }
-    }
-    
-    // Need to wait
-    while (true) {
-        lock_count = static_cast<s32>(memory_->read_u32(cs_ptr + CS::OFFSET_LOCK_COUNT));
-        
-        if (lock_count == -1) {
-            // Unlocked - acquire
-            memory_->write_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, 0);
-            memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, 1);
-            memory_->write_u32(cs_ptr + CS::OFFSET_OWNING_THREAD, current_tid);
-            return nt::STATUS_SUCCESS;
+        if (i >= spin_count || static_cast<s32>(expected) > 0) {
+            // Count ourselves in; if the owner left meanwhile we got it anyway
+            if (add_lock_count(cs_ptr, 1) != 0) {
+                keyed_wait(cs_ptr);  // Returns owning the section
+            }
+            break;
         }
-        
-        // Increment lock count to indicate we're waiting
-        memory_->write_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, static_cast<u32>(lock_count + 1));
-        
-        // Yield
-        yield();
+        cpu_relax();
     }
+    
+    memory_->write_u32(cs_ptr + CS::OFFSET_OWNING_THREAD, current_tid);
+    memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, 1);
+    return nt::STATUS_SUCCESS;
 }
 
 u32 KernelThreadManager::leave_critical_section(GuestAddr cs_ptr) {
     using CS = RTL_CRITICAL_SECTION_LAYOUT;
     
+    if (!valid_critical_section(cs_ptr, "RtlLeaveCriticalSection")) {
+        return nt::STATUS_INVALID_PARAMETER;
+    }
+    
     s32 recursion = static_cast<s32>(memory_->read_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT));
-    s32 lock_count = static_cast<s32>(memory_->read_u32(cs_ptr + CS::OFFSET_LOCK_COUNT));
     
     if (recursion > 1) {
         // Still have recursive locks
         memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, static_cast<u32>(recursion - 1));
-        memory_->write_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, static_cast<u32>(lock_count - 1));
-    } else {
-        // Release lock completely
-        memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, 0);
-        memory_->write_u32(cs_ptr + CS::OFFSET_OWNING_THREAD, 0);
-        memory_->write_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, static_cast<u32>(-1));
+        add_lock_count(cs_ptr, -1);
+        return nt::STATUS_SUCCESS;
+    }
+    
+    // Release lock completely; a count still >= 0 means threads are queued
+    // and the next one is handed ownership directly
+    memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, 0);
+    memory_->write_u32(cs_ptr + CS::OFFSET_OWNING_THREAD, 0);
+    if (add_lock_count(cs_ptr, -1) >= 0) {
+        keyed_release(cs_ptr);
     }
     
     return nt::STATUS_SUCCESS;
@@ -751,34 +849,106 @@ u32 KernelThreadManager::leave_critical_section(GuestAddr cs_ptr) {
 u32 KernelThreadManager::try_enter_critical_section(GuestAddr cs_ptr) {
     using CS = RTL_CRITICAL_SECTION_LAYOUT;
     
+    if (!valid_critical_section(cs_ptr, "RtlTryEnterCriticalSection")) {
+        return 0;  // FALSE
+    }
+    
     u32 current_tid = get_current_thread_id();
     if (current_tid == 0) current_tid = 1;
     
-    s32 lock_count = static_cast<s32>(memory_->read_u32(cs_ptr + CS::OFFSET_LOCK_COUNT));
-    u32 owning_thread = memory_->read_u32(cs_ptr + CS::OFFSET_OWNING_THREAD);
-    
     // Already owned by us?
-    if (owning_thread == current_tid) {
+    if (memory_->read_u32(cs_ptr + CS::OFFSET_OWNING_THREAD) == current_tid) {
+        add_lock_count(cs_ptr, 1);
         s32 recursion = static_cast<s32>(memory_->read_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT));
-        memory_->write_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, static_cast<u32>(lock_count + 1));
         memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, static_cast<u32>(recursion + 1));
         return 1;  // TRUE - acquired
     }
     
     // Try to acquire
-    if (lock_count == -1) {
-        memory_->write_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, 0);
-        memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, 1);
+    u32 expected = static_cast<u32>(-1);
+    if (memory_->compare_exchange_u32(cs_ptr + CS::OFFSET_LOCK_COUNT, expected, 0)) {
         memory_->write_u32(cs_ptr + CS::OFFSET_OWNING_THREAD, current_tid);
+        memory_->write_u32(cs_ptr + CS::OFFSET_RECURSION_COUNT, 1);
         return 1;  // TRUE - acquired
     }
     
     return 0;  // FALSE - not acquired
 }
 
+KernelThreadManager::KeyedBucket& KernelThreadManager::keyed_bucket(GuestAddr key) {
+    return keyed_buckets_[(key >> 3) % KEYED_BUCKETS];
+}
+
+void KernelThreadManager::keyed_wait(GuestAddr key) {
+    static thread_local Parker host_parker;
+    
+    GuestThread* thread = GetCurrentGuestThread();
+    if (thread && !thread->scheduler) thread = nullptr;
+    
+    KeyedWaiter waiter;
+    waiter.key = key;
+    waiter.thread = thread;
+    waiter.host_parker = thread ? nullptr : &host_parker;
+    
+    auto& bucket = keyed_bucket(key);
+    {
+        std::lock_guard<std::mutex> lock(bucket.mutex);
+        auto banked = bucket.banked_releases.find(key);
+        if (banked != bucket.banked_releases.end()) {
+            if (--banked->second == 0) bucket.banked_releases.erase(banked);
+            return;
+        }
+        bucket.waiters.push_back(&waiter);
+    }
+    
+    while (!waiter.released.load(std::memory_order_acquire)) {
+        if (thread) {
+            thread->scheduler->park(thread);
+        } else {
+            host_parker.park();
+        }
+    }
+    
+    // keyed_release() unparks under the bucket lock; wait for it to finish
+    // before this thread (and its parker) can go away
+    std::lock_guard<std::mutex> lock(bucket.mutex);
+}
+
+void KernelThreadManager::keyed_release(GuestAddr key) {
+    auto& bucket = keyed_bucket(key);
+    std::lock_guard<std::mutex> lock(bucket.mutex);
+    
+    auto it = std::find_if(bucket.waiters.begin(), bucket.waiters.end(),
+                           [key](KeyedWaiter* w) { return w->key == key; });
+    if (it == bucket.waiters.end()) {
+        // The waiter counted itself but hasn't queued yet
+        bucket.banked_releases[key]++;
+        return;
+    }
+    KeyedWaiter* waiter = *it;
+    bucket.waiters.erase(it);
+    
+    // The node may be gone once released is visible; copy what we need
+    GuestThread* thread = waiter->thread;
+    Parker* host_parker = waiter->host_parker;
+    waiter->released.store(true, std::memory_order_release);
+    if (thread) {
+        thread->scheduler->unpark(thread);
+    } else {
+        host_parker->unpark();
+    }
+}
+
 u32 KernelThreadManager::delete_critical_section(GuestAddr cs_ptr) {
     using CS = RTL_CRITICAL_SECTION_LAYOUT;
     
+    // Drop releases banked for a waiter that will never come
+    {
+        auto& bucket = keyed_bucket(cs_ptr);
+        std::lock_guard<std::mutex> lock(bucket.mutex);
+        bucket.banked_releases.erase(cs_ptr);
+    }
+    
     // Zero out the structure
     for (u32 i = 0; i < CS::SIZE; i += 4) {
         memory_->write_u32(cs_ptr + i, 0);
@@ -842,6 +1012,11 @@ u32 KernelThreadManager::tls_set_value(u32 index, u64 value) {
 //=============================================================================
 
 void KernelThreadManager::yield() {
+    if (GuestThread* fiber_thread = GetCurrentFiberThread()) {
+        // Fiber mode: let the next fiber on this worker run
+        fiber_thread->scheduler->yield(fiber_thread);
+        return;
+    }
     if (scheduler_) {
         GuestThread* current = scheduler_->get_current_thread(0);
         if (current) {
@@ -852,7 +1027,9 @@ void KernelThreadManager::yield() {
 }
 
 u32 KernelThreadManager::delay_execution(bool alertable, s64* interval_100ns) {
-    GuestThread* current = scheduler_ ? scheduler_->get_current_thread(0) : nullptr;
+    // The sleeper itself, so alerts aimed at it can unpark it
+    GuestThread* current = GetCurrentGuestThread();
+    if (!current && scheduler_) current = scheduler_->get_current_thread(0);
     
     // Check for pending APCs if alertable
     if (alertable && current && current->has_pending_apcs()) {
@@ -881,70 +1058,35 @@ u32 KernelThreadManager::delay_execution(bool alertable, s64* interval_100ns) {
         current->in_alertable_wait = true;
     }
     
+    // Relative (negative) or absolute interval, as a delay in 100ns units
+    u64 delay_100ns = 0;
     if (interval < 0) {
-        // Relative time in 100ns units (negative)
-        u64 microseconds = static_cast<u64>(-interval) / 10;
-        if (microseconds > 0) {
-            // For alertable waits, we need to check for APCs periodically
-            if (alertable && current) {
-                u64 remaining_us = microseconds;
-                constexpr u64 check_interval_us = 1000;  // Check every 1ms
-                
-                while (remaining_us > 0) {
-                    // Check for APCs
-                    if (current->has_pending_apcs()) {
-                        scheduler_->process_pending_apcs(current);
-                        return nt::STATUS_USER_APC;
-                    }
-                    if (current->alerted) {
-                        current->alerted = false;
-                        scheduler_->process_pending_apcs(current);
-                        return nt::STATUS_ALERTED;
-                    }
-                    
-                    u64 sleep_us = std::min(remaining_us, check_interval_us);
-                    std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
-                    remaining_us -= sleep_us;
-                }
-                current->in_alertable_wait = false;
-            } else {
-                std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
-            }
+        delay_100ns = static_cast<u64>(-interval);
+        if (delay_100ns < 10) delay_100ns = 0;  // Sub-microsecond: just yield
+    } else if (interval > 0) {
+        u64 now = get_current_time_100ns();
+        if (static_cast<u64>(interval) <= now) {
+            delay_100ns = ~0ULL;  // Already past: return immediately
         } else {
-            yield();
+            delay_100ns = static_cast<u64>(interval) - now;
         }
-    } else if (interval == 0) {
+    }
+
+    if (delay_100ns == 0) {
         yield();
-    } else {
-        // Absolute time - calculate delay from current time
-        u64 now = get_current_time_100ns();
-        if (static_cast<u64>(interval) > now) {
-            u64 delay_100ns = static_cast<u64>(interval) - now;
-            u64 delay_us = delay_100ns / 10;
-            
-            // For alertable waits, check for APCs periodically
-            if (alertable && current && delay_us > 0) {
-                constexpr u64 check_interval_us = 1000;  // Check every 1ms
-                
-                while (delay_us > 0) {
-                    // Check for APCs
-                    if (current->has_pending_apcs()) {
-                        scheduler_->process_pending_apcs(current);
-                        return nt::STATUS_USER_APC;
-                    }
-                    if (current->alerted) {
-                        current->alerted = false;
-                        scheduler_->process_pending_apcs(current);
-                        return nt::STATUS_ALERTED;
-                    }
-                    
-                    u64 sleep_us = std::min(delay_us, check_interval_us);
-                    std::this_thread::sleep_for(std::chrono::microseconds(sleep_us));
-                    delay_us -= sleep_us;
-                }
-                current->in_alertable_wait = false;
-            } else {
-                std::this_thread::sleep_for(std::chrono::nanoseconds(delay_100ns * 100));
+    } else if (delay_100ns != ~0ULL) {
+        // An alertable sleep ends early when an APC or alert arrives;
+        // queue_apc()/alert_thread() unpark the sleeper
+        sleep_current(delay_100ns * 100, (alertable && current) ? current : nullptr);
+        if (alertable && current) {
+            if (current->has_pending_apcs()) {
+                scheduler_->process_pending_apcs(current);
+                return nt::STATUS_USER_APC;
+            }
+            if (current->alerted) {
+                current->alerted = false;
+                scheduler_->process_pending_apcs(current);
+                return nt::STATUS_ALERTED;
             }
         }
     }
@@ -956,19 +1098,57 @@ u32 KernelThreadManager::delay_execution(bool alertable, s64* interval_100ns) {
     return nt::STATUS_SUCCESS;
 }
 
+void KernelThreadManager::sleep_current(u64 nanoseconds, GuestThread* alertable_thread) {
+    GuestThread* thread = GetCurrentGuestThread();
+    if (!thread || !thread->scheduler) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(nanoseconds));
+        return;
+    }
+    
+    // Park until the timer queue unparks us at the deadline. A fiber parks
+    // rather than sleeps so its worker keeps running other fibers. Unrelated
+    // unparks can end a park early, hence the loop.
+    u64 deadline = get_current_time_100ns() + (nanoseconds + 99) / 100;
+    u64 wake_id = arm_wake(thread, deadline);
+    while (get_current_time_100ns() < deadline) {
+        if (alertable_thread &&
+            (alertable_thread->has_pending_apcs() || alertable_thread->alerted)) {
+            break;
+        }
+        thread->scheduler->park(thread);
+    }
+    disarm_wake(wake_id);
+}
+
+u64 KernelThreadManager::arm_wake(GuestThread* thread, u64 deadline_100ns) {
+    return TimerQueue::instance().schedule(deadline_100ns, [thread]() {
+        thread->scheduler->unpark(thread);
+    });
+}
+
+void KernelThreadManager::disarm_wake(u64 wake_id) {
+    if (!wake_id) return;
+    auto& timer_queue = TimerQueue::instance();
+    if (!timer_queue.cancel(wake_id)) {
+        // Already fired; make sure the callback is done touching the thread
+        timer_queue.synchronize();
+    }
+}
+
 //=============================================================================
 // Handle Management
 //=============================================================================
 
 u32 KernelThreadManager::close_handle(u32 handle) {
     // Try local waitable objects first
-    {
-        std::lock_guard<std::mutex> lock(objects_mutex_);
-        auto it = objects_.find(handle);
-        if (it != objects_.end()) {
-            objects_.erase(it);
-            return nt::STATUS_SUCCESS;
+    if (auto obj = objects_.remove(handle)) {
+        if (obj->type == KernelWaitableType::Timer) {
+            // A late expiry finds the handle gone and does nothing
+            std::lock_guard<std::mutex> lock(objects_mutex_);
+            u64 timer_id = static_cast<KernelTimer*>(obj.get())->timer_id;
+            if (timer_id) TimerQueue::instance().cancel(timer_id);
         }
+        return nt::STATUS_SUCCESS;
     }
 
     // Check thread handles
@@ -1008,38 +1188,52 @@ u32 KernelThreadManager::duplicate_handle(u32 source_handle, u32* target_handle)
 // Helper Methods
 //=============================================================================
 
-u32 KernelThreadManager::allocate_handle() {
-    return next_handle_++;
+u32 KernelThreadManager::add_object(std::shared_ptr<KernelWaitable> object) {
+    KernelWaitable* raw = object.get();
+    u32 handle = objects_.insert(std::move(object));
+    if (handle == 0) {
+        LOGE("Kernel object handle table full");
+        return 0;
+    }
+    raw->handle = handle;
+    return handle;
 }
 
-KernelWaitable* KernelThreadManager::get_waitable(u32 handle) {
-    auto it = objects_.find(handle);
-    if (it != objects_.end()) {
-        return it->second.get();
+std::shared_ptr<KernelWaitable> KernelThreadManager::get_waitable(u32 handle,
+                                                                 KernelWaitableType type) {
+    auto obj = objects_.lookup(handle);
+    if (obj && type != KernelWaitableType::None && obj->type != type) {
+        return nullptr;
     }
-    return nullptr;
+    return obj;
 }
 
 void KernelThreadManager::wake_waiters(KernelWaitable* obj) {
     if (!obj || !scheduler_) return;
 
     // Wake threads waiting on this object
-    for (auto* thread : obj->waiters) {
+    std::vector<GuestThread*> woken;
+    {
+        std::lock_guard<std::mutex> lock(obj->wait_mutex);
+        woken.swap(obj->waiters);
+    }
+    for (auto* thread : woken) {
         if (thread && thread->state == ThreadState::Waiting) {
             thread->state = ThreadState::Ready;
             thread->wait_object = 0;
         }
+        // Threads parked in perform_wait()
+        if (thread && thread->scheduler) {
+            thread->scheduler->unpark(thread);
+        }
     }
-    obj->waiters.clear();
 
     // Notify the condition variable to wake any threads blocked in perform_wait()
     obj->wait_cv.notify_all();
 }
 
 u64 KernelThreadManager::get_current_time_100ns() const {
-    auto now = std::chrono::steady_clock::now();
-    auto duration = now.time_since_epoch();
-    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 100;
+    return TimerQueue::now_100ns();
 }
 
 //=============================================================================
@@ -1048,14 +1242,11 @@ u64 KernelThreadManager::get_current_time_100ns() const {
 
 u32 KernelThreadManager::create_timer(u32* handle_out, u32 access_mask, GuestAddr obj_attr,
                                        u32 timer_type) {
-    auto timer = std::make_unique<KernelTimer>();
-    timer->handle = allocate_handle();
-
-    u32 handle = timer->handle;
+    auto timer = std::make_shared<KernelTimer>();
 
-    {
-        std::lock_guard<std::mutex> lock(objects_mutex_);
-        objects_[handle] = std::move(timer);
+    u32 handle = add_object(timer);
+    if (handle == 0) {
+        return nt::STATUS_NO_MEMORY;
     }
 
     if (handle_out) *handle_out = handle;
@@ -1068,14 +1259,13 @@ u32 KernelThreadManager::create_timer(u32* handle_out, u32 access_mask, GuestAdd
 u32 KernelThreadManager::set_timer(u32 handle, s64 due_time, u32 period_ms,
                                     GuestAddr dpc_routine, GuestAddr dpc_context,
                                     bool resume, bool* prev_state) {
-    std::lock_guard<std::mutex> lock(objects_mutex_);
-
-    auto it = objects_.find(handle);
-    if (it == objects_.end() || it->second->type != KernelWaitableType::Timer) {
+    auto obj = get_waitable(handle, KernelWaitableType::Timer);
+    if (!obj) {
         return nt::STATUS_INVALID_HANDLE;
     }
 
-    auto* timer = static_cast<KernelTimer*>(it->second.get());
+    std::lock_guard<std::mutex> lock(objects_mutex_);
+    auto* timer = static_cast<KernelTimer*>(obj.get());
 
     if (prev_state) *prev_state = timer->active;
 
@@ -1097,6 +1287,14 @@ u32 KernelThreadManager::set_timer(u32 handle, s64 due_time, u32 period_ms,
     timer->dpc_context = dpc_context;
     timer->active = true;
 
+    // Re-arming replaces any pending expiry
+    auto& timer_queue = TimerQueue::instance();
+    if (timer->timer_id) timer_queue.cancel(timer->timer_id);
+    u32 generation = ++timer->generation;
+    timer->timer_id = timer_queue.schedule(timer->due_time_100ns, [this, handle, generation]() {
+        fire_timer(handle, generation);
+    });
+
     LOGD("Set timer 0x%X: due=%llu, period=%u ms, dpc=0x%08X",
          handle, (unsigned long long)timer->due_time_100ns, period_ms, dpc_routine);
 
@@ -1104,47 +1302,62 @@ u32 KernelThreadManager::set_timer(u32 handle, s64 due_time, u32 period_ms,
 }
 
 u32 KernelThreadManager::cancel_timer(u32 handle, bool* was_set) {
-    std::lock_guard<std::mutex> lock(objects_mutex_);
-
-    auto it = objects_.find(handle);
-    if (it == objects_.end() || it->second->type != KernelWaitableType::Timer) {
+    auto obj = get_waitable(handle, KernelWaitableType::Timer);
+    if (!obj) {
         return nt::STATUS_INVALID_HANDLE;
     }
 
-    auto* timer = static_cast<KernelTimer*>(it->second.get());
+    std::lock_guard<std::mutex> lock(objects_mutex_);
+    auto* timer = static_cast<KernelTimer*>(obj.get());
 
     if (was_set) *was_set = timer->active;
     timer->active = false;
     timer->signaled = false;
+    timer->generation++;
+    if (timer->timer_id) {
+        TimerQueue::instance().cancel(timer->timer_id);
+        timer->timer_id = 0;
+    }
 
     return nt::STATUS_SUCCESS;
 }
 
 void KernelThreadManager::process_timer_queue() {
-    u64 now = get_current_time_100ns();
-    std::lock_guard<std::mutex> lock(objects_mutex_);
+    TimerQueue::instance().run_expired();
+}
 
-    for (auto& [h, obj] : objects_) {
-        if (obj->type != KernelWaitableType::Timer) continue;
+void KernelThreadManager::fire_timer(u32 handle, u32 generation) {
+    auto obj = get_waitable(handle, KernelWaitableType::Timer);
+    if (!obj) {
+        return;  // Closed while pending
+    }
 
-        auto* timer = static_cast<KernelTimer*>(obj.get());
-        if (!timer->active) continue;
-        if (now < timer->due_time_100ns) continue;
+    std::lock_guard<std::mutex> lock(objects_mutex_);
+    auto* timer = static_cast<KernelTimer*>(obj.get());
+    if (!timer->active || timer->generation != generation) {
+        return;  // Cancelled or re-armed after this expiry was popped
+    }
 
-        // Timer expired - signal it
-        timer->signaled = true;
-        wake_waiters(timer);
+    // Timer expired - signal it
+    timer->signaled = true;
+    wake_waiters(timer);
 
-        // Handle periodic timer
-        if (timer->periodic && timer->period_100ns > 0) {
+    // Handle periodic timer
+    if (timer->periodic && timer->period_100ns > 0) {
+        timer->due_time_100ns += timer->period_100ns;
+        u64 now = get_current_time_100ns();
+        if (timer->due_time_100ns <= now) {
+            // Fell behind (host stall); skip missed periods instead of bursting
             timer->due_time_100ns = now + timer->period_100ns;
-            timer->signaled = false;  // Reset for next period
-        } else {
-            timer->active = false;
         }
-
-        LOGD("Timer 0x%X fired", timer->handle);
+        timer->timer_id = TimerQueue::instance().schedule(
+            timer->due_time_100ns, [this, handle, generation]() { fire_timer(handle, generation); });
+    } else {
+        timer->active = false;
+        timer->timer_id = 0;
     }
+
+    LOGD("Timer 0x%X fired", timer->handle);
 }
 
 //=============================================================================
@@ -1153,15 +1366,12 @@ void KernelThreadManager::process_timer_queue() {
 
 u32 KernelThreadManager::create_io_completion(u32* handle_out, u32 access_mask, GuestAddr obj_attr,
                                                u32 max_concurrent_threads) {
-    auto iocp = std::make_unique<KernelIoCompletion>();
+    auto iocp = std::make_shared<KernelIoCompletion>();
     iocp->max_concurrent_threads = max_concurrent_threads;
-    iocp->handle = allocate_handle();
-
-    u32 handle = iocp->handle;
 
-    {
-        std::lock_guard<std::mutex> lock(objects_mutex_);
-        objects_[handle] = std::move(iocp);
+    u32 handle = add_object(iocp);
+    if (handle == 0) {
+        return nt::STATUS_NO_MEMORY;
     }
 
     if (handle_out) *handle_out = handle;
@@ -1173,14 +1383,13 @@ u32 KernelThreadManager::create_io_completion(u32* handle_out, u32 access_mask,
 
 u32 KernelThreadManager::set_io_completion(u32 handle, GuestAddr key_context, GuestAddr apc_context,
                                             u32 status, u32 bytes_transferred) {
-    std::lock_guard<std::mutex> lock(objects_mutex_);
-
-    auto it = objects_.find(handle);
-    if (it == objects_.end() || it->second->type != KernelWaitableType::IoCompletion) {
+    auto obj = get_waitable(handle, KernelWaitableType::IoCompletion);
+    if (!obj) {
         return nt::STATUS_INVALID_HANDLE;
     }
 
-    auto* iocp = static_cast<KernelIoCompletion*>(it->second.get());
+    std::lock_guard<std::mutex> lock(objects_mutex_);
+    auto* iocp = static_cast<KernelIoCompletion*>(obj.get());
 
     IoCompletionPacket packet;
     packet.key_context = key_context;
@@ -1200,16 +1409,12 @@ u32 KernelThreadManager::set_io_completion(u32 handle, GuestAddr key_context, Gu
 
 u32 KernelThreadManager::remove_io_completion(u32 handle, IoCompletionPacket* packet_out,
                                                s64* timeout_100ns) {
-    KernelIoCompletion* iocp = nullptr;
-
-    {
-        std::lock_guard<std::mutex> lock(objects_mutex_);
-        auto it = objects_.find(handle);
-        if (it == objects_.end() || it->second->type != KernelWaitableType::IoCompletion) {
-            return nt::STATUS_INVALID_HANDLE;
-        }
-        iocp = static_cast<KernelIoCompletion*>(it->second.get());
+    // Held for the whole wait, so a concurrent close can't free the port
+    auto obj = get_waitable(handle, KernelWaitableType::IoCompletion);
+    if (!obj) {
+        return nt::STATUS_INVALID_HANDLE;
     }
+    auto* iocp = static_cast<KernelIoCompletion*>(obj.get());
 
     // Try to dequeue immediately
     {
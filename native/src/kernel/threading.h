@@ -15,6 +15,7 @@
 #pragma once
 
 #include "x360mu/types.h"
+#include "handle_table.h"
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -33,6 +34,7 @@ class Memory;
 class Cpu;
 class ThreadScheduler;
 struct GuestThread;
+class Parker;
 
 //=============================================================================
 // NTSTATUS Codes
@@ -188,6 +190,8 @@ struct KernelTimer : public KernelWaitable {
     GuestAddr dpc_context = 0;
     GuestAddr dpc_arg1 = 0;
     GuestAddr dpc_arg2 = 0;
+    u64 timer_id = 0;            // TimerQueue entry while armed (0 = none)
+    u32 generation = 0;          // Bumped on every arm/cancel to drop stale expiries
 
     KernelTimer() { type = KernelWaitableType::Timer; }
 
@@ -424,11 +428,15 @@ public:
     
     /**
      * Enter a critical section (RtlEnterCriticalSection)
+     * Uncontended: one compare-and-swap on LockCount. Contended: spins up to
+     * the section's spin count, then parks on the section address until the
+     * owner hands it over.
      */
     u32 enter_critical_section(GuestAddr cs_ptr);
     
     /**
      * Leave a critical section (RtlLeaveCriticalSection)
+     * Wakes exactly one parked waiter if LockCount shows any.
      */
     u32 leave_critical_section(GuestAddr cs_ptr);
     
@@ -526,7 +534,8 @@ public:
     u32 cancel_timer(u32 handle, bool* was_set);
 
     /**
-     * Process expired timers (called from main loop)
+     * Fire timers that are already due on the calling thread. Timers normally
+     * fire from the TimerQueue thread; this only catches up if it lags.
      */
     void process_timer_queue();
 
@@ -573,8 +582,13 @@ private:
     Cpu* cpu_ = nullptr;
     ThreadScheduler* scheduler_ = nullptr;
     
-    // Kernel objects (events, semaphores, mutants)
-    std::unordered_map<u32, std::unique_ptr<KernelWaitable>> objects_;
+    // Kernel objects (events, semaphores, mutants, timers, I/O completions).
+    // Lookups are lock-free; objects_mutex_ only serializes state changes on
+    // the non-event objects (events use their own wait_mutex). The tag keeps
+    // these handles clear of ThreadScheduler's (0x80000100 and up) and the
+    // untagged ObjectTable's.
+    static constexpr u32 OBJECT_HANDLE_TAG = 0xC0000000;
+    HandleTable<KernelWaitable> objects_{OBJECT_HANDLE_TAG};
     std::mutex objects_mutex_;
     
     // Thread handle to GuestThread* mapping (managed by ThreadScheduler)
@@ -586,17 +600,40 @@ private:
     std::array<bool, 64> tls_slots_used_;
     std::mutex tls_mutex_;
     
-    // Handle generation
-    std::atomic<u32> next_handle_{0x80001000};
+    // Keyed event for critical sections: waiters park on the section address.
+    // A release that finds nobody queued yet is banked for the next waiter
+    // (the waiter has already counted itself in LockCount).
+    struct KeyedWaiter {
+        GuestAddr key;
+        GuestThread* thread;        // Parks through its scheduler, or
+        Parker* host_parker;        // a non-guest caller's own parker
+        std::atomic<bool> released{false};
+    };
+    struct KeyedBucket {
+        std::mutex mutex;
+        std::deque<KeyedWaiter*> waiters;
+        std::unordered_map<GuestAddr, u32> banked_releases;
+    };
+    static constexpr u32 KEYED_BUCKETS = 64;
+    std::array<KeyedBucket, KEYED_BUCKETS> keyed_buckets_;
     
     // Statistics
     Stats stats_ = {};
     
     // Helper methods
-    u32 allocate_handle();
-    KernelWaitable* get_waitable(u32 handle);
+    u32 add_object(std::shared_ptr<KernelWaitable> object);
+    std::shared_ptr<KernelWaitable> get_waitable(u32 handle, KernelWaitableType type);
     void wake_waiters(KernelWaitable* obj);
+    void fire_timer(u32 handle, u32 generation);
+    KeyedBucket& keyed_bucket(GuestAddr key);
+    void keyed_wait(GuestAddr key);
+    void keyed_release(GuestAddr key);
+    s32 add_lock_count(GuestAddr cs_ptr, s32 delta);
+    bool valid_critical_section(GuestAddr cs_ptr, const char* caller);
     u64 get_current_time_100ns() const;
+    void sleep_current(u64 nanoseconds, GuestThread* alertable_thread = nullptr);
+    u64 arm_wake(GuestThread* thread, u64 deadline_100ns);
+    void disarm_wake(u64 wake_id);
     bool check_wait_satisfied(const std::vector<KernelWaitable*>& objects, WaitType wait_type);
     u32 perform_wait(const std::vector<KernelWaitable*>& objects, WaitType wait_type,
                      bool alertable, s64* timeout_100ns);
@@ -0,0 +1,179 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Kernel Timer Queue Implementation
+ */
+
+#include "timer_queue.h"
+#include "../cpu/xenon/host_affinity.h"
+#include "../core/guest_clock.h"
+#include <chrono>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "360mu-timerq"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) printf("[TimerQ] " __VA_ARGS__); printf("\n")
+#endif
+
+namespace x360mu {
+
+TimerQueue& TimerQueue::instance() {
+    static TimerQueue queue;
+    return queue;
+}
+
+TimerQueue::~TimerQueue() {
+    stop();
+}
+
+u64 TimerQueue::now_100ns() {
+    return GuestClock::instance().now_100ns();
+}
+
+u64 TimerQueue::schedule(u64 due_100ns, Callback callback) {
+    u64 id;
+    bool new_earliest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_id_++;
+        new_earliest = heap_.empty() || due_100ns < heap_.top().due;
+        heap_.push({due_100ns, id});
+        callbacks_.emplace(id, std::move(callback));
+
+        if (!thread_started_ && !GuestClock::instance().is_virtual()) {
+            thread_started_ = true;
+            stop_ = false;
+            thread_ = std::thread(&TimerQueue::thread_main, this);
+            LOGI("Timer thread started");
+        }
+    }
+    // Only an earlier deadline changes how long the thread should sleep
+    if (new_earliest) {
+        cv_.notify_one();
+    }
+    return id;
+}
+
+bool TimerQueue::cancel(u64 id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The heap entry stays until it reaches the top (lazy deletion)
+    return callbacks_.erase(id) != 0;
+}
+
+void TimerQueue::synchronize() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this] { return running_callbacks_ == 0; });
+}
+
+void TimerQueue::drop_cancelled_top() {
+    while (!heap_.empty() && callbacks_.find(heap_.top().id) == callbacks_.end()) {
+        heap_.pop();
+    }
+}
+
+bool TimerQueue::pop_expired(u64 now, std::vector<Callback>& out) {
+    drop_cancelled_top();
+    while (!heap_.empty() && heap_.top().due <= now) {
+        auto it = callbacks_.find(heap_.top().id);
+        heap_.pop();
+        if (it != callbacks_.end()) {
+            out.push_back(std::move(it->second));
+            callbacks_.erase(it);
+        }
+        drop_cancelled_top();
+    }
+    return !out.empty();
+}
+
+u32 TimerQueue::run_expired() {
+    std::vector<Callback> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pop_expired(now_100ns(), expired)) return 0;
+        running_callbacks_++;
+    }
+
+    for (auto& callback : expired) {
+        callback();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_callbacks_--;
+    }
+    idle_cv_.notify_all();
+    return static_cast<u32>(expired.size());
+}
+
+u64 TimerQueue::next_due() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drop_cancelled_top();
+    return heap_.empty() ? ~0ULL : heap_.top().due;
+}
+
+size_t TimerQueue::pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return callbacks_.size();
+}
+
+void TimerQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_started_) return;
+        stop_ = true;
+        thread_started_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void TimerQueue::clock_changed() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    cv_.notify_one();
+}
+
+void TimerQueue::thread_main() {
+    std::vector<Callback> expired;
+    HostAffinity::instance().pin_service_thread("timer");
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stop_) {
+        if (GuestClock::instance().is_virtual()) {
+            // Virtual time does not pass while we sleep; the scheduler fires
+            // expiries in run_expired()
+            cv_.wait(lock);
+            continue;
+        }
+        if (!pop_expired(now_100ns(), expired)) {
+            if (heap_.empty()) {
+                cv_.wait(lock);
+            } else {
+                // Sleep until the earliest deadline or an earlier schedule()
+                auto due = std::chrono::steady_clock::time_point(
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::nanoseconds(heap_.top().due * 100)));
+                cv_.wait_until(lock, due);
+            }
+            continue;
+        }
+
+        running_callbacks_++;
+        lock.unlock();
+        for (auto& callback : expired) {
+            callback();
+        }
+        expired.clear();
+        lock.lock();
+        running_callbacks_--;
+        idle_cv_.notify_all();
+    }
+}
+
+} // namespace x360mu
@@ -0,0 +1,117 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Kernel Timer Queue
+ *
+ * Min-heap of deadlines shared by kernel timers (NtSetTimerEx, KeSetTimer)
+ * and guest sleeps. A host timer thread sleeps until the earliest deadline
+ * and runs the expired callbacks, so nothing has to scan timer lists from
+ * the emulation loop. Callbacks run on the timer thread (or on whoever calls
+ * run_expired()) and must not block.
+ *
+ * Deadlines are on the guest clock. While it runs on virtual time the timer
+ * thread stays idle and the deterministic scheduler fires expiries itself
+ * through run_expired() as the clock passes them.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace x360mu {
+
+class TimerQueue {
+public:
+    using Callback = std::function<void()>;
+
+    static TimerQueue& instance();
+
+    TimerQueue() = default;
+    ~TimerQueue();
+
+    TimerQueue(const TimerQueue&) = delete;
+    TimerQueue& operator=(const TimerQueue&) = delete;
+
+    /**
+     * Current time on the queue's clock (GuestClock, 100ns units)
+     */
+    static u64 now_100ns();
+
+    /**
+     * Run `callback` once at `due_100ns` (now_100ns() clock). Starts the
+     * timer thread on first use, unless the guest clock is virtual.
+     * @return Id for cancel(), never 0
+     */
+    u64 schedule(u64 due_100ns, Callback callback);
+
+    /**
+     * Drop a pending timer. Non-blocking: a callback already running is not
+     * waited for (see synchronize()).
+     * @return true if the timer had not fired yet
+     */
+    bool cancel(u64 id);
+
+    /**
+     * Wait until no callback is running. Used after cancel() before freeing
+     * state the callbacks reference.
+     */
+    void synchronize();
+
+    /**
+     * Fire everything already due on the calling thread
+     * @return Number of callbacks run
+     */
+    u32 run_expired();
+
+    /**
+     * Earliest pending deadline, or ~0 if none
+     */
+    u64 next_due();
+
+    size_t pending();
+
+    /**
+     * Let the timer thread re-read the guest clock after it switched
+     * between host and virtual time
+     */
+    void clock_changed();
+
+    /**
+     * Stop the timer thread; pending timers stay queued
+     */
+    void stop();
+
+private:
+    struct Entry {
+        u64 due;
+        u64 id;
+        bool operator>(const Entry& other) const {
+            return due != other.due ? due > other.due : id > other.id;
+        }
+    };
+
+    void thread_main();
+    bool pop_expired(u64 now, std::vector<Callback>& out);
+    void drop_cancelled_top();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable idle_cv_;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap_;
+    std::unordered_map<u64, Callback> callbacks_;   // Pending (not cancelled) timers
+    u64 next_id_ = 1;
+    u32 running_callbacks_ = 0;
+
+    std::thread thread_;
+    bool thread_started_ = false;
+    bool stop_ = false;
+};
+
+} // namespace x360mu
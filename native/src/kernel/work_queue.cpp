@@ -5,6 +5,8 @@
  */
 
 #include "work_queue.h"
+#include "../core/parker.h"
+#include <algorithm>
 #include <chrono>
 
 #ifdef __ANDROID__
@@ -26,96 +28,173 @@ namespace x360mu {
 // WorkQueue Implementation
 //=============================================================================
 
+WorkQueue::~WorkQueue() {
+    drain();
+}
+
 void WorkQueue::enqueue(const WorkQueueItem& item) {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        items_.push_back(item);
-        LOGI("Enqueued work item: routine=0x%08X, param=0x%08X, queue_size=%zu",
-             (u32)item.worker_routine, (u32)item.parameter, items_.size());
+    auto* node = new Node();
+    node->item = item;
+    
+    size_.fetch_add(1, std::memory_order_relaxed);
+    incoming_.push(node);
+    wake_waiter();
+    
+    LOGD("Enqueued work item: routine=0x%08X, param=0x%08X",
+         (u32)item.worker_routine, (u32)item.parameter);
+}
+
+void WorkQueue::wake_waiter() {
+    // Pairs with the fence in dequeue(): either the consumer sees the new
+    // item before parking, or we see it registered here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiter_.load(std::memory_order_relaxed)) {
+        if (Parker* waiter = waiter_.exchange(nullptr, std::memory_order_acq_rel)) {
+            waiter->unpark();
+        }
     }
-    cv_.notify_one();
 }
 
-bool WorkQueue::dequeue(WorkQueueItem& item, u32 timeout_ms) {
-    std::unique_lock<std::mutex> lock(mutex_);
+void WorkQueue::collect() {
+    Node* batch = incoming_.pop_all();
+    if (!batch) return;
     
-    if (timeout_ms == WORK_QUEUE_INFINITE_TIMEOUT) {
-        // Infinite wait
-        cv_.wait(lock, [this] { return !items_.empty() || shutdown_.load(); });
-    } else if (timeout_ms > 0) {
-        // Timed wait
-        auto result = cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms),
-                                   [this] { return !items_.empty() || shutdown_.load(); });
-        if (!result) {
-            return false;  // Timeout
-        }
+    if (tail_) {
+        tail_->mpsc_next = batch;
     } else {
-        // No wait - just check
-        if (items_.empty()) {
-            return false;
-        }
+        head_ = batch;
     }
-    
-    if (shutdown_.load() && items_.empty()) {
-        return false;
+    tail_ = batch;
+    while (Node* next = MpscQueue<Node>::next(tail_)) {
+        tail_ = next;
     }
-    
-    if (items_.empty()) {
-        return false;
+}
+
+bool WorkQueue::try_dequeue(WorkQueueItem& item) {
+    std::lock_guard<std::mutex> lock(consumer_mutex_);
+    if (!head_) {
+        collect();
+        if (!head_) return false;
     }
     
-    item = items_.front();
-    items_.pop_front();
+    Node* node = head_;
+    head_ = MpscQueue<Node>::next(node);
+    if (!head_) tail_ = nullptr;
     
-    LOGI("Dequeued work item: routine=0x%08X, param=0x%08X, remaining=%zu",
-         (u32)item.worker_routine, (u32)item.parameter, items_.size());
+    item = node->item;
+    delete node;
+    size_.fetch_sub(1, std::memory_order_relaxed);
     
+    LOGD("Dequeued work item: routine=0x%08X, param=0x%08X",
+         (u32)item.worker_routine, (u32)item.parameter);
     return true;
 }
 
-void WorkQueue::shutdown() {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        shutdown_ = true;
+bool WorkQueue::dequeue(WorkQueueItem& item, u32 timeout_ms) {
+    // Consumers on host threads park here; fibers always poll (timeout 0)
+    static thread_local Parker parker;
+    
+    using Clock = std::chrono::steady_clock;
+    bool infinite = timeout_ms == WORK_QUEUE_INFINITE_TIMEOUT;
+    auto deadline = Clock::now() + std::chrono::milliseconds(infinite ? 0 : timeout_ms);
+    
+    while (true) {
+        if (try_dequeue(item)) {
+            return true;
+        }
+        if (shutdown_.load() || timeout_ms == 0) {
+            return false;
+        }
+        
+        u64 wait_ns = Parker::INFINITE;
+        if (!infinite) {
+            auto now = Clock::now();
+            if (now >= deadline) {
+                return false;  // Timeout
+            }
+            wait_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+        }
+        
+        // Only one consumer can be registered for wakeups; any other polls
+        Parker* expected = nullptr;
+        bool registered = waiter_.compare_exchange_strong(expected, &parker,
+                                                         std::memory_order_acq_rel);
+        if (!registered) {
+            wait_ns = std::min<u64>(wait_ns, 1000000);
+        }
+        
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (incoming_.empty() && !shutdown_.load()) {
+            parker.park(wait_ns);
+        }
+        
+        if (registered) {
+            expected = &parker;
+            waiter_.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+        }
     }
-    cv_.notify_all();
+}
+
+void WorkQueue::shutdown() {
+    shutdown_ = true;
+    wake_waiter();
 }
 
 bool WorkQueue::is_empty() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return items_.empty();
+    return size_.load(std::memory_order_relaxed) == 0;
 }
 
 size_t WorkQueue::size() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return items_.size();
+    return size_.load(std::memory_order_relaxed);
 }
 
 bool WorkQueue::cancel(GuestAddr item_address) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(consumer_mutex_);
+    collect();
 
-    for (auto it = items_.begin(); it != items_.end(); ++it) {
-        if (it->item_address == item_address) {
-            LOGI("Cancelled work item: routine=0x%08X, param=0x%08X",
-                 (u32)it->worker_routine, (u32)it->parameter);
-            items_.erase(it);
-            return true;
+    Node* prev = nullptr;
+    for (Node* node = head_; node; prev = node, node = MpscQueue<Node>::next(node)) {
+        if (node->item.item_address != item_address) {
+            continue;
         }
+        
+        LOGI("Cancelled work item: routine=0x%08X, param=0x%08X",
+             (u32)node->item.worker_routine, (u32)node->item.parameter);
+        Node* next = MpscQueue<Node>::next(node);
+        if (prev) {
+            prev->mpsc_next = next;
+        } else {
+            head_ = next;
+        }
+        if (tail_ == node) {
+            tail_ = prev;
+        }
+        delete node;
+        size_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
     }
     return false;
 }
 
 size_t WorkQueue::drain() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    size_t count = items_.size();
-    items_.clear();
+    std::lock_guard<std::mutex> lock(consumer_mutex_);
+    collect();
+    
+    size_t count = 0;
+    while (head_) {
+        Node* node = head_;
+        head_ = MpscQueue<Node>::next(node);
+        delete node;
+        count++;
+    }
+    tail_ = nullptr;
+    size_.fetch_sub(count, std::memory_order_relaxed);
     return count;
 }
 
 void WorkQueue::reset() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    drain();
     shutdown_ = false;
-    items_.clear();
 }
 
 //=============================================================================
@@ -136,7 +215,7 @@ void WorkQueueManager::enqueue(WorkQueueType type, const WorkQueueItem& item) {
     queues_[queue_idx].enqueue(item);
     total_queued_++;
     
-    LOGI("WorkQueueManager: enqueued to queue %zu, total_queued=%zu", 
+    LOGD("WorkQueueManager: enqueued to queue %zu, total_queued=%zu", 
          queue_idx, total_queued_.load());
 }
 
@@ -10,14 +10,15 @@
 #pragma once
 
 #include "x360mu/types.h"
-#include <deque>
+#include "../core/mpsc_queue.h"
 #include <mutex>
-#include <condition_variable>
 #include <atomic>
 #include <limits>
 
 namespace x360mu {
 
+class Parker;
+
 // Mirrors Xbox 360 WORK_QUEUE_ITEM structure layout
 // struct _WORK_QUEUE_ITEM {
 //     LIST_ENTRY List;              // Offset 0x00 (Flink, Blink)
@@ -42,11 +43,13 @@ enum class WorkQueueType : u32 {
     Maximum = 3
 };
 
-// Thread-safe work queue
+// Thread-safe work queue. enqueue() is lock-free (guest threads and
+// interrupt handlers call it); consumers share a small mutex among
+// themselves and an idle consumer is woken through its parking word.
 class WorkQueue {
 public:
     WorkQueue() = default;
-    ~WorkQueue() = default;
+    ~WorkQueue();
     
     // Enqueue a work item (non-blocking)
     void enqueue(const WorkQueueItem& item);
@@ -75,9 +78,23 @@ public:
     void reset();
 
 private:
-    mutable std::mutex mutex_;
-    std::condition_variable cv_;
-    std::deque<WorkQueueItem> items_;
+    struct Node : MpscNode {
+        WorkQueueItem item;
+    };
+    
+    bool try_dequeue(WorkQueueItem& item);
+    void collect();         // Move newly enqueued items to the consumer list
+    void wake_waiter();
+    
+    MpscQueue<Node> incoming_;
+    
+    // Consumer-side FIFO, only touched under consumer_mutex_
+    std::mutex consumer_mutex_;
+    Node* head_ = nullptr;
+    Node* tail_ = nullptr;
+    
+    std::atomic<size_t> size_{0};
+    std::atomic<Parker*> waiter_{nullptr};   // Consumer parked in dequeue()
     std::atomic<bool> shutdown_{false};
 };
 
@@ -6,9 +6,13 @@
 
 #include "xobject.h"
 #include "xthread.h"
+#include "timer_queue.h"
+#include "../core/timeline.h"
+#include "../core/guest_clock.h"
 #include "../memory/memory.h"
 #include "../cpu/xenon/cpu.h"
-#include <chrono>
+#include <algorithm>
+#include <thread>
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -52,9 +56,12 @@ void XObject::add_waiter(XThread* thread) {
     waiters_.push_back(thread);
 }
 
-void XObject::remove_waiter(XThread* thread) {
+bool XObject::remove_waiter(XThread* thread) {
     std::lock_guard<std::mutex> lock(waiters_mutex_);
-    waiters_.remove(thread);
+    auto it = std::find(waiters_.begin(), waiters_.end(), thread);
+    if (it == waiters_.end()) return false;
+    waiters_.erase(it);
+    return true;
 }
 
 void XObject::wake_waiters(u32 count) {
@@ -82,42 +89,32 @@ ObjectTable::ObjectTable() {
 }
 
 ObjectTable::~ObjectTable() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    objects_.clear();
-}
-
-u32 ObjectTable::allocate_handle() {
-    // NT-style handle allocation: 4-byte aligned incrementing
-    u32 handle = next_handle_;
-    next_handle_ += 4;
-    return handle;
+    clear();
 }
 
 u32 ObjectTable::add_object(std::shared_ptr<XObject> object) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    u32 handle = allocate_handle();
-    object->set_handle(handle);
+    XObject* raw = object.get();
+    u32 handle = handles_.insert(std::move(object));
+    if (handle == 0) {
+        LOGW("Handle table full (%u slots)", HandleTable<XObject>::MAX_SLOTS);
+        return 0;
+    }
     // The object starts with refcount 1 (from construction).
     // The handle table holds a shared_ptr which keeps it alive.
-    objects_[handle] = object;
+    raw->set_handle(handle);
 
     LOGD("Added object: handle=0x%08X, type=%u, name=%s",
-         handle, static_cast<u32>(object->type()), object->name().c_str());
+         handle, static_cast<u32>(raw->type()), raw->name().c_str());
 
     return handle;
 }
 
 bool ObjectTable::remove_handle(u32 handle) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    auto it = objects_.find(handle);
-    if (it == objects_.end()) {
+    auto obj = handles_.remove(handle);
+    if (!obj) {
         return false;
     }
 
-    auto obj = it->second;
-    objects_.erase(it);
     // Release the handle's reference on the Xbox-side refcount
     obj->release();
 
@@ -127,25 +124,16 @@ bool ObjectTable::remove_handle(u32 handle) {
 }
 
 std::shared_ptr<XObject> ObjectTable::lookup(u32 handle) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    auto it = objects_.find(handle);
-    if (it == objects_.end()) {
-        return nullptr;
-    }
-    return it->second;
+    return handles_.lookup(handle);
 }
 
 std::shared_ptr<XObject> ObjectTable::lookup_typed(u32 handle, XObjectType expected_type, u32* status_out) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    auto it = objects_.find(handle);
-    if (it == objects_.end()) {
+    auto obj = lookup(handle);
+    if (!obj) {
         if (status_out) *status_out = nt_obj::STATUS_INVALID_HANDLE;
         return nullptr;
     }
 
-    auto& obj = it->second;
     if (expected_type != XObjectType::None && obj->type() != expected_type) {
         if (status_out) *status_out = nt_obj::STATUS_OBJECT_TYPE_MISMATCH;
         LOGW("Type mismatch: handle=0x%08X, expected=%u, actual=%u",
@@ -159,24 +147,29 @@ std::shared_ptr<XObject> ObjectTable::lookup_typed(u32 handle, XObjectType expec
 
 u32 ObjectTable::reference_object_by_handle(u32 handle, XObjectType expected_type,
                                              std::shared_ptr<XObject>* out_object) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    auto it = objects_.find(handle);
-    if (it == objects_.end()) {
+    // Increment Xbox-side refcount while the handle is pinned, so a racing
+    // close can't drop the last reference first (caller must eventually
+    // call release/ObDereferenceObject)
+    u32 status = nt_obj::STATUS_SUCCESS;
+    std::shared_ptr<XObject> obj;
+    bool valid = handles_.with_pinned(handle, [&](const std::shared_ptr<XObject>& pinned) {
+        if (expected_type != XObjectType::None && pinned->type() != expected_type) {
+            LOGW("ObReferenceObjectByHandle: type mismatch handle=0x%08X (expected=%u, got=%u)",
+                 handle, static_cast<u32>(expected_type), static_cast<u32>(pinned->type()));
+            status = nt_obj::STATUS_OBJECT_TYPE_MISMATCH;
+            return;
+        }
+        pinned->retain();
+        obj = pinned;
+    });
+    if (!valid) {
         LOGW("ObReferenceObjectByHandle: invalid handle 0x%08X", handle);
         return nt_obj::STATUS_INVALID_HANDLE;
     }
-
-    auto& obj = it->second;
-    if (expected_type != XObjectType::None && obj->type() != expected_type) {
-        LOGW("ObReferenceObjectByHandle: type mismatch handle=0x%08X (expected=%u, got=%u)",
-             handle, static_cast<u32>(expected_type), static_cast<u32>(obj->type()));
-        return nt_obj::STATUS_OBJECT_TYPE_MISMATCH;
+    if (status != nt_obj::STATUS_SUCCESS) {
+        return status;
     }
 
-    // Increment Xbox-side refcount (caller must eventually call release/ObDereferenceObject)
-    obj->retain();
-
     if (out_object) {
         *out_object = obj;
     }
@@ -187,17 +180,12 @@ u32 ObjectTable::reference_object_by_handle(u32 handle, XObjectType expected_typ
 }
 
 u32 ObjectTable::close_handle(u32 handle) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    auto it = objects_.find(handle);
-    if (it == objects_.end()) {
+    auto obj = handles_.remove(handle);
+    if (!obj) {
         LOGW("NtClose: invalid handle 0x%08X", handle);
         return nt_obj::STATUS_INVALID_HANDLE;
     }
 
-    auto obj = it->second;
-    objects_.erase(it);
-
     // Release the handle's reference. The object may still be alive
     // if other references exist (e.g., wait list, ObReferenceObjectByHandle).
     obj->release();
@@ -208,23 +196,22 @@ u32 ObjectTable::close_handle(u32 handle) {
 }
 
 u32 ObjectTable::duplicate_handle(u32 source_handle, u32* target_handle_out) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    auto it = objects_.find(source_handle);
-    if (it == objects_.end()) {
+    auto obj = lookup(source_handle);
+    if (!obj) {
         LOGW("NtDuplicateObject: invalid source handle 0x%08X", source_handle);
         return nt_obj::STATUS_INVALID_HANDLE;
     }
 
-    auto obj = it->second;
-
-    // Allocate new handle pointing to same object
-    u32 new_handle = allocate_handle();
-    objects_[new_handle] = obj;
-
     // Increment Xbox-side refcount for the new handle
     obj->retain();
 
+    // Allocate new handle pointing to same object
+    u32 new_handle = handles_.insert(obj);
+    if (new_handle == 0) {
+        obj->release();
+        return nt_obj::STATUS_INVALID_PARAMETER;
+    }
+
     if (target_handle_out) {
         *target_handle_out = new_handle;
     }
@@ -237,29 +224,24 @@ u32 ObjectTable::duplicate_handle(u32 source_handle, u32* target_handle_out) {
 std::shared_ptr<XObject> ObjectTable::lookup_by_name(const std::string& name) {
     if (name.empty()) return nullptr;
 
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    for (const auto& pair : objects_) {
-        if (pair.second->name() == name) {
-            return pair.second;
+    // Rare (named object creation); walks every slot handed out so far
+    std::shared_ptr<XObject> found;
+    handles_.for_each([&](u32, const std::shared_ptr<XObject>& obj) {
+        if (!found && obj->name() == name) {
+            found = obj;
         }
-    }
-    return nullptr;
+    });
+    return found;
 }
 
 size_t ObjectTable::object_count() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return objects_.size();
+    return handles_.size();
 }
 
 void ObjectTable::clear() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    // Release all handle references before clearing
-    for (auto& pair : objects_) {
-        pair.second->release();
-    }
-    objects_.clear();
-    next_handle_ = 4;
+    // Shutdown only: no other thread may use the table meanwhile.
+    // Release all handle references before clearing.
+    handles_.clear([](XObject& obj) { obj.release(); });
 }
 
 //=============================================================================
@@ -276,26 +258,27 @@ KernelState& KernelState::instance() {
 void KernelState::initialize(Memory* memory, Cpu* cpu) {
     memory_ = memory;
     cpu_ = cpu;
-    boot_time_ = std::chrono::steady_clock::now();
+    boot_100ns_ = GuestClock::instance().now_100ns();
     
     LOGI("KernelState initialized (cpu=%s)", cpu ? "available" : "null");
 }
 
 void KernelState::shutdown() {
+    // Disarm timers before anything they touch goes away
+    {
+        std::lock_guard<std::mutex> lock(timer_mutex_);
+        for (auto& [addr, entry] : timers_) {
+            TimerQueue::instance().cancel(entry.timer_id);
+        }
+        timers_.clear();
+    }
+    TimerQueue::instance().synchronize();
+    
     // Clear all objects
     object_table_.clear();
     
     // Clear DPC queue
-    {
-        std::lock_guard<std::mutex> lock(dpc_mutex_);
-        dpc_queue_.clear();
-    }
-    
-    // Clear timer queue
-    {
-        std::lock_guard<std::mutex> lock(timer_mutex_);
-        timer_queue_.clear();
-    }
+    dpc_queue_.clear();
     
     gpu_interrupt_event_addr_ = 0;
     memory_ = nullptr;
@@ -305,28 +288,17 @@ void KernelState::shutdown() {
 
 u64 KernelState::system_time() const {
     // Windows FILETIME: 100-nanosecond intervals since January 1, 1601
-    // We need to add the offset from 1601 to Unix epoch (1970)
-    constexpr u64 EPOCH_DIFF = 116444736000000000ULL;
-    
-    auto now = std::chrono::system_clock::now();
-    auto duration = now.time_since_epoch();
-    auto ticks = std::chrono::duration_cast<std::chrono::duration<u64, std::ratio<1, 10000000>>>(duration);
-    
-    return ticks.count() + EPOCH_DIFF;
+    return GuestClock::instance().system_time();
 }
 
 u64 KernelState::interrupt_time() const {
     // 100-nanosecond intervals since boot
-    auto now = std::chrono::steady_clock::now();
-    auto duration = now - boot_time_;
-    return std::chrono::duration_cast<std::chrono::duration<u64, std::ratio<1, 10000000>>>(duration).count();
+    return GuestClock::instance().now_100ns() - boot_100ns_;
 }
 
 u32 KernelState::tick_count() const {
     // Milliseconds since boot
-    auto now = std::chrono::steady_clock::now();
-    auto duration = now - boot_time_;
-    return static_cast<u32>(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    return static_cast<u32>(interrupt_time() / 10000);
 }
 
 void KernelState::set_current_thread(XThread* thread) {
@@ -339,25 +311,29 @@ XThread* KernelState::current_thread() const {
 
 void KernelState::queue_dpc(GuestAddr dpc_addr, GuestAddr dpc_routine, GuestAddr context,
                             GuestAddr arg1, GuestAddr arg2) {
-    std::lock_guard<std::mutex> lock(dpc_mutex_);
-    dpc_queue_.push_back({dpc_addr, dpc_routine, context, arg1, arg2});
-    LOGI("Queued DPC: dpc=0x%08X, routine=0x%08X, context=0x%08X, arg1=0x%08X, arg2=0x%08X",
+    auto* dpc = new DpcEntry();
+    dpc->dpc_addr = dpc_addr;
+    dpc->routine = dpc_routine;
+    dpc->context = context;
+    dpc->arg1 = arg1;
+    dpc->arg2 = arg2;
+    if (dpc_queue_.push(dpc)) {
+        // First DPC since the last drain: the emulation thread may be asleep
+        Timeline::instance().wake();
+    }
+    LOGD("Queued DPC: dpc=0x%08X, routine=0x%08X, context=0x%08X, arg1=0x%08X, arg2=0x%08X",
          dpc_addr, dpc_routine, context, arg1, arg2);
 }
 
 void KernelState::process_dpcs() {
-    std::vector<DpcEntry> to_process;
-    
-    {
-        std::lock_guard<std::mutex> lock(dpc_mutex_);
-        to_process.swap(dpc_queue_);
-    }
-    
-    if (to_process.empty()) return;
+    DpcEntry* batch = dpc_queue_.pop_all();
+    if (!batch) return;
     
-    LOGI("Processing %zu DPCs", to_process.size());
-    
-    for (const auto& dpc : to_process) {
+    while (batch) {
+        std::unique_ptr<DpcEntry> node(batch);
+        batch = MpscQueue<DpcEntry>::next(batch);
+        const DpcEntry& dpc = *node;
+        
         if (dpc.routine == 0) {
             LOGW("Skipping DPC with null routine");
             continue;
@@ -426,101 +402,113 @@ void KernelState::process_dpcs() {
 }
 
 void KernelState::queue_timer(GuestAddr timer_addr, u64 due_time_100ns, u64 period_100ns, GuestAddr dpc_addr) {
+    // Due times are system time (FILETIME); the timer queue runs on a
+    // monotonic clock so wall clock adjustments can't stall timers
+    u64 now_system = system_time();
+    u64 delay_100ns = due_time_100ns > now_system ? due_time_100ns - now_system : 0;
+    u64 due = TimerQueue::now_100ns() + delay_100ns;
+    
     std::lock_guard<std::mutex> lock(timer_mutex_);
     
     // Check if timer already exists - update it instead of adding new
-    for (auto& entry : timer_queue_) {
-        if (entry.timer_addr == timer_addr) {
-            entry.due_time_100ns = due_time_100ns;
-            entry.period_100ns = period_100ns;
-            entry.dpc_addr = dpc_addr;
-            LOGI("Updated timer 0x%08X: due=%llu, period=%llu, dpc=0x%08X",
-                 timer_addr, (unsigned long long)due_time_100ns, 
-                 (unsigned long long)period_100ns, dpc_addr);
-            return;
-        }
+    auto it = timers_.find(timer_addr);
+    if (it != timers_.end()) {
+        TimerQueue::instance().cancel(it->second.timer_id);
+        it->second = {due, period_100ns, dpc_addr, 0, 0};
+        arm_timer(timer_addr, it->second);
+        LOGI("Updated timer 0x%08X: due=%llu, period=%llu, dpc=0x%08X",
+             timer_addr, (unsigned long long)due_time_100ns, 
+             (unsigned long long)period_100ns, dpc_addr);
+        return;
     }
     
     // Add new timer
-    timer_queue_.push_back({timer_addr, due_time_100ns, period_100ns, dpc_addr});
+    auto& entry = timers_[timer_addr];
+    entry = {due, period_100ns, dpc_addr, 0, 0};
+    arm_timer(timer_addr, entry);
     LOGI("Queued timer 0x%08X: due=%llu, period=%llu, dpc=0x%08X",
          timer_addr, (unsigned long long)due_time_100ns, 
          (unsigned long long)period_100ns, dpc_addr);
 }
 
+void KernelState::arm_timer(GuestAddr timer_addr, TimerEntry& entry) {
+    // Caller holds timer_mutex_
+    u64 generation = ++timer_generation_;
+    entry.generation = generation;
+    entry.timer_id = TimerQueue::instance().schedule(entry.due_time_100ns,
+        [this, timer_addr, generation]() { fire_timer(timer_addr, generation); });
+}
+
 bool KernelState::cancel_timer(GuestAddr timer_addr) {
     std::lock_guard<std::mutex> lock(timer_mutex_);
     
-    for (auto it = timer_queue_.begin(); it != timer_queue_.end(); ++it) {
-        if (it->timer_addr == timer_addr) {
-            timer_queue_.erase(it);
-            LOGI("Cancelled timer 0x%08X", timer_addr);
-            return true;  // Was set
-        }
+    auto it = timers_.find(timer_addr);
+    if (it == timers_.end()) {
+        return false;  // Was not set
     }
-    return false;  // Was not set
+    TimerQueue::instance().cancel(it->second.timer_id);
+    timers_.erase(it);
+    LOGI("Cancelled timer 0x%08X", timer_addr);
+    return true;  // Was set
 }
 
 void KernelState::process_timer_queue() {
-    u64 current_time = system_time();
-    
-    std::vector<TimerEntry> expired;
-    
+    // Timers fire on their own; this just catches up on anything already due
+    TimerQueue::instance().run_expired();
+}
+
+void KernelState::fire_timer(GuestAddr timer_addr, u64 generation) {
+    GuestAddr dpc_addr = 0;
     {
         std::lock_guard<std::mutex> lock(timer_mutex_);
         
-        for (auto it = timer_queue_.begin(); it != timer_queue_.end(); ) {
-            if (current_time >= it->due_time_100ns) {
-                expired.push_back(*it);
-                
-                // Handle periodic timers
-                if (it->period_100ns > 0) {
-                    // Reschedule periodic timer
-                    it->due_time_100ns = current_time + it->period_100ns;
-                    ++it;
-                } else {
-                    // One-shot timer - remove it
-                    it = timer_queue_.erase(it);
-                }
-            } else {
-                ++it;
-            }
+        auto it = timers_.find(timer_addr);
+        if (it == timers_.end() || it->second.generation != generation) {
+            return;  // Cancelled or re-armed since this expiry was queued
         }
-    }
-    
-    // Process expired timers outside the lock
-    for (const auto& timer : expired) {
-        LOGI("Timer 0x%08X fired", timer.timer_addr);
+        dpc_addr = it->second.dpc_addr;
         
-        // Signal the timer object (set SignalState to 1)
-        if (memory_) {
-            memory_->write_u32(timer.timer_addr + 4, 1);  // SignalState = 1
+        // Handle periodic timers
+        if (it->second.period_100ns > 0) {
+            // Reschedule periodic timer
+            it->second.due_time_100ns = TimerQueue::now_100ns() + it->second.period_100ns;
+            arm_timer(timer_addr, it->second);
+        } else {
+            // One-shot timer - remove it
+            timers_.erase(it);
         }
+    }
+    
+    LOGI("Timer 0x%08X fired", timer_addr);
+    
+    // Signal the timer object (set SignalState to 1)
+    if (memory_) {
+        memory_->write_u32(timer_addr + 4, 1);  // SignalState = 1
+    }
+    
+    // Queue associated DPC if present
+    if (dpc_addr != 0 && memory_) {
+        // Read DPC routine and context from the KDPC structure
+        // KDPC layout:
+        //   0x0C: DeferredRoutine
+        //   0x10: DeferredContext
+        GuestAddr routine = memory_->read_u32(dpc_addr + 0x0C);
+        GuestAddr context = memory_->read_u32(dpc_addr + 0x10);
         
-        // Queue associated DPC if present
-        if (timer.dpc_addr != 0 && memory_) {
-            // Read DPC routine and context from the KDPC structure
-            // KDPC layout:
-            //   0x0C: DeferredRoutine
-            //   0x10: DeferredContext
-            GuestAddr routine = memory_->read_u32(timer.dpc_addr + 0x0C);
-            GuestAddr context = memory_->read_u32(timer.dpc_addr + 0x10);
-            
-            if (routine != 0) {
-                // For timer DPCs, SystemArgument1 is often the timer address
-                queue_dpc(timer.dpc_addr, routine, context, timer.timer_addr, 0);
-            }
+        if (routine != 0) {
+            // For timer DPCs, SystemArgument1 is often the timer address
+            queue_dpc(dpc_addr, routine, context, timer_addr, 0);
         }
     }
 }
 
 void KernelState::queue_gpu_interrupt() {
-    LOGI("GPU interrupt received");
+    LOGD("GPU interrupt received");
     
     // Signal GPU interrupt event if one is registered
     if (gpu_interrupt_event_addr_ != 0 && memory_) {
         memory_->write_u32(gpu_interrupt_event_addr_ + 4, 1);  // SignalState = 1
-        LOGI("Signaled GPU interrupt event at 0x%08X", gpu_interrupt_event_addr_);
+        LOGD("Signaled GPU interrupt event at 0x%08X", gpu_interrupt_event_addr_);
     }
     
     // Also queue a system DPC to notify any waiters
@@ -8,10 +8,13 @@
 #pragma once
 
 #include "x360mu/types.h"
+#include "../core/mpsc_queue.h"
+#include "handle_table.h"
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <mutex>
+#include <array>
 #include <atomic>
 #include <vector>
 #include <list>
@@ -112,7 +115,7 @@ public:
     
     // Wait list management
     void add_waiter(XThread* thread);
-    void remove_waiter(XThread* thread);
+    bool remove_waiter(XThread* thread);  // false if wake_waiters() took it
     void wake_waiters(u32 count = UINT32_MAX);
     
 protected:
@@ -153,6 +156,10 @@ constexpr u32 HANDLE_CURRENT_THREAD  = 0xFFFFFFFE;  // NtCurrentThread()  = -2
  * - ObReferenceObjectByHandle: looks up + increments refcount (caller must deref)
  * - ObDereferenceObject: decrements refcount
  * - Objects survive handle close if additional references exist
+ *
+ * Serves XObject handles (XThread, XEvent, ...). The NT sync objects behind
+ * Nt*Event, Nt*Semaphore and NtWaitFor*Object live in KernelThreadManager's
+ * own HandleTable and are not looked up here.
  */
 class ObjectTable {
 public:
@@ -212,11 +219,9 @@ public:
     void clear();
 
 private:
-    mutable std::mutex mutex_;
-    std::unordered_map<u32, std::shared_ptr<XObject>> objects_;
-    u32 next_handle_ = 4;  // NT-style: handles start at 4, increment by 4
-
-    u32 allocate_handle();
+    // Untagged: handles are 4, 8, 12, ... with bit 31 clear, apart from the
+    // KernelThreadManager's table (see threading.h)
+    HandleTable<XObject> handles_;
 };
 
 /**
@@ -247,7 +252,8 @@ public:
                    GuestAddr arg1 = 0, GuestAddr arg2 = 0);
     void process_dpcs();
     
-    // Timer support
+    // Timer support. Timers fire from the TimerQueue thread, which only
+    // signals them and queues their DPCs; process_dpcs() still runs the DPCs.
     void queue_timer(GuestAddr timer_addr, u64 due_time_100ns, u64 period_100ns, GuestAddr dpc_addr);
     bool cancel_timer(GuestAddr timer_addr);
     void process_timer_queue();
@@ -266,32 +272,37 @@ private:
     Cpu* cpu_ = nullptr;
     ObjectTable object_table_;
     
-    // Time tracking
-    std::chrono::steady_clock::time_point boot_time_;
+    // Time tracking (GuestClock, 100ns units)
+    u64 boot_100ns_ = 0;
     
     // Per-thread current thread (using thread_local)
     static thread_local XThread* current_thread_;
     
-    // DPC queue - stores all info needed to execute the DPC
-    struct DpcEntry {
+    // DPC queue - stores all info needed to execute the DPC. Queued
+    // lock-free, since GPU interrupts and guest threads both insert.
+    struct DpcEntry : MpscNode {
         GuestAddr dpc_addr;    // Pointer to KDPC structure (passed as r3)
         GuestAddr routine;     // DeferredRoutine to call
         GuestAddr context;     // DeferredContext (r4)
         GuestAddr arg1;        // SystemArgument1 (r5)
         GuestAddr arg2;        // SystemArgument2 (r6)
     };
-    std::mutex dpc_mutex_;
-    std::vector<DpcEntry> dpc_queue_;
+    MpscQueue<DpcEntry> dpc_queue_;
     
-    // Timer queue - stores pending timers
+    // Armed timers, keyed by guest KTIMER address
     struct TimerEntry {
-        GuestAddr timer_addr;     // Guest KTIMER structure address
-        u64 due_time_100ns;       // When to fire (absolute system time)
+        u64 due_time_100ns;       // When to fire (TimerQueue clock)
         u64 period_100ns;         // Repeat interval (0 = one-shot)
         GuestAddr dpc_addr;       // Associated DPC (optional, 0 if none)
+        u64 timer_id;             // Pending TimerQueue entry
+        u64 generation;           // Identifies this arming to its expiry
     };
     std::mutex timer_mutex_;
-    std::vector<TimerEntry> timer_queue_;
+    std::unordered_map<GuestAddr, TimerEntry> timers_;
+    u64 timer_generation_ = 0;
+    
+    void arm_timer(GuestAddr timer_addr, TimerEntry& entry);
+    void fire_timer(GuestAddr timer_addr, u64 generation);
     
     // GPU interrupt support
     GuestAddr gpu_interrupt_event_addr_ = 0;
@@ -48,7 +48,7 @@ XThread::~XThread() {
     
     // Stop host thread if running
     should_stop_ = true;
-    wait_cv_.notify_all();
+    parker_.unpark();
     
     if (host_thread_.joinable()) {
         host_thread_.join();
@@ -236,10 +236,33 @@ bool XThread::is_signaled() const {
 
 u32 XThread::wait(XObject* object, u64 timeout_100ns) {
     if (!object) return WAIT_FAILED;
+    return wait_multiple(&object, 1, false, timeout_100ns);
+}
+
+u32 XThread::wait_multiple(XObject** objects, u32 count, bool wait_all, u64 timeout_100ns) {
+    // handed[i]: object i woke us directly (an auto-reset event passes its
+    // signal to the woken waiter and is already unsignaled again)
+    std::vector<bool> handed(count, false);
+    auto satisfied = [&](u32* index) {
+        bool all = true;
+        for (u32 i = 0; i < count; i++) {
+            if (!objects[i]) continue;
+            if (handed[i] || objects[i]->is_signaled()) {
+                if (!wait_all) {
+                    *index = i;
+                    return true;
+                }
+            } else {
+                all = false;
+            }
+        }
+        *index = 0;
+        return wait_all && all;
+    };
     
-    // Check if already signaled
-    if (object->is_signaled()) {
-        return WAIT_OBJECT_0;
+    u32 index = 0;
+    if (satisfied(&index)) {
+        return WAIT_OBJECT_0 + index;
     }
     
     // Zero timeout = poll
@@ -247,65 +270,68 @@ u32 XThread::wait(XObject* object, u64 timeout_100ns) {
         return WAIT_TIMEOUT;
     }
     
-    // Set up wait
-    state_ = XThreadState::Waiting;
-    wait_satisfied_ = false;
-    wait_result_ = WAIT_TIMEOUT;
+    using Clock = std::chrono::steady_clock;
+    bool infinite = timeout_100ns == UINT64_MAX;
+    Clock::time_point deadline{};
+    if (!infinite) {
+        deadline = Clock::now() + std::chrono::nanoseconds(timeout_100ns * 100);
+    }
     
-    // Add to object's wait list
-    object->add_waiter(this);
+    state_ = XThreadState::Waiting;
+    u32 result = WAIT_TIMEOUT;
     
-    // Wait
-    {
-        std::unique_lock<std::mutex> lock(wait_mutex_);
+    while (!should_stop_) {
+        wait_satisfied_ = false;
+        wait_result_ = WAIT_TIMEOUT;
         
-        if (timeout_100ns == UINT64_MAX) {
-            // Infinite wait
-            wait_cv_.wait(lock, [this]() {
-                return wait_satisfied_.load() || should_stop_.load();
-            });
-        } else {
-            // Timed wait
-            auto timeout = std::chrono::nanoseconds(timeout_100ns * 100);
-            wait_cv_.wait_for(lock, timeout, [this]() {
-                return wait_satisfied_.load() || should_stop_.load();
-            });
+        // Register on every object; each list is locked on its own, so
+        // WaitAll never holds two object locks at once
+        for (u32 i = 0; i < count; i++) {
+            if (objects[i]) objects[i]->add_waiter(this);
         }
-    }
-    
-    // Clean up
-    object->remove_waiter(this);
-    state_ = XThreadState::Ready;
-    
-    return wait_result_.load();
-}
-
-u32 XThread::wait_multiple(XObject** objects, u32 count, bool wait_all, u64 timeout_100ns) {
-    // Simplified implementation - just check each object
-    for (u32 i = 0; i < count; i++) {
-        if (!objects[i]) continue;
         
-        if (objects[i]->is_signaled()) {
-            if (!wait_all) {
-                return WAIT_OBJECT_0 + i;
+        // A signal that landed before registering had nobody to wake
+        bool done = satisfied(&index);
+        
+        while (!done && !wait_satisfied_ && !should_stop_) {
+            u64 park_ns = Parker::INFINITE;
+            if (!infinite) {
+                auto now = Clock::now();
+                if (now >= deadline) break;
+                park_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
             }
-        } else if (wait_all) {
-            // Wait for this one
-            return wait(objects[i], timeout_100ns);
+            parker_.park(park_ns);
+        }
+        
+        for (u32 i = 0; i < count; i++) {
+            if (objects[i] && !objects[i]->remove_waiter(this)) {
+                handed[i] = true;
+            }
+        }
+        
+        // Woken for another reason (APC delivery)
+        if (wait_satisfied_ && wait_result_ != WAIT_OBJECT_0) {
+            result = wait_result_;
+            break;
+        }
+        if (done || satisfied(&index)) {
+            result = WAIT_OBJECT_0 + index;
+            break;
+        }
+        if (!infinite && Clock::now() >= deadline) {
+            result = WAIT_TIMEOUT;
+            break;
         }
     }
     
-    if (wait_all) {
-        return WAIT_OBJECT_0;
-    }
-    
-    return WAIT_TIMEOUT;
+    state_ = XThreadState::Ready;
+    return result;
 }
 
 void XThread::wake_from_wait(u32 result) {
     wait_result_ = result;
     wait_satisfied_ = true;
-    wait_cv_.notify_all();
+    parker_.unpark();
 }
 
 void XThread::delay(u64 interval_100ns, bool alertable) {
@@ -528,6 +554,11 @@ std::shared_ptr<XThread> XScheduler::get_thread(u32 thread_id) {
     return nullptr;
 }
 
+bool XScheduler::has_threads() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !threads_.empty();
+}
+
 void XScheduler::run_for(u64 cycles) {
     // Execute all ready threads, sorted by priority (highest first)
     std::vector<std::shared_ptr<XThread>> ready;
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "xobject.h"
+#include "../core/parker.h"
 #include <mutex>
 #include <condition_variable>
 #include <thread>
@@ -172,9 +173,8 @@ private:
     // Exit
     std::atomic<u32> exit_code_{0};
     
-    // Wait support
-    std::mutex wait_mutex_;
-    std::condition_variable wait_cv_;
+    // Wait support: wake_from_wait() publishes the result, then unparks
+    Parker parker_;
     std::atomic<bool> wait_satisfied_{false};
     std::atomic<u32> wait_result_{0};
     
@@ -218,6 +218,7 @@ public:
     void add_thread(std::shared_ptr<XThread> thread);
     void remove_thread(XThread* thread);
     std::shared_ptr<XThread> get_thread(u32 thread_id);
+    bool has_threads();
     
     // Scheduling
     void schedule();
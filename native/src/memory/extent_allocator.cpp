@@ -0,0 +1,178 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Extent-based guest address space allocator
+ */
+
+#include "extent_allocator.h"
+#include <algorithm>
+
+namespace x360mu {
+
+ExtentAllocator::ExtentAllocator(GuestAddr base, u64 size, u32 granularity)
+    : base_(base), size_(size), granularity_(granularity) {
+    reset();
+}
+
+void ExtentAllocator::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    free_by_addr_.clear();
+    free_by_size_.clear();
+    allocations_.clear();
+    used_ = 0;
+    peak_used_ = 0;
+    insert_free(base_, size_);
+}
+
+void ExtentAllocator::erase_free(std::map<GuestAddr, u64>::iterator it) {
+    free_by_size_.erase({it->second, it->first});
+    free_by_addr_.erase(it);
+}
+
+void ExtentAllocator::insert_free(GuestAddr base, u64 size) {
+    if (size == 0) return;
+
+    // Coalesce with the following extent
+    auto next = free_by_addr_.lower_bound(base);
+    if (next != free_by_addr_.end() && static_cast<u64>(base) + size == next->first) {
+        size += next->second;
+        auto merged = next++;
+        erase_free(merged);
+    }
+
+    // Coalesce with the preceding extent
+    if (next != free_by_addr_.begin()) {
+        auto prev = std::prev(next);
+        if (static_cast<u64>(prev->first) + prev->second == base) {
+            base = prev->first;
+            size += prev->second;
+            erase_free(prev);
+        }
+    }
+
+    free_by_addr_[base] = size;
+    free_by_size_.insert({size, base});
+}
+
+void ExtentAllocator::carve(std::map<GuestAddr, u64>::iterator it, GuestAddr base, u64 size) {
+    GuestAddr extent_base = it->first;
+    u64 extent_end = static_cast<u64>(it->first) + it->second;
+    erase_free(it);
+
+    if (base > extent_base) {
+        free_by_addr_[extent_base] = base - extent_base;
+        free_by_size_.insert({base - extent_base, extent_base});
+    }
+    u64 end = static_cast<u64>(base) + size;
+    if (end < extent_end) {
+        GuestAddr tail = static_cast<GuestAddr>(end);
+        free_by_addr_[tail] = extent_end - end;
+        free_by_size_.insert({extent_end - end, tail});
+    }
+
+    allocations_[base] = size;
+    used_ += size;
+    peak_used_ = std::max(peak_used_, used_);
+}
+
+GuestAddr ExtentAllocator::allocate(u64 size, u32 alignment, bool top_down,
+                                    GuestAddr min_addr, GuestAddr max_addr) {
+    if (size == 0) size = granularity_;
+    size = align_up<u64>(size, granularity_);
+    alignment = std::max(alignment, granularity_);
+
+    u64 lower = std::max<u64>(min_addr, base_);
+    u64 upper = static_cast<u64>(base_) + size_;
+    if (max_addr != 0) upper = std::min<u64>(upper, static_cast<u64>(max_addr) + 1);
+
+    // Placement of the block inside a free extent, or false if it does not fit
+    auto place = [&](GuestAddr extent_base, u64 extent_size, u64& start) {
+        u64 lo = std::max<u64>(extent_base, lower);
+        u64 hi = std::min<u64>(static_cast<u64>(extent_base) + extent_size, upper);
+        if (hi <= lo || hi - lo < size) return false;
+        if (top_down) {
+            start = align_down<u64>(hi - size, alignment);
+            return start >= lo;
+        }
+        start = align_up<u64>(lo, alignment);
+        return start + size <= hi;
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    u64 start = 0;
+    if (top_down) {
+        for (auto it = free_by_addr_.rbegin(); it != free_by_addr_.rend(); ++it) {
+            if (place(it->first, it->second, start)) {
+                carve(std::prev(it.base()), static_cast<GuestAddr>(start), size);
+                return static_cast<GuestAddr>(start);
+            }
+        }
+        return 0;
+    }
+
+    // Best fit: smallest extent that can hold the aligned block
+    for (auto it = free_by_size_.lower_bound({size, 0}); it != free_by_size_.end(); ++it) {
+        if (place(it->second, it->first, start)) {
+            carve(free_by_addr_.find(it->second), static_cast<GuestAddr>(start), size);
+            return static_cast<GuestAddr>(start);
+        }
+    }
+    return 0;
+}
+
+bool ExtentAllocator::allocate_fixed(GuestAddr base, u64 size) {
+    u64 start = align_down<u64>(base, granularity_);
+    u64 end = align_up<u64>(static_cast<u64>(base) + std::max<u64>(size, 1), granularity_);
+    if (start < base_ || end > static_cast<u64>(base_) + size_) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = free_by_addr_.upper_bound(static_cast<GuestAddr>(start));
+    if (it == free_by_addr_.begin()) return false;
+    --it;
+    if (static_cast<u64>(it->first) + it->second < end) return false;
+
+    carve(it, static_cast<GuestAddr>(start), end - start);
+    return true;
+}
+
+u64 ExtentAllocator::free(GuestAddr base) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = allocations_.find(base);
+    if (it == allocations_.end()) return 0;
+
+    u64 size = it->second;
+    allocations_.erase(it);
+    used_ -= size;
+    insert_free(base, size);
+    return size;
+}
+
+u64 ExtentAllocator::allocation_size(GuestAddr base) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = allocations_.find(base);
+    return it == allocations_.end() ? 0 : it->second;
+}
+
+ExtentAllocator::Stats ExtentAllocator::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Stats stats{};
+    stats.total = size_;
+    stats.used = used_;
+    stats.peak_used = peak_used_;
+    stats.free = size_ - used_;
+    stats.largest_free = free_by_size_.empty() ? 0 : free_by_size_.rbegin()->first;
+    stats.allocations = static_cast<u32>(allocations_.size());
+    stats.free_extents = static_cast<u32>(free_by_addr_.size());
+    stats.fragmentation = stats.free
+        ? 1.0 - static_cast<double>(stats.largest_free) / static_cast<double>(stats.free)
+        : 0.0;
+    return stats;
+}
+
+} // namespace x360mu
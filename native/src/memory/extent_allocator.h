@@ -0,0 +1,106 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Extent-based guest address space allocator
+ *
+ * Hands out page-granular ranges of a fixed guest address window and takes
+ * them back. Free space is kept as coalesced extents indexed both by
+ * address and by size, so allocation is best-fit and freed memory is
+ * reused instead of being lost behind a bump pointer. Backs the kernel's
+ * virtual and physical allocation services.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include <map>
+#include <mutex>
+#include <set>
+#include <utility>
+
+namespace x360mu {
+
+class ExtentAllocator {
+public:
+    /**
+     * @param base First address managed
+     * @param size Size of the managed window in bytes
+     * @param granularity Minimum allocation unit (power of two)
+     */
+    ExtentAllocator(GuestAddr base, u64 size, u32 granularity = 4096);
+
+    /**
+     * Allocate a range
+     * @param size Bytes (rounded up to the granularity)
+     * @param alignment Power of two, at least the granularity
+     * @param top_down Take the highest fitting address instead of best fit
+     * @param min_addr/max_addr Optional bounds; max_addr is inclusive, 0 = none
+     * @return Base address, or 0 if nothing fits
+     */
+    GuestAddr allocate(u64 size, u32 alignment, bool top_down = false,
+                       GuestAddr min_addr = 0, GuestAddr max_addr = 0);
+
+    /**
+     * Claim a specific range
+     * @return false if it leaves the window or overlaps an allocation
+     */
+    bool allocate_fixed(GuestAddr base, u64 size);
+
+    /**
+     * Release the allocation starting at base
+     * @return Its size, or 0 if base is not an allocation
+     */
+    u64 free(GuestAddr base);
+
+    /**
+     * Size of the allocation starting at base (0 if none)
+     */
+    u64 allocation_size(GuestAddr base) const;
+
+    /**
+     * True if addr lies inside the managed window
+     */
+    bool contains(GuestAddr addr) const {
+        return addr >= base_ && static_cast<u64>(addr) < static_cast<u64>(base_) + size_;
+    }
+
+    GuestAddr base() const { return base_; }
+    u64 size() const { return size_; }
+
+    struct Stats {
+        u64 total;
+        u64 used;
+        u64 peak_used;
+        u64 free;
+        u64 largest_free;
+        u32 allocations;
+        u32 free_extents;
+        // 0 = all free space in one extent, approaching 1 = scattered
+        double fragmentation;
+    };
+    Stats stats() const;
+
+    /**
+     * Drop all allocations
+     */
+    void reset();
+
+private:
+    GuestAddr base_;
+    u64 size_;
+    u32 granularity_;
+
+    u64 used_ = 0;
+    u64 peak_used_ = 0;
+
+    std::map<GuestAddr, u64> free_by_addr_;             // base -> size
+    std::set<std::pair<u64, GuestAddr>> free_by_size_;  // (size, base)
+    std::map<GuestAddr, u64> allocations_;              // base -> size
+    mutable std::mutex mutex_;
+
+    void insert_free(GuestAddr base, u64 size);
+    void erase_free(std::map<GuestAddr, u64>::iterator it);
+    void carve(std::map<GuestAddr, u64>::iterator it, GuestAddr base, u64 size);
+};
+
+} // namespace x360mu
@@ -0,0 +1,168 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Guest memory access heatmap
+ */
+
+#include "heatmap.h"
+#include <algorithm>
+#include <bitset>
+#include <cstdio>
+
+namespace x360mu {
+
+namespace {
+
+// Per-thread sampling state. The slot is handed out by the heatmap the
+// thread first samples into, so each heatmap numbers its threads from 0.
+// Heatmaps are told apart by instance id, not address, since a new one
+// may be allocated where an old one lived.
+struct SamplerState {
+    u64 owner = 0;
+    u32 slot = 0;
+    u32 countdown = 0;
+};
+thread_local SamplerState tls_sampler;
+
+std::atomic<u64> g_next_instance{1};
+
+} // namespace
+
+MemoryHeatmap::MemoryHeatmap()
+    : instance_(g_next_instance.fetch_add(1, std::memory_order_relaxed)) {}
+
+void MemoryHeatmap::set_enabled(bool enabled) {
+    if (enabled) {
+        std::call_once(alloc_once_, [this] {
+            reads_ = std::make_unique<std::atomic<u32>[]>(RAM_PAGES);
+            writes_ = std::make_unique<std::atomic<u32>[]>(RAM_PAGES);
+            threads_ = std::make_unique<std::atomic<u32>[]>(RAM_PAGES);
+        });
+    }
+    enabled_.store(enabled, std::memory_order_release);
+}
+
+void MemoryHeatmap::set_sample_period(u32 period) {
+    period_.store(std::max<u32>(period, 1), std::memory_order_relaxed);
+}
+
+void MemoryHeatmap::record(GuestAddr addr, bool is_write, bool is_mmio) {
+    if (!enabled()) return;
+
+    SamplerState& state = tls_sampler;
+    if (state.owner != instance_) {
+        state.owner = instance_;
+        state.slot = next_thread_slot_.fetch_add(1, std::memory_order_relaxed);
+        state.countdown = 0;
+    }
+    if (state.countdown > 1) {
+        state.countdown--;
+        return;
+    }
+    state.countdown = period_.load(std::memory_order_relaxed);
+
+    u32 thread_bit = 1u << (state.slot & 31);
+
+    if (is_mmio) {
+        std::lock_guard<std::mutex> lock(mmio_mutex_);
+        MmioStats& stats = mmio_pages_[addr & ~static_cast<GuestAddr>(memory::PAGE_MASK)];
+        (is_write ? stats.writes : stats.reads)++;
+        stats.thread_mask |= thread_bit;
+        return;
+    }
+
+    u32 page = static_cast<u32>((addr & 0x1FFFFFFF) >> memory::PAGE_SHIFT);
+    (is_write ? writes_ : reads_)[page].fetch_add(1, std::memory_order_relaxed);
+    if ((threads_[page].load(std::memory_order_relaxed) & thread_bit) == 0) {
+        threads_[page].fetch_or(thread_bit, std::memory_order_relaxed);
+    }
+}
+
+std::vector<MemoryHeatmap::PageEntry> MemoryHeatmap::pages() const {
+    std::vector<PageEntry> entries;
+
+    if (reads_) {
+        for (u32 page = 0; page < RAM_PAGES; page++) {
+            u32 reads = reads_[page].load(std::memory_order_relaxed);
+            u32 writes = writes_[page].load(std::memory_order_relaxed);
+            if (reads == 0 && writes == 0) continue;
+
+            entries.push_back({static_cast<GuestAddr>(page) << memory::PAGE_SHIFT,
+                               reads, writes, threads_[page].load(std::memory_order_relaxed),
+                               false});
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mmio_mutex_);
+        for (const auto& [page, stats] : mmio_pages_) {
+            entries.push_back({page, stats.reads, stats.writes, stats.thread_mask, true});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const PageEntry& a, const PageEntry& b) {
+        return a.reads + a.writes > b.reads + b.writes;
+    });
+    return entries;
+}
+
+u32 MemoryHeatmap::thread_count(u32 thread_mask) {
+    return static_cast<u32>(std::bitset<32>(thread_mask).count());
+}
+
+std::string MemoryHeatmap::report(size_t max_rows) const {
+    std::string out;
+    char line[160];
+
+    auto entries = pages();
+    u64 total = 0;
+    size_t shared = 0, mmio = 0;
+    for (const auto& e : entries) {
+        total += e.reads + e.writes;
+        if (thread_count(e.thread_mask) > 1) shared++;
+        if (e.mmio) mmio++;
+    }
+
+    snprintf(line, sizeof(line),
+             "Memory heatmap (%llu samples, 1/%u, %zu pages, %zu MMIO, %zu shared)\n",
+             (unsigned long long)total, sample_period(), entries.size(), mmio, shared);
+    out += line;
+    for (size_t i = 0; i < entries.size() && i < max_rows; i++) {
+        const auto& e = entries[i];
+        snprintf(line, sizeof(line), "  %08X %-4s %12llu reads %12llu writes  %2u threads  %5.1f%%\n",
+                 e.page, e.mmio ? "MMIO" : "RAM", (unsigned long long)e.reads,
+                 (unsigned long long)e.writes, thread_count(e.thread_mask),
+                 total ? 100.0 * (e.reads + e.writes) / total : 0.0);
+        out += line;
+    }
+
+    return out;
+}
+
+std::string MemoryHeatmap::export_csv() const {
+    std::string out = "page,reads,writes,threads,mmio\n";
+    char line[96];
+
+    for (const auto& e : pages()) {
+        snprintf(line, sizeof(line), "0x%08X,%llu,%llu,%u,%d\n", e.page,
+                 (unsigned long long)e.reads, (unsigned long long)e.writes,
+                 thread_count(e.thread_mask), e.mmio ? 1 : 0);
+        out += line;
+    }
+    return out;
+}
+
+void MemoryHeatmap::reset() {
+    if (reads_) {
+        for (u32 page = 0; page < RAM_PAGES; page++) {
+            reads_[page].store(0, std::memory_order_relaxed);
+            writes_[page].store(0, std::memory_order_relaxed);
+            threads_[page].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mmio_mutex_);
+    mmio_pages_.clear();
+}
+
+} // namespace x360mu
@@ -0,0 +1,107 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Guest memory access heatmap
+ *
+ * Optional sampler fed by Memory's slow path and, while enabled, by
+ * instrumentation the JIT emits on fastmem accesses. Every Nth access per
+ * host thread is attributed to its 4KB page, giving per-page read/write
+ * counts, the set of threads touching each page, and which pages are MMIO.
+ * Used to find MMIO-hot registers, data shared between threads, and
+ * regions that would benefit from huge pages or caching.
+ */
+
+#pragma once
+
+#include "x360mu/types.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace x360mu {
+
+class MemoryHeatmap {
+public:
+    MemoryHeatmap();
+
+    /**
+     * Enable/disable recording. Counters are allocated on first enable.
+     */
+    void set_enabled(bool enabled);
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    /**
+     * Record one access in every `period` per thread (1 = every access)
+     */
+    void set_sample_period(u32 period);
+    u32 sample_period() const { return period_.load(std::memory_order_relaxed); }
+
+    /**
+     * Count an access. RAM addresses are attributed to their physical page;
+     * MMIO accesses are keyed by the address as issued.
+     */
+    void record(GuestAddr addr, bool is_write, bool is_mmio);
+
+    struct PageEntry {
+        GuestAddr page;         // Page base (physical for RAM)
+        u64 reads;              // Sampled reads
+        u64 writes;             // Sampled writes
+        u32 thread_mask;        // Bit per sampling thread (slot % 32)
+        bool mmio;
+    };
+
+    /**
+     * Snapshot of every touched page, hottest first
+     */
+    std::vector<PageEntry> pages() const;
+
+    /**
+     * Human-readable summary of the hottest pages
+     */
+    std::string report(size_t max_rows = 32) const;
+
+    /**
+     * One line per touched page: "page,reads,writes,threads,mmio"
+     */
+    std::string export_csv() const;
+
+    /**
+     * Number of distinct threads in a PageEntry::thread_mask
+     */
+    static u32 thread_count(u32 thread_mask);
+
+    /**
+     * Clear all counters
+     */
+    void reset();
+
+private:
+    static constexpr u32 RAM_PAGES =
+        static_cast<u32>(memory::MAIN_MEMORY_SIZE >> memory::PAGE_SHIFT);
+
+    const u64 instance_;
+    std::atomic<bool> enabled_{false};
+    std::atomic<u32> period_{16};
+
+    // Indexed by physical page; allocated on first enable
+    std::unique_ptr<std::atomic<u32>[]> reads_;
+    std::unique_ptr<std::atomic<u32>[]> writes_;
+    std::unique_ptr<std::atomic<u32>[]> threads_;
+    std::once_flag alloc_once_;
+
+    // MMIO pages are few and already slow; keep them in a map
+    struct MmioStats {
+        u64 reads = 0;
+        u64 writes = 0;
+        u32 thread_mask = 0;
+    };
+    mutable std::mutex mmio_mutex_;
+    std::unordered_map<GuestAddr, MmioStats> mmio_pages_;
+
+    std::atomic<u32> next_thread_slot_{0};
+};
+
+} // namespace x360mu
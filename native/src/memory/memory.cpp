@@ -5,10 +5,15 @@
  */
 
 #include "memory.h"
+#include "heatmap.h"
+#include "x360mu/byte_swap.h"
+#include <algorithm>
 #include <cstring>
 #include <sys/mman.h>
 #include <signal.h>
 #include <unistd.h>
+#include <fstream>
+#include <string>
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -26,20 +31,44 @@ namespace x360mu {
 // Global memory instance for signal handler
 static Memory* g_memory_instance = nullptr;
 
-// Signal handler for fastmem faults (only handles page mapping, not MMIO)
+// Handler that was installed before ours (crash handler, runtime)
+static struct sigaction g_previous_segv_action;
+static bool g_segv_handler_installed = false;
+
+// Signal handler for fastmem faults (page mapping and write detection)
 static void fastmem_signal_handler(int sig, siginfo_t* info, void* context) {
-    (void)context; // Unused - we don't do complex instruction emulation
-    
-    if (g_memory_instance && g_memory_instance->handle_fault(info->si_addr)) {
+    if (g_memory_instance &&
+        g_memory_instance->handle_fault(info->si_addr, info->si_code == SEGV_ACCERR)) {
         return; // Fault handled
     }
     
-    // Not our fault, re-raise
+    // Not our fault, hand it to whoever was installed before us
+    if ((g_previous_segv_action.sa_flags & SA_SIGINFO) && g_previous_segv_action.sa_sigaction) {
+        g_previous_segv_action.sa_sigaction(sig, info, context);
+        return;
+    }
+    if (g_previous_segv_action.sa_handler != SIG_DFL &&
+        g_previous_segv_action.sa_handler != SIG_IGN) {
+        g_previous_segv_action.sa_handler(sig);
+        return;
+    }
     signal(sig, SIG_DFL);
     raise(sig);
 }
 
-Memory::Memory() = default;
+// True if the kernel will back madvise(MADV_HUGEPAGE) regions with THP
+static bool transparent_huge_pages_available() {
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string mode;
+    if (!file || !std::getline(file, mode)) {
+        return false;
+    }
+    return mode.find("[never]") == std::string::npos;
+}
+
+Memory::Memory()
+    : register_shadow_(std::make_unique<std::atomic<u64>[]>(SHADOW_REGISTER_COUNT)),
+      reservation_versions_(std::make_unique<std::atomic<u32>[]>(RESERVATION_TABLE_SIZE)) {}
 
 Memory::~Memory() {
     shutdown();
@@ -50,17 +79,19 @@ Status Memory::initialize() {
     
     LOGI("Initializing memory subsystem");
     
-    // Allocate main memory (512MB)
+    // Allocate main memory (512MB). Fastmem maps it straight into its
+    // window; guest RAM is only mapped on its own if that fails, so a huge
+    // page pool never has to hold two copies.
     main_memory_size_ = memory::MAIN_MEMORY_SIZE;
-    main_memory_ = mmap(
-        nullptr,
-        main_memory_size_,
-        PROT_READ | PROT_WRITE,
-        MAP_PRIVATE | MAP_ANONYMOUS,
-        -1, 0
-    );
+    Status status = setup_fastmem();
+    if (status != Status::Ok) {
+        LOGE("Fastmem setup failed, using slow path");
+        // Non-fatal, continue without fastmem
+        main_memory_ = map_guest_ram(nullptr, main_memory_size_);
+    }
     
-    if (main_memory_ == MAP_FAILED) {
+    if (main_memory_ == MAP_FAILED || !main_memory_) {
+        main_memory_ = nullptr;
         LOGE("Failed to allocate main memory");
         return Status::OutOfMemory;
     }
@@ -77,18 +108,18 @@ Status Memory::initialize() {
         page_table_[i].valid = true;
     }
     
-    // Setup fastmem
-    Status status = setup_fastmem();
-    if (status != Status::Ok) {
-        LOGE("Fastmem setup failed, using slow path");
-        // Non-fatal, continue without fastmem
+    if (huge_pages_requested_ && backing_ == MemoryBacking::Normal) {
+        LOGI("Huge pages requested but unavailable, using normal pages");
     }
+    LOGI("Guest RAM backing: %s", memory_backing_name(backing_));
     
     LOGI("Memory subsystem initialized");
     return Status::Ok;
 }
 
 void Memory::shutdown() {
+    set_fastmem_write_detection(false);
+    
     std::lock_guard<std::mutex> lock(mutex_);
     
     // If fastmem is active, main_memory_ points into fastmem_base_
@@ -106,7 +137,11 @@ void Memory::shutdown() {
     page_table_.clear();
     regions_.clear();
     mmio_handlers_.clear();
-    write_tracks_.clear();
+    mmio_table_.store(nullptr, std::memory_order_relaxed);
+    mmio_tables_.clear();
+    retired_mmio_functions_.clear();
+    rebuild_mmio_table();
+    clear_watches();
 }
 
 void Memory::reset() {
@@ -114,7 +149,7 @@ void Memory::reset() {
     
     // Zero out main memory
     if (main_memory_) {
-        memset(main_memory_, 0, main_memory_size_);
+        discard_range(0, main_memory_size_);
     }
     
     // Reset page table flags (keep valid)
@@ -123,61 +158,98 @@ void Memory::reset() {
     }
 }
 
+void* Memory::map_guest_ram(void* addr, u64 size) {
+    int fixed = addr ? MAP_FIXED : 0;
+    
+#ifdef MAP_HUGETLB
+    if (huge_pages_requested_) {
+        void* mapped = mmap(addr, size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | fixed, -1, 0);
+        if (mapped != MAP_FAILED) {
+            backing_ = MemoryBacking::HugeTlb;
+            return mapped;
+        }
+        // Usually no pool reserved (vm.nr_hugepages == 0); try THP next
+    }
+#endif
+    
+    void* mapped = mmap(addr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | fixed, -1, 0);
+    if (mapped == MAP_FAILED) {
+        return mapped;
+    }
+    
+    backing_ = MemoryBacking::Normal;
+#ifdef MADV_HUGEPAGE
+    if (huge_pages_requested_ && madvise(mapped, size, MADV_HUGEPAGE) == 0 &&
+        transparent_huge_pages_available()) {
+        backing_ = MemoryBacking::TransparentHuge;
+    }
+#endif
+    return mapped;
+}
+
 Status Memory::setup_fastmem() {
     // Reserve a large virtual address space for fastmem
     // This allows direct address translation via pointer arithmetic
     fastmem_size_ = 4ULL * GB; // 4GB address space
     
-    fastmem_base_ = mmap(
+    // Over-reserve by one huge page so the base can be 2MB aligned; huge
+    // pages (hugetlb or THP) only back naturally aligned ranges
+    const u64 huge_page_size = 2 * MB;
+    fastmem_reservation_size_ = fastmem_size_ + huge_page_size;
+    fastmem_reservation_ = mmap(
         nullptr,
-        fastmem_size_,
+        fastmem_reservation_size_,
         PROT_NONE,
         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
         -1, 0
     );
     
-    if (fastmem_base_ == MAP_FAILED) {
+    if (fastmem_reservation_ == MAP_FAILED) {
         LOGE("Failed to reserve fastmem address space");
+        fastmem_reservation_ = nullptr;
         fastmem_base_ = nullptr;
         return Status::OutOfMemory;
     }
+    fastmem_base_ = reinterpret_cast<void*>(
+        align_up(reinterpret_cast<uintptr_t>(fastmem_reservation_),
+                 static_cast<uintptr_t>(huge_page_size)));
     
     LOGI("Reserved fastmem at %p (4GB)", fastmem_base_);
     
-    // Map the first 512MB + 4KB as read/write for physical memory
+    // Map the first 512MB as read/write for physical memory
+    void* mapped = map_guest_ram(fastmem_base_, main_memory_size_);
+    
     // The extra 4KB page handles edge case where a multi-byte store at 
     // offset 0x1FFFFFFC (end of 512MB) would cross into unmapped memory.
     // This is a guard page that allows such stores to complete safely.
+    // Mapped separately so it never has to be a huge page.
     const size_t guard_page_size = 4096;  // One extra page
-    void* mapped = mmap(
-        fastmem_base_,
-        main_memory_size_ + guard_page_size,
-        PROT_READ | PROT_WRITE,
-        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
-        -1, 0
-    );
+    void* guard = MAP_FAILED;
+    if (mapped != MAP_FAILED) {
+        guard = mmap(
+            static_cast<u8*>(fastmem_base_) + main_memory_size_,
+            guard_page_size,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+            -1, 0
+        );
+    }
     
-    if (mapped == MAP_FAILED) {
+    if (mapped == MAP_FAILED || guard == MAP_FAILED) {
         LOGE("Failed to map main memory into fastmem");
-        munmap(fastmem_base_, fastmem_size_);
+        munmap(fastmem_reservation_, fastmem_reservation_size_);
+        fastmem_reservation_ = nullptr;
         fastmem_base_ = nullptr;
         return Status::Error;
     }
     
-    // CRITICAL: Copy existing main_memory content to fastmem region
-    memcpy(fastmem_base_, main_memory_, main_memory_size_);
-    
-    // CRITICAL FIX: Now redirect main_memory_ to point to fastmem_base_
-    // This ensures both interpreter and JIT use the SAME memory region.
-    // The original main_memory_ allocation becomes orphaned (small leak)
-    // but this is acceptable for correctness.
-    void* old_main_memory = main_memory_;
+    // Guest RAM lives in the fastmem window, so the interpreter and JIT
+    // use the SAME memory region
     main_memory_ = fastmem_base_;
     
-    // Free the old allocation to avoid the leak
-    munmap(old_main_memory, main_memory_size_);
-    
-    LOGI("Fastmem: main_memory_ redirected to fastmem_base_ at %p", main_memory_);
+    LOGI("Fastmem: main_memory_ at fastmem_base_ %p", main_memory_);
     
     // Note: We don't install a signal handler as it interferes with Android's runtime.
     // Instead, we rely on the JIT to do proper address translation.
@@ -189,13 +261,14 @@ Status Memory::setup_fastmem() {
 
 void Memory::teardown_fastmem() {
     if (fastmem_base_) {
-        munmap(fastmem_base_, fastmem_size_);
+        munmap(fastmem_reservation_, fastmem_reservation_size_);
+        fastmem_reservation_ = nullptr;
         fastmem_base_ = nullptr;
         g_memory_instance = nullptr;
     }
 }
 
-bool Memory::handle_fault(void* fault_addr) {
+bool Memory::handle_fault(void* fault_addr, bool access_error) {
     if (!fastmem_base_) return false;
     
     uintptr_t addr = reinterpret_cast<uintptr_t>(fault_addr);
@@ -208,6 +281,12 @@ bool Memory::handle_fault(void* fault_addr) {
     
     GuestAddr guest_addr = static_cast<GuestAddr>(addr - base);
     
+    if (guest_addr < main_memory_size_ &&
+        fastmem_write_detection_.load(std::memory_order_acquire) &&
+        handle_write_protect_fault(guest_addr, access_error)) {
+        return true;
+    }
+    
     // MMIO addresses should never be accessed via fastmem - they must use
     // the slow path (read_u32/write_u32) which routes through MMIO handlers.
     // If we get here, it's a bug in the JIT/interpreter.
@@ -278,32 +357,48 @@ GuestAddr Memory::translate_address(GuestAddr addr) {
     return addr & 0x1FFFFFFF;
 }
 
+// Heatmap sampling hook for the accessors below
+inline void Memory::sample_access(GuestAddr addr, bool is_write, bool is_mmio) {
+    if (MemoryHeatmap* heatmap = active_heatmap_.load(std::memory_order_relaxed)) {
+        heatmap->record(addr, is_write, is_mmio);
+    }
+}
+
+void Memory::set_heatmap_enabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!heatmap_) {
+        if (!enabled) return;
+        heatmap_ = std::make_unique<MemoryHeatmap>();
+    }
+    
+    heatmap_->set_enabled(enabled);
+    active_heatmap_.store(enabled ? heatmap_.get() : nullptr, std::memory_order_release);
+    LOGI("Memory access heatmap %s", enabled ? "enabled" : "disabled");
+}
+
 // Memory access with byte swapping (Xbox 360 is big-endian)
 u8 Memory::read_u8(GuestAddr addr) {
-    if (is_mmio(addr)) {
-        GuestAddr phys_addr = translate_address(addr);
-        auto* handler = find_mmio(phys_addr);
-        if (handler) {
-            return static_cast<u8>(handler->read(phys_addr));
-        }
-        return 0;
+    u32 mmio_value;
+    if (mmio_read(addr, mmio_value)) {
+        sample_access(addr, false, true);
+        return static_cast<u8>(mmio_value);
     }
     
+    sample_access(addr, false, false);
     GuestAddr phys_addr = translate_address(addr);
     if (phys_addr >= main_memory_size_) return 0;
     return static_cast<u8*>(main_memory_)[phys_addr];
 }
 
 u16 Memory::read_u16(GuestAddr addr) {
-    if (is_mmio(addr)) {
-        GuestAddr phys_addr = translate_address(addr);
-        auto* handler = find_mmio(phys_addr);
-        if (handler) {
-            return static_cast<u16>(handler->read(phys_addr));
-        }
-        return 0;
+    u32 mmio_value;
+    if (mmio_read(addr, mmio_value)) {
+        sample_access(addr, false, true);
+        return static_cast<u16>(mmio_value);
     }
     
+    sample_access(addr, false, false);
     GuestAddr phys_addr = translate_address(addr);
     if (phys_addr + 1 >= main_memory_size_) return 0;
     u16 value;
@@ -312,18 +407,15 @@ u16 Memory::read_u16(GuestAddr addr) {
 }
 
 u32 Memory::read_u32(GuestAddr addr) {
-    if (is_mmio(addr)) {
-        GuestAddr phys_addr = translate_address(addr);
-        auto* handler = find_mmio(phys_addr);
-        if (handler) {
-            return handler->read(phys_addr);
-        }
-        return 0;
+    u32 value;
+    if (mmio_read(addr, value)) {
+        sample_access(addr, false, true);
+        return value;
     }
     
+    sample_access(addr, false, false);
     GuestAddr phys_addr = translate_address(addr);
     if (phys_addr + 3 >= main_memory_size_) return 0;
-    u32 value;
     memcpy(&value, static_cast<u8*>(main_memory_) + phys_addr, sizeof(u32));
     value = byte_swap(value);
     
@@ -331,17 +423,14 @@ u32 Memory::read_u32(GuestAddr addr) {
 }
 
 u64 Memory::read_u64(GuestAddr addr) {
-    if (is_mmio(addr)) {
-        GuestAddr phys_addr = translate_address(addr);
-        auto* handler = find_mmio(phys_addr);
-        if (handler) {
-            u64 lo = handler->read(phys_addr);
-            u64 hi = handler->read(phys_addr + 4);
-            return (hi << 32) | lo;
-        }
-        return 0;
+    u32 lo, hi;
+    if (mmio_read(addr, lo)) {
+        sample_access(addr, false, true);
+        mmio_read(addr + 4, hi);
+        return (static_cast<u64>(hi) << 32) | lo;
     }
     
+    sample_access(addr, false, false);
     GuestAddr phys_addr = translate_address(addr);
     if (phys_addr + 7 >= main_memory_size_) return 0;
     u64 value;
@@ -350,16 +439,13 @@ u64 Memory::read_u64(GuestAddr addr) {
 }
 
 void Memory::write_u8(GuestAddr addr, u8 value) {
-    if (is_mmio(addr)) {
-        GuestAddr phys_addr = translate_address(addr);
-        auto* handler = find_mmio(phys_addr);
-        if (handler) {
-            handler->write(phys_addr, value);
-        }
+    if (mmio_write(addr, value)) {
+        sample_access(addr, true, true);
         return;
     }
     
     // Translate virtual to physical address
+    sample_access(addr, true, false);
     GuestAddr phys_addr = translate_address(addr);
     if (phys_addr >= main_memory_size_) return;
     static_cast<u8*>(main_memory_)[phys_addr] = value;
@@ -367,15 +453,12 @@ void Memory::write_u8(GuestAddr addr, u8 value) {
 }
 
 void Memory::write_u16(GuestAddr addr, u16 value) {
-    if (is_mmio(addr)) {
-        GuestAddr phys_addr = translate_address(addr);
-        auto* handler = find_mmio(phys_addr);
-        if (handler) {
-            handler->write(phys_addr, byte_swap(value));
-        }
+    if (mmio_write(addr, byte_swap(value))) {
+        sample_access(addr, true, true);
         return;
     }
     
+    sample_access(addr, true, false);
     GuestAddr phys_addr = translate_address(addr);
     if (phys_addr + 1 >= main_memory_size_) return;
     value = byte_swap(value); // Host to big-endian
@@ -384,19 +467,13 @@ void Memory::write_u16(GuestAddr addr, u16 value) {
 }
 
 void Memory::write_u32(GuestAddr addr, u32 value) {
-    // Check if this is an MMIO address (could be virtual or physical)
-    if (is_mmio(addr)) {
-        // Translate to physical address for handler lookup and dispatch
-        // This handles virtual GPU addresses (0xC0000000+) -> physical (0x7FC00000+)
-        GuestAddr phys_addr = translate_address(addr);
-        auto* handler = find_mmio(phys_addr);
-        if (handler) {
-            // Pass the physical address to the handler
-            handler->write(phys_addr, value);
-        }
+    // MMIO (virtual GPU aliases are dispatched with the physical address)
+    if (mmio_write(addr, value)) {
+        sample_access(addr, true, true);
         return;
     }
     
+    sample_access(addr, true, false);
     GuestAddr phys_addr = translate_address(addr);
     
     // DEBUG: Trace writes to PCR region
@@ -416,16 +493,13 @@ void Memory::write_u32(GuestAddr addr, u32 value) {
 }
 
 void Memory::write_u64(GuestAddr addr, u64 value) {
-    if (is_mmio(addr)) {
-        GuestAddr phys_addr = translate_address(addr);
-        auto* handler = find_mmio(phys_addr);
-        if (handler) {
-            handler->write(phys_addr, static_cast<u32>(value >> 32));
-            handler->write(phys_addr + 4, static_cast<u32>(value));
-        }
+    if (mmio_write(addr, static_cast<u32>(value >> 32))) {
+        sample_access(addr, true, true);
+        mmio_write(addr + 4, static_cast<u32>(value));
         return;
     }
     
+    sample_access(addr, true, false);
     GuestAddr phys_addr = translate_address(addr);
     if (phys_addr + 7 >= main_memory_size_) return;
     value = byte_swap(value);
@@ -449,13 +523,74 @@ void Memory::write_bytes(GuestAddr addr, const void* src, u64 size) {
 }
 
 void Memory::zero_bytes(GuestAddr addr, u64 size) {
+    if (addr >= main_memory_size_) {
+        return;
+    }
     if (addr + size > main_memory_size_) {
         size = main_memory_size_ - addr;
     }
-    memset(static_cast<u8*>(main_memory_) + addr, 0, size);
+    if (size >= LAZY_ZERO_MIN) {
+        discard_range(addr, size);
+    } else {
+        memset(static_cast<u8*>(main_memory_) + addr, 0, size);
+    }
     notify_write(addr, size);
 }
 
+// Zero [offset, offset + size) of guest RAM. Whole host pages are handed
+// back with MADV_DONTNEED; the private anonymous mapping then reads them as
+// the shared zero page and only allocates again on the first write. Partial
+// pages at the edges, and hugetlbfs backing (which can only drop whole
+// 2MB pages), are cleared with memset.
+void Memory::discard_range(u64 offset, u64 size) {
+    static const u64 host_page = static_cast<u64>(sysconf(_SC_PAGESIZE));
+    
+    u8* host = static_cast<u8*>(main_memory_);
+    u64 first = align_up(offset, host_page);
+    u64 last = align_down(offset + size, host_page);
+    
+    if (backing_ != MemoryBacking::HugeTlb && last > first &&
+        madvise(host + first, last - first, MADV_DONTNEED) == 0) {
+        memset(host + offset, 0, first - offset);
+        memset(host + last, 0, offset + size - last);
+        return;
+    }
+    memset(host + offset, 0, size);
+}
+
+void Memory::decommit(GuestAddr base, u64 size) {
+    if (!main_memory_ || base >= main_memory_size_ || size == 0) {
+        return;
+    }
+    
+    u64 start = align_down<u64>(base, memory::MEM_PAGE_SIZE);
+    u64 end = std::min<u64>(align_up<u64>(base + size, memory::MEM_PAGE_SIZE),
+                            main_memory_size_);
+    discard_range(start, end - start);
+    notify_write(static_cast<GuestAddr>(start), end - start);
+}
+
+u64 Memory::resident_bytes(GuestAddr base, u64 size) const {
+    if (!main_memory_ || base >= main_memory_size_ || size == 0) {
+        return 0;
+    }
+    
+    static const u64 host_page = static_cast<u64>(sysconf(_SC_PAGESIZE));
+    u64 first = align_down<u64>(base, host_page);
+    u64 last = align_up<u64>(std::min<u64>(base + size, main_memory_size_), host_page);
+    
+    std::vector<unsigned char> pages((last - first) / host_page);
+    if (mincore(static_cast<u8*>(main_memory_) + first, last - first, pages.data()) != 0) {
+        return 0;
+    }
+    
+    u64 resident = 0;
+    for (unsigned char page : pages) {
+        if (page & 1) resident += host_page;
+    }
+    return resident;
+}
+
 void Memory::copy_bytes(GuestAddr dest, GuestAddr src, u64 size) {
     if (src + size > main_memory_size_ || dest + size > main_memory_size_) {
         return;
@@ -468,6 +603,72 @@ void Memory::copy_bytes(GuestAddr dest, GuestAddr src, u64 size) {
     notify_write(dest, size);
 }
 
+// Byte-swapped bulk access
+//
+// Work proceeds one guest page at a time: within a page the translation is
+// contiguous and the page is either all RAM or all MMIO.
+template <typename T>
+void Memory::read_swapped(GuestAddr addr, T* dst, u64 count) {
+    while (count > 0) {
+        u32 page_left = memory::MEM_PAGE_SIZE - (addr & (memory::MEM_PAGE_SIZE - 1));
+        u64 n = std::min<u64>(count, page_left / sizeof(T));
+        GuestAddr phys_addr = translate_address(addr);
+        
+        if (n == 0 || is_mmio(addr) || phys_addr + n * sizeof(T) > main_memory_size_) {
+            // Straddles a page, MMIO or out of range: one element at a time
+            u64 m = n ? n : 1;
+            for (u64 i = 0; i < m; i++) {
+                GuestAddr a = addr + static_cast<GuestAddr>(i * sizeof(T));
+                if constexpr (sizeof(T) == 2) dst[i] = read_u16(a);
+                else if constexpr (sizeof(T) == 4) dst[i] = read_u32(a);
+                else dst[i] = read_u64(a);
+            }
+            n = m;
+        } else {
+            detail::byte_swap_copy<T>(dst, static_cast<u8*>(main_memory_) + phys_addr, n);
+        }
+        
+        addr += static_cast<GuestAddr>(n * sizeof(T));
+        dst += n;
+        count -= n;
+    }
+}
+
+template <typename T>
+void Memory::write_swapped(GuestAddr addr, const T* src, u64 count) {
+    while (count > 0) {
+        u32 page_left = memory::MEM_PAGE_SIZE - (addr & (memory::MEM_PAGE_SIZE - 1));
+        u64 n = std::min<u64>(count, page_left / sizeof(T));
+        GuestAddr phys_addr = translate_address(addr);
+        
+        if (n == 0 || is_mmio(addr) || phys_addr + n * sizeof(T) > main_memory_size_) {
+            u64 m = n ? n : 1;
+            for (u64 i = 0; i < m; i++) {
+                GuestAddr a = addr + static_cast<GuestAddr>(i * sizeof(T));
+                if constexpr (sizeof(T) == 2) write_u16(a, src[i]);
+                else if constexpr (sizeof(T) == 4) write_u32(a, src[i]);
+                else write_u64(a, src[i]);
+            }
+            n = m;
+        } else {
+            detail::byte_swap_copy<T>(static_cast<u8*>(main_memory_) + phys_addr, src, n);
+            notify_write(addr, n * sizeof(T));
+        }
+        
+        addr += static_cast<GuestAddr>(n * sizeof(T));
+        src += n;
+        count -= n;
+    }
+}
+
+void Memory::read_swapped16(GuestAddr addr, u16* dst, u64 count) { read_swapped(addr, dst, count); }
+void Memory::read_swapped32(GuestAddr addr, u32* dst, u64 count) { read_swapped(addr, dst, count); }
+void Memory::read_swapped64(GuestAddr addr, u64* dst, u64 count) { read_swapped(addr, dst, count); }
+
+void Memory::write_swapped16(GuestAddr addr, const u16* src, u64 count) { write_swapped(addr, src, count); }
+void Memory::write_swapped32(GuestAddr addr, const u32* src, u64 count) { write_swapped(addr, src, count); }
+void Memory::write_swapped64(GuestAddr addr, const u64* src, u64 count) { write_swapped(addr, src, count); }
+
 void* Memory::get_host_ptr(GuestAddr addr) {
     if (is_mmio(addr)) return nullptr;
     if (addr >= main_memory_size_) return nullptr;
@@ -523,24 +724,33 @@ Status Memory::allocate(GuestAddr base, u64 size, u32 flags) {
 }
 
 void Memory::free(GuestAddr base) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // Find and remove region
-    for (auto it = regions_.begin(); it != regions_.end(); ++it) {
-        if (it->base == base) {
-            // Clear page table entries
-            u64 start_page = base / memory::MEM_PAGE_SIZE;
-            u64 page_count = (it->size + memory::MEM_PAGE_SIZE - 1) / memory::MEM_PAGE_SIZE;
-            
-            for (u64 i = 0; i < page_count; i++) {
-                page_table_[start_page + i].flags = 0;
-                page_table_[start_page + i].valid = false;
+    u64 size = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        
+        // Find and remove region
+        for (auto it = regions_.begin(); it != regions_.end(); ++it) {
+            if (it->base == base) {
+                // Clear page table entries
+                u64 start_page = base / memory::MEM_PAGE_SIZE;
+                u64 page_count = (it->size + memory::MEM_PAGE_SIZE - 1) / memory::MEM_PAGE_SIZE;
+                
+                for (u64 i = 0; i < page_count; i++) {
+                    page_table_[start_page + i].flags = 0;
+                    page_table_[start_page + i].valid = false;
+                }
+                
+                size = it->size;
+                regions_.erase(it);
+                break;
             }
-            
-            regions_.erase(it);
-            return;
         }
     }
+    
+    // Give the host pages back; a later allocation starts from zero pages
+    if (size != 0) {
+        decommit(base, size);
+    }
 }
 
 Status Memory::protect(GuestAddr base, u64 size, u32 flags) {
@@ -573,14 +783,45 @@ bool Memory::query(GuestAddr addr, MemoryRegion& out) const {
 void Memory::register_mmio(GuestAddr base, u64 size,
                            MmioReadHandler read,
                            MmioWriteHandler write) {
+    auto functions = std::make_unique<MmioFunctions>();
+    functions->read = std::move(read);
+    functions->write = std::move(write);
+    
     std::lock_guard<std::mutex> lock(mutex_);
     
+    MmioFunctions* context = functions.get();
     mmio_handlers_.push_back({
         .base = base,
         .size = size,
-        .read = std::move(read),
-        .write = std::move(write)
+        .read = [](void* ctx, GuestAddr addr) -> u32 {
+            auto* fns = static_cast<MmioFunctions*>(ctx);
+            return fns->read ? fns->read(addr) : 0;
+        },
+        .write = [](void* ctx, GuestAddr addr, u32 value) {
+            auto* fns = static_cast<MmioFunctions*>(ctx);
+            if (fns->write) fns->write(addr, value);
+        },
+        .context = context,
+        .functions = std::move(functions)
     });
+    rebuild_mmio_table();
+    
+    LOGI("Registered MMIO: 0x%08X - 0x%08X", base, base + static_cast<u32>(size));
+}
+
+void Memory::register_mmio(GuestAddr base, u64 size,
+                           MmioReadFn read, MmioWriteFn write, void* context) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    mmio_handlers_.push_back({
+        .base = base,
+        .size = size,
+        .read = read,
+        .write = write,
+        .context = context,
+        .functions = nullptr
+    });
+    rebuild_mmio_table();
     
     LOGI("Registered MMIO: 0x%08X - 0x%08X", base, base + static_cast<u32>(size));
 }
@@ -590,43 +831,134 @@ void Memory::unregister_mmio(GuestAddr base) {
     
     for (auto it = mmio_handlers_.begin(); it != mmio_handlers_.end(); ++it) {
         if (it->base == base) {
+            if (it->functions) {
+                retired_mmio_functions_.push_back(std::move(it->functions));
+            }
             mmio_handlers_.erase(it);
+            rebuild_mmio_table();
             return;
         }
     }
 }
 
-bool Memory::is_mmio(GuestAddr addr) const {
-    // GPU registers at physical address 0x7FC00000-0x7FFFFFFF
-    if (addr >= memory::GPU_REGS_BASE && addr <= memory::GPU_REGS_END) {
-        return true;
-    }
+void Memory::rebuild_mmio_table() {
+    // Each window page gets the smallest range covering it entirely. Pages
+    // that also contain a range ending or starting mid-page are flagged so
+    // the access resolves against the range list instead.
+    const u64 window_base = memory::GPU_REGS_BASE;
     
-    // GPU MMIO virtual mapping: 0xC0000000-0xC3FFFFFF
-    // Kernel maps GPU registers here for usermode access
-    if (addr >= 0xC0000000 && addr < 0xC4000000) {
-        return true;
+    auto table = std::make_unique<MmioTable>();
+    std::array<u64, MMIO_WINDOW_PAGES> best_size{};
+    
+    for (const auto& range : mmio_handlers_) {
+        table->ranges.push_back({range.base, range.size, range.read, range.write, range.context});
+        
+        u64 start = range.base;
+        u64 end = start + range.size;
+        if (start < window_base || start >= window_base + MMIO_WINDOW_SIZE) {
+            table->external_ranges++;
+            continue;
+        }
+        end = std::min<u64>(end, window_base + MMIO_WINDOW_SIZE);
+        
+        u32 first = static_cast<u32>((start - window_base) >> memory::MEM_PAGE_SHIFT);
+        u32 last = static_cast<u32>((end - 1 - window_base) >> memory::MEM_PAGE_SHIFT);
+        for (u32 page = first; page <= last; page++) {
+            u64 page_start = window_base + (static_cast<u64>(page) << memory::MEM_PAGE_SHIFT);
+            u64 page_end = page_start + memory::MEM_PAGE_SIZE;
+            if (start > page_start || end < page_end) {
+                table->pages[page].partial = true;
+                continue;
+            }
+            if (best_size[page] == 0 || range.size < best_size[page]) {
+                table->pages[page].read = range.read;
+                table->pages[page].write = range.write;
+                table->pages[page].context = range.context;
+                best_size[page] = range.size;
+            }
+        }
     }
     
-    // Alternate GPU MMIO virtual mapping: 0xEC800000-0xECFFFFFF
-    if (addr >= 0xEC800000 && addr < 0xED000000) {
+    mmio_table_.store(table.get(), std::memory_order_release);
+    mmio_tables_.push_back(std::move(table));
+}
+
+bool Memory::gpu_window_offset(GuestAddr addr, u32& offset) {
+    // The physical GPU window and both virtual aliases sit on 4MB
+    // boundaries, so the window offset is just the low 22 bits
+    bool in_window = (addr >= memory::GPU_REGS_BASE && addr <= memory::GPU_REGS_END) ||
+                     (addr >= 0xC0000000 && addr < 0xC4000000) ||
+                     (addr >= 0xEC800000 && addr < 0xED000000);
+    offset = addr & (MMIO_WINDOW_SIZE - 1);
+    return in_window;
+}
+
+bool Memory::lookup_mmio(GuestAddr addr, GuestAddr& phys, MmioPage& page) const {
+    const MmioTable* table = mmio_table_.load(std::memory_order_acquire);
+    if (!table) return false;
+    
+    u32 offset;
+    if (gpu_window_offset(addr, offset)) {
+        phys = memory::GPU_REGS_BASE + offset;
+        page = table->pages[offset >> memory::MEM_PAGE_SHIFT];
+        if (page.partial) {
+            const MmioEntry* range = find_mmio(*table, phys);
+            page = range ? MmioPage{range->read, range->write, range->context, true} : MmioPage{};
+        }
         return true;
     }
     
-    // Check registered MMIO ranges
-    for (const auto& handler : mmio_handlers_) {
-        if (addr >= handler.base && addr < handler.base + handler.size) {
+    if (table->external_ranges != 0) {
+        if (const MmioEntry* range = find_mmio(*table, addr)) {
+            phys = addr;
+            page = {range->read, range->write, range->context, false};
             return true;
         }
     }
-    
     return false;
 }
 
-Memory::MmioRange* Memory::find_mmio(GuestAddr addr) {
+bool Memory::mmio_read(GuestAddr addr, u32& value) const {
+    u32 offset;
+    if (gpu_window_offset(addr, offset) && (offset >> 2) < SHADOW_REGISTER_COUNT) {
+        u64 shadow = register_shadow_[offset >> 2].load(std::memory_order_acquire);
+        if (shadow & SHADOW_REGISTER_VALID) {
+            value = static_cast<u32>(shadow);
+            return true;
+        }
+    }
+    
+    GuestAddr phys;
+    MmioPage page;
+    if (!lookup_mmio(addr, phys, page)) {
+        return false;
+    }
+    value = page.read ? page.read(page.context, phys) : 0;
+    return true;
+}
+
+bool Memory::mmio_write(GuestAddr addr, u32 value) {
+    GuestAddr phys;
+    MmioPage page;
+    if (!lookup_mmio(addr, phys, page)) {
+        return false;
+    }
+    if (page.write) {
+        page.write(page.context, phys, value);
+    }
+    return true;
+}
+
+bool Memory::is_mmio(GuestAddr addr) const {
+    GuestAddr phys;
+    MmioPage page;
+    return lookup_mmio(addr, phys, page);
+}
+
+const Memory::MmioEntry* Memory::find_mmio(const MmioTable& table, GuestAddr addr) {
     // Find the most specific (smallest) matching range
-    MmioRange* best = nullptr;
-    for (auto& handler : mmio_handlers_) {
+    const MmioEntry* best = nullptr;
+    for (const auto& handler : table.ranges) {
         if (addr >= handler.base && addr < handler.base + handler.size) {
             if (!best || handler.size < best->size) {
                 best = &handler;
@@ -637,31 +969,120 @@ Memory::MmioRange* Memory::find_mmio(GuestAddr addr) {
 }
 
 void Memory::track_writes(GuestAddr base, u64 size, WriteCallback callback) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    write_tracks_.push_back({
-        .base = base,
-        .size = size,
-        .callback = std::move(callback)
-    });
+    add_watch(base, size, std::move(callback), false);
 }
 
 void Memory::untrack_writes(GuestAddr base) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::lock_guard<std::mutex> lock(watch_mutex_);
     
-    for (auto it = write_tracks_.begin(); it != write_tracks_.end(); ++it) {
-        if (it->base == base) {
-            write_tracks_.erase(it);
+    for (size_t i = 0; i < write_watches_.size(); i++) {
+        if (!write_watches_[i]->deferred && write_watches_[i]->base == base) {
+            remove_watch_locked(i);
+            return;
+        }
+    }
+}
+
+Memory::WatchId Memory::watch_pages(GuestAddr base, u64 size, WriteCallback callback) {
+    return add_watch(base, size, std::move(callback), true);
+}
+
+void Memory::unwatch_pages(WatchId id) {
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    
+    for (size_t i = 0; i < write_watches_.size(); i++) {
+        if (write_watches_[i]->id == id) {
+            remove_watch_locked(i);
             return;
         }
     }
 }
 
+Memory::WatchId Memory::add_watch(GuestAddr base, u64 size, WriteCallback callback,
+                                  bool deferred) {
+    if (size == 0) return 0;
+    
+    auto watch = std::make_shared<WriteWatch>();
+    watch->base = base;
+    watch->size = size;
+    watch->first_page = watch_page_index(base);
+    u64 span = std::min<u64>(size, memory::MAIN_MEMORY_SIZE) - 1;
+    watch->last_page = std::min<u32>(watch_page_index(base + static_cast<GuestAddr>(span)),
+                                     WATCH_PAGE_COUNT - 1);
+    if (watch->last_page < watch->first_page) {
+        // Range wraps the end of physical memory; watch everything above base
+        watch->last_page = WATCH_PAGE_COUNT - 1;
+    }
+    watch->phys_begin = base & 0x1FFFFFFF;
+    watch->phys_end = std::min<u64>(watch->phys_begin + size,
+                                    static_cast<u64>(watch->last_page + 1) << memory::MEM_PAGE_SHIFT);
+    watch->deferred = deferred;
+    watch->callback = std::move(callback);
+    if (deferred) {
+        watch->pending.resize((watch->last_page - watch->first_page) / 64 + 1, 0);
+    }
+    
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    if (watch_refs_.empty()) {
+        watch_refs_.resize(WATCH_PAGE_COUNT, 0);
+    }
+    watch->id = next_watch_id_++;
+    for (u32 page = watch->first_page; page <= watch->last_page; page++) {
+        if (watch_refs_[page]++ == 0) {
+            watched_pages_[page >> 6].fetch_or(1ULL << (page & 63), std::memory_order_relaxed);
+        }
+    }
+    write_watches_.push_back(watch);
+    return watch->id;
+}
+
+void Memory::remove_watch_locked(size_t index) {
+    const WriteWatch& watch = *write_watches_[index];
+    for (u32 page = watch.first_page; page <= watch.last_page; page++) {
+        if (--watch_refs_[page] == 0) {
+            watched_pages_[page >> 6].fetch_and(~(1ULL << (page & 63)), std::memory_order_relaxed);
+        }
+    }
+    write_watches_.erase(write_watches_.begin() + index);
+}
+
+void Memory::clear_watches() {
+    std::lock_guard<std::mutex> lock(watch_mutex_);
+    
+    write_watches_.clear();
+    watch_refs_.clear();
+    for (auto& word : watched_pages_) {
+        word.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool Memory::any_page_watched(u32 first_page, u32 last_page) const {
+    u32 first_word = first_page >> 6;
+    u32 last_word = last_page >> 6;
+    for (u32 w = first_word; w <= last_word; w++) {
+        u64 mask = ~0ULL;
+        if (w == first_word) mask &= ~0ULL << (first_page & 63);
+        if (w == last_word) mask &= ~0ULL >> (63 - (last_page & 63));
+        if (watched_pages_[w].load(std::memory_order_relaxed) & mask) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void Memory::notify_write(GuestAddr addr, u64 size) {
-    for (const auto& track : write_tracks_) {
-        // Check for overlap
-        if (addr < track.base + track.size && addr + size > track.base) {
-            track.callback(addr, size);
+    if (size != 0) {
+        u32 first_page = watch_page_index(addr);
+        u32 last_page = watch_page_index(addr + static_cast<GuestAddr>(size - 1));
+        if (last_page < first_page) {
+            // Wrapped past the end of physical memory
+            last_page = WATCH_PAGE_COUNT - 1;
+        }
+        if (dirty_tracking_active_.load(std::memory_order_acquire)) {
+            mark_pages_dirty(first_page, last_page);
+        }
+        if (any_page_watched(first_page, last_page)) {
+            notify_watchers(addr, size, first_page, last_page);
         }
     }
     
@@ -669,46 +1090,412 @@ void Memory::notify_write(GuestAddr addr, u64 size) {
     invalidate_reservations(addr, size);
 }
 
+void Memory::notify_watchers(GuestAddr addr, u64 size, u32 first_page, u32 last_page) {
+    // Synchronous watchers are called outside the lock so they may
+    // register or remove watches themselves
+    std::shared_ptr<WriteWatch> immediate[8];
+    std::vector<std::shared_ptr<WriteWatch>> overflow;
+    size_t immediate_count = 0;
+    
+    // The page bitmap only got us here; synchronous watchers want writes
+    // that touch their bytes, not just their pages
+    u64 write_begin = addr & 0x1FFFFFFF;
+    u64 write_end = write_begin + size;
+    
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        for (const auto& watch : write_watches_) {
+            if (last_page < watch->first_page || first_page > watch->last_page) {
+                continue;
+            }
+            if (watch->deferred) {
+                u32 lo = std::max(first_page, watch->first_page) - watch->first_page;
+                u32 hi = std::min(last_page, watch->last_page) - watch->first_page;
+                for (u32 bit = lo; bit <= hi; bit++) {
+                    watch->pending[bit >> 6] |= 1ULL << (bit & 63);
+                }
+                watch->has_pending = true;
+            } else if (write_end <= watch->phys_begin || write_begin >= watch->phys_end) {
+                continue;
+            } else if (immediate_count < 8) {
+                immediate[immediate_count++] = watch;
+            } else {
+                overflow.push_back(watch);
+            }
+        }
+    }
+    
+    for (size_t i = 0; i < immediate_count; i++) {
+        immediate[i]->callback(addr, size);
+    }
+    for (const auto& watch : overflow) {
+        watch->callback(addr, size);
+    }
+}
+
+void Memory::flush_page_writes() {
+    struct Run {
+        std::shared_ptr<WriteWatch> watch;
+        GuestAddr base;
+        u64 size;
+    };
+    std::vector<Run> runs;
+    
+    {
+        std::lock_guard<std::mutex> lock(watch_mutex_);
+        for (const auto& watch : write_watches_) {
+            if (!watch->deferred || !watch->has_pending) continue;
+            
+            u32 count = watch->last_page - watch->first_page + 1;
+            u32 bit = 0;
+            while (bit < count) {
+                if (!(watch->pending[bit >> 6] & (1ULL << (bit & 63)))) {
+                    bit++;
+                    continue;
+                }
+                u32 start = bit;
+                while (bit < count && (watch->pending[bit >> 6] & (1ULL << (bit & 63)))) {
+                    bit++;
+                }
+                GuestAddr base = (watch->first_page + start) << memory::MEM_PAGE_SHIFT;
+                runs.push_back({watch, base, static_cast<u64>(bit - start) << memory::MEM_PAGE_SHIFT});
+            }
+            std::fill(watch->pending.begin(), watch->pending.end(), 0);
+            watch->has_pending = false;
+        }
+    }
+    
+    for (const auto& run : runs) {
+        run.watch->callback(run.base, run.size);
+    }
+}
+
+// Dirty page tracking
+//
+// A write stamps its pages (and their 64-page chunk) with the current
+// generation. A snapshot bumps the generation and reports every page
+// stamped at or after the consumer's previous snapshot. Writers re-check
+// the generation after stamping so a write racing a snapshot is carried
+// into the next interval instead of being lost.
+void Memory::mark_pages_dirty(u32 first_page, u32 last_page) {
+    u32 gen = dirty_generation_.load();
+    for (;;) {
+        for (u32 page = first_page; page <= last_page; page++) {
+            if (page_write_gen_[page].load(std::memory_order_relaxed) != gen) {
+                page_write_gen_[page].store(gen);
+            }
+            u32 chunk = page >> 6;
+            if (chunk_write_gen_[chunk].load(std::memory_order_relaxed) != gen) {
+                chunk_write_gen_[chunk].store(gen);
+            }
+        }
+        u32 now = dirty_generation_.load();
+        if (now == gen) break;
+        gen = now;
+    }
+}
+
+Memory::DirtyConsumerId Memory::register_dirty_consumer() {
+    std::lock_guard<std::mutex> lock(dirty_mutex_);
+    
+    if (!page_write_gen_) {
+        // Never freed while the Memory lives; writers may still be reading
+        page_write_gen_ = std::make_unique<std::atomic<u32>[]>(WATCH_PAGE_COUNT);
+        chunk_write_gen_ = std::make_unique<std::atomic<u32>[]>(WATCH_PAGE_COUNT / 64);
+    }
+    
+    DirtyConsumerId id = next_dirty_consumer_id_++;
+    dirty_consumers_.push_back({id, dirty_generation_.fetch_add(1) + 1});
+    dirty_tracking_active_.store(true, std::memory_order_release);
+    return id;
+}
+
+void Memory::unregister_dirty_consumer(DirtyConsumerId id) {
+    std::lock_guard<std::mutex> lock(dirty_mutex_);
+    
+    for (auto it = dirty_consumers_.begin(); it != dirty_consumers_.end(); ++it) {
+        if (it->id == id) {
+            dirty_consumers_.erase(it);
+            break;
+        }
+    }
+    if (dirty_consumers_.empty()) {
+        dirty_tracking_active_.store(false, std::memory_order_release);
+    }
+}
+
+u32 Memory::advance_dirty_interval(DirtyConsumerId id, u32& since) {
+    for (auto& consumer : dirty_consumers_) {
+        if (consumer.id == id) {
+            since = consumer.since;
+            u32 snap = dirty_generation_.fetch_add(1);
+            consumer.since = snap + 1;
+            
+            // Pages left writable by the fault handler may have taken
+            // undetected stores; protect them again and count them as
+            // written in the new generation
+            if (fastmem_write_detection_.load(std::memory_order_acquire)) {
+                reprotect_fastmem_pages(snap + 1);
+            }
+            return id;
+        }
+    }
+    return 0;
+}
+
+void Memory::snapshot_dirty_pages(DirtyConsumerId id, std::vector<GuestAddr>& pages) {
+    pages.clear();
+    
+    std::lock_guard<std::mutex> lock(dirty_mutex_);
+    u32 since;
+    if (!advance_dirty_interval(id, since)) return;
+    
+    // Stamps only move forward, so anything at or past 'since' was
+    // written during this consumer's interval
+    for (u32 chunk = 0; chunk < WATCH_PAGE_COUNT / 64; chunk++) {
+        if (chunk_write_gen_[chunk].load() < since) continue;
+        for (u32 page = chunk * 64; page < chunk * 64 + 64; page++) {
+            if (page_write_gen_[page].load() >= since) {
+                pages.push_back(page << memory::MEM_PAGE_SHIFT);
+            }
+        }
+    }
+}
+
+void Memory::clear_dirty_pages(DirtyConsumerId id) {
+    std::lock_guard<std::mutex> lock(dirty_mutex_);
+    u32 since;
+    advance_dirty_interval(id, since);
+}
+
+u32 Memory::page_generation(GuestAddr addr) const {
+    if (!dirty_tracking_active_.load(std::memory_order_acquire)) return 0;
+    return page_write_gen_[watch_page_index(addr)].load();
+}
+
+Status Memory::set_fastmem_write_detection(bool enable) {
+    std::lock_guard<std::mutex> lock(dirty_mutex_);
+    
+    if (enable == fastmem_write_detection_.load()) return Status::Ok;
+    
+    if (enable) {
+        if (!fastmem_base_ || !page_write_gen_) {
+            // Needs fastmem and at least one registered consumer
+            return Status::InvalidArgument;
+        }
+        if (backing_ == MemoryBacking::HugeTlb) {
+            // hugetlb mappings cannot be protected per 4KB page
+            LOGE("Fastmem write detection is unavailable with hugetlb backing");
+            return Status::NotImplemented;
+        }
+        if (!fastmem_protected_) {
+            fastmem_protected_ = std::make_unique<std::atomic<u64>[]>(WATCH_PAGE_COUNT / 64);
+        }
+        if (!g_segv_handler_installed) {
+            struct sigaction sa;
+            memset(&sa, 0, sizeof(sa));
+            sa.sa_sigaction = fastmem_signal_handler;
+            sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+            sigemptyset(&sa.sa_mask);
+            if (sigaction(SIGSEGV, &sa, &g_previous_segv_action) != 0) {
+                LOGE("Failed to install fastmem write-detection handler");
+                return Status::Error;
+            }
+            g_segv_handler_installed = true;
+        }
+        g_memory_instance = this;
+        fastmem_write_detection_.store(true, std::memory_order_release);
+        reprotect_fastmem_pages(dirty_generation_.load());
+        LOGI("Fastmem write detection enabled");
+        return Status::Ok;
+    }
+    
+    while (fastmem_protect_lock_.test_and_set(std::memory_order_acquire)) {}
+    if (mprotect(fastmem_base_, main_memory_size_, PROT_READ | PROT_WRITE) != 0) {
+        LOGE("Failed to unprotect guest RAM while disabling write detection");
+    }
+    for (u32 w = 0; w < WATCH_PAGE_COUNT / 64; w++) {
+        fastmem_protected_[w].store(0, std::memory_order_relaxed);
+    }
+    fastmem_write_detection_.store(false, std::memory_order_release);
+    fastmem_protect_lock_.clear(std::memory_order_release);
+    
+    if (g_segv_handler_installed) {
+        sigaction(SIGSEGV, &g_previous_segv_action, nullptr);
+        g_segv_handler_installed = false;
+    }
+    LOGI("Fastmem write detection disabled");
+    return Status::Ok;
+}
+
+void Memory::reprotect_fastmem_pages(u32 generation) {
+    u8* base = static_cast<u8*>(fastmem_base_);
+    u32 page_count = static_cast<u32>(main_memory_size_ >> memory::MEM_PAGE_SHIFT);
+    
+    while (fastmem_protect_lock_.test_and_set(std::memory_order_acquire)) {}
+    
+    u32 page = 0;
+    while (page < page_count) {
+        auto writable = [&](u32 p) {
+            return !((fastmem_protected_[p >> 6].load(std::memory_order_relaxed) >> (p & 63)) & 1);
+        };
+        if (!writable(page)) {
+            page++;
+            continue;
+        }
+        u32 start = page;
+        while (page < page_count && writable(page)) {
+            // Bit first: a fault on a protected page must find it set
+            fastmem_protected_[page >> 6].fetch_or(1ULL << (page & 63), std::memory_order_relaxed);
+            page++;
+        }
+        if (mprotect(base + (static_cast<u64>(start) << memory::MEM_PAGE_SHIFT),
+                     static_cast<u64>(page - start) << memory::MEM_PAGE_SHIFT, PROT_READ) != 0) {
+            // Still writable: drop the bits so faults there aren't ours, and
+            // keep counting the pages as written (below) since stores go unseen
+            LOGE("Failed to write-protect guest pages 0x%08X-0x%08X",
+                 start << memory::MEM_PAGE_SHIFT, (page << memory::MEM_PAGE_SHIFT) - 1);
+            for (u32 p = start; p < page; p++) {
+                fastmem_protected_[p >> 6].fetch_and(~(1ULL << (p & 63)), std::memory_order_relaxed);
+            }
+        }
+        if (dirty_tracking_active_.load(std::memory_order_relaxed)) {
+            for (u32 p = start; p < page; p++) {
+                page_write_gen_[p].store(generation);
+                chunk_write_gen_[p >> 6].store(generation);
+            }
+        }
+    }
+    
+    fastmem_protect_lock_.clear(std::memory_order_release);
+}
+
+bool Memory::handle_write_protect_fault(GuestAddr guest_addr, bool access_error) {
+    // Runs in the signal handler: atomics and mprotect only
+    u32 page = guest_addr >> memory::MEM_PAGE_SHIFT;
+    bool handled = false;
+    
+    while (fastmem_protect_lock_.test_and_set(std::memory_order_acquire)) {}
+    u64 bit = 1ULL << (page & 63);
+    if (fastmem_protected_[page >> 6].load(std::memory_order_relaxed) & bit) {
+        if (mprotect(static_cast<u8*>(fastmem_base_) + (static_cast<u64>(page) << memory::MEM_PAGE_SHIFT),
+                     memory::MEM_PAGE_SIZE, PROT_READ | PROT_WRITE) == 0) {
+            fastmem_protected_[page >> 6].fetch_and(~bit, std::memory_order_relaxed);
+            if (dirty_tracking_active_.load(std::memory_order_relaxed)) {
+                mark_pages_dirty(page, page);
+            }
+            handled = true;
+        }
+    } else if (access_error) {
+        // A clear bit means the page is writable right now (the bit is only
+        // cleared after a successful unprotect), so a permission fault here
+        // raced another thread's unprotect: retrying the store succeeds.
+        // Unmapped-page faults fall through to the caller.
+        handled = true;
+    }
+    fastmem_protect_lock_.clear(std::memory_order_release);
+    
+    return handled;
+}
+
 // Per-thread atomic reservation support
 void Memory::set_reservation(u32 thread_id, GuestAddr addr, u32 size) {
     if (thread_id >= MAX_THREADS) return;
     
-    std::lock_guard<std::mutex> lock(reservation_mutex_);
-    reservations_[thread_id].addr = addr;
-    reservations_[thread_id].size = size;
-    reservations_[thread_id].valid = true;
+    auto& res = reservations_[thread_id];
+    if (!res.valid) {
+        // Publish before sampling the version: a store either sees the
+        // count and bumps the granule, or lands before our load
+        active_reservations_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    res.addr = addr;
+    res.size = size;
+    res.granule = reservation_granule(addr);
+    res.version = reservation_versions_[res.granule].load(std::memory_order_seq_cst);
+    res.valid = true;
 }
 
 bool Memory::check_reservation(u32 thread_id, GuestAddr addr, u32 size) const {
     if (thread_id >= MAX_THREADS) return false;
     
-    std::lock_guard<std::mutex> lock(reservation_mutex_);
     const auto& res = reservations_[thread_id];
-    if (!res.valid) return false;
-    return (addr == res.addr && size == res.size);
+    if (!res.valid || addr != res.addr || size != res.size) return false;
+    return reservation_versions_[res.granule].load(std::memory_order_acquire) == res.version;
+}
+
+bool Memory::store_conditional(u32 thread_id, GuestAddr addr, u32 size, u64 value) {
+    if (thread_id >= MAX_THREADS) return false;
+    
+    auto& res = reservations_[thread_id];
+    if (!res.valid || addr != res.addr || size != res.size) return false;
+    
+    // Odd versions mark a conditional store in flight; reservations
+    // taken while it runs cannot match once it finishes
+    u32 expected = res.version;
+    if (expected & 1) return false;
+    auto& version = reservation_versions_[res.granule];
+    if (!version.compare_exchange_strong(expected, expected + 1, std::memory_order_acq_rel,
+                                         std::memory_order_acquire)) {
+        return false;
+    }
+    
+    if (size == 8) {
+        write_u64(addr, value);
+    } else {
+        write_u32(addr, static_cast<u32>(value));
+    }
+    
+    version.fetch_add(1, std::memory_order_release);
+    return true;
 }
 
 void Memory::clear_reservation(u32 thread_id) {
     if (thread_id >= MAX_THREADS) return;
     
-    std::lock_guard<std::mutex> lock(reservation_mutex_);
-    reservations_[thread_id].valid = false;
+    auto& res = reservations_[thread_id];
+    if (res.valid) {
+        res.valid = false;
+        active_reservations_.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+bool Memory::is_atomic_word(GuestAddr addr) {
+    GuestAddr phys_addr = translate_address(addr);
+    return (phys_addr & 3) == 0 && !is_mmio(addr) && phys_addr + 3 < main_memory_size_;
+}
+
+bool Memory::compare_exchange_u32(GuestAddr addr, u32& expected, u32 desired) {
+    if (!is_atomic_word(addr)) {
+        expected = read_u32(addr);
+        return false;
+    }
+    
+    GuestAddr phys_addr = translate_address(addr);
+    std::atomic_ref<u32> word(*reinterpret_cast<u32*>(static_cast<u8*>(main_memory_) + phys_addr));
+    u32 swapped_expected = byte_swap(expected);
+    if (!word.compare_exchange_strong(swapped_expected, byte_swap(desired),
+                                      std::memory_order_acq_rel, std::memory_order_acquire)) {
+        expected = byte_swap(swapped_expected);
+        return false;
+    }
+    
+    notify_write(addr, 4);
+    return true;
 }
 
 void Memory::invalidate_reservations(GuestAddr addr, u64 size) {
-    std::lock_guard<std::mutex> lock(reservation_mutex_);
-    
-    // Check all thread reservations for overlap with the written range
-    for (u32 i = 0; i < MAX_THREADS; i++) {
-        auto& res = reservations_[i];
-        if (res.valid) {
-            // Check if write overlaps with reservation
-            GuestAddr res_end = res.addr + res.size;
-            GuestAddr write_end = addr + size;
-            if (addr < res_end && write_end > res.addr) {
-                res.valid = false;
-            }
-        }
+    if (size == 0) return;
+    
+    // Order the caller's store before the check (pairs with set_reservation)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (active_reservations_.load(std::memory_order_relaxed) == 0) return;
+    
+    u64 first = (addr & 0x1FFFFFFF) >> RESERVATION_GRANULE_SHIFT;
+    u64 last = ((addr & 0x1FFFFFFF) + size - 1) >> RESERVATION_GRANULE_SHIFT;
+    u64 count = std::min<u64>(last - first + 1, RESERVATION_TABLE_SIZE);
+    for (u64 i = 0; i < count; i++) {
+        reservation_versions_[(first + i) & (RESERVATION_TABLE_SIZE - 1)]
+            .fetch_add(2, std::memory_order_release);
     }
 }
 
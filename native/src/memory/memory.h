@@ -22,10 +22,17 @@ namespace memory {
     constexpr u32 MEM_PAGE_SHIFT = 12;
 }
 
+class MemoryHeatmap;
+
 // MMIO handler types
 using MmioReadHandler = std::function<u32(GuestAddr addr)>;
 using MmioWriteHandler = std::function<void(GuestAddr addr, u32 value)>;
 
+// Direct MMIO handlers: plain function pointers plus an opaque context,
+// dispatched straight from the MMIO page table
+using MmioReadFn = u32 (*)(void* context, GuestAddr addr);
+using MmioWriteFn = void (*)(void* context, GuestAddr addr, u32 value);
+
 /**
  * Memory region descriptor
  */
@@ -43,6 +50,24 @@ struct MemoryRegion {
     };
 };
 
+/**
+ * Page backing obtained for guest RAM
+ */
+enum class MemoryBacking {
+    Normal,             // Base pages
+    TransparentHuge,    // madvise(MADV_HUGEPAGE) on a THP-enabled kernel
+    HugeTlb,            // MAP_HUGETLB from the reserved huge page pool
+};
+
+inline const char* memory_backing_name(MemoryBacking backing) {
+    switch (backing) {
+        case MemoryBacking::Normal: return "normal pages";
+        case MemoryBacking::TransparentHuge: return "transparent huge pages";
+        case MemoryBacking::HugeTlb: return "hugetlb pages";
+    }
+    return "unknown";
+}
+
 /**
  * Page table entry (simplified)
  */
@@ -66,6 +91,18 @@ public:
     Memory();
     ~Memory();
     
+    /**
+     * Request huge page backing for guest RAM (and the fastmem window that
+     * maps it). Tries MAP_HUGETLB, then madvise(MADV_HUGEPAGE), then plain
+     * pages. Must be called before initialize().
+     */
+    void set_huge_pages(bool enable) { huge_pages_requested_ = enable; }
+    
+    /**
+     * Backing actually obtained by initialize()
+     */
+    MemoryBacking backing() const { return backing_; }
+    
     /**
      * Initialize memory subsystem
      */
@@ -104,6 +141,20 @@ public:
     void zero_bytes(GuestAddr addr, u64 size);
     void copy_bytes(GuestAddr dest, GuestAddr src, u64 size);
     
+    // ----- Byte-swapped bulk access (big-endian guest <-> host arrays) -----
+    //
+    // Equivalent to count read_uN/write_uN calls at consecutive addresses,
+    // but RAM runs are swapped with vector instructions a page at a time.
+    // MMIO pages and elements straddling a page fall back to single accesses.
+    
+    void read_swapped16(GuestAddr addr, u16* dst, u64 count);
+    void read_swapped32(GuestAddr addr, u32* dst, u64 count);
+    void read_swapped64(GuestAddr addr, u64* dst, u64 count);
+    
+    void write_swapped16(GuestAddr addr, const u16* src, u64 count);
+    void write_swapped32(GuestAddr addr, const u32* src, u64 count);
+    void write_swapped64(GuestAddr addr, const u64* src, u64 count);
+    
     // ----- Host pointer access (for DMA, etc.) -----
     
     /**
@@ -130,6 +181,18 @@ public:
      */
     void free(GuestAddr base);
     
+    /**
+     * Decommit a range: the host pages behind it go back to the OS and the
+     * guest reads zeros until it writes there again. Covers every page the
+     * range touches. Used for MEM_DECOMMIT and MEM_RESET.
+     */
+    void decommit(GuestAddr base, u64 size);
+    
+    /**
+     * Bytes of a range currently backed by host RAM (whole host pages)
+     */
+    u64 resident_bytes(GuestAddr base, u64 size) const;
+    
     /**
      * Protect memory region
      */
@@ -149,17 +212,62 @@ public:
                        MmioReadHandler read,
                        MmioWriteHandler write);
     
+    /**
+     * Register direct MMIO handlers for address range
+     * Preferred for hot register files (GPU, APU): no std::function
+     * indirection on dispatch.
+     */
+    void register_mmio(GuestAddr base, u64 size,
+                       MmioReadFn read, MmioWriteFn write, void* context);
+    
     /**
      * Unregister MMIO handlers
      */
     void unregister_mmio(GuestAddr base);
     
+    // ----- Shadowed GPU status registers -----
+    //
+    // Registers the GPU publishes here are answered from a lock-free
+    // shadow page instead of the MMIO handler, so polling them (ring read
+    // pointer, idle status, vblank counter) is a single atomic load. The
+    // JIT reads the page directly for 32-bit loads from the GPU window.
+    
+    static constexpr u32 SHADOW_REGISTER_COUNT = 0x10000;
+    static constexpr u64 SHADOW_REGISTER_VALID = 1ULL << 32;
+    
+    /**
+     * Publish a register value; reads of it bypass the MMIO handler from now on
+     * @param index Register index (dword offset into the GPU window)
+     */
+    void shadow_register(u32 index, u32 value) {
+        if (index < SHADOW_REGISTER_COUNT) {
+            register_shadow_[index].store(SHADOW_REGISTER_VALID | value, std::memory_order_release);
+        }
+    }
+    
+    /**
+     * Send reads of a register back to its MMIO handler
+     */
+    void unshadow_register(u32 index) {
+        if (index < SHADOW_REGISTER_COUNT) {
+            register_shadow_[index].store(0, std::memory_order_release);
+        }
+    }
+    
+    /**
+     * Shadow page base: one u64 per register, SHADOW_REGISTER_VALID set
+     * when published, value in the low 32 bits. Stable for Memory's lifetime.
+     */
+    const std::atomic<u64>* register_shadow() const { return register_shadow_.get(); }
+    
     // ----- Write tracking (for GPU texture invalidation) -----
     
     using WriteCallback = std::function<void(GuestAddr addr, u64 size)>;
+    using WatchId = u32;
     
     /**
      * Enable write tracking for address range
+     * The callback fires synchronously on every overlapping write.
      */
     void track_writes(GuestAddr base, u64 size, WriteCallback callback);
     
@@ -168,10 +276,121 @@ public:
      */
     void untrack_writes(GuestAddr base);
     
+    /**
+     * Watch a page range for writes without a per-store callback
+     * Writes only mark the touched pages pending; flush_page_writes()
+     * then reports each contiguous run of pending pages once.
+     * @return Watch id for unwatch_pages (never 0)
+     */
+    WatchId watch_pages(GuestAddr base, u64 size, WriteCallback callback);
+    
+    /**
+     * Remove a page watch (pending pages are dropped)
+     */
+    void unwatch_pages(WatchId id);
+    
+    /**
+     * Deliver pending page writes to watch_pages() callbacks, coalesced
+     * into one call per contiguous run of written pages. Ranges passed to
+     * the callback are physical and page-aligned.
+     */
+    void flush_page_writes();
+    
+    /**
+     * True if any write watcher covers the page containing addr
+     */
+    bool is_page_watched(GuestAddr addr) const {
+        u32 page = watch_page_index(addr);
+        return (watched_pages_[page >> 6].load(std::memory_order_relaxed) >> (page & 63)) & 1;
+    }
+    
+    // ----- Access heatmap -----
+    
+    /**
+     * Sample guest accesses into a per-page heatmap (see heatmap.h). Only
+     * the slow-path accessors feed it here; the JIT instruments fastmem
+     * accesses in blocks compiled while it is enabled (Cpu does the
+     * recompile). Disabled, the accessors pay a single relaxed load.
+     */
+    void set_heatmap_enabled(bool enabled);
+    
+    /**
+     * The heatmap while it is recording, else nullptr
+     */
+    MemoryHeatmap* active_heatmap() const {
+        return active_heatmap_.load(std::memory_order_acquire);
+    }
+    
+    /**
+     * Heatmap storage, kept with its counters after disabling (nullptr
+     * until first enabled)
+     */
+    MemoryHeatmap* heatmap() const { return heatmap_.get(); }
+    
+    // ----- Dirty page tracking -----
+    //
+    // Every 4KB physical page carries the generation in which it was last
+    // written. Each consumer (save states, texture/vertex caches, SMC
+    // detection) snapshots "pages written since my last snapshot" on its
+    // own schedule without disturbing the others.
+    
+    using DirtyConsumerId = u32;
+    
+    /**
+     * Register a dirty page consumer; tracking is enabled while any exist
+     * @return Consumer id (never 0). Only writes after this call are seen.
+     */
+    DirtyConsumerId register_dirty_consumer();
+    
+    /**
+     * Unregister a dirty page consumer
+     */
+    void unregister_dirty_consumer(DirtyConsumerId id);
+    
+    /**
+     * Collect physical page addresses written since this consumer's last
+     * snapshot (or registration), and start a new interval for it
+     */
+    void snapshot_dirty_pages(DirtyConsumerId id, std::vector<GuestAddr>& pages);
+    
+    /**
+     * Start a new interval for this consumer without collecting
+     */
+    void clear_dirty_pages(DirtyConsumerId id);
+    
+    /**
+     * Current write generation, and the generation a page was last written
+     * in. A cache that records dirty_generation() when it fills an entry
+     * can later test page_generation() > recorded to detect a write.
+     */
+    u32 dirty_generation() const { return dirty_generation_.load(std::memory_order_acquire); }
+    u32 page_generation(GuestAddr addr) const;
+    
+    /**
+     * Detect writes that bypass the slow path (JIT fastmem stores, host
+     * pointers) by write-protecting guest RAM and catching the first store
+     * to each page in a SIGSEGV handler. Requires fastmem.
+     */
+    Status set_fastmem_write_detection(bool enable);
+    bool fastmem_write_detection() const {
+        return fastmem_write_detection_.load(std::memory_order_acquire);
+    }
+    
     // ----- Atomic/reservation support (per-thread) -----
+    //
+    // Reservations cover a 128-byte granule, as on Xenon. Each granule has
+    // an atomic version counter that every store bumps by two; a
+    // reservation records the version seen by lwarx and stays valid while
+    // it is unchanged. A conditional store holds the granule by making the
+    // version odd until its data is written, so no other reservation taken
+    // meanwhile can succeed. No lock is shared between the hardware threads.
+    
+    static constexpr u32 RESERVATION_GRANULE_SHIFT = 7;
+    static constexpr u32 RESERVATION_GRANULE = 1u << RESERVATION_GRANULE_SHIFT;
     
     /**
      * Set reservation for lwarx/ldarx for a specific thread
+     * Must be called before the reserved value is loaded.
      * @param thread_id The hardware thread (0-5)
      * @param addr Guest address being reserved
      * @param size Size of reservation (4 or 8 bytes)
@@ -187,6 +406,15 @@ public:
      */
     bool check_reservation(u32 thread_id, GuestAddr addr, u32 size) const;
     
+    /**
+     * Perform stwcx./stdcx.: store if the reservation is still valid
+     * At most one thread can win a given reservation. The caller still
+     * clears its reservation afterwards.
+     * @param value Value to store (low 32 bits for size 4)
+     * @return true if the store was performed
+     */
+    bool store_conditional(u32 thread_id, GuestAddr addr, u32 size, u64 value);
+    
     /**
      * Clear reservation for a specific thread
      * @param thread_id The hardware thread (0-5)
@@ -194,13 +422,34 @@ public:
     void clear_reservation(u32 thread_id);
     
     /**
-     * Invalidate all reservations that overlap with an address range
-     * Called on every write to memory
+     * Host-side compare-and-swap on an aligned guest word, for HLE code
+     * that shares a lock word with the guest. Values are native (the
+     * byte swap is done here). A successful swap counts as a store.
+     * @param expected In: value to compare; out: current value on failure
+     * @return true if the word was replaced by desired
+     */
+    bool compare_exchange_u32(GuestAddr addr, u32& expected, u32 desired);
+    
+    /**
+     * True if compare_exchange_u32 can operate on addr: word aligned, in
+     * guest RAM and not MMIO. Elsewhere the swap always fails.
+     */
+    bool is_atomic_word(GuestAddr addr);
+    
+    /**
+     * Invalidate all reservations on granules overlapping an address range
+     * Called on every write to memory; free while no thread holds one
      * @param addr Start address of write
      * @param size Size of write
      */
     void invalidate_reservations(GuestAddr addr, u64 size);
-    
+
+    /**
+     * Number of threads currently holding a reservation. JIT fastmem
+     * stores read this (after a full barrier) to skip the invalidate call.
+     */
+    const std::atomic<u32>* active_reservation_count() const { return &active_reservations_; }
+
     // ----- Time base -----
     
     /**
@@ -223,10 +472,12 @@ public:
     
     /**
      * Handle fastmem fault (called from signal handler)
-     * Returns true if fault was handled (page mapped)
+     * Returns true if fault was handled (page mapped or unprotected)
+     * access_error: the page is mapped but the access was not permitted
+     * (SEGV_ACCERR), as opposed to an unmapped page
      * Note: MMIO addresses should use read_u32/write_u32, not fastmem
      */
-    bool handle_fault(void* fault_addr);
+    bool handle_fault(void* fault_addr, bool access_error = false);
     
 private:
     // Main RAM backing (512MB)
@@ -236,26 +487,119 @@ private:
     // Fastmem mapping
     void* fastmem_base_ = nullptr;
     u64 fastmem_size_ = 0;
+    void* fastmem_reservation_ = nullptr;   // fastmem_base_ is aligned within this
+    u64 fastmem_reservation_size_ = 0;
+    
+    // Huge page backing
+    bool huge_pages_requested_ = false;
+    MemoryBacking backing_ = MemoryBacking::Normal;
     
     // Page table (simplified - just tracks allocations)
     std::vector<PageEntry> page_table_;
     
     // MMIO handlers
+    struct MmioFunctions {
+        MmioReadHandler read;
+        MmioWriteHandler write;
+    };
     struct MmioRange {
         GuestAddr base;
         u64 size;
-        MmioReadHandler read;
-        MmioWriteHandler write;
+        MmioReadFn read;
+        MmioWriteFn write;
+        void* context;
+        std::unique_ptr<MmioFunctions> functions;  // Backs std::function registrations
     };
     std::vector<MmioRange> mmio_handlers_;
     
-    // Write tracking
-    struct WriteTrack {
+    // Page-granular dispatch for the 4MB GPU register window. The physical
+    // window (0x7FC00000) and its 0xC0000000/0xEC800000 aliases all index
+    // this table by (addr & 0x3FFFFF) >> 12.
+    //
+    // Accesses read the table without mutex_, so (un)registration builds a
+    // new immutable table and publishes it with one pointer store. Replaced
+    // tables stay allocated until shutdown since a reader may still be in
+    // one; registrations are rare, so they don't pile up.
+    static constexpr u32 MMIO_WINDOW_SIZE = 0x400000;
+    static constexpr u32 MMIO_WINDOW_PAGES = MMIO_WINDOW_SIZE >> memory::MEM_PAGE_SHIFT;
+    struct MmioPage {
+        MmioReadFn read = nullptr;
+        MmioWriteFn write = nullptr;
+        void* context = nullptr;
+        bool partial = false;   // Sub-page ranges present: resolve per access
+    };
+    struct MmioEntry {
         GuestAddr base;
         u64 size;
+        MmioReadFn read;
+        MmioWriteFn write;
+        void* context;
+    };
+    struct MmioTable {
+        std::array<MmioPage, MMIO_WINDOW_PAGES> pages{};
+        std::vector<MmioEntry> ranges;  // Copy of mmio_handlers_ for per-access lookups
+        u32 external_ranges = 0;        // Ranges outside the window
+    };
+    std::atomic<const MmioTable*> mmio_table_{nullptr};
+    std::vector<std::unique_ptr<MmioTable>> mmio_tables_;  // Current and replaced, under mutex_
+    // Handlers of unregistered ranges: replaced tables still pass them as
+    // the trampoline context, so they live exactly as long as those tables
+    std::vector<std::unique_ptr<MmioFunctions>> retired_mmio_functions_;
+    
+    // Published GPU status registers, indexed like the MMIO page table but per dword
+    std::unique_ptr<std::atomic<u64>[]> register_shadow_;
+    
+    // zero_bytes() ranges at least this large drop their host pages instead
+    // of writing zeros, so committed-but-untouched memory stays unbacked
+    static constexpr u64 LAZY_ZERO_MIN = 64 * KB;
+    
+    // Write tracking
+    // One bit per 4KB physical page says "someone watches this page", so an
+    // unwatched store costs a single bit test. Watchers themselves are only
+    // looked at once the bit is set.
+    static constexpr u32 WATCH_PAGE_COUNT =
+        static_cast<u32>(memory::MAIN_MEMORY_SIZE >> memory::MEM_PAGE_SHIFT);
+    struct WriteWatch {
+        WatchId id;
+        GuestAddr base;         // As registered (track_writes key)
+        u64 size;
+        u32 first_page;
+        u32 last_page;          // Inclusive
+        u64 phys_begin;         // Watched bytes as physical offsets [begin, end)
+        u64 phys_end;
+        bool deferred;          // watch_pages(): batched via flush_page_writes()
         WriteCallback callback;
+        std::vector<u64> pending;   // Deferred only: bit per page since first_page
+        bool has_pending = false;
+    };
+    std::array<std::atomic<u64>, WATCH_PAGE_COUNT / 64> watched_pages_{};
+    std::vector<u16> watch_refs_;   // Watchers per page, under watch_mutex_
+    std::vector<std::shared_ptr<WriteWatch>> write_watches_;
+    WatchId next_watch_id_ = 1;
+    mutable std::mutex watch_mutex_;
+    
+    // Access heatmap
+    std::unique_ptr<MemoryHeatmap> heatmap_;
+    std::atomic<MemoryHeatmap*> active_heatmap_{nullptr};
+    
+    // Dirty page tracking: per-page write generation, plus a per-64-page
+    // summary so snapshots skip untouched regions
+    std::unique_ptr<std::atomic<u32>[]> page_write_gen_;
+    std::unique_ptr<std::atomic<u32>[]> chunk_write_gen_;
+    std::atomic<u32> dirty_generation_{1};
+    std::atomic<bool> dirty_tracking_active_{false};
+    struct DirtyConsumer {
+        DirtyConsumerId id;
+        u32 since;              // First generation not yet snapshotted
     };
-    std::vector<WriteTrack> write_tracks_;
+    std::vector<DirtyConsumer> dirty_consumers_;
+    DirtyConsumerId next_dirty_consumer_id_ = 1;
+    std::mutex dirty_mutex_;
+    
+    // Fastmem write detection: bit set while a RAM page is read-only
+    std::atomic<bool> fastmem_write_detection_{false};
+    std::unique_ptr<std::atomic<u64>[]> fastmem_protected_;
+    std::atomic_flag fastmem_protect_lock_ = ATOMIC_FLAG_INIT;  // Taken in the fault handler
     
     // Memory regions (for query)
     std::vector<MemoryRegion> regions_;
@@ -264,25 +608,63 @@ private:
     mutable std::mutex mutex_;
     
     // Per-thread reservation state for atomic ops (lwarx/stwcx)
-    // Xbox 360 has 6 hardware threads, each maintains its own reservation
+    // Xbox 360 has 6 hardware threads, each maintains its own reservation.
+    // A slot is only touched by its own thread; stores from other threads
+    // communicate through the granule versions.
     static constexpr u32 MAX_THREADS = 6;
-    struct ThreadReservation {
+    struct alignas(64) ThreadReservation {
         GuestAddr addr = 0;
         u32 size = 0;
+        u32 granule = 0;
+        u32 version = 0;
         bool valid = false;
     };
     std::array<ThreadReservation, MAX_THREADS> reservations_;
-    mutable std::mutex reservation_mutex_;  // Separate lock for reservation access
+    
+    // Granule version counters, hashed by physical granule. Aliasing
+    // granules only cause spurious stwcx. failures, which the
+    // architecture allows.
+    static constexpr u32 RESERVATION_TABLE_SIZE = 1u << 16;
+    std::unique_ptr<std::atomic<u32>[]> reservation_versions_;
+    std::atomic<u32> active_reservations_{0};
+    
+    static u32 reservation_granule(GuestAddr addr) {
+        return ((addr & 0x1FFFFFFF) >> RESERVATION_GRANULE_SHIFT) & (RESERVATION_TABLE_SIZE - 1);
+    }
     
     // Time base counter
     std::atomic<u64> time_base_{0};
     
     // Internal helpers
     bool is_mmio(GuestAddr addr) const;
-    MmioRange* find_mmio(GuestAddr addr);
+    static const MmioEntry* find_mmio(const MmioTable& table, GuestAddr addr);
+    bool lookup_mmio(GuestAddr addr, GuestAddr& phys, MmioPage& page) const;
+    static bool gpu_window_offset(GuestAddr addr, u32& offset);
+    bool mmio_read(GuestAddr addr, u32& value) const;
+    bool mmio_write(GuestAddr addr, u32 value);
+    void rebuild_mmio_table();
+    
+    template <typename T> void read_swapped(GuestAddr addr, T* dst, u64 count);
+    template <typename T> void write_swapped(GuestAddr addr, const T* src, u64 count);
     void notify_write(GuestAddr addr, u64 size);
+    void sample_access(GuestAddr addr, bool is_write, bool is_mmio);
+    void discard_range(u64 offset, u64 size);
+    void notify_watchers(GuestAddr addr, u64 size, u32 first_page, u32 last_page);
+    bool any_page_watched(u32 first_page, u32 last_page) const;
+    WatchId add_watch(GuestAddr base, u64 size, WriteCallback callback, bool deferred);
+    void remove_watch_locked(size_t index);
+    void clear_watches();
+    void mark_pages_dirty(u32 first_page, u32 last_page);
+    u32 advance_dirty_interval(DirtyConsumerId id, u32& since);
+    void reprotect_fastmem_pages(u32 generation);
+    bool handle_write_protect_fault(GuestAddr guest_addr, bool access_error);
+    
+    static u32 watch_page_index(GuestAddr addr) {
+        return (addr & 0x1FFFFFFF) >> memory::MEM_PAGE_SHIFT;
+    }
     
     // Fastmem setup
+    void* map_guest_ram(void* addr, u64 size);
     Status setup_fastmem();
     void teardown_fastmem();
 };
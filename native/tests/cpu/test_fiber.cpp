@@ -0,0 +1,270 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Fiber and M:N Scheduler Tests
+ */
+
+#include <gtest/gtest.h>
+#include "cpu/xenon/fiber.h"
+#include "cpu/xenon/threading.h"
+#include "core/guest_clock.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace x360mu {
+namespace test {
+
+//=============================================================================
+// Fiber
+//=============================================================================
+
+TEST(FiberTest, ResumeSuspendFinish) {
+    if (!Fiber::supported()) GTEST_SKIP() << "No fiber support on this host";
+
+    std::vector<int> trace;
+    Fiber* self = nullptr;
+    Fiber fiber([&]() {
+        trace.push_back(1);
+        EXPECT_EQ(Fiber::current(), self);
+        self->suspend();
+        trace.push_back(3);
+    });
+    self = &fiber;
+    ASSERT_TRUE(fiber.valid());
+    EXPECT_EQ(Fiber::current(), nullptr);
+
+    fiber.resume();
+    EXPECT_FALSE(fiber.finished());
+    EXPECT_EQ(Fiber::current(), nullptr);
+    trace.push_back(2);
+
+    fiber.resume();
+    EXPECT_TRUE(fiber.finished());
+    EXPECT_EQ(trace, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(FiberTest, PreservesCalleeSavedState) {
+    if (!Fiber::supported()) GTEST_SKIP() << "No fiber support on this host";
+
+    // Values live across switches in both directions
+    volatile double outer = 1.5;
+    double inner_sum = 0.0;
+    Fiber* self = nullptr;
+    Fiber fiber([&]() {
+        double acc = 0.25;
+        for (int i = 0; i < 4; i++) {
+            acc *= 2.0;
+            self->suspend();
+        }
+        inner_sum = acc;
+    });
+    self = &fiber;
+
+    for (int i = 0; i < 5; i++) {
+        fiber.resume();
+        outer = outer + 1.0;
+    }
+    EXPECT_TRUE(fiber.finished());
+    EXPECT_DOUBLE_EQ(inner_sum, 4.0);
+    EXPECT_DOUBLE_EQ(outer, 6.5);
+}
+
+//=============================================================================
+// M:N Scheduler
+//=============================================================================
+
+class FiberSchedulerTest : public ::testing::Test {
+protected:
+    std::unique_ptr<ThreadScheduler> scheduler;
+
+    void start(SchedulingMode mode) {
+        scheduler = std::make_unique<ThreadScheduler>();
+        ASSERT_EQ(scheduler->initialize(nullptr, nullptr, nullptr, 0, mode), Status::Ok);
+    }
+
+    void TearDown() override {
+        if (scheduler) scheduler->shutdown();
+    }
+
+    static bool wait_for(const std::atomic<int>& counter, int target) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (counter.load() < target) {
+            if (std::chrono::steady_clock::now() > deadline) return false;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+};
+
+TEST_F(FiberSchedulerTest, HonoursAffinityMask) {
+    if (!Fiber::supported()) GTEST_SKIP() << "No fiber support on this host";
+    start(SchedulingMode::Fibers);
+    ASSERT_EQ(scheduler->scheduling_mode(), SchedulingMode::Fibers);
+
+    std::atomic<int> done{0};
+    GuestThread* t = scheduler->create_system_thread([&](GuestThread*) { done++; }, 1u << 4);
+    ASSERT_NE(t, nullptr);
+    EXPECT_NE(t->fiber, nullptr);
+    EXPECT_EQ(t->fiber_worker, 4u);
+    EXPECT_TRUE(wait_for(done, 1));
+}
+
+TEST_F(FiberSchedulerTest, TimedParkExpires) {
+    if (!Fiber::supported()) GTEST_SKIP() << "No fiber support on this host";
+    start(SchedulingMode::Fibers);
+
+    std::atomic<int> done{0};
+    std::atomic<long long> elapsed_us{0};
+    scheduler->create_system_thread([&](GuestThread* self) {
+        auto begin = std::chrono::steady_clock::now();
+        scheduler->park(self, 5000000);  // 5ms
+        elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+        done++;
+    }, 1);
+
+    ASSERT_TRUE(wait_for(done, 1));
+    EXPECT_GE(elapsed_us.load(), 5000);
+    EXPECT_LT(elapsed_us.load(), 1000000);
+}
+
+TEST_F(FiberSchedulerTest, ParkedFiberDoesNotBlockWorker) {
+    if (!Fiber::supported()) GTEST_SKIP() << "No fiber support on this host";
+    start(SchedulingMode::Fibers);
+
+    // Both fibers share worker 0; the second must run while the first is parked
+    std::atomic<int> done{0};
+    std::atomic<int> order{0};
+    int parked_saw = -1;
+    GuestThread* sleeper = scheduler->create_system_thread([&](GuestThread* self) {
+        scheduler->park(self);
+        parked_saw = order.load();
+        done++;
+    }, 1);
+    scheduler->create_system_thread([&](GuestThread*) {
+        order = 1;
+        scheduler->unpark(sleeper);
+        done++;
+    }, 1);
+
+    ASSERT_TRUE(wait_for(done, 2));
+    EXPECT_EQ(parked_saw, 1);
+    EXPECT_GT(scheduler->get_stats().fiber_switches, 0u);
+}
+
+TEST_F(FiberSchedulerTest, YieldInterleavesFibers) {
+    if (!Fiber::supported()) GTEST_SKIP() << "No fiber support on this host";
+    start(SchedulingMode::Fibers);
+
+    std::atomic<int> done{0};
+    std::atomic<bool> go{false};
+    std::vector<int> trace;
+    for (int id = 0; id < 2; id++) {
+        scheduler->create_system_thread([&, id](GuestThread* self) {
+            while (!go.load()) scheduler->yield(self);
+            for (int i = 0; i < 3; i++) {
+                trace.push_back(id);
+                scheduler->yield(self);
+            }
+            done++;
+        }, 1);
+    }
+
+    go = true;
+    ASSERT_TRUE(wait_for(done, 2));
+    ASSERT_EQ(trace.size(), 6u);
+    for (size_t i = 1; i < trace.size(); i++) {
+        EXPECT_NE(trace[i], trace[i - 1]);
+    }
+}
+
+//=============================================================================
+// Deterministic scheduling
+//=============================================================================
+
+namespace {
+
+// Two threads that yield and sleep; returns the order they ran in and the
+// virtual time of every step
+std::vector<std::pair<int, u64>> deterministic_trace(ThreadScheduler& scheduler) {
+    std::vector<std::pair<int, u64>> trace;
+    auto& clock = GuestClock::instance();
+    int done = 0;
+    for (int id = 0; id < 2; id++) {
+        scheduler.create_system_thread([&, id](GuestThread* self) {
+            for (int i = 0; i < 5; i++) {
+                trace.emplace_back(id, clock.cycles());
+                if ((i + id) % 2) {
+                    scheduler.park(self, (id + 1) * 300000);  // 0.3 / 0.6 ms
+                } else {
+                    scheduler.yield(self);
+                }
+            }
+            done++;
+        });
+    }
+    for (int slice = 0; slice < 100 && done < 2; slice++) {
+        scheduler.run(cpu::CLOCK_SPEED / 1000);  // 1ms of guest time
+    }
+    EXPECT_EQ(done, 2);
+    return trace;
+}
+
+} // namespace
+
+TEST_F(FiberSchedulerTest, DeterministicRunsRepeat) {
+    if (!Fiber::supported()) GTEST_SKIP() << "No fiber support on this host";
+
+    start(SchedulingMode::Deterministic);
+    ASSERT_EQ(scheduler->scheduling_mode(), SchedulingMode::Deterministic);
+    EXPECT_TRUE(GuestClock::instance().is_virtual());
+    auto first = deterministic_trace(*scheduler);
+    u64 first_cycles = GuestClock::instance().cycles();
+    scheduler->shutdown();
+    EXPECT_FALSE(GuestClock::instance().is_virtual());
+
+    start(SchedulingMode::Deterministic);
+    auto second = deterministic_trace(*scheduler);
+
+    ASSERT_EQ(first.size(), 10u);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first_cycles, GuestClock::instance().cycles());
+}
+
+TEST_F(FiberSchedulerTest, DeterministicParkSkipsIdleTime) {
+    if (!Fiber::supported()) GTEST_SKIP() << "No fiber support on this host";
+    start(SchedulingMode::Deterministic);
+
+    // A 10 second park ends as soon as nothing else can run, at its
+    // virtual deadline
+    auto& clock = GuestClock::instance();
+    u64 woke_ns = 0;
+    scheduler->create_system_thread([&](GuestThread* self) {
+        scheduler->park(self, 10000000000ULL);
+        woke_ns = clock.now_ns();
+    });
+
+    auto begin = std::chrono::steady_clock::now();
+    u64 advanced = scheduler->run(cpu::CLOCK_SPEED * 20);
+    auto host_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+
+    EXPECT_GE(woke_ns, 10000000000ULL);
+    EXPECT_LT(woke_ns, 10001000000ULL);
+    EXPECT_EQ(advanced, cpu::CLOCK_SPEED * 20);
+    EXPECT_LT(host_ms, 1000);
+}
+
+TEST(GuestClockTest, CycleConversions) {
+    EXPECT_EQ(GuestClock::cycles_to_ns(cpu::CLOCK_SPEED), 1000000000ULL);
+    EXPECT_EQ(GuestClock::ns_to_cycles(1000000000ULL), cpu::CLOCK_SPEED);
+    EXPECT_EQ(GuestClock::ns_to_cycles(1), 4u);  // 3.2 cycles, rounded up
+    // A day of guest time does not overflow
+    u64 day_ns = 86400ULL * 1000000000ULL;
+    EXPECT_EQ(GuestClock::cycles_to_ns(GuestClock::ns_to_cycles(day_ns)), day_ns);
+}
+
+} // namespace test
+} // namespace x360mu
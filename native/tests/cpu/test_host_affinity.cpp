@@ -0,0 +1,96 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Host Core Placement Tests
+ */
+
+#include <gtest/gtest.h>
+#include "cpu/xenon/host_affinity.h"
+#include "cpu/xenon/threading.h"
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace x360mu {
+namespace test {
+
+static u64 cpu_bit(u32 cpu) { return 1ULL << cpu; }
+
+TEST(HostAffinityTest, BigLittleLayout) {
+    // 4 little cores, 3 big cores, 1 prime core (typical phone SoC)
+    std::vector<HostCpu> cpus = {
+        {0, 325}, {1, 325}, {2, 325}, {3, 325},
+        {4, 870}, {5, 870}, {6, 870}, {7, 1024},
+    };
+    HostAffinity affinity;
+    affinity.configure(HostAffinityConfig{}, cpus);
+    ASSERT_TRUE(affinity.enabled());
+
+    // Main hardware thread on the prime core, services on the first big core
+    EXPECT_EQ(affinity.hw_thread_cpus(0), cpu_bit(7));
+    EXPECT_EQ(affinity.service_cpus(), cpu_bit(4));
+    EXPECT_EQ(affinity.hw_thread_cpus(1), cpu_bit(5));
+    EXPECT_EQ(affinity.hw_thread_cpus(2), cpu_bit(6));
+    EXPECT_EQ(affinity.hw_thread_cpus(3), cpu_bit(0));
+    EXPECT_EQ(affinity.hw_thread_cpus(5), cpu_bit(2));
+
+    // Unrestricted guest threads never share the service core
+    u64 guest = affinity.guest_cpus(kAllThreads);
+    EXPECT_EQ(guest & affinity.service_cpus(), 0u);
+    EXPECT_EQ(affinity.guest_cpus(kCore0Thread0 | kCore0Thread1), cpu_bit(7) | cpu_bit(5));
+    EXPECT_EQ(affinity.describe(), "hw0=7 hw1=5 hw2=6 hw3=0 hw4=1 hw5=2 service=4");
+}
+
+TEST(HostAffinityTest, OverridesAndSmallHosts) {
+    std::vector<HostCpu> quad = {{0, 1}, {1, 1}, {2, 1}, {3, 1}};
+
+    HostAffinityConfig config;
+    config.hw_thread_cpus[0] = cpu_bit(3);
+    config.service_cpus = cpu_bit(0) | cpu_bit(9);  // CPU 9 is not usable
+    HostAffinity affinity;
+    affinity.configure(config, quad);
+    EXPECT_EQ(affinity.hw_thread_cpus(0), cpu_bit(3));
+    EXPECT_EQ(affinity.service_cpus(), cpu_bit(0));
+    EXPECT_EQ(affinity.hw_thread_cpus(1), cpu_bit(2));  // Auto: after cpu0, service cpu1
+
+    // Two CPUs: no core to spare for services, they float
+    affinity.configure(HostAffinityConfig{}, {{0, 1}, {1, 1}});
+    EXPECT_EQ(affinity.hw_thread_cpus(0), cpu_bit(0));
+    EXPECT_EQ(affinity.hw_thread_cpus(4), cpu_bit(1));
+    EXPECT_EQ(affinity.service_cpus(), cpu_bit(0) | cpu_bit(1));
+
+    // One CPU, or disabled: nothing is pinned
+    affinity.configure(HostAffinityConfig{}, {{0, 1}});
+    EXPECT_FALSE(affinity.enabled());
+    EXPECT_EQ(affinity.guest_cpus(kAllThreads), 0u);
+    config.enabled = false;
+    affinity.configure(config, quad);
+    EXPECT_FALSE(affinity.enabled());
+    EXPECT_EQ(affinity.describe(), "unpinned");
+}
+
+#if defined(__linux__)
+TEST(HostAffinityTest, PinsCallingThread) {
+    auto cpus = HostAffinity::detect_cpus();
+    ASSERT_FALSE(cpus.empty());
+    u32 target = cpus.back().id;
+
+    bool pinned = false;
+    int running_on = -1;
+    std::thread([&]() {
+        pinned = HostAffinity::pin_thread(HostAffinity::current_thread_id(), cpu_bit(target));
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        sched_getaffinity(0, sizeof(set), &set);
+        running_on = CPU_COUNT(&set) == 1 && CPU_ISSET(target, &set) ? static_cast<int>(target) : -1;
+    }).join();
+
+    EXPECT_TRUE(pinned);
+    EXPECT_EQ(running_on, static_cast<int>(target));
+}
+#endif
+
+} // namespace test
+} // namespace x360mu
@@ -122,6 +122,21 @@ protected:
         return (36 << 26) | (rs << 21) | (ra << 16) | (static_cast<u16>(d));
     }
 
+    // lmw rD, D(rA) (opcode 46)
+    static u32 encode_lmw(u8 rd, u8 ra, s16 d) {
+        return (46 << 26) | (rd << 21) | (ra << 16) | (static_cast<u16>(d));
+    }
+
+    // stmw rS, D(rA) (opcode 47)
+    static u32 encode_stmw(u8 rs, u8 ra, s16 d) {
+        return (47 << 26) | (rs << 21) | (ra << 16) | (static_cast<u16>(d));
+    }
+
+    // dcbz rA, rB (opcode 31, xo 1014); l = 1 encodes dcbz128
+    static u32 encode_dcbz(u8 ra, u8 rb, u8 l = 0) {
+        return (31 << 26) | (l << 21) | (ra << 16) | (rb << 11) | (1014 << 1);
+    }
+
     // lbz rD, D(rA) (opcode 34)
     static u32 encode_lbz(u8 rd, u8 ra, s16 d) {
         return (34 << 26) | (rd << 21) | (ra << 16) | (static_cast<u16>(d));
@@ -434,6 +449,76 @@ TEST_F(InterpreterExtTest, LoadStore_Sequence) {
     EXPECT_EQ(memory->read_u32(addr), 150u);
 }
 
+TEST_F(InterpreterExtTest, Lmw_LoadsThroughR31) {
+    GuestAddr addr = 0x20000;
+    for (u32 i = 0; i < 8; i++) {
+        memory->write_u32(addr + i * 4, 0x11110000 + i);
+    }
+    ctx.gpr[3] = addr;
+    ctx.gpr[24] = 0xFFFFFFFFFFFFFFFFULL;
+    execute_instruction(encode_lmw(24, 3, 0));
+    for (u32 i = 0; i < 8; i++) {
+        EXPECT_EQ(ctx.gpr[24 + i], 0x11110000ULL + i);  // Zero-extended
+    }
+}
+
+TEST_F(InterpreterExtTest, Stmw_StoresThroughR31) {
+    GuestAddr addr = 0x20000;
+    memory->write_u32(addr + 7 * 4, 0xAAAAAAAA);  // Word just past the run
+    for (u32 i = 0; i < 7; i++) {
+        ctx.gpr[25 + i] = 0xFFFFFFFF00000000ULL | (0x22220000 + i);
+    }
+    ctx.gpr[3] = addr;
+    execute_instruction(encode_stmw(25, 3, 0));
+    for (u32 i = 0; i < 7; i++) {
+        EXPECT_EQ(memory->read_u32(addr + i * 4), 0x22220000u + i);
+    }
+    EXPECT_EQ(memory->read_u32(addr + 7 * 4), 0xAAAAAAAAu);
+}
+
+TEST_F(InterpreterExtTest, Stmw_Lmw_VirtualAddress) {
+    // Usermode virtual addresses mirror physical RAM
+    ctx.gpr[30] = 0x12345678;
+    ctx.gpr[31] = 0x9ABCDEF0;
+    ctx.gpr[3] = 0x80020000;
+    execute_instruction(encode_stmw(30, 3, 0x10));
+    EXPECT_EQ(memory->read_u32(0x20010), 0x12345678u);
+    EXPECT_EQ(memory->read_u32(0x20014), 0x9ABCDEF0u);
+
+    ctx.gpr[30] = ctx.gpr[31] = 0;
+    ctx.pc = 0x10000;
+    execute_instruction(encode_lmw(30, 3, 0x10));
+    EXPECT_EQ(ctx.gpr[30], 0x12345678ULL);
+    EXPECT_EQ(ctx.gpr[31], 0x9ABCDEF0ULL);
+}
+
+TEST_F(InterpreterExtTest, Dcbz_Zeros32ByteBlock) {
+    GuestAddr addr = 0x20000;
+    for (u32 i = 0; i < 64; i += 4) {
+        memory->write_u32(addr + i, 0xFFFFFFFF);
+    }
+    ctx.gpr[3] = addr;
+    ctx.gpr[4] = 0x14;  // Unaligned, rounds down to the block
+    execute_instruction(encode_dcbz(3, 4));
+    for (u32 i = 0; i < 32; i += 4) {
+        EXPECT_EQ(memory->read_u32(addr + i), 0u);
+    }
+    EXPECT_EQ(memory->read_u32(addr + 32), 0xFFFFFFFFu);
+}
+
+TEST_F(InterpreterExtTest, Dcbz128_ZerosCacheLine) {
+    GuestAddr addr = 0x20000;
+    for (u32 i = 0; i < 256; i += 4) {
+        memory->write_u32(addr + i, 0xFFFFFFFF);
+    }
+    ctx.gpr[3] = 0x80000000 + addr + 0x44;  // Virtual, mid-line
+    execute_instruction(encode_dcbz(0, 3, 1));
+    for (u32 i = 0; i < 128; i += 4) {
+        EXPECT_EQ(memory->read_u32(addr + i), 0u);
+    }
+    EXPECT_EQ(memory->read_u32(addr + 128), 0xFFFFFFFFu);
+}
+
 //=============================================================================
 // Rotate/Mask Operations
 //=============================================================================
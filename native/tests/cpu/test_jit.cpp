@@ -12,9 +12,12 @@
 
 #include <gtest/gtest.h>
 #include <chrono>
+#include <set>
+#include <thread>
 #include "../../src/cpu/jit/jit.h"
 #include "../../src/memory/memory.h"
 #include "../../src/cpu/xenon/cpu.h"
+#include "../../src/cpu/xenon/profiler.h"
 
 namespace x360mu {
 namespace test {
@@ -118,6 +121,18 @@ protected:
         return (44 << 26) | (rs << 21) | (ra << 16) | (offset & 0xFFFF);
     }
     
+    static u32 ppc_lmw(int rd, int ra, s16 offset) {
+        return (46 << 26) | (rd << 21) | (ra << 16) | (offset & 0xFFFF);
+    }
+    
+    static u32 ppc_stmw(int rs, int ra, s16 offset) {
+        return (47 << 26) | (rs << 21) | (ra << 16) | (offset & 0xFFFF);
+    }
+    
+    static u32 ppc_dcbz(int ra, int rb, bool line128 = false) {
+        return (31 << 26) | ((line128 ? 1 : 0) << 21) | (ra << 16) | (rb << 11) | (1014 << 1);
+    }
+    
     static u32 ppc_b(s32 offset, bool link = false, bool absolute = false) {
         return (18 << 26) | (offset & 0x03FFFFFC) | (absolute ? 2 : 0) | (link ? 1 : 0);
     }
@@ -375,6 +390,33 @@ TEST_F(ARM64EmitterTest, EmitByteReverse) {
     ASSERT_EQ(emit_->size(), 12);
 }
 
+TEST_F(ARM64EmitterTest, EmitByteReverse32) {
+    emit_->REV_32(1, 1);
+    EXPECT_EQ(get_inst(0), 0x5AC00821u);  // rev w1, w1
+}
+
+TEST_F(ARM64EmitterTest, EmitPairLoadStore32) {
+    emit_->LDP_u32(1, 4, 3, 8);
+    emit_->STP_u32(1, 5, 4, -8);
+    emit_->STP(arm64::XZR, arm64::XZR, 0, 112);
+    
+    EXPECT_EQ(get_inst(0), 0x29411061u);  // ldp w1, w4, [x3, #8]
+    EXPECT_EQ(get_inst(1), 0x293F1481u);  // stp w1, w5, [x4, #-8]
+    EXPECT_EQ(get_inst(2), 0xA9077C1Fu);  // stp xzr, xzr, [x0, #112]
+}
+
+TEST_F(ARM64EmitterTest, EmitLogicalImmediate) {
+    emit_->AND_imm(0, 1, 0xFFFF);
+    emit_->AND_imm(0, 1, 0x3F);
+    emit_->AND_imm(0, 0, ~3ULL);
+    emit_->AND_imm(0, 1, 0x1FFFFFFF);
+    
+    EXPECT_EQ(get_inst(0), 0x92403C20u);  // and x0, x1, #0xffff
+    EXPECT_EQ(get_inst(1), 0x92401420u);  // and x0, x1, #0x3f
+    EXPECT_EQ(get_inst(2), 0x927EF400u);  // and x0, x0, #0xfffffffffffffffc
+    EXPECT_EQ(get_inst(3), 0x92407020u);  // and x0, x1, #0x1fffffff
+}
+
 TEST_F(ARM64EmitterTest, EmitExtend) {
     emit_->SXTB(0, 1);
     emit_->SXTH(2, 3);
@@ -662,6 +704,27 @@ TEST_F(JitCompilerTest, BlockCacheHit) {
     EXPECT_GE(stats.cache_hits, 1);
 }
 
+TEST_F(JitCompilerTest, DispatchTableHit) {
+    write_ppc_inst(CODE_BASE, ppc_addi(3, 0, 7));
+    write_ppc_inst(CODE_BASE + 4, ppc_blr());
+    
+    // First run misses the dispatch table and publishes the block
+    ctx_.pc = CODE_BASE;
+    jit_->execute(ctx_, 100);
+    EXPECT_GE(jit_->get_stats().dispatch_misses, 1);
+    EXPECT_EQ(jit_->get_stats().dispatch_hits, 0);
+    
+    // Second run is entered straight from the generated dispatcher
+    ctx_.pc = CODE_BASE;
+    ctx_.gpr[3] = 0;
+    ctx_.running = true;
+    ctx_.interrupted = false;
+    jit_->execute(ctx_, 100);
+    
+    EXPECT_EQ(ctx_.gpr[3], 7);
+    EXPECT_GE(jit_->get_stats().dispatch_hits, 1);
+}
+
 TEST_F(JitCompilerTest, InvalidateOnWrite) {
     write_ppc_inst(CODE_BASE, ppc_addi(3, 0, 1));
     write_ppc_inst(CODE_BASE + 4, ppc_blr());
@@ -708,6 +771,68 @@ TEST_F(JitCompilerTest, FlushCache) {
     EXPECT_EQ(stats2.blocks_compiled, 0);
 }
 
+TEST_F(JitCompilerTest, ParallelCompilation) {
+    constexpr int kThreads = 6;
+    constexpr int kBlocks = 64;
+    for (int i = 0; i < kBlocks; i++) {
+        GuestAddr addr = CODE_BASE + i * 8;
+        write_ppc_inst(addr, ppc_addi(3, 0, i));
+        write_ppc_inst(addr + 4, ppc_blr());
+    }
+    
+    // Every thread compiles every block; each address must be published once
+    std::vector<std::vector<void*>> code(kThreads, std::vector<void*>(kBlocks));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < kBlocks; i++) {
+                int block = (i + t * 11) % kBlocks;
+                code[t][block] = jit_->lookup_block_for_dispatch(CODE_BASE + block * 8);
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    
+    std::set<void*> unique_code;
+    for (int i = 0; i < kBlocks; i++) {
+        ASSERT_NE(code[0][i], nullptr);
+        for (int t = 1; t < kThreads; t++) {
+            EXPECT_EQ(code[t][i], code[0][i]);
+        }
+        unique_code.insert(code[0][i]);
+    }
+    EXPECT_EQ(unique_code.size(), static_cast<size_t>(kBlocks));
+    EXPECT_EQ(jit_->get_stats().blocks_compiled, static_cast<u64>(kBlocks));
+}
+
+TEST_F(JitCompilerTest, ProfilerCountsExecutedBlocks) {
+    OpcodeProfiler profiler;
+    profiler.set_enabled(true);
+    jit_->set_profiler(&profiler);
+    
+    write_ppc_inst(CODE_BASE, ppc_addi(3, 0, 5));
+    write_ppc_inst(CODE_BASE + 4, ppc_blr());
+    
+    for (int i = 0; i < 3; i++) {
+        ctx_.pc = CODE_BASE;
+        ctx_.running = true;
+        ctx_.interrupted = false;
+        jit_->execute(ctx_, 100);
+    }
+    
+    auto blocks = profiler.hot_blocks();
+    ASSERT_EQ(blocks.size(), 1u);
+    EXPECT_EQ(blocks[0].start, CODE_BASE);
+    EXPECT_EQ(blocks[0].executions, 3u);
+    
+    auto opcodes = profiler.opcode_counts();
+    ASSERT_EQ(opcodes.size(), 2u);
+    EXPECT_EQ(opcodes[0].count, 3u);
+    EXPECT_EQ(jit_->get_stats().dispatch_hits, 0u);
+    
+    jit_->set_profiler(nullptr);
+}
+
 TEST_F(JitCompilerTest, CompileMtspr) {
     write_ppc_inst(CODE_BASE, ppc_addi(3, 0, 0x1234));
     write_ppc_inst(CODE_BASE + 4, ppc_mtspr(8, 3));  // mtlr r3
@@ -797,6 +922,59 @@ TEST_F(JitCompilerTest, CompileLwzStw) {
     EXPECT_EQ(ctx_.gpr[3], 0x12345678);
 }
 
+TEST_F(JitCompilerTest, CompileLmwStmw) {
+    // stmw r25, 0(r4) then lmw r25, 0x40(r4) over a copy of the run
+    for (int r = 25; r < 32; r++) {
+        ctx_.gpr[r] = 0xFFFFFFFF00000000ULL | (0x01020300 + r);
+    }
+    memory_->write_u32(DATA_BASE + 7 * 4, 0xAAAAAAAA);
+    
+    write_ppc_inst(CODE_BASE, ppc_addis(4, 0, DATA_BASE >> 16));
+    write_ppc_inst(CODE_BASE + 4, ppc_ori(4, 4, DATA_BASE & 0xFFFF));
+    write_ppc_inst(CODE_BASE + 8, ppc_stmw(25, 4, 0));
+    write_ppc_inst(CODE_BASE + 12, ppc_blr());
+    
+    ctx_.pc = CODE_BASE;
+    jit_->execute(ctx_, 100);
+    
+    for (int r = 25; r < 32; r++) {
+        EXPECT_EQ(memory_->read_u32(DATA_BASE + (r - 25) * 4), 0x01020300u + r);
+        memory_->write_u32(DATA_BASE + 0x40 + (r - 25) * 4, 0x0A0B0C00 + r);
+    }
+    EXPECT_EQ(memory_->read_u32(DATA_BASE + 7 * 4), 0xAAAAAAAAu);  // Odd tail is one word
+    
+    write_ppc_inst(CODE_BASE + 16, ppc_addis(4, 0, DATA_BASE >> 16));
+    write_ppc_inst(CODE_BASE + 20, ppc_ori(4, 4, DATA_BASE & 0xFFFF));
+    write_ppc_inst(CODE_BASE + 24, ppc_lmw(25, 4, 0x40));
+    write_ppc_inst(CODE_BASE + 28, ppc_blr());
+    
+    ctx_.pc = CODE_BASE + 16;
+    jit_->execute(ctx_, 100);
+    
+    for (int r = 25; r < 32; r++) {
+        EXPECT_EQ(ctx_.gpr[r], 0x0A0B0C00ULL + r);  // Zero-extended
+    }
+}
+
+TEST_F(JitCompilerTest, CompileDcbz128) {
+    for (u32 i = 0; i < 256; i += 4) {
+        memory_->write_u32(DATA_BASE + i, 0xFFFFFFFF);
+    }
+    
+    write_ppc_inst(CODE_BASE, ppc_addis(4, 0, DATA_BASE >> 16));
+    write_ppc_inst(CODE_BASE + 4, ppc_ori(4, 4, 0x44));
+    write_ppc_inst(CODE_BASE + 8, ppc_dcbz(0, 4, true));
+    write_ppc_inst(CODE_BASE + 12, ppc_blr());
+    
+    ctx_.pc = CODE_BASE;
+    jit_->execute(ctx_, 100);
+    
+    for (u32 i = 0; i < 128; i += 4) {
+        EXPECT_EQ(memory_->read_u32(DATA_BASE + i), 0u);
+    }
+    EXPECT_EQ(memory_->read_u32(DATA_BASE + 128), 0xFFFFFFFFu);
+}
+
 TEST_F(JitCompilerTest, CompileLbz) {
     memory_->write_u8(DATA_BASE, 0xAB);
     
@@ -0,0 +1,111 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ * 
+ * Opcode Profiler Tests
+ */
+
+#include <gtest/gtest.h>
+#include "cpu/xenon/cpu.h"
+#include "cpu/xenon/profiler.h"
+#include "memory/memory.h"
+
+namespace x360mu {
+namespace test {
+
+class OpcodeProfilerTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Memory> memory;
+    std::unique_ptr<Interpreter> interp;
+    OpcodeProfiler profiler;
+    ThreadContext ctx;
+    
+    static constexpr GuestAddr CODE = 0x10000;
+    
+    void SetUp() override {
+        memory = std::make_unique<Memory>();
+        ASSERT_EQ(memory->initialize(), Status::Ok);
+        
+        interp = std::make_unique<Interpreter>(memory.get());
+        ctx.reset();
+        ctx.running = true;
+        ctx.pc = CODE;
+    }
+    
+    void TearDown() override {
+        memory->shutdown();
+    }
+    
+    static u32 encode_addi(u8 rd, u8 ra, s16 simm) {
+        return (14 << 26) | (rd << 21) | (ra << 16) | static_cast<u16>(simm);
+    }
+    
+    static u32 encode_add(u8 rd, u8 ra, u8 rb) {
+        return (31 << 26) | (rd << 21) | (ra << 16) | (rb << 11) | (266 << 1);
+    }
+    
+    static u32 encode_b(s32 offset) {
+        return (18 << 26) | (static_cast<u32>(offset) & 0x03FFFFFC);
+    }
+};
+
+TEST_F(OpcodeProfilerTest, DisabledRecordsNothing) {
+    interp->set_profiler(&profiler);
+    memory->write_u32(CODE, encode_addi(3, 0, 1));
+    
+    interp->execute(ctx, 1);
+    
+    EXPECT_TRUE(profiler.opcode_counts().empty());
+    EXPECT_TRUE(profiler.hot_blocks().empty());
+}
+
+TEST_F(OpcodeProfilerTest, CountsOpcodesAndBlocks) {
+    profiler.set_enabled(true);
+    interp->set_profiler(&profiler);
+    
+    // Loop: addi, addi, add, b -12 (back to start)
+    memory->write_u32(CODE + 0, encode_addi(3, 3, 1));
+    memory->write_u32(CODE + 4, encode_addi(4, 4, 2));
+    memory->write_u32(CODE + 8, encode_add(5, 3, 4));
+    memory->write_u32(CODE + 12, encode_b(-12));
+    
+    interp->execute(ctx, 40);  // 10 iterations
+    
+    EXPECT_EQ(ctx.gpr[3], 10u);
+    
+    auto opcodes = profiler.opcode_counts();
+    ASSERT_EQ(opcodes.size(), 3u);
+    EXPECT_EQ(opcodes[0].key, OpcodeProfiler::opcode_key(Decoder::decode(encode_addi(0, 0, 0))));
+    EXPECT_EQ(opcodes[0].count, 20u);
+    EXPECT_EQ(opcodes[1].count, 10u);
+    EXPECT_EQ(opcodes[2].count, 10u);
+    
+    auto blocks = profiler.hot_blocks();
+    ASSERT_EQ(blocks.size(), 1u);
+    EXPECT_EQ(blocks[0].start, CODE);
+    EXPECT_EQ(blocks[0].instructions, 4u);
+    EXPECT_EQ(blocks[0].executions, 10u);
+    EXPECT_EQ(blocks[0].cycles, 40u);
+}
+
+TEST_F(OpcodeProfilerTest, FallbacksSortedByCount) {
+    profiler.set_enabled(true);
+    profiler.record_fallback(0x82000000, 0x7C0004AC);  // sync
+    profiler.record_fallback(0x82000010, 0x7C00002C);  // icbt-ish
+    profiler.record_fallback(0x82000010, 0x7C00002C);
+    
+    auto fallbacks = profiler.fallbacks();
+    ASSERT_EQ(fallbacks.size(), 2u);
+    EXPECT_EQ(fallbacks[0].pc, 0x82000010u);
+    EXPECT_EQ(fallbacks[0].count, 2u);
+    EXPECT_EQ(fallbacks[1].pc, 0x82000000u);
+    
+    std::string report = profiler.report();
+    EXPECT_NE(report.find("JIT interpreter fallbacks (2)"), std::string::npos);
+    EXPECT_NE(report.find("82000010"), std::string::npos);
+    
+    profiler.reset();
+    EXPECT_TRUE(profiler.fallbacks().empty());
+}
+
+} // namespace test
+} // namespace x360mu
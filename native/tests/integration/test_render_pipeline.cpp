@@ -49,6 +49,12 @@ static u32 pm4_type3(u16 opcode, u16 count) {
     return (3u << 30) | (static_cast<u32>(opcode) << 8) | ((count - 1) & 0x3F);
 }
 
+// PM4 Type 3 as the command processor decodes it (opcode in bits 0-7,
+// data dword count in bits 16-29)
+static u32 pm4_type3_cmd(PM4Opcode opcode, u16 count) {
+    return (3u << 30) | (static_cast<u32>(count) << 16) | static_cast<u32>(opcode);
+}
+
 // ============================================================================
 // Test Fixture: Memory + Command Processor (headless, no Vulkan)
 // ============================================================================
@@ -566,6 +572,105 @@ TEST_F(GpuIntegrationTest, ProcessCommands_AfterSurfaceLoss_StillParsesRingBuffe
     EXPECT_EQ(memory_->read_u32(kReadbackAddr), 2u);
 }
 
+// ============================================================================
+// 7b. Asynchronous command processing (recorded ring streams)
+// ============================================================================
+
+class GpuAsyncCommandTest : public GpuIntegrationTest {
+protected:
+    static constexpr GuestAddr kRingBase = 0x00804000;
+    static constexpr GuestAddr kReadbackAddr = 0x00805000;
+    static constexpr u64 kTimeoutNs = 2000000000ULL;  // 2s
+
+    u32 wptr_ = 0;
+
+    void SetUp() override {
+        memory_ = std::make_unique<Memory>();
+        ASSERT_EQ(memory_->initialize(), Status::Ok);
+
+        gpu_ = std::make_unique<Gpu>();
+        GpuConfig config;
+        config.use_vulkan = true;
+        config.cache_path = "";
+        config.async_commands = true;
+        ASSERT_EQ(gpu_->initialize(memory_.get(), config), Status::Ok);
+        ASSERT_TRUE(gpu_->async_commands());
+
+        memory_->write_u32(kReadbackAddr, 0);
+        gpu_->write_register(xenos_reg::CP_RB_BASE, kRingBase);
+        gpu_->write_register(xenos_reg::CP_RB_CNTL, 7);  // 256-byte ring buffer
+        gpu_->write_register(xenos_reg::CP_RB_RPTR_ADDR, kReadbackAddr);
+        gpu_->write_register(xenos_reg::CP_RB_RPTR, 0);
+    }
+
+    void Emit(u32 dword) {
+        memory_->write_u32(kRingBase + wptr_ * 4, dword);
+        wptr_++;
+    }
+
+    // Publish the recorded stream the way the guest does: move the write
+    // pointer, then queue a fence behind it
+    void Submit(u64 fence) {
+        gpu_->write_register(xenos_reg::CP_RB_WPTR, wptr_);
+        gpu_->cpu_signal_fence(fence);
+    }
+};
+
+TEST_F(GpuAsyncCommandTest, WritePointer_DrainsOnCommandThread) {
+    static constexpr GuestAddr kDest = 0x00806000;
+    memory_->write_u32(kDest, 0);
+
+    Emit(pm4_type3_cmd(PM4Opcode::MEM_WRITE, 2));
+    Emit(kDest);
+    Emit(0xCAFEF00D);
+    Submit(1);
+
+    // No process_commands() call: the write pointer move alone wakes the thread
+    ASSERT_TRUE(gpu_->wait_for_gpu_fence(1, kTimeoutNs));
+    EXPECT_EQ(memory_->read_u32(kDest), 0xCAFEF00Du);
+    EXPECT_EQ(memory_->read_u32(kReadbackAddr), wptr_);
+}
+
+TEST_F(GpuAsyncCommandTest, WaitRegMem_HoldsLaterMemWrite) {
+    static constexpr GuestAddr kFlag = 0x00806000;
+    static constexpr GuestAddr kDest = 0x00806010;
+    memory_->write_u32(kFlag, 0);
+    memory_->write_u32(kDest, 0);
+
+    Emit(pm4_type3_cmd(PM4Opcode::WAIT_REG_MEM, 5));
+    Emit((1u << 4) | 3);  // memory space, equal
+    Emit(kFlag);
+    Emit(0);
+    Emit(1);              // reference
+    Emit(0xFFFFFFFF);     // mask
+    Emit(pm4_type3_cmd(PM4Opcode::MEM_WRITE, 2));
+    Emit(kDest);
+    Emit(0x12345678);
+    Submit(1);
+
+    // The ring stalls at the wait: neither the write nor the fence may pass it
+    EXPECT_FALSE(gpu_->wait_for_gpu_fence(1, 20000000ULL));
+    EXPECT_EQ(memory_->read_u32(kDest), 0u);
+
+    // CPU releases the wait; the thread's re-poll picks it up unprompted
+    memory_->write_u32(kFlag, 1);
+    ASSERT_TRUE(gpu_->wait_for_gpu_fence(1, kTimeoutNs));
+    EXPECT_EQ(memory_->read_u32(kDest), 0x12345678u);
+}
+
+TEST_F(GpuAsyncCommandTest, Fence_SignaledWhenRingDrains) {
+    // A fence queued with no new commands is reached once the (empty) ring drains
+    gpu_->cpu_signal_fence(1);
+    ASSERT_TRUE(gpu_->wait_for_gpu_fence(1, kTimeoutNs));
+
+    // A later fence times out until a pass runs after it
+    EXPECT_FALSE(gpu_->wait_for_gpu_fence(2, 0));
+    Emit(pm4_type2());
+    Submit(2);
+    EXPECT_TRUE(gpu_->wait_for_gpu_fence(2, kTimeoutNs));
+    EXPECT_TRUE(gpu_->gpu_fence_reached(2));
+}
+
 // ============================================================================
 // 8. Pipeline State Hashing
 // ============================================================================
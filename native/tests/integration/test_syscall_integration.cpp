@@ -12,6 +12,8 @@
 #include "memory/memory.h"
 #include "cpu/xenon/cpu.h"
 #include "cpu/xenon/threading.h"
+#include <thread>
+#include <vector>
 
 namespace x360mu {
 namespace test {
@@ -21,11 +23,13 @@ namespace nt {
 constexpr u32 STATUS_SUCCESS = 0x00000000;
 constexpr u32 STATUS_NO_MEMORY = 0xC0000017;
 constexpr u32 STATUS_INVALID_PARAMETER = 0xC000000D;
+constexpr u32 STATUS_CONFLICTING_ADDRESSES = 0xC0000018;
 }
 
 // Memory allocation flags
 constexpr u32 MEM_COMMIT = 0x1000;
 constexpr u32 MEM_RESERVE = 0x2000;
+constexpr u32 MEM_LARGE_PAGES = 0x20000000;
 constexpr u32 PAGE_READWRITE = 0x04;
 
 class SyscallIntegrationTest : public ::testing::Test {
@@ -68,6 +72,17 @@ protected:
         *result = ctx.gpr[3];
     }
     
+    // Same as call_hle_function, but dispatched with a current guest thread
+    // bound so the handler actually runs against context 0's registers
+    u64 call_hle_on_guest_thread(u32 ordinal) {
+        auto thread = std::make_unique<GuestThread>();
+        thread->context = cpu_->get_context(0);
+        SetCurrentGuestThread(thread.get());
+        kernel_->handle_syscall(ordinal, 0);
+        SetCurrentGuestThread(nullptr);
+        return thread->context.gpr[3];
+    }
+
     // Setup CPU registers for a syscall
     void setup_syscall_args(u64 arg0, u64 arg1 = 0, u64 arg2 = 0, u64 arg3 = 0,
                            u64 arg4 = 0, u64 arg5 = 0, u64 arg6 = 0, u64 arg7 = 0) {
@@ -165,6 +180,53 @@ TEST_F(SyscallIntegrationTest, NtAllocateVirtualMemory_SpecificAddress) {
     EXPECT_NE(allocated_base, 0u);
 }
 
+TEST_F(SyscallIntegrationTest, NtAllocateVirtualMemory_CommitInsideReservation) {
+    GuestAddr base_addr_ptr = 0x10000;
+    GuestAddr region_size_ptr = 0x10010;
+
+    // Reserve 1MB, let the kernel pick the address
+    memory_->write_u32(base_addr_ptr, 0);
+    memory_->write_u32(region_size_ptr, 0x100000);
+    setup_syscall_args(0xFFFFFFFF, base_addr_ptr, 0, region_size_ptr,
+                       MEM_RESERVE, PAGE_READWRITE);
+    // NtAllocateVirtualMemory ordinal 1 (186 is taken by NtCancelTimer)
+    ASSERT_EQ(call_hle_on_guest_thread(1), nt::STATUS_SUCCESS);
+    GuestAddr reservation = memory_->read_u32(base_addr_ptr);
+    ASSERT_NE(reservation, 0u);
+
+    // Commit two pages in the middle of it
+    memory_->write_u32(base_addr_ptr, reservation + 0x20010);
+    memory_->write_u32(region_size_ptr, 0x1000);
+    setup_syscall_args(0xFFFFFFFF, base_addr_ptr, 0, region_size_ptr,
+                       MEM_COMMIT, PAGE_READWRITE);
+    EXPECT_EQ(call_hle_on_guest_thread(1), nt::STATUS_SUCCESS);
+    EXPECT_EQ(memory_->read_u32(base_addr_ptr), reservation + 0x20000);
+    EXPECT_EQ(memory_->read_u32(region_size_ptr), 0x2000u);
+
+    // A commit that runs past the end of the reservation conflicts
+    memory_->write_u32(base_addr_ptr, reservation + 0xFF000);
+    memory_->write_u32(region_size_ptr, 0x2000);
+    setup_syscall_args(0xFFFFFFFF, base_addr_ptr, 0, region_size_ptr,
+                       MEM_COMMIT, PAGE_READWRITE);
+    EXPECT_EQ(call_hle_on_guest_thread(1), nt::STATUS_CONFLICTING_ADDRESSES);
+}
+
+TEST_F(SyscallIntegrationTest, NtAllocateVirtualMemory_LargePagesUseOwnPool) {
+    GuestAddr base_addr_ptr = 0x10000;
+    GuestAddr region_size_ptr = 0x10010;
+
+    memory_->write_u32(base_addr_ptr, 0);
+    memory_->write_u32(region_size_ptr, 0x10000);
+    setup_syscall_args(0xFFFFFFFF, base_addr_ptr, 0, region_size_ptr,
+                       MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE);
+    ASSERT_EQ(call_hle_on_guest_thread(1), nt::STATUS_SUCCESS);
+
+    GuestAddr base = memory_->read_u32(base_addr_ptr);
+    EXPECT_GE(base, 0x18000000u);
+    EXPECT_LT(base, 0x20000000u);
+    EXPECT_EQ(base % 0x10000, 0u);
+}
+
 //=============================================================================
 // KeInitializeEvent / KeSetEvent / KeResetEvent Tests
 //=============================================================================
@@ -317,5 +379,52 @@ TEST_F(SyscallIntegrationTest, SemaphoreInitAndRelease) {
     EXPECT_EQ(signal_state, 5u);
 }
 
+//=============================================================================
+// Import Slot Dispatch Tests
+//=============================================================================
+
+TEST_F(SyscallIntegrationTest, ImportSlotDispatch) {
+    // Same import resolves to the same slot; distinct imports get distinct slots
+    u32 freq_slot = kernel_->resolve_import(0, 103);  // KeQueryPerformanceFrequency
+    u32 missing_slot = kernel_->resolve_import(2, 0x7FFF);
+    ASSERT_NE(freq_slot, INVALID_IMPORT_SLOT);
+    ASSERT_NE(missing_slot, INVALID_IMPORT_SLOT);
+    EXPECT_EQ(kernel_->resolve_import(0, 103), freq_slot);
+    EXPECT_NE(missing_slot, freq_slot);
+    
+    // Dispatch through the thunk encoding from several guest threads at once
+    constexpr int THREADS = 4;
+    constexpr int CALLS = 10000;
+    std::vector<std::thread> threads;
+    std::vector<u64> results(THREADS, 0);
+    std::vector<u64> missing_results(THREADS, 1);
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t]() {
+            GuestThread guest{};
+            SetCurrentGuestThread(&guest);
+            for (int i = 0; i < CALLS; i++) {
+                guest.context.gpr[0] = IMPORT_SLOT_FLAG | freq_slot;
+                cpu_->dispatch_syscall(guest.context);
+            }
+            results[t] = guest.context.gpr[3];
+            
+            guest.context.gpr[0] = IMPORT_SLOT_FLAG | missing_slot;
+            guest.context.gpr[3] = 1;
+            cpu_->dispatch_syscall(guest.context);
+            missing_results[t] = guest.context.gpr[3];
+            SetCurrentGuestThread(nullptr);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    
+    for (int t = 0; t < THREADS; t++) {
+        EXPECT_EQ(results[t], 50000000u);
+        EXPECT_EQ(missing_results[t], nt::STATUS_SUCCESS);  // Unimplemented returns success
+    }
+    EXPECT_EQ(kernel_->get_import_call_count(0, 103), u64(THREADS) * CALLS);
+    EXPECT_EQ(kernel_->get_import_call_count(2, 0x7FFF), u64(THREADS));
+    EXPECT_EQ(kernel_->get_import_call_count(0, 104), 0u);
+}
+
 } // namespace test
 } // namespace x360mu
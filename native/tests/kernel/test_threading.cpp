@@ -10,6 +10,15 @@
 #include "memory/memory.h"
 #include "cpu/xenon/cpu.h"
 #include "cpu/xenon/threading.h"
+#include "kernel/timer_queue.h"
+#include "kernel/work_queue.h"
+#include "core/parker.h"
+#include "core/mpsc_queue.h"
+#include "core/timeline.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace x360mu {
 namespace test {
@@ -346,6 +355,17 @@ TEST_F(ThreadingTest, CriticalSectionEnterLeave) {
     EXPECT_EQ(lock_count, -1);
 }
 
+TEST_F(ThreadingTest, CriticalSectionMisalignedIsRejected) {
+    // A lock word the host can't CAS must fail, not spin forever
+    GuestAddr cs_addr = 0x10000002;
+    memory_->allocate(0x10000000, 4096, MemoryRegion::Read | MemoryRegion::Write);
+    memory_->write_u32(cs_addr + RTL_CRITICAL_SECTION_LAYOUT::OFFSET_LOCK_COUNT, 0);
+    
+    EXPECT_EQ(thread_mgr_->enter_critical_section(cs_addr), nt::STATUS_INVALID_PARAMETER);
+    EXPECT_EQ(thread_mgr_->try_enter_critical_section(cs_addr), 0u);
+    EXPECT_EQ(thread_mgr_->leave_critical_section(cs_addr), nt::STATUS_INVALID_PARAMETER);
+}
+
 TEST_F(ThreadingTest, CriticalSectionRecursive) {
     GuestAddr cs_addr = 0x10000000;
     memory_->allocate(cs_addr, 64, MemoryRegion::Read | MemoryRegion::Write);
@@ -377,6 +397,40 @@ TEST_F(ThreadingTest, CriticalSectionRecursive) {
     EXPECT_EQ(lock_count, -1);
 }
 
+TEST_F(ThreadingTest, CriticalSectionContended) {
+    GuestAddr cs_addr = 0x10000000;
+    memory_->allocate(cs_addr, 64, MemoryRegion::Read | MemoryRegion::Write);
+    thread_mgr_->init_critical_section_with_spin(cs_addr, 100);
+    
+    // Unsynchronized counter: only exact under mutual exclusion. Waiters
+    // park on the section, so the hand-offs go through keyed_release().
+    constexpr int THREADS = 4;
+    constexpr int ITERATIONS = 5000;
+    int counter = 0;
+    std::atomic<int> done{0};
+    for (int t = 0; t < THREADS; t++) {
+        scheduler_->create_system_thread([&](GuestThread*) {
+            for (int i = 0; i < ITERATIONS; i++) {
+                thread_mgr_->enter_critical_section(cs_addr);
+                int value = counter;
+                if ((i & 63) == 0) std::this_thread::yield();
+                counter = value + 1;
+                thread_mgr_->leave_critical_section(cs_addr);
+            }
+            done++;
+        });
+    }
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+    while (done.load() < THREADS && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(done.load(), THREADS);
+    EXPECT_EQ(counter, THREADS * ITERATIONS);
+    s32 lock_count = static_cast<s32>(memory_->read_u32(cs_addr + RTL_CRITICAL_SECTION_LAYOUT::OFFSET_LOCK_COUNT));
+    EXPECT_EQ(lock_count, -1);
+}
+
 TEST_F(ThreadingTest, TryEnterCriticalSection) {
     GuestAddr cs_addr = 0x10000000;
     memory_->allocate(cs_addr, 64, MemoryRegion::Read | MemoryRegion::Write);
@@ -488,6 +542,25 @@ TEST_F(ThreadingTest, CloseHandle) {
     EXPECT_EQ(status, nt::STATUS_INVALID_HANDLE);
 }
 
+TEST_F(ThreadingTest, StaleHandleMissesReusedSlot) {
+    u32 old_handle = 0;
+    thread_mgr_->create_event(&old_handle, 0, 0, EventType::NotificationEvent, false);
+    ASSERT_EQ(thread_mgr_->close_handle(old_handle), nt::STATUS_SUCCESS);
+
+    // The freed slot comes back under a new generation
+    u32 new_handle = 0;
+    thread_mgr_->create_semaphore(&new_handle, 0, 0, 0, 1);
+    EXPECT_NE(new_handle, old_handle);
+
+    s64 no_wait = 0;
+    EXPECT_EQ(thread_mgr_->wait_for_single_object(old_handle, false, &no_wait),
+              nt::STATUS_INVALID_HANDLE);
+    EXPECT_EQ(thread_mgr_->release_semaphore(new_handle, 1, nullptr), nt::STATUS_SUCCESS);
+    EXPECT_EQ(thread_mgr_->wait_for_single_object(new_handle, false, &no_wait),
+              nt::STATUS_WAIT_0);
+    thread_mgr_->close_handle(new_handle);
+}
+
 TEST_F(ThreadingTest, InvalidHandle) {
     // Try to use invalid handle
     s32 prev_state;
@@ -495,6 +568,321 @@ TEST_F(ThreadingTest, InvalidHandle) {
     EXPECT_EQ(status, nt::STATUS_INVALID_HANDLE);
 }
 
+//=============================================================================
+// Parking Tests
+//=============================================================================
+
+TEST(ParkerTest, UnparkBeforeParkIsRemembered) {
+    Parker parker;
+    parker.unpark();
+    
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(parker.park(1000000000ULL));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 500);
+    
+    // The permit is consumed
+    EXPECT_FALSE(parker.park(1000000ULL));
+}
+
+TEST(ParkerTest, TimedParkExpires) {
+    Parker parker;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(parker.park(5000000ULL));  // 5ms
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    EXPECT_GE(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), 5000);
+}
+
+TEST(ParkerTest, WakesParkedThread) {
+    Parker parker;
+    std::atomic<bool> flag{false};
+    std::thread waker([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        flag = true;
+        parker.unpark();
+    });
+    while (!flag.load()) parker.park();
+    waker.join();
+    EXPECT_TRUE(flag.load());
+}
+
+TEST_F(ThreadingTest, WaitAllParksGuestThread) {
+    u32 events[2] = {};
+    thread_mgr_->create_event(&events[0], 0, 0, EventType::NotificationEvent, false);
+    thread_mgr_->create_event(&events[1], 0, 0, EventType::NotificationEvent, false);
+    
+    std::atomic<u32> result{0xFFFFFFFF};
+    scheduler_->create_system_thread([&](GuestThread*) {
+        result = thread_mgr_->wait_for_multiple_objects(2, events, WaitType::WaitAll,
+                                                        false, nullptr);
+    });
+    
+    s32 prev = 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    thread_mgr_->set_event(events[0], &prev);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_EQ(result.load(), 0xFFFFFFFFu);  // Still waiting for the second
+    thread_mgr_->set_event(events[1], &prev);
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (result.load() == 0xFFFFFFFFu && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(result.load(), nt::STATUS_WAIT_0);
+}
+
+//=============================================================================
+// Timer Queue Tests
+//=============================================================================
+
+TEST(TimerQueueTest, FiresInDeadlineOrderAndHonoursCancel) {
+    TimerQueue queue;
+    std::mutex mutex;
+    std::vector<int> fired;
+    auto record = [&](int id) {
+        return [&, id]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            fired.push_back(id);
+        };
+    };
+    
+    u64 now = TimerQueue::now_100ns();
+    queue.schedule(now + 60000, record(3));  // 6ms
+    queue.schedule(now + 20000, record(1));  // 2ms
+    u64 cancelled = queue.schedule(now + 40000, record(2));
+    queue.schedule(now + 40000, record(2));  // Same deadline, still fires
+    EXPECT_TRUE(queue.cancel(cancelled));
+    EXPECT_FALSE(queue.cancel(cancelled));
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (queue.pending() > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    queue.synchronize();
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(fired, (std::vector<int>{1, 2, 3}));
+}
+
+TEST_F(ThreadingTest, PeriodicTimerWakesWaiter) {
+    u32 timer = 0;
+    ASSERT_EQ(thread_mgr_->create_timer(&timer, 0, 0, 1), nt::STATUS_SUCCESS);
+    bool prev = false;
+    s64 due = -20000;  // 2ms
+    ASSERT_EQ(thread_mgr_->set_timer(timer, due, 2, 0, 0, false, &prev), nt::STATUS_SUCCESS);
+    
+    // Nothing polls process_timer_queue(); the timer thread has to fire it
+    std::atomic<int> woken{0};
+    scheduler_->create_system_thread([&](GuestThread*) {
+        for (int i = 0; i < 3; i++) {
+            s64 timeout = -10000000;  // 1s
+            if (thread_mgr_->wait_for_single_object(timer, false, &timeout) == nt::STATUS_WAIT_0) {
+                woken++;
+            }
+        }
+    });
+    
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (woken.load() < 3 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(woken.load(), 3);
+    
+    bool was_set = false;
+    EXPECT_EQ(thread_mgr_->cancel_timer(timer, &was_set), nt::STATUS_SUCCESS);
+    EXPECT_TRUE(was_set);
+}
+
+TEST_F(ThreadingTest, AlertableDelayEndsOnAlert) {
+    std::atomic<u32> result{0xFFFFFFFF};
+    std::atomic<GuestThread*> sleeper{nullptr};
+    scheduler_->create_system_thread([&](GuestThread* self) {
+        sleeper = self;
+        s64 interval = -100000000;  // 10s
+        result = thread_mgr_->delay_execution(true, &interval);
+    });
+    
+    auto start = std::chrono::steady_clock::now();
+    while ((!sleeper.load() || !sleeper.load()->in_alertable_wait) &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_TRUE(sleeper.load() && sleeper.load()->in_alertable_wait);
+    scheduler_->alert_thread(sleeper.load());
+    
+    while (result.load() == 0xFFFFFFFFu &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(5)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(result.load(), nt::STATUS_ALERTED);
+}
+
+//=============================================================================
+// Lock-free Queue Tests
+//=============================================================================
+
+TEST(MpscQueueTest, ConcurrentProducersKeepPerProducerOrder) {
+    struct Item : MpscNode {
+        int producer;
+        int seq;
+    };
+    
+    constexpr int PRODUCERS = 4;
+    constexpr int PER_PRODUCER = 20000;
+    MpscQueue<Item> queue;
+    std::atomic<int> finished{0};
+    
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < PER_PRODUCER; i++) {
+                auto* item = new Item();
+                item->producer = p;
+                item->seq = i;
+                queue.push(item);
+            }
+            finished++;
+        });
+    }
+    
+    // Consume concurrently with the producers
+    int next_seq[PRODUCERS] = {};
+    int received = 0;
+    bool in_order = true;
+    while (received < PRODUCERS * PER_PRODUCER) {
+        Item* batch = queue.pop_all();
+        if (!batch) {
+            std::this_thread::yield();
+            continue;
+        }
+        while (batch) {
+            Item* next = MpscQueue<Item>::next(batch);
+            in_order &= batch->seq == next_seq[batch->producer]++;
+            received++;
+            delete batch;
+            batch = next;
+        }
+    }
+    for (auto& t : producers) t.join();
+    
+    EXPECT_TRUE(in_order);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(WorkQueueTest, EnqueueWakesParkedConsumer) {
+    WorkQueue queue;
+    std::atomic<int> consumed{0};
+    std::atomic<u32> last_param{0};
+    
+    std::thread consumer([&]() {
+        WorkQueueItem item{};
+        while (queue.dequeue(item, WORK_QUEUE_INFINITE_TIMEOUT)) {
+            last_param = item.parameter;
+            consumed++;
+        }
+    });
+    
+    // Consumer is parked with an infinite timeout; each enqueue must wake it
+    for (u32 i = 1; i <= 3; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        queue.enqueue({0, 0, 0x82000000, i, 0});
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (consumed.load() < static_cast<int>(i) &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        EXPECT_EQ(consumed.load(), static_cast<int>(i));
+        EXPECT_EQ(last_param.load(), i);
+    }
+    
+    // shutdown() also wakes it
+    queue.shutdown();
+    consumer.join();
+    EXPECT_TRUE(queue.is_empty());
+}
+
+TEST(WorkQueueTest, CancelAndDrainPreserveOrder) {
+    WorkQueue queue;
+    for (u32 i = 0; i < 5; i++) {
+        queue.enqueue({0, 0, 0x82000000, i, 0x40000000 + i * 0x10});
+    }
+    EXPECT_EQ(queue.size(), 5u);
+    EXPECT_TRUE(queue.cancel(0x40000020));
+    EXPECT_FALSE(queue.cancel(0x40000020));
+    EXPECT_TRUE(queue.cancel(0x40000040));  // Tail
+    
+    WorkQueueItem item{};
+    ASSERT_TRUE(queue.dequeue(item, 0));
+    EXPECT_EQ(item.parameter, 0u);
+    queue.enqueue({0, 0, 0x82000000, 9, 0});
+    ASSERT_TRUE(queue.dequeue(item, 0));
+    EXPECT_EQ(item.parameter, 1u);
+    ASSERT_TRUE(queue.dequeue(item, 0));
+    EXPECT_EQ(item.parameter, 3u);
+    EXPECT_EQ(queue.drain(), 1u);
+    EXPECT_FALSE(queue.dequeue(item, 1));
+    EXPECT_TRUE(queue.is_empty());
+}
+
+TEST(GuestThreadApcTest, KernelApcsRunAheadOfUserApcs) {
+    GuestThread thread;
+    thread.reset();
+    EXPECT_FALSE(thread.has_pending_apcs());
+    
+    thread.queue_apc(0x82001000, 1, 0, 0, false);
+    thread.queue_apc(0x82002000, 2, 0, 0, true);
+    thread.queue_apc(0x82003000, 3, 0, 0, false);
+    EXPECT_TRUE(thread.has_pending_apcs());
+    
+    ApcEntry* kernel = thread.kernel_apcs.pop_all();
+    ASSERT_NE(kernel, nullptr);
+    EXPECT_EQ(kernel->context, 2u);
+    EXPECT_EQ(MpscQueue<ApcEntry>::next(kernel), nullptr);
+    delete kernel;
+    
+    // reset() frees whatever is still queued
+    thread.reset();
+    EXPECT_FALSE(thread.has_pending_apcs());
+    EXPECT_TRUE(thread.user_apcs.empty());
+}
+
+TEST(TimelineTest, SleepsUntilDeadlineOrWake) {
+    using Clock = Timeline::Clock;
+    Timeline timeline;
+    EXPECT_EQ(timeline.next_due(), Clock::time_point::max());
+    
+    // Each event holds one deadline; scheduling again moves it
+    auto start = Clock::now();
+    timeline.schedule(TimelineEvent::VBlank, start + std::chrono::milliseconds(20));
+    timeline.schedule(TimelineEvent::Audio, start + std::chrono::milliseconds(5));
+    timeline.schedule(TimelineEvent::VBlank, start + std::chrono::milliseconds(10));
+    EXPECT_EQ(timeline.next_due(), start + std::chrono::milliseconds(5));
+    EXPECT_EQ(timeline.take_due(start), 0u);
+    
+    // Wakes at the earliest deadline and hands back only what is due
+    while (Clock::now() < start + std::chrono::milliseconds(5)) {
+        timeline.wait();
+    }
+    EXPECT_EQ(timeline.take_due(Clock::now()), Timeline::bit(TimelineEvent::Audio));
+    EXPECT_FALSE(timeline.scheduled(TimelineEvent::Audio));
+    EXPECT_TRUE(timeline.scheduled(TimelineEvent::VBlank));
+    timeline.cancel(TimelineEvent::VBlank);
+    
+    // Nothing scheduled: only wake() ends the sleep
+    std::atomic<bool> woken{false};
+    std::thread waiter([&]() {
+        timeline.wait();
+        woken = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    timeline.wake();
+    waiter.join();
+    EXPECT_TRUE(woken.load());
+    
+    // A wake that arrives before the wait is not lost
+    timeline.wake();
+    EXPECT_TRUE(timeline.wait());
+}
+
 } // namespace test
 } // namespace x360mu
-
@@ -10,6 +10,9 @@
 #include "kernel/xevent.h"
 #include "memory/memory.h"
 #include "cpu/xenon/cpu.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 namespace x360mu {
 namespace test {
@@ -166,6 +169,90 @@ TEST(ObjectTableTest, MultipleObjects) {
     }
 }
 
+TEST(ObjectTableTest, StaleHandleAfterSlotReuse) {
+    ObjectTable table;
+    auto first = std::make_shared<TestObject>();
+    u32 old_handle = table.add_object(first);
+    EXPECT_EQ(table.close_handle(old_handle), nt_obj::STATUS_SUCCESS);
+    
+    // The slot is recycled under a new generation; the old handle stays dead
+    auto second = std::make_shared<TestObject>();
+    u32 new_handle = table.add_object(second);
+    EXPECT_NE(new_handle, old_handle);
+    EXPECT_EQ(table.lookup(old_handle), nullptr);
+    EXPECT_EQ(table.close_handle(old_handle), nt_obj::STATUS_INVALID_HANDLE);
+    EXPECT_EQ(table.lookup(new_handle).get(), second.get());
+}
+
+TEST(ObjectTableTest, ConcurrentLookupAndChurn) {
+    ObjectTable table;
+    auto stable = std::make_shared<TestObject>();
+    u32 stable_handle = table.add_object(stable);
+    
+    std::atomic<bool> stop{false};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; t++) {
+        threads.emplace_back([&]() {
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (table.lookup(stable_handle).get() != stable.get()) failures++;
+            }
+        });
+    }
+    threads.emplace_back([&]() {
+        for (int i = 0; i < 20000; i++) {
+            u32 h = table.add_object(std::make_shared<TestObject>());
+            if (!table.lookup(h)) failures++;
+            if (table.close_handle(h) != nt_obj::STATUS_SUCCESS) failures++;
+        }
+        stop = true;
+    });
+    for (auto& t : threads) t.join();
+    
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(table.object_count(), 1u);
+}
+
+TEST(ObjectTableTest, ConcurrentEventLookups) {
+    ObjectTable table;
+    for (int i = 0; i < 2000; i++) {
+        table.add_object(std::make_shared<TestObject>());
+    }
+    
+    // Each thread sets and consumes its own event through typed and untyped
+    // lookups while the others do the same on neighbouring slots
+    constexpr int THREADS = 4;
+    std::vector<u32> handles;
+    for (int t = 0; t < THREADS; t++) {
+        handles.push_back(table.add_object(
+            std::make_shared<XEvent>(XEventType::NotificationEvent, false)));
+    }
+    
+    std::atomic<int> failures{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < THREADS; t++) {
+        workers.emplace_back([&, handle = handles[t]]() {
+            for (int i = 0; i < 20000; i++) {
+                auto event = std::static_pointer_cast<XEvent>(
+                    table.lookup_typed(handle, XObjectType::NotificationEvent));
+                if (!event) { failures++; continue; }
+                event->set();
+                
+                auto waitable = table.lookup(handle);
+                if (!waitable || !waitable->is_signaled()) { failures++; continue; }
+                waitable->unsignal();
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    
+    EXPECT_EQ(failures.load(), 0);
+    for (u32 h : handles) {
+        EXPECT_EQ(table.close_handle(h), nt_obj::STATUS_SUCCESS);
+    }
+    EXPECT_EQ(table.object_count(), 2000u);
+}
+
 //=============================================================================
 // KernelState Tests
 //=============================================================================
@@ -0,0 +1,138 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Extent Allocator Tests
+ */
+
+#include <gtest/gtest.h>
+#include "memory/extent_allocator.h"
+
+namespace x360mu {
+namespace test {
+
+constexpr GuestAddr HEAP_BASE = 0x10000000;
+constexpr u64 HEAP_SIZE = 0x01000000;  // 16MB
+
+TEST(ExtentAllocatorTest, ReusesFreedRanges) {
+    ExtentAllocator heap(HEAP_BASE, HEAP_SIZE);
+
+    GuestAddr a = heap.allocate(0x10000, 0x1000);
+    GuestAddr b = heap.allocate(0x10000, 0x1000);
+    EXPECT_EQ(a, HEAP_BASE);
+    EXPECT_EQ(b, HEAP_BASE + 0x10000);
+
+    EXPECT_EQ(heap.free(a), 0x10000u);
+    EXPECT_EQ(heap.allocate(0x8000, 0x1000), a);
+    EXPECT_EQ(heap.free(0x12345000), 0u);
+}
+
+TEST(ExtentAllocatorTest, BestFitPicksSmallestHole) {
+    ExtentAllocator heap(HEAP_BASE, HEAP_SIZE);
+
+    GuestAddr big = heap.allocate(0x40000, 0x1000);
+    heap.allocate(0x1000, 0x1000);
+    GuestAddr small = heap.allocate(0x4000, 0x1000);
+    heap.allocate(0x1000, 0x1000);
+
+    heap.free(big);
+    heap.free(small);
+
+    // The 16KB hole fits exactly; the 256KB hole and the tail are left alone
+    EXPECT_EQ(heap.allocate(0x4000, 0x1000), small);
+    EXPECT_EQ(heap.allocate(0x20000, 0x1000), big);
+}
+
+TEST(ExtentAllocatorTest, CoalescesNeighbours) {
+    ExtentAllocator heap(HEAP_BASE, HEAP_SIZE);
+
+    GuestAddr a = heap.allocate(0x1000, 0x1000);
+    GuestAddr b = heap.allocate(0x1000, 0x1000);
+    GuestAddr c = heap.allocate(0x1000, 0x1000);
+
+    heap.free(a);
+    heap.free(c);
+    EXPECT_EQ(heap.stats().free_extents, 2u);
+
+    heap.free(b);
+    auto stats = heap.stats();
+    EXPECT_EQ(stats.free_extents, 1u);
+    EXPECT_EQ(stats.largest_free, HEAP_SIZE);
+    EXPECT_EQ(stats.used, 0u);
+    EXPECT_DOUBLE_EQ(stats.fragmentation, 0.0);
+}
+
+TEST(ExtentAllocatorTest, AlignmentAndTopDown) {
+    ExtentAllocator heap(HEAP_BASE, HEAP_SIZE);
+
+    heap.allocate(0x1000, 0x1000);
+    GuestAddr aligned = heap.allocate(0x1000, 0x10000);
+    EXPECT_EQ(aligned % 0x10000, 0u);
+    EXPECT_EQ(aligned, HEAP_BASE + 0x10000);
+
+    GuestAddr top = heap.allocate(0x3000, 0x1000, true);
+    EXPECT_EQ(top, HEAP_BASE + HEAP_SIZE - 0x3000);
+
+    // Odd sizes round up to the granularity
+    GuestAddr rounded = heap.allocate(0x1234, 0x1000);
+    EXPECT_EQ(heap.allocation_size(rounded), 0x2000u);
+}
+
+TEST(ExtentAllocatorTest, FixedAllocations) {
+    ExtentAllocator heap(HEAP_BASE, HEAP_SIZE);
+
+    EXPECT_TRUE(heap.allocate_fixed(HEAP_BASE + 0x100000, 0x10000));
+    EXPECT_FALSE(heap.allocate_fixed(HEAP_BASE + 0x108000, 0x10000));  // Overlap
+    EXPECT_FALSE(heap.allocate_fixed(HEAP_BASE - 0x1000, 0x1000));     // Below window
+    EXPECT_FALSE(heap.allocate_fixed(HEAP_BASE + HEAP_SIZE - 0x1000, 0x2000));
+    EXPECT_TRUE(heap.allocate_fixed(HEAP_BASE + 0x110000, 0x1000));    // Adjacent
+
+    EXPECT_EQ(heap.free(HEAP_BASE + 0x100000), 0x10000u);
+    EXPECT_TRUE(heap.allocate_fixed(HEAP_BASE + 0x108000, 0x8000));
+}
+
+TEST(ExtentAllocatorTest, AddressBounds) {
+    ExtentAllocator heap(HEAP_BASE, HEAP_SIZE);
+
+    GuestAddr addr = heap.allocate(0x2000, 0x1000, false, HEAP_BASE + 0x200000,
+                                   HEAP_BASE + 0x2FFFFF);
+    EXPECT_EQ(addr, HEAP_BASE + 0x200000);
+
+    addr = heap.allocate(0x2000, 0x1000, true, HEAP_BASE + 0x200000, HEAP_BASE + 0x2FFFFF);
+    EXPECT_EQ(addr, HEAP_BASE + 0x2FE000);
+
+    // Range too small for the request
+    EXPECT_EQ(heap.allocate(0x2000, 0x1000, false, HEAP_BASE + 0x400000,
+                            HEAP_BASE + 0x400FFF), 0u);
+}
+
+TEST(ExtentAllocatorTest, StatsTrackUsageAndFragmentation) {
+    ExtentAllocator heap(HEAP_BASE, 0x10000);
+
+    GuestAddr blocks[16];
+    for (auto& block : blocks) {
+        block = heap.allocate(0x1000, 0x1000);
+        ASSERT_NE(block, 0u);
+    }
+    EXPECT_EQ(heap.allocate(0x1000, 0x1000), 0u);  // Exhausted
+
+    for (int i = 0; i < 16; i += 2) heap.free(blocks[i]);
+
+    auto stats = heap.stats();
+    EXPECT_EQ(stats.total, 0x10000u);
+    EXPECT_EQ(stats.used, 0x8000u);
+    EXPECT_EQ(stats.peak_used, 0x10000u);
+    EXPECT_EQ(stats.allocations, 8u);
+    EXPECT_EQ(stats.free_extents, 8u);
+    EXPECT_EQ(stats.largest_free, 0x1000u);
+    EXPECT_NEAR(stats.fragmentation, 0.875, 1e-9);
+
+    // 32KB is free but not contiguous
+    EXPECT_EQ(heap.allocate(0x2000, 0x1000), 0u);
+
+    heap.reset();
+    EXPECT_EQ(heap.stats().used, 0u);
+    EXPECT_EQ(heap.allocate(0x10000, 0x1000), HEAP_BASE);
+}
+
+} // namespace test
+} // namespace x360mu
@@ -0,0 +1,134 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Memory Access Heatmap Tests
+ */
+
+#include <gtest/gtest.h>
+#include "memory/memory.h"
+#include "memory/heatmap.h"
+#include <thread>
+
+namespace x360mu {
+namespace test {
+
+class MemoryHeatmapTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Memory> memory;
+
+    void SetUp() override {
+        memory = std::make_unique<Memory>();
+        ASSERT_EQ(memory->initialize(), Status::Ok);
+    }
+
+    void TearDown() override {
+        memory->shutdown();
+    }
+
+    static const MemoryHeatmap::PageEntry* find(const std::vector<MemoryHeatmap::PageEntry>& pages,
+                                                GuestAddr page, bool mmio) {
+        for (const auto& entry : pages) {
+            if (entry.page == page && entry.mmio == mmio) return &entry;
+        }
+        return nullptr;
+    }
+};
+
+TEST_F(MemoryHeatmapTest, DisabledByDefault) {
+    EXPECT_EQ(memory->heatmap(), nullptr);
+    EXPECT_EQ(memory->active_heatmap(), nullptr);
+
+    memory->set_heatmap_enabled(false);
+    EXPECT_EQ(memory->heatmap(), nullptr);
+}
+
+TEST_F(MemoryHeatmapTest, CountsPerPhysicalPage) {
+    memory->set_heatmap_enabled(true);
+    MemoryHeatmap* heatmap = memory->heatmap();
+    ASSERT_NE(heatmap, nullptr);
+    heatmap->set_sample_period(1);
+
+    memory->write_u32(0x00101000, 1);
+    memory->write_u32(0x80101004, 2);   // Cached mirror of the same page
+    memory->read_u32(0x00101008);
+    memory->read_u8(0x00205000);
+
+    auto pages = heatmap->pages();
+    ASSERT_EQ(pages.size(), 2u);
+    EXPECT_EQ(pages[0].page, 0x00101000u);   // Hottest first
+    EXPECT_EQ(pages[0].writes, 2u);
+    EXPECT_EQ(pages[0].reads, 1u);
+    EXPECT_FALSE(pages[0].mmio);
+    EXPECT_EQ(MemoryHeatmap::thread_count(pages[0].thread_mask), 1u);
+
+    // Disabling stops recording but keeps the counters
+    memory->set_heatmap_enabled(false);
+    EXPECT_EQ(memory->active_heatmap(), nullptr);
+    memory->write_u32(0x00101000, 3);
+    EXPECT_EQ(heatmap->pages()[0].writes, 2u);
+
+    heatmap->reset();
+    EXPECT_TRUE(heatmap->pages().empty());
+}
+
+TEST_F(MemoryHeatmapTest, SeparatesMmioPages) {
+    memory->register_mmio(0x7FC02000, 0x100,
+                          [](GuestAddr) -> u32 { return 0x1234; },
+                          [](GuestAddr, u32) {});
+    memory->set_heatmap_enabled(true);
+    memory->heatmap()->set_sample_period(1);
+
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(memory->read_u32(0x7FC02010), 0x1234u);
+    }
+    memory->write_u32(0xC0002010, 0);   // GPU alias dispatches to the same handler
+
+    auto pages = memory->heatmap()->pages();
+    const auto* physical = find(pages, 0x7FC02000, true);
+    ASSERT_NE(physical, nullptr);
+    EXPECT_EQ(physical->reads, 3u);
+    EXPECT_NE(find(pages, 0xC0002000, true), nullptr);
+
+    std::string csv = memory->heatmap()->export_csv();
+    EXPECT_EQ(csv.rfind("page,reads,writes,threads,mmio\n", 0), 0u);
+    EXPECT_NE(csv.find("0x7FC02000,3,0,1,1\n"), std::string::npos);
+}
+
+TEST_F(MemoryHeatmapTest, SamplesEveryNthAccess) {
+    memory->set_heatmap_enabled(true);
+    memory->heatmap()->set_sample_period(4);
+
+    for (int i = 0; i < 100; i++) {
+        memory->read_u32(0x00300000);
+    }
+
+    auto pages = memory->heatmap()->pages();
+    ASSERT_EQ(pages.size(), 1u);
+    EXPECT_EQ(pages[0].reads, 25u);
+}
+
+TEST_F(MemoryHeatmapTest, TracksSharingThreads) {
+    memory->set_heatmap_enabled(true);
+    memory->heatmap()->set_sample_period(1);
+
+    memory->write_u32(0x00400000, 1);
+    std::thread other([this] {
+        memory->write_u32(0x00400010, 2);
+        memory->write_u32(0x00500000, 3);
+    });
+    other.join();
+
+    auto pages = memory->heatmap()->pages();
+    const auto* shared = find(pages, 0x00400000, false);
+    const auto* private_page = find(pages, 0x00500000, false);
+    ASSERT_NE(shared, nullptr);
+    ASSERT_NE(private_page, nullptr);
+    EXPECT_EQ(MemoryHeatmap::thread_count(shared->thread_mask), 2u);
+    EXPECT_EQ(MemoryHeatmap::thread_count(private_page->thread_mask), 1u);
+
+    std::string report = memory->heatmap()->report();
+    EXPECT_NE(report.find("1 shared"), std::string::npos);
+}
+
+} // namespace test
+} // namespace x360mu
@@ -6,6 +6,7 @@
 
 #include <gtest/gtest.h>
 #include "memory/memory.h"
+#include <vector>
 
 namespace x360mu {
 namespace test {
@@ -84,5 +85,70 @@ TEST_F(MemoryTest, Alignment) {
     EXPECT_EQ(memory->read_u32(addr), 0xCAFEBABE);
 }
 
+TEST_F(MemoryTest, DecommitReleasesHostPages) {
+    GuestAddr base = 0x01000000;
+    u64 size = 256 * KB;
+    ASSERT_EQ(memory->allocate(base, size, MemoryRegion::Read | MemoryRegion::Write), Status::Ok);
+    
+    // Committing zeroes lazily: nothing is backed until written
+    memory->zero_bytes(base, size);
+    EXPECT_EQ(memory->resident_bytes(base, size), 0u);
+    
+    for (u64 offset = 0; offset < size; offset += memory::MEM_PAGE_SIZE) {
+        memory->write_u32(base + offset, 0xDEADBEEF);
+    }
+    EXPECT_EQ(memory->resident_bytes(base, size), size);
+    
+    memory->decommit(base, size);
+    EXPECT_EQ(memory->resident_bytes(base, size), 0u);
+    EXPECT_EQ(memory->read_u32(base), 0u);
+    EXPECT_EQ(memory->read_u32(base + size - 4), 0u);
+    
+    // Freeing a region releases it as well
+    memory->write_u32(base, 1);
+    memory->free(base);
+    EXPECT_EQ(memory->resident_bytes(base, size), 0u);
+}
+
+TEST_F(MemoryTest, LazyZeroPreservesNeighbours) {
+    GuestAddr base = 0x02000000;
+    std::vector<u8> pattern(0x30000, 0xAB);
+    memory->write_bytes(base, pattern.data(), pattern.size());
+    
+    // Unaligned on both ends
+    memory->zero_bytes(base + 0x100, 0x20000);
+    EXPECT_EQ(memory->read_u8(base + 0xFF), 0xABu);
+    EXPECT_EQ(memory->read_u8(base + 0x100), 0u);
+    EXPECT_EQ(memory->read_u8(base + 0x10000), 0u);
+    EXPECT_EQ(memory->read_u8(base + 0x200FF), 0u);
+    EXPECT_EQ(memory->read_u8(base + 0x20100), 0xABu);
+}
+
+TEST(MemoryBackingTest, HugePagesFallBackGracefully) {
+    Memory mem;
+    mem.set_huge_pages(true);
+    ASSERT_EQ(mem.initialize(), Status::Ok);
+    
+    // Whatever backing was obtained, guest RAM behaves the same
+    EXPECT_NE(memory_backing_name(mem.backing()), nullptr);
+    mem.write_u32(0x01234560, 0xDEADBEEF);
+    mem.write_u32(0x1FFFFFF8, 0x12345678);
+    EXPECT_EQ(mem.read_u32(0x01234560), 0xDEADBEEFu);
+    EXPECT_EQ(mem.read_u32(0x1FFFFFF8), 0x12345678u);
+    
+    // Fastmem base stays huge-page aligned
+    if (mem.get_fastmem_base()) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(mem.get_fastmem_base()) & (2 * MB - 1), 0u);
+    }
+    mem.shutdown();
+}
+
+TEST(MemoryBackingTest, DefaultsToNormalPages) {
+    Memory mem;
+    ASSERT_EQ(mem.initialize(), Status::Ok);
+    EXPECT_EQ(mem.backing(), MemoryBacking::Normal);
+    mem.shutdown();
+}
+
 } // namespace test
 } // namespace x360mu
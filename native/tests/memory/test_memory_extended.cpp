@@ -7,8 +7,11 @@
 
 #include <gtest/gtest.h>
 #include "memory/memory.h"
+#include "x360mu/byte_swap.h"
 #include <vector>
 #include <atomic>
+#include <algorithm>
+#include <thread>
 
 namespace x360mu {
 namespace test {
@@ -152,6 +155,115 @@ TEST_F(MemoryExtTest, Free_Region) {
     EXPECT_FALSE(found);
 }
 
+//=============================================================================
+// Byte-Swapped Bulk Access
+//=============================================================================
+
+TEST_F(MemoryExtTest, Swapped32_MatchesScalarAccess) {
+    // Unaligned start, crosses several pages
+    GuestAddr addr = 0x00200FFE;
+    std::vector<u32> values(3000);
+    for (size_t i = 0; i < values.size(); i++) values[i] = 0x01020304u * (u32)(i + 1);
+
+    memory->write_swapped32(addr, values.data(), values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        ASSERT_EQ(memory->read_u32(addr + (GuestAddr)i * 4), values[i]) << "index " << i;
+    }
+
+    std::vector<u32> readback(values.size());
+    memory->read_swapped32(0x80000000 | addr, readback.data(), readback.size());
+    EXPECT_EQ(readback, values);
+}
+
+TEST_F(MemoryExtTest, Swapped16And64_RoundTrip) {
+    std::vector<u16> h(1001);
+    std::vector<u64> d(513);
+    for (size_t i = 0; i < h.size(); i++) h[i] = (u16)(i * 0x0101 + 7);
+    for (size_t i = 0; i < d.size(); i++) d[i] = 0x0102030405060708ULL * (i + 1);
+
+    memory->write_swapped16(0x00210001, h.data(), h.size());
+    memory->write_swapped64(0x00220FFC, d.data(), d.size());
+    EXPECT_EQ(memory->read_u16(0x00210001 + 2 * 500), h[500]);
+    EXPECT_EQ(memory->read_u64(0x00220FFC), d[0]);
+    EXPECT_EQ(memory->read_u64(0x00220FFC + 8 * 512), d[512]);
+
+    std::vector<u16> h2(h.size());
+    std::vector<u64> d2(d.size());
+    memory->read_swapped16(0x00210001, h2.data(), h2.size());
+    memory->read_swapped64(0x00220FFC, d2.data(), d2.size());
+    EXPECT_EQ(h2, h);
+    EXPECT_EQ(d2, d);
+}
+
+TEST_F(MemoryExtTest, Swapped32_DispatchesMmio) {
+    std::vector<GuestAddr> writes;
+    memory->register_mmio(memory::GPU_REGS_BASE, 0x400000,
+        [](GuestAddr addr) -> u32 { return addr & 0xFFFF; },
+        [&](GuestAddr addr, u32) { writes.push_back(addr); }
+    );
+
+    u32 regs[4];
+    memory->read_swapped32(0xC0000100, regs, 4);
+    EXPECT_EQ(regs[0], 0x100u);
+    EXPECT_EQ(regs[3], 0x10Cu);
+
+    const u32 values[2] = {1, 2};
+    memory->write_swapped32(0x7FC00200, values, 2);
+    ASSERT_EQ(writes.size(), 2u);
+    EXPECT_EQ(writes[1], 0x7FC00204u);
+}
+
+TEST_F(MemoryExtTest, Swapped32_NotifiesWriteWatchers) {
+    std::vector<std::pair<GuestAddr, u64>> runs;
+    memory->watch_pages(0x00231000, 0x1000, [&](GuestAddr a, u64 s) { runs.push_back({a, s}); });
+
+    std::vector<u32> values(2048, 0xAABBCCDD);   // 8KB starting one page early
+    memory->write_swapped32(0x00230000, values.data(), values.size());
+    memory->flush_page_writes();
+    ASSERT_EQ(runs.size(), 1u);
+    EXPECT_EQ(runs[0].first, 0x00231000u);
+}
+
+TEST(ByteSwapTest, BulkKernelsMatchScalar) {
+    for (size_t count = 0; count < 70; count++) {
+        for (size_t offset = 0; offset < 8; offset++) {
+            std::vector<u8> src(count * 8 + 16), out(count * 8 + 16), ref(count * 8 + 16);
+            for (size_t i = 0; i < src.size(); i++) src[i] = (u8)(i * 13 + 5);
+
+            byte_swap_copy_32(out.data() + offset, src.data() + offset, count * 2);
+            for (size_t i = 0; i < count * 2; i++) {
+                u32 v;
+                memcpy(&v, src.data() + offset + i * 4, 4);
+                v = byte_swap(v);
+                memcpy(ref.data() + offset + i * 4, &v, 4);
+            }
+            ASSERT_EQ(out, ref) << "count " << count << " offset " << offset;
+
+            // In place
+            std::vector<u8> inplace = src;
+            byte_swap_copy_32(inplace.data() + offset, inplace.data() + offset, count * 2);
+            EXPECT_TRUE(std::equal(ref.begin() + offset, ref.begin() + offset + count * 8,
+                                   inplace.begin() + offset));
+        }
+    }
+
+    u16 h[9] = {0x0102, 0x0304, 0x0506, 0x0708, 0x090A, 0x0B0C, 0x0D0E, 0x0F10, 0x1112};
+    byte_swap_in_place_16(h, 9);
+    EXPECT_EQ(h[0], 0x0201);
+    EXPECT_EQ(h[8], 0x1211);
+
+    u64 q[3] = {0x0102030405060708ULL, 0, 0x1122334455667788ULL};
+    byte_swap_in_place_64(q, 3);
+    EXPECT_EQ(q[0], 0x0807060504030201ULL);
+    EXPECT_EQ(q[2], 0x8877665544332211ULL);
+
+    u32 words[5] = {0x11112222, 0x33334444, 0x55556666, 0x77778888, 0x9999AAAA};
+    u32 halves[5];
+    half_swap_copy_32(halves, words, 5);
+    EXPECT_EQ(halves[0], 0x22221111u);
+    EXPECT_EQ(halves[4], 0xAAAA9999u);
+}
+
 //=============================================================================
 // MMIO Registration and Dispatch
 //=============================================================================
@@ -211,6 +323,98 @@ TEST_F(MemoryExtTest, UnregisterMmio) {
     // The key is it shouldn't crash
 }
 
+TEST_F(MemoryExtTest, RegisterMmio_DirectHandlerAliases) {
+    struct Regs { u32 last_addr = 0; u32 last_value = 0; } regs;
+
+    memory->register_mmio(memory::GPU_REGS_BASE, 0x400000,
+        [](void*, GuestAddr addr) -> u32 { return addr; },
+        [](void* ctx, GuestAddr addr, u32 value) {
+            auto* r = static_cast<Regs*>(ctx);
+            r->last_addr = addr;
+            r->last_value = value;
+        },
+        &regs
+    );
+
+    // Physical window and both virtual aliases dispatch with the physical address
+    EXPECT_EQ(memory->read_u32(0x7FC02000), 0x7FC02000u);
+    EXPECT_EQ(memory->read_u32(0xC0002000), 0x7FC02000u);
+    EXPECT_EQ(memory->read_u32(0xEC802000), 0x7FC02000u);
+
+    memory->write_u32(0xC0001714, 0x1234);
+    EXPECT_EQ(regs.last_addr, 0x7FC01714u);
+    EXPECT_EQ(regs.last_value, 0x1234u);
+
+    memory->write_u32(0xEC800714, 0x5678);
+    EXPECT_EQ(regs.last_addr, 0x7FC00714u);
+    EXPECT_EQ(regs.last_value, 0x5678u);
+}
+
+TEST_F(MemoryExtTest, RegisterMmio_SmallestRangeWins) {
+    int outer = 0, inner = 0, sub = 0;
+
+    memory->register_mmio(memory::GPU_REGS_BASE, 0x400000,
+        [&](GuestAddr) -> u32 { outer++; return 1; }, [](GuestAddr, u32) {});
+    memory->register_mmio(0x7FEA0000, 0x10000,
+        [&](GuestAddr) -> u32 { inner++; return 2; }, [](GuestAddr, u32) {});
+    // Sub-page range shares its page with the outer range
+    memory->register_mmio(0x7FC03100, 0x100,
+        [&](GuestAddr) -> u32 { sub++; return 3; }, [](GuestAddr, u32) {});
+
+    EXPECT_EQ(memory->read_u32(0x7FC00000), 1u);
+    EXPECT_EQ(memory->read_u32(0x7FEA0010), 2u);
+    EXPECT_EQ(memory->read_u32(0x7FC03100), 3u);
+    EXPECT_EQ(memory->read_u32(0x7FC03200), 1u);   // Same page, outside sub-range
+    EXPECT_EQ(outer, 2);
+    EXPECT_EQ(inner, 1);
+    EXPECT_EQ(sub, 1);
+
+    memory->unregister_mmio(0x7FEA0000);
+    EXPECT_EQ(memory->read_u32(0x7FEA0010), 1u);
+}
+
+TEST_F(MemoryExtTest, RegisterMmio_OutsideGpuWindow) {
+    GuestAddr base = 0xE1000000;
+    u32 written = 0;
+
+    memory->register_mmio(base, 0x1000,
+        [](GuestAddr addr) -> u32 { return addr & 0xFFF; },
+        [&](GuestAddr, u32 value) { written = value; }
+    );
+
+    EXPECT_EQ(memory->read_u32(base + 0x40), 0x40u);
+    memory->write_u32(base + 0x40, 0x99);
+    EXPECT_EQ(written, 0x99u);
+    EXPECT_EQ(memory->get_host_ptr(base), nullptr);
+}
+
+TEST_F(MemoryExtTest, ShadowRegister_BypassesHandler) {
+    int reads = 0, writes = 0;
+    memory->register_mmio(memory::GPU_REGS_BASE, 0x400000,
+        [&](GuestAddr) -> u32 { reads++; return 0xDEAD; },
+        [&](GuestAddr, u32) { writes++; });
+
+    // CP_RB_RPTR (register 0x070D) published by the GPU side
+    memory->shadow_register(0x070D, 0x40);
+    EXPECT_EQ(memory->read_u32(0x7FC01C34), 0x40u);
+    EXPECT_EQ(memory->read_u32(0xC0001C34), 0x40u);
+    EXPECT_EQ(memory->read_u32(0xEC801C34), 0x40u);
+    EXPECT_EQ(reads, 0);
+
+    memory->shadow_register(0x070D, 0x80);
+    EXPECT_EQ(memory->read_u32(0x7FC01C34), 0x80u);
+
+    // Writes and neighbouring registers still reach the handler
+    memory->write_u32(0x7FC01C34, 0);
+    EXPECT_EQ(writes, 1);
+    EXPECT_EQ(memory->read_u32(0x7FC01C38), 0xDEADu);
+    EXPECT_EQ(reads, 1);
+
+    memory->unshadow_register(0x070D);
+    EXPECT_EQ(memory->read_u32(0x7FC01C34), 0xDEADu);
+    EXPECT_EQ(reads, 2);
+}
+
 //=============================================================================
 // Reservation (Atomic) Operations
 //=============================================================================
@@ -269,6 +473,59 @@ TEST_F(MemoryExtTest, Reservation_WrongSize) {
     EXPECT_FALSE(memory->check_reservation(0, 0x00200000, 8));
 }
 
+TEST_F(MemoryExtTest, Reservation_GranuleWide) {
+    memory->set_reservation(0, 0x00200000, 4);
+
+    // A store elsewhere in the same 128-byte granule kills the reservation
+    memory->write_u32(0x00200040, 1);
+    EXPECT_FALSE(memory->check_reservation(0, 0x00200000, 4));
+
+    // The next granule, and stores through a mirror, are tracked physically
+    memory->set_reservation(0, 0x00200000, 4);
+    memory->write_u32(0x00200080, 1);
+    EXPECT_TRUE(memory->check_reservation(0, 0x00200000, 4));
+    memory->write_u32(0x80200010, 1);
+    EXPECT_FALSE(memory->check_reservation(0, 0x00200000, 4));
+}
+
+TEST_F(MemoryExtTest, Reservation_StoreConditionalOnce) {
+    memory->set_reservation(0, 0x00200000, 4);
+    memory->set_reservation(1, 0x00200000, 4);
+
+    EXPECT_TRUE(memory->store_conditional(0, 0x00200000, 4, 1));
+    EXPECT_FALSE(memory->store_conditional(1, 0x00200000, 4, 2));
+    EXPECT_FALSE(memory->store_conditional(0, 0x00200000, 4, 3));
+    EXPECT_EQ(memory->read_u32(0x00200000), 1u);
+
+    memory->clear_reservation(0);
+    memory->clear_reservation(1);
+}
+
+TEST_F(MemoryExtTest, Reservation_ConcurrentIncrement) {
+    constexpr GuestAddr counter = 0x00200000;
+    constexpr int ITERATIONS = 20000;
+    memory->write_u32(counter, 0);
+
+    // lwarx/addi/stwcx. loop on every hardware thread
+    std::vector<std::thread> threads;
+    for (u32 tid = 0; tid < 6; tid++) {
+        threads.emplace_back([this, tid] {
+            for (int i = 0; i < ITERATIONS; i++) {
+                for (;;) {
+                    memory->set_reservation(tid, counter, 4);
+                    u32 value = memory->read_u32(counter);
+                    bool stored = memory->store_conditional(tid, counter, 4, value + 1);
+                    memory->clear_reservation(tid);
+                    if (stored) break;
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    EXPECT_EQ(memory->read_u32(counter), 6u * ITERATIONS);
+}
+
 //=============================================================================
 // Write Tracking
 //=============================================================================
@@ -309,6 +566,202 @@ TEST_F(MemoryExtTest, WriteTracking_Untrack) {
     EXPECT_FALSE(callback_fired);
 }
 
+TEST_F(MemoryExtTest, WriteTracking_PageBitmap) {
+    GuestAddr track_base = 0x00320000;
+    EXPECT_FALSE(memory->is_page_watched(track_base));
+
+    memory->track_writes(track_base, 0x2000, [](GuestAddr, u64) {});
+    EXPECT_TRUE(memory->is_page_watched(track_base));
+    EXPECT_TRUE(memory->is_page_watched(track_base + 0x1FFF));
+    EXPECT_FALSE(memory->is_page_watched(track_base + 0x2000));
+    EXPECT_FALSE(memory->is_page_watched(track_base - 1));
+
+    // Virtual mirrors share the physical page bit
+    EXPECT_TRUE(memory->is_page_watched(0x80000000 | track_base));
+
+    memory->untrack_writes(track_base);
+    EXPECT_FALSE(memory->is_page_watched(track_base));
+}
+
+TEST_F(MemoryExtTest, WriteTracking_OverlappingWatchers) {
+    GuestAddr base = 0x00330000;
+    int first = 0, second = 0;
+
+    memory->track_writes(base, 0x1000, [&](GuestAddr, u64) { first++; });
+    memory->track_writes(base + 0x800, 0x1000, [&](GuestAddr, u64) { second++; });
+
+    memory->write_u32(base + 0x10, 1);
+    EXPECT_EQ(first, 1);
+    EXPECT_EQ(second, 0);   // Same page, but outside the second's bytes
+
+    memory->write_u32(base + 0x900, 1);
+    EXPECT_EQ(first, 2);
+    EXPECT_EQ(second, 1);   // Inside both ranges
+
+    memory->untrack_writes(base);
+    EXPECT_TRUE(memory->is_page_watched(base));   // Still watched by the second
+
+    memory->write_u32(base + 0x1010, 2);
+    EXPECT_EQ(first, 2);
+    EXPECT_EQ(second, 2);
+}
+
+TEST_F(MemoryExtTest, WriteTracking_DeferredCoalescesPages) {
+    GuestAddr base = 0x00400000;
+    std::vector<std::pair<GuestAddr, u64>> runs;
+
+    auto id = memory->watch_pages(base, 0x10000, [&](GuestAddr addr, u64 size) {
+        runs.push_back({addr, size});
+    });
+    EXPECT_NE(id, 0u);
+
+    // Many stores to pages 0-1 and one to page 5
+    for (u32 i = 0; i < 256; i++) {
+        memory->write_u32(base + i * 32, i);
+    }
+    memory->write_u8(0x80000000 | (base + 0x5004), 0xFF);
+    EXPECT_TRUE(runs.empty());
+
+    memory->flush_page_writes();
+    ASSERT_EQ(runs.size(), 2u);
+    EXPECT_EQ(runs[0].first, base);
+    EXPECT_EQ(runs[0].second, 0x2000u);
+    EXPECT_EQ(runs[1].first, base + 0x5000);
+    EXPECT_EQ(runs[1].second, 0x1000u);
+
+    // Pending state is cleared by the flush
+    runs.clear();
+    memory->flush_page_writes();
+    EXPECT_TRUE(runs.empty());
+
+    memory->unwatch_pages(id);
+    memory->write_u32(base, 0);
+    memory->flush_page_writes();
+    EXPECT_TRUE(runs.empty());
+    EXPECT_FALSE(memory->is_page_watched(base));
+}
+
+TEST_F(MemoryExtTest, WriteTracking_BulkWriteSpansPages) {
+    GuestAddr base = 0x00500000;
+    std::vector<std::pair<GuestAddr, u64>> runs;
+    memory->watch_pages(base + 0x3000, 0x1000, [&](GuestAddr addr, u64 size) {
+        runs.push_back({addr, size});
+    });
+
+    // Write starts on an unwatched page and ends on the watched one
+    memory->zero_bytes(base, 0x3010);
+    memory->flush_page_writes();
+    ASSERT_EQ(runs.size(), 1u);
+    EXPECT_EQ(runs[0].first, base + 0x3000);
+}
+
+//=============================================================================
+// Dirty Page Tracking
+//=============================================================================
+
+TEST_F(MemoryExtTest, DirtyPages_SnapshotAndClear) {
+    memory->write_u32(0x00600000, 1);   // Before registration: not reported
+
+    auto id = memory->register_dirty_consumer();
+    EXPECT_NE(id, 0u);
+
+    memory->write_u32(0x00600010, 1);
+    memory->write_u8(0x80000000 | 0x00602FFF, 1);   // Virtual mirror
+    memory->zero_bytes(0x00700FF0, 0x20);           // Spans two pages
+
+    std::vector<GuestAddr> pages;
+    memory->snapshot_dirty_pages(id, pages);
+    std::vector<GuestAddr> expected = {0x00600000, 0x00602000, 0x00700000, 0x00701000};
+    EXPECT_EQ(pages, expected);
+
+    // Snapshot starts a new interval
+    memory->snapshot_dirty_pages(id, pages);
+    EXPECT_TRUE(pages.empty());
+
+    memory->write_u32(0x00600000, 2);
+    memory->clear_dirty_pages(id);
+    memory->snapshot_dirty_pages(id, pages);
+    EXPECT_TRUE(pages.empty());
+
+    memory->unregister_dirty_consumer(id);
+}
+
+TEST_F(MemoryExtTest, DirtyPages_IndependentConsumers) {
+    auto a = memory->register_dirty_consumer();
+    auto b = memory->register_dirty_consumer();
+
+    memory->write_u32(0x00610000, 1);
+
+    std::vector<GuestAddr> pages;
+    memory->snapshot_dirty_pages(a, pages);
+    ASSERT_EQ(pages.size(), 1u);
+
+    memory->write_u32(0x00620000, 1);
+
+    // b has not snapshotted yet and sees both writes
+    memory->snapshot_dirty_pages(b, pages);
+    EXPECT_EQ(pages.size(), 2u);
+
+    memory->snapshot_dirty_pages(a, pages);
+    ASSERT_EQ(pages.size(), 1u);
+    EXPECT_EQ(pages[0], 0x00620000u);
+
+    memory->unregister_dirty_consumer(a);
+    memory->unregister_dirty_consumer(b);
+}
+
+TEST_F(MemoryExtTest, DirtyPages_GenerationStamps) {
+    auto id = memory->register_dirty_consumer();
+
+    u32 filled = memory->dirty_generation();
+    EXPECT_LT(memory->page_generation(0x00630000), filled);
+
+    memory->clear_dirty_pages(id);   // Advance the generation
+    memory->write_u32(0x00630000, 1);
+    EXPECT_GT(memory->page_generation(0x00630000), filled);
+    EXPECT_LT(memory->page_generation(0x00631000), filled);
+
+    memory->unregister_dirty_consumer(id);
+}
+
+TEST_F(MemoryExtTest, DirtyPages_FastmemWriteDetection) {
+    u8* fastmem = static_cast<u8*>(memory->get_fastmem_base());
+    if (!fastmem) GTEST_SKIP() << "fastmem unavailable";
+
+    // Requires a consumer
+    EXPECT_NE(memory->set_fastmem_write_detection(true), Status::Ok);
+
+    auto id = memory->register_dirty_consumer();
+    ASSERT_EQ(memory->set_fastmem_write_detection(true), Status::Ok);
+    EXPECT_TRUE(memory->fastmem_write_detection());
+
+    // Store straight through the fastmem window, bypassing Memory
+    fastmem[0x00640004] = 0x5A;
+    fastmem[0x00640008] = 0x5B;
+    EXPECT_EQ(memory->read_u8(0x00640004), 0x5A);
+
+    std::vector<GuestAddr> pages;
+    memory->snapshot_dirty_pages(id, pages);
+    EXPECT_NE(std::find(pages.begin(), pages.end(), 0x00640000u), pages.end());
+
+    // Pages still writable at a snapshot are conservatively carried into
+    // the next interval; after that the page stays clean until written
+    memory->snapshot_dirty_pages(id, pages);
+    memory->snapshot_dirty_pages(id, pages);
+    EXPECT_EQ(std::find(pages.begin(), pages.end(), 0x00640000u), pages.end());
+
+    // Page was protected again by the snapshot
+    fastmem[0x00640010] = 0x5C;
+    memory->snapshot_dirty_pages(id, pages);
+    EXPECT_NE(std::find(pages.begin(), pages.end(), 0x00640000u), pages.end());
+
+    EXPECT_EQ(memory->set_fastmem_write_detection(false), Status::Ok);
+    fastmem[0x00640020] = 0x5D;
+    EXPECT_EQ(memory->read_u8(0x00640020), 0x5D);
+
+    memory->unregister_dirty_consumer(id);
+}
+
 //=============================================================================
 // Time Base
 //=============================================================================
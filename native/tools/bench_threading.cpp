@@ -0,0 +1,175 @@
+/**
+ * 360μ - Xbox 360 Emulator for Android
+ *
+ * Threading benchmark: guest context switch and event wake latency.
+ *
+ * Switch: two system threads hand a token back and forth through
+ * park/unpark, once with 1:1 host threads and once with fibers on the M:N
+ * scheduler (both peers on one worker, and on two workers).
+ *
+ * Wake: two threads hand off through a pair of auto-reset kernel events.
+ * Guest threads park on their futex word; plain host threads take the
+ * per-object condition variable path.
+ *
+ * Usage: ./bench_threading [rounds]
+ */
+
+#include "cpu/xenon/cpu.h"
+#include "cpu/xenon/fiber.h"
+#include "cpu/xenon/threading.h"
+#include "kernel/threading.h"
+#include "memory/memory.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace x360mu;
+
+static std::unique_ptr<ThreadScheduler> start_scheduler(SchedulingMode mode) {
+    auto scheduler = std::make_unique<ThreadScheduler>();
+    if (scheduler->initialize(nullptr, nullptr, nullptr, 0, mode) != Status::Ok) {
+        printf("Scheduler initialization failed\n");
+        return nullptr;
+    }
+    return scheduler;
+}
+
+static double ping_pong_ns_per_switch(ThreadScheduler& scheduler, u32 mask_a, u32 mask_b,
+                                      int rounds) {
+    std::atomic<int> turn{0};
+    std::atomic<int> done{0};
+    std::atomic<GuestThread*> peers[2] = {nullptr, nullptr};
+    std::atomic<bool> go{false};
+
+    auto side = [&](int me) {
+        return [&, me](GuestThread* self) {
+            while (!go.load()) scheduler.park(self, 100000);
+            GuestThread* other = peers[1 - me].load();
+            for (int i = 0; i < rounds; i++) {
+                while (turn.load(std::memory_order_acquire) != me) scheduler.park(self);
+                turn.store(1 - me, std::memory_order_release);
+                scheduler.unpark(other);
+            }
+            done++;
+        };
+    };
+
+    peers[0] = scheduler.create_system_thread(side(0), mask_a);
+    peers[1] = scheduler.create_system_thread(side(1), mask_b);
+
+    auto begin = std::chrono::steady_clock::now();
+    go = true;
+    scheduler.unpark(peers[0].load());
+    scheduler.unpark(peers[1].load());
+    while (done.load() < 2) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (2.0 * rounds);
+}
+
+template <typename Spawn>
+static double event_ping_pong_ns(KernelThreadManager& mgr, Spawn spawn, int rounds) {
+    u32 events[2] = {};
+    mgr.create_event(&events[0], 0, 0, EventType::SynchronizationEvent, false);
+    mgr.create_event(&events[1], 0, 0, EventType::SynchronizationEvent, false);
+    std::atomic<int> done{0};
+    std::atomic<int> failures{0};
+
+    auto side = [&](int me) {
+        return [&, me]() {
+            s32 prev = 0;
+            for (int i = 0; i < rounds; i++) {
+                if (me == 0) mgr.set_event(events[1], &prev);
+                if (mgr.wait_for_single_object(events[me], false, nullptr) != nt::STATUS_WAIT_0) {
+                    failures++;
+                }
+                if (me == 1) mgr.set_event(events[0], &prev);
+            }
+            done++;
+        };
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    spawn(side(0));
+    spawn(side(1));
+    while (done.load() < 2) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+
+    if (failures.load()) printf("  %d waits failed\n", failures.load());
+    mgr.close_handle(events[0]);
+    mgr.close_handle(events[1]);
+    return std::chrono::duration<double, std::nano>(elapsed).count() / (2.0 * rounds);
+}
+
+static bool bench_event_wake(int rounds) {
+    Memory memory;
+    if (memory.initialize() != Status::Ok) {
+        printf("Memory initialization failed\n");
+        return false;
+    }
+    Cpu cpu;
+    CpuConfig cpu_config{};
+    ThreadScheduler scheduler;
+    KernelThreadManager mgr;
+    if (cpu.initialize(&memory, cpu_config) != Status::Ok ||
+        scheduler.initialize(&memory, nullptr, &cpu, 1) != Status::Ok ||
+        mgr.initialize(&memory, &cpu, &scheduler) != Status::Ok) {
+        printf("Kernel initialization failed\n");
+        return false;
+    }
+    set_kernel_thread_manager(&mgr);
+
+    printf("\nAuto-reset event ping-pong, %d rounds\n\n", rounds);
+
+    double guest_ns = event_ping_pong_ns(mgr, [&](std::function<void()> fn) {
+        scheduler.create_system_thread([fn](GuestThread*) { fn(); });
+    }, rounds);
+
+    std::vector<std::thread> host_threads;
+    double host_ns = event_ping_pong_ns(mgr, [&](std::function<void()> fn) {
+        host_threads.emplace_back(fn);
+    }, rounds);
+    for (auto& t : host_threads) t.join();
+
+    printf("guest threads (futex park): %8.0f ns/wake\n", guest_ns);
+    printf("host threads (object CV):   %8.0f ns/wake\n", host_ns);
+
+    set_kernel_thread_manager(nullptr);
+    mgr.shutdown();
+    scheduler.shutdown();
+    cpu.shutdown();
+    memory.shutdown();
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? atoi(argv[1]) : 20000;
+    if (rounds <= 0) rounds = 20000;
+
+    printf("Park/unpark ping-pong, %d rounds\n\n", rounds);
+
+    auto scheduler = start_scheduler(SchedulingMode::OneToOne);
+    if (!scheduler) return 1;
+    printf("1:1 host threads:     %8.0f ns/switch\n",
+           ping_pong_ns_per_switch(*scheduler, 1, 2, rounds));
+    scheduler->shutdown();
+
+    if (Fiber::supported()) {
+        scheduler = start_scheduler(SchedulingMode::Fibers);
+        if (!scheduler) return 1;
+        printf("fibers, same worker:  %8.0f ns/switch\n",
+               ping_pong_ns_per_switch(*scheduler, 1, 1, rounds));
+        printf("fibers, cross worker: %8.0f ns/switch\n",
+               ping_pong_ns_per_switch(*scheduler, 1, 2, rounds));
+        scheduler->shutdown();
+    } else {
+        printf("fibers:               unsupported on this host\n");
+    }
+
+    return bench_event_wake(rounds / 4) ? 0 : 1;
+}